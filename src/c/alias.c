@@ -6,10 +6,11 @@
 #include <windows.h>
 
 #include <ovarray.h>
+#include <ovhashmap.h>
 #include <ovl/os.h>
 #include <ovl/path.h>
 #include <ovmo.h>
-#include <ovsort.h>
+#include <ovthreads.h>
 
 #include "i18n.h"
 #include "ini_reader.h"
@@ -50,7 +51,13 @@ static bool is_digits(char const *const s, size_t const len) {
 }
 
 void ptk_alias_script_definitions_free(struct ptk_alias_script_definitions *const defs) {
-  if (!defs || !defs->items) {
+  if (!defs) {
+    return;
+  }
+  if (defs->effect_index) {
+    OV_HASHMAP_DESTROY(&defs->effect_index);
+  }
+  if (!defs->items) {
     return;
   }
   size_t const n = OV_ARRAY_LENGTH(defs->items);
@@ -229,13 +236,91 @@ cleanup:
   return success;
 }
 
-bool ptk_alias_load_script_definitions(struct ptk_alias_script_definitions *const defs, struct ov_error *const err) {
-  if (!defs) {
-    OV_ERROR_SET_GENERIC(err, ov_error_generic_invalid_argument);
+struct effect_index_entry {
+  char const *effect_name; // points to ptk_alias_script_definition.effect_name
+  size_t effect_name_len;
+  size_t index;
+};
+
+static void get_effect_index_key(void const *const item, void const **const key, size_t *const key_bytes) {
+  struct effect_index_entry const *const entry = (struct effect_index_entry const *)item;
+  *key = entry->effect_name;
+  *key_bytes = entry->effect_name_len;
+}
+
+/**
+ * @brief Build the effect name index of script definitions
+ *
+ * When several definitions share an effect name, the first one wins as in a linear search.
+ *
+ * @param defs [in/out] Script definitions
+ * @param err [out] Error information on failure
+ * @return true on success, false on failure
+ */
+static bool build_effect_index(struct ptk_alias_script_definitions *const defs, struct ov_error *const err) {
+  size_t const n = OV_ARRAY_LENGTH(defs->items);
+  defs->effect_index =
+      OV_HASHMAP_CREATE_DYNAMIC(sizeof(struct effect_index_entry), n > 0 ? n : 1, get_effect_index_key);
+  if (!defs->effect_index) {
+    OV_ERROR_SET_GENERIC(err, ov_error_generic_out_of_memory);
     return false;
   }
+  for (size_t i = 0; i < n; i++) {
+    struct effect_index_entry const entry = {
+        .effect_name = defs->items[i].effect_name,
+        .effect_name_len = strlen(defs->items[i].effect_name),
+        .index = i,
+    };
+    if (OV_HASHMAP_GET(defs->effect_index, &entry)) {
+      continue;
+    }
+    if (!OV_HASHMAP_SET(defs->effect_index, &entry)) {
+      OV_ERROR_SET_GENERIC(err, ov_error_generic_out_of_memory);
+      return false;
+    }
+  }
+  return true;
+}
 
-  NATIVE_CHAR *config_dir = NULL;
+/**
+ * @brief Find the script definition for an effect name
+ *
+ * @param defs Script definitions
+ * @param effect_name Effect name (not NUL-terminated)
+ * @param effect_name_len Length of effect name
+ * @return Definition, or NULL if not found
+ */
+static struct ptk_alias_script_definition const *
+find_definition_by_effect(struct ptk_alias_script_definitions const *const defs,
+                          char const *const effect_name,
+                          size_t const effect_name_len) {
+  if (defs->effect_index) {
+    struct effect_index_entry const key = {.effect_name = effect_name, .effect_name_len = effect_name_len};
+    struct effect_index_entry const *const found =
+        (struct effect_index_entry const *)OV_HASHMAP_GET(defs->effect_index, &key);
+    return found ? &defs->items[found->index] : NULL;
+  }
+  size_t const defs_count = OV_ARRAY_LENGTH(defs->items);
+  for (size_t i = 0; i < defs_count; i++) {
+    struct ptk_alias_script_definition const *def = &defs->items[i];
+    if (strlen(def->effect_name) == effect_name_len && strncmp(effect_name, def->effect_name, effect_name_len) == 0) {
+      return def;
+    }
+  }
+  return NULL;
+}
+
+/**
+ * @brief Load script definitions from the INI files in a config directory
+ *
+ * @param config_dir Config directory path, ending with a path separator
+ * @param defs [out] Output definitions, including the effect name index
+ * @param err [out] Error information on failure
+ * @return true on success, false on failure
+ */
+static bool load_script_definitions_from_dir(NATIVE_CHAR const *const config_dir,
+                                             struct ptk_alias_script_definitions *const defs,
+                                             struct ov_error *const err) {
   NATIVE_CHAR *ini_path = NULL;
   NATIVE_CHAR *user_ini_path = NULL;
   struct ptk_ini_reader *reader = NULL;
@@ -246,11 +331,6 @@ bool ptk_alias_load_script_definitions(struct ptk_alias_script_definitions *cons
   memset(defs, 0, sizeof(*defs));
 
   {
-    if (!get_config_dir(&config_dir, err)) {
-      OV_ERROR_ADD_TRACE(err);
-      goto cleanup;
-    }
-
     // Build path to PSDToolKit.ini
     if (!build_config_path(config_dir, L"PSDToolKit.ini", &ini_path, err)) {
       OV_ERROR_ADD_TRACE(err);
@@ -299,6 +379,11 @@ bool ptk_alias_load_script_definitions(struct ptk_alias_script_definitions *cons
       }
       // If user file fails to load, we silently ignore and continue with main file's data
     }
+
+    if (!build_effect_index(defs, err)) {
+      OV_ERROR_ADD_TRACE(err);
+      goto cleanup;
+    }
   }
 
   success = true;
@@ -307,9 +392,6 @@ cleanup:
   if (reader) {
     ptk_ini_reader_destroy(&reader);
   }
-  if (config_dir) {
-    OV_ARRAY_DESTROY(&config_dir);
-  }
   if (ini_path) {
     OV_ARRAY_DESTROY(&ini_path);
   }
@@ -328,6 +410,192 @@ cleanup:
   return success;
 }
 
+bool ptk_alias_load_script_definitions(struct ptk_alias_script_definitions *const defs, struct ov_error *const err) {
+  if (!defs) {
+    OV_ERROR_SET_GENERIC(err, ov_error_generic_invalid_argument);
+    return false;
+  }
+
+  NATIVE_CHAR *config_dir = NULL;
+  bool success = false;
+
+  if (!get_config_dir(&config_dir, err)) {
+    OV_ERROR_ADD_TRACE(err);
+    goto cleanup;
+  }
+  if (!load_script_definitions_from_dir(config_dir, defs, err)) {
+    OV_ERROR_ADD_TRACE(err);
+    goto cleanup;
+  }
+
+  success = true;
+
+cleanup:
+  if (config_dir) {
+    OV_ARRAY_DESTROY(&config_dir);
+  }
+  return success;
+}
+
+/**
+ * @brief Size and last write time of a config file, used to detect changes
+ */
+struct config_file_stamp {
+  uint64_t size;
+  uint64_t time;
+  bool exists;
+};
+
+static struct config_file_stamp get_config_file_stamp(NATIVE_CHAR const *const path) {
+  WIN32_FILE_ATTRIBUTE_DATA attr;
+  if (!GetFileAttributesExW(path, GetFileExInfoStandard, &attr)) {
+    return (struct config_file_stamp){0};
+  }
+  return (struct config_file_stamp){
+      .size = ((uint64_t)attr.nFileSizeHigh << 32) | attr.nFileSizeLow,
+      .time = ((uint64_t)attr.ftLastWriteTime.dwHighDateTime << 32) | attr.ftLastWriteTime.dwLowDateTime,
+      .exists = true,
+  };
+}
+
+static bool config_file_stamp_equals(struct config_file_stamp const *const a, struct config_file_stamp const *const b) {
+  return a->exists == b->exists && a->size == b->size && a->time == b->time;
+}
+
+struct ptk_alias_script_catalog {
+  NATIVE_CHAR *config_dir;    // ovarray
+  NATIVE_CHAR *ini_path;      // ovarray
+  NATIVE_CHAR *user_ini_path; // ovarray
+  struct ptk_alias_script_definitions defs;
+  struct config_file_stamp ini_stamp;
+  struct config_file_stamp user_ini_stamp;
+  bool loaded;
+  thrd_t thread;
+  bool thread_created; // true until the preload thread is joined
+};
+
+/**
+ * @brief Reload script definitions if the INI files changed since the last load
+ *
+ * @param catalog Catalog
+ * @param err [out] Error information on failure
+ * @return true on success, false on failure
+ */
+static bool catalog_refresh(struct ptk_alias_script_catalog *const catalog, struct ov_error *const err) {
+  // Stamps are taken before reading so that a change during the load is detected next time
+  struct config_file_stamp const ini_stamp = get_config_file_stamp(catalog->ini_path);
+  struct config_file_stamp const user_ini_stamp = get_config_file_stamp(catalog->user_ini_path);
+  if (catalog->loaded && config_file_stamp_equals(&catalog->ini_stamp, &ini_stamp) &&
+      config_file_stamp_equals(&catalog->user_ini_stamp, &user_ini_stamp)) {
+    return true;
+  }
+
+  struct ptk_alias_script_definitions defs = {0};
+  if (!load_script_definitions_from_dir(catalog->config_dir, &defs, err)) {
+    OV_ERROR_ADD_TRACE(err);
+    return false;
+  }
+  ptk_alias_script_definitions_free(&catalog->defs);
+  catalog->defs = defs;
+  catalog->ini_stamp = ini_stamp;
+  catalog->user_ini_stamp = user_ini_stamp;
+  catalog->loaded = true;
+  return true;
+}
+
+static int catalog_preload_thread(void *const userdata) {
+  struct ptk_alias_script_catalog *const catalog = (struct ptk_alias_script_catalog *)userdata;
+  // Errors are reported by ptk_alias_script_catalog_get, which retries the load
+  struct ov_error err = {0};
+  if (!catalog_refresh(catalog, &err)) {
+    OV_ERROR_DESTROY(&err);
+  }
+  return 0;
+}
+
+struct ptk_alias_script_catalog *ptk_alias_script_catalog_create(NATIVE_CHAR const *const config_dir,
+                                                                 struct ov_error *const err) {
+  struct ptk_alias_script_catalog *catalog = NULL;
+  bool success = false;
+
+  if (!OV_REALLOC(&catalog, 1, sizeof(*catalog))) {
+    OV_ERROR_SET_GENERIC(err, ov_error_generic_out_of_memory);
+    goto cleanup;
+  }
+  *catalog = (struct ptk_alias_script_catalog){0};
+
+  if (config_dir) {
+    size_t const len = wcslen(config_dir);
+    if (!OV_ARRAY_GROW(&catalog->config_dir, len + 1)) {
+      OV_ERROR_SET_GENERIC(err, ov_error_generic_out_of_memory);
+      goto cleanup;
+    }
+    memcpy(catalog->config_dir, config_dir, (len + 1) * sizeof(NATIVE_CHAR));
+    OV_ARRAY_SET_LENGTH(catalog->config_dir, len);
+  } else if (!get_config_dir(&catalog->config_dir, err)) {
+    OV_ERROR_ADD_TRACE(err);
+    goto cleanup;
+  }
+  if (!build_config_path(catalog->config_dir, L"PSDToolKit.ini", &catalog->ini_path, err) ||
+      !build_config_path(catalog->config_dir, L"PSDToolKit.user.ini", &catalog->user_ini_path, err)) {
+    OV_ERROR_ADD_TRACE(err);
+    goto cleanup;
+  }
+
+  if (thrd_create(&catalog->thread, catalog_preload_thread, catalog) != thrd_success) {
+    OV_ERROR_SET_GENERIC(err, ov_error_generic_fail);
+    goto cleanup;
+  }
+  catalog->thread_created = true;
+
+  success = true;
+
+cleanup:
+  if (!success) {
+    ptk_alias_script_catalog_destroy(&catalog);
+  }
+  return catalog;
+}
+
+void ptk_alias_script_catalog_destroy(struct ptk_alias_script_catalog **const catalog_ptr) {
+  if (!catalog_ptr || !*catalog_ptr) {
+    return;
+  }
+  struct ptk_alias_script_catalog *const catalog = *catalog_ptr;
+  if (catalog->thread_created) {
+    thrd_join(catalog->thread, NULL);
+  }
+  ptk_alias_script_definitions_free(&catalog->defs);
+  if (catalog->user_ini_path) {
+    OV_ARRAY_DESTROY(&catalog->user_ini_path);
+  }
+  if (catalog->ini_path) {
+    OV_ARRAY_DESTROY(&catalog->ini_path);
+  }
+  if (catalog->config_dir) {
+    OV_ARRAY_DESTROY(&catalog->config_dir);
+  }
+  OV_FREE(catalog_ptr);
+}
+
+struct ptk_alias_script_definitions const *ptk_alias_script_catalog_get(struct ptk_alias_script_catalog *const catalog,
+                                                                       struct ov_error *const err) {
+  if (!catalog) {
+    OV_ERROR_SET_GENERIC(err, ov_error_generic_invalid_argument);
+    return NULL;
+  }
+  // The catalog is only touched by the preload thread until it is joined here
+  if (catalog->thread_created) {
+    thrd_join(catalog->thread, NULL);
+    catalog->thread_created = false;
+  }
+  if (!catalog_refresh(catalog, err)) {
+    OV_ERROR_ADD_TRACE(err);
+    return NULL;
+  }
+  return &catalog->defs;
+}
+
 void ptk_alias_available_scripts_free(struct ptk_alias_available_scripts *const scripts) {
   if (!scripts) {
     return;
@@ -377,8 +645,6 @@ static bool scan_alias_sections(struct ptk_ini_reader const *const reader,
   char *effect_name = NULL;
   bool success = false;
 
-  size_t const defs_count = OV_ARRAY_LENGTH(defs->items);
-
   {
     struct ptk_ini_iter section_iter = {0};
     while (ptk_ini_reader_iter_sections(reader, &section_iter)) {
@@ -420,39 +686,36 @@ static bool scan_alias_sections(struct ptk_ini_reader const *const reader,
       }
 
       // Check against script definitions
-      for (size_t i = 0; i < defs_count; i++) {
-        struct ptk_alias_script_definition const *def = &defs->items[i];
-        size_t const def_effect_len = strlen(def->effect_name);
-        if (effect_val.size != def_effect_len || strncmp(effect_val.ptr, def->effect_name, effect_val.size) != 0) {
-          continue;
-        }
+      struct ptk_alias_script_definition const *const def =
+          find_definition_by_effect(defs, effect_val.ptr, effect_val.size);
+      if (!def) {
+        continue;
+      }
 
-        // Found matching effect - add to scripts
-        if (!strdup_n(&script_name, def->script_name, strlen(def->script_name), err)) {
-          OV_ERROR_ADD_TRACE(err);
-          goto cleanup;
-        }
-        if (!strdup_n(&effect_name, def->effect_name, def_effect_len, err)) {
-          OV_ERROR_ADD_TRACE(err);
-          goto cleanup;
-        }
+      // Found matching effect - add to scripts
+      if (!strdup_n(&script_name, def->script_name, strlen(def->script_name), err)) {
+        OV_ERROR_ADD_TRACE(err);
+        goto cleanup;
+      }
+      if (!strdup_n(&effect_name, def->effect_name, effect_val.size, err)) {
+        OV_ERROR_ADD_TRACE(err);
+        goto cleanup;
+      }
 
-        size_t const len = OV_ARRAY_LENGTH(scripts->items);
-        if (!OV_ARRAY_GROW(&scripts->items, len + 1)) {
-          OV_ERROR_SET_GENERIC(err, ov_error_generic_out_of_memory);
-          goto cleanup;
-        }
-        scripts->items[len].script_name = script_name;
-        scripts->items[len].effect_name = effect_name;
-        scripts->items[len].translated_name = NULL;
-        scripts->items[len].selected = true;
-        OV_ARRAY_SET_LENGTH(scripts->items, len + 1);
-
-        // Ownership transferred
-        script_name = NULL;
-        effect_name = NULL;
-        break;
+      size_t const len = OV_ARRAY_LENGTH(scripts->items);
+      if (!OV_ARRAY_GROW(&scripts->items, len + 1)) {
+        OV_ERROR_SET_GENERIC(err, ov_error_generic_out_of_memory);
+        goto cleanup;
       }
+      scripts->items[len].script_name = script_name;
+      scripts->items[len].effect_name = effect_name;
+      scripts->items[len].translated_name = NULL;
+      scripts->items[len].selected = true;
+      OV_ARRAY_SET_LENGTH(scripts->items, len + 1);
+
+      // Ownership transferred
+      script_name = NULL;
+      effect_name = NULL;
     }
   }
 
@@ -558,80 +821,49 @@ void ptk_alias_extracted_animation_free(struct ptk_alias_extracted_animation *co
 /**
  * @brief Find the section containing the specified effect
  *
- * @param reader INI reader with loaded alias data
+ * Scans the alias in file order and stops at the first matching section,
+ * so the rest of the alias is never parsed.
+ *
+ * @param alias Alias data
+ * @param alias_len Length of alias data
  * @param effect_name Effect name to search for
- * @param section_name [out] Buffer for section name
- * @param section_name_size Size of section_name buffer
- * @param section_name_len [out] Length of section name
+ * @param section [out] Scanner positioned on the header of the found section
  * @return true if found, false otherwise
  */
-static bool find_effect_section(struct ptk_ini_reader *const reader,
+static bool find_effect_section(char const *const alias,
+                                size_t const alias_len,
                                 char const *const effect_name,
-                                char *const section_name,
-                                size_t const section_name_size,
-                                size_t *const section_name_len) {
-  struct ptk_ini_iter section_iter = {0};
-  while (ptk_ini_reader_iter_sections(reader, &section_iter)) {
-    if (!section_iter.name) {
+                                struct ptk_ini_scanner *const section) {
+  static char const object_prefix[] = "Object.";
+  static size_t const prefix_len = sizeof(object_prefix) - 1;
+  static char const key[] = "effect.name";
+  size_t const effect_name_len = strlen(effect_name);
+  struct ptk_ini_scanner scanner;
+  struct ptk_ini_scanner header = {0};
+  bool in_object_section = false;
+
+  ptk_ini_scanner_init(&scanner, alias, alias_len);
+  while (ptk_ini_scanner_next(&scanner)) {
+    if (!scanner.name) {
+      in_object_section = scanner.section_len > prefix_len &&
+                          strncmp(scanner.section, object_prefix, prefix_len) == 0 &&
+                          is_digits(scanner.section + prefix_len, scanner.section_len - prefix_len);
+      header = scanner;
       continue;
     }
-
-    static char const object_prefix[] = "Object.";
-    static size_t const prefix_len = sizeof(object_prefix) - 1;
-    if (section_iter.name_len <= prefix_len || strncmp(section_iter.name, object_prefix, prefix_len) != 0) {
-      continue;
-    }
-    if (!is_digits(section_iter.name + prefix_len, section_iter.name_len - prefix_len)) {
-      continue;
-    }
-
-    static char const key[] = "effect.name";
-    struct ptk_ini_value val =
-        ptk_ini_reader_get_value_n(reader, section_iter.name, section_iter.name_len, key, sizeof(key) - 1);
-    if (!val.ptr || val.size == 0) {
+    if (!in_object_section || scanner.name_len != sizeof(key) - 1 ||
+        strncmp(scanner.name, key, scanner.name_len) != 0) {
       continue;
     }
-
-    if (val.size == strlen(effect_name) && strncmp(val.ptr, effect_name, val.size) == 0) {
-      if (section_iter.name_len >= section_name_size) {
-        return false;
-      }
-      memcpy(section_name, section_iter.name, section_iter.name_len);
-      section_name[section_iter.name_len] = '\0';
-      *section_name_len = section_iter.name_len;
+    struct ptk_ini_value const val = ptk_ini_scanner_get_value(&scanner);
+    if (val.size == effect_name_len && val.size > 0 && strncmp(val.ptr, effect_name, val.size) == 0) {
+      *section = header;
       return true;
     }
   }
   return false;
 }
 
-/**
- * @brief Intermediate structure to hold entry info with line number for sorting
- */
-struct ini_entry_info {
-  char const *name;
-  size_t name_len;
-  char const *value;
-  size_t value_len;
-  size_t line_number;
-};
-
-/**
- * @brief Comparison function for sorting ini_entry_info by line number
- */
-static int compare_ini_entry_info_by_line(void const *const a, void const *const b, void *const userdata) {
-  (void)userdata;
-  struct ini_entry_info const *ea = (struct ini_entry_info const *)a;
-  struct ini_entry_info const *eb = (struct ini_entry_info const *)b;
-  if (ea->line_number < eb->line_number) {
-    return -1;
-  }
-  if (ea->line_number > eb->line_number) {
-    return 1;
-  }
-  return 0;
-}
-
 /**
  * @brief Add a parameter entry to the params array
  *
@@ -699,79 +931,33 @@ cleanup:
 /**
  * @brief Collect all parameters from a section as key-value pairs
  *
- * This function iterates through all entries in the given section and adds them
+ * This function reads the entries following the section header and adds them
  * as key-value pairs to the params array, excluding "effect.name".
- * Entries are sorted by line number to preserve the original order from the INI file.
+ * Entries are read in file order, so the original order from the INI file is preserved.
  *
- * @param reader INI reader instance
- * @param section Section name
- * @param section_len Section name length
+ * @param section Scanner positioned on the section header
  * @param params Pointer to params ovarray
  * @param err Error information
  * @return true on success, false on failure
  */
-static bool collect_all_params_from_section(struct ptk_ini_reader *const reader,
-                                            char const *const section,
-                                            size_t const section_len,
+static bool collect_all_params_from_section(struct ptk_ini_scanner const *const section,
                                             struct ptk_alias_extracted_param **const params,
                                             struct ov_error *const err) {
   static char const excluded_key[] = "effect.name";
-  struct ptk_ini_iter iter = {0};
-  struct ini_entry_info *entries = NULL;
-  bool success = false;
-
-  {
-    // First pass: collect all entries with line numbers
-    while (ptk_ini_reader_iter_entries_n(reader, section, section_len, &iter)) {
-      if (iter.name_len == sizeof(excluded_key) - 1 && strncmp(iter.name, excluded_key, iter.name_len) == 0) {
-        continue;
-      }
+  struct ptk_ini_scanner scanner = *section;
 
-      struct ptk_ini_value val = ptk_ini_reader_get_value_n(reader, section, section_len, iter.name, iter.name_len);
-
-      size_t const entries_len = OV_ARRAY_LENGTH(entries);
-      if (!OV_ARRAY_GROW(&entries, entries_len + 1)) {
-        OV_ERROR_SET_GENERIC(err, ov_error_generic_out_of_memory);
-        goto cleanup;
-      }
-      entries[entries_len] = (struct ini_entry_info){
-          .name = iter.name,
-          .name_len = iter.name_len,
-          .value = val.ptr,
-          .value_len = val.size,
-          .line_number = iter.line_number,
-      };
-      OV_ARRAY_SET_LENGTH(entries, entries_len + 1);
-    }
-
-    // Sort entries by line number
-    {
-      size_t const entries_len = OV_ARRAY_LENGTH(entries);
-      if (entries_len > 1) {
-        ov_qsort(entries, entries_len, sizeof(entries[0]), compare_ini_entry_info_by_line, NULL);
-      }
+  // Stop at the next section header
+  while (ptk_ini_scanner_next(&scanner) && scanner.name) {
+    if (scanner.name_len == sizeof(excluded_key) - 1 && strncmp(scanner.name, excluded_key, scanner.name_len) == 0) {
+      continue;
     }
-
-    // Second pass: add entries to params array in sorted order
-    {
-      size_t const entries_len = OV_ARRAY_LENGTH(entries);
-      for (size_t i = 0; i < entries_len; i++) {
-        struct ini_entry_info const *e = &entries[i];
-        if (!add_param_entry(params, e->name, e->name_len, e->value, e->value_len, err)) {
-          OV_ERROR_ADD_TRACE(err);
-          goto cleanup;
-        }
-      }
+    struct ptk_ini_value const val = ptk_ini_scanner_get_value(&scanner);
+    if (!add_param_entry(params, scanner.name, scanner.name_len, val.ptr, val.size, err)) {
+      OV_ERROR_ADD_TRACE(err);
+      return false;
     }
   }
-
-  success = true;
-
-cleanup:
-  if (entries) {
-    OV_ARRAY_DESTROY(&entries);
-  }
-  return success;
+  return true;
 }
 
 bool ptk_alias_extract_animation(char const *const alias,
@@ -785,25 +971,13 @@ bool ptk_alias_extract_animation(char const *const alias,
     return false;
   }
 
-  struct ptk_ini_reader *reader = NULL;
-  char section[64];
-  size_t section_len = 0;
+  struct ptk_ini_scanner section;
   bool success = false;
 
   memset(anim, 0, sizeof(*anim));
 
   {
-    if (!ptk_ini_reader_create(&reader, err)) {
-      OV_ERROR_ADD_TRACE(err);
-      goto cleanup;
-    }
-
-    if (!ptk_ini_reader_load_memory(reader, alias, alias_len, err)) {
-      OV_ERROR_ADD_TRACE(err);
-      goto cleanup;
-    }
-
-    if (!find_effect_section(reader, effect_name, section, sizeof(section), &section_len)) {
+    if (!find_effect_section(alias, alias_len, effect_name, &section)) {
       OV_ERROR_SETF(err,
                     ov_error_type_generic,
                     ov_error_generic_fail,
@@ -823,7 +997,7 @@ bool ptk_alias_extract_animation(char const *const alias,
       goto cleanup;
     }
 
-    if (!collect_all_params_from_section(reader, section, section_len, &anim->params, err)) {
+    if (!collect_all_params_from_section(&section, &anim->params, err)) {
       OV_ERROR_ADD_TRACE(err);
       goto cleanup;
     }
@@ -832,9 +1006,6 @@ bool ptk_alias_extract_animation(char const *const alias,
   success = true;
 
 cleanup:
-  if (reader) {
-    ptk_ini_reader_destroy(&reader);
-  }
   if (!success) {
     ptk_alias_extracted_animation_free(anim);
     memset(anim, 0, sizeof(*anim));
@@ -2,6 +2,8 @@
 
 #include <ovbase.h>
 
+struct ov_hashmap;
+
 /**
  * @brief Custom error codes for alias processing
  *
@@ -57,6 +59,7 @@ struct ptk_alias_script_definition {
  */
 struct ptk_alias_script_definitions {
   struct ptk_alias_script_definition *items; // ovarray
+  struct ov_hashmap *effect_index;           // effect_name -> index in items, NULL when not built
 };
 
 /**
@@ -78,6 +81,47 @@ void ptk_alias_script_definitions_free(struct ptk_alias_script_definitions *defs
  */
 NODISCARD bool ptk_alias_load_script_definitions(struct ptk_alias_script_definitions *defs, struct ov_error *err);
 
+/**
+ * @brief Persistent catalog of script definitions
+ *
+ * Loads the definitions once on a background thread and reloads them only when
+ * the size or last write time of PSDToolKit.ini or PSDToolKit.user.ini changes.
+ */
+struct ptk_alias_script_catalog;
+
+/**
+ * @brief Create a script catalog and start loading it in the background
+ *
+ * @param config_dir Directory containing the INI files, ending with a path separator,
+ *                   or NULL to use the directory of the DLL
+ * @param err [out] Error information on failure
+ * @return Catalog on success, NULL on failure
+ */
+NODISCARD struct ptk_alias_script_catalog *ptk_alias_script_catalog_create(NATIVE_CHAR const *config_dir,
+                                                                           struct ov_error *err);
+
+/**
+ * @brief Destroy a script catalog
+ *
+ * @param catalog Pointer to catalog to destroy, will be set to NULL
+ */
+void ptk_alias_script_catalog_destroy(struct ptk_alias_script_catalog **catalog);
+
+/**
+ * @brief Get the current script definitions
+ *
+ * Waits for the background load if it is still running, then reloads the
+ * definitions if the INI files changed since the last load.
+ * The returned definitions are owned by the catalog and stay valid until
+ * the next call or until the catalog is destroyed.
+ *
+ * @param catalog Catalog
+ * @param err [out] Error information on failure
+ * @return Definitions on success, NULL on failure
+ */
+NODISCARD struct ptk_alias_script_definitions const *
+ptk_alias_script_catalog_get(struct ptk_alias_script_catalog *catalog, struct ov_error *err);
+
 /**
  * @brief Available script for import
  *
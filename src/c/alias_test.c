@@ -21,6 +21,9 @@
 #include <stdio.h>
 #include <string.h>
 
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+
 static void test_enumerate_available_scripts(void) {
   struct ov_error err = {0};
   struct ptk_alias_script_definitions defs = {0};
@@ -386,11 +389,139 @@ static void test_extract_animation_not_found(void) {
   ptk_alias_extracted_animation_free(&anim);
 }
 
+static bool write_catalog_file(wchar_t const *dir, wchar_t const *name, char const *text) {
+  wchar_t path[MAX_PATH];
+  if (wcslen(dir) + wcslen(name) >= MAX_PATH) {
+    return false;
+  }
+  wcscpy(path, dir);
+  wcscat(path, name);
+  FILE *f = _wfopen(path, L"wb");
+  if (!f) {
+    return false;
+  }
+  size_t const len = strlen(text);
+  bool const ok = fwrite(text, 1, len, f) == len;
+  fclose(f);
+  return ok;
+}
+
+static void delete_catalog_file(wchar_t const *dir, wchar_t const *name) {
+  wchar_t path[MAX_PATH];
+  wcscpy(path, dir);
+  wcscat(path, name);
+  DeleteFileW(path);
+}
+
+static void test_script_catalog(void) {
+  struct ov_error err = {0};
+  struct ptk_alias_script_catalog *catalog = NULL;
+  struct ptk_alias_available_scripts scripts = {0};
+  struct ptk_alias_script_definitions const *defs = NULL;
+  struct ptk_alias_script_definition const *items = NULL;
+  char *alias_data = NULL;
+  size_t alias_len = 0;
+  wchar_t dir[MAX_PATH];
+  bool dir_created = false;
+
+  {
+    DWORD const len = GetTempPathW(MAX_PATH, dir);
+    if (!TEST_CHECK(len > 0 && len + 32 < MAX_PATH)) {
+      return;
+    }
+    wcscat(dir, L"ptk_alias_catalog_test\\");
+    CreateDirectoryW(dir, NULL);
+    dir_created = true;
+  }
+
+  if (!TEST_CHECK(write_catalog_file(dir,
+                                     L"PSDToolKit.ini",
+                                     "[anm2Editor.AnimationScripts]\r\n"
+                                     "PSDToolKit.Blinker=目パチ@PSDToolKit\r\n"
+                                     "PSDToolKit.LipSync=口パク 開閉のみ@PSDToolKit\r\n"))) {
+    goto cleanup;
+  }
+
+  catalog = ptk_alias_script_catalog_create(dir, &err);
+  if (!TEST_SUCCEEDED(catalog != NULL, &err)) {
+    goto cleanup;
+  }
+
+  defs = ptk_alias_script_catalog_get(catalog, &err);
+  if (!TEST_SUCCEEDED(defs != NULL, &err)) {
+    goto cleanup;
+  }
+  TEST_CHECK(OV_ARRAY_LENGTH(defs->items) == 2);
+  TEST_MSG("want 2, got %zu", OV_ARRAY_LENGTH(defs->items));
+  TEST_CHECK(defs->effect_index != NULL);
+  items = defs->items;
+
+  // Unchanged files are not reloaded
+  defs = ptk_alias_script_catalog_get(catalog, &err);
+  if (!TEST_SUCCEEDED(defs != NULL, &err)) {
+    goto cleanup;
+  }
+  TEST_CHECK(defs->items == items);
+  TEST_MSG("definitions should be reused while the INI files are unchanged");
+
+  // Adding the user file triggers a reload
+  if (!TEST_CHECK(write_catalog_file(dir,
+                                     L"PSDToolKit.user.ini",
+                                     "[anm2Editor.AnimationScripts]\r\n"
+                                     "PSDToolKit.Blinker=目パチ@PSDToolKit\r\n"
+                                     "PSDToolKit.LipSyncLab=口パク あいうえお@PSDToolKit\r\n"))) {
+    goto cleanup;
+  }
+  defs = ptk_alias_script_catalog_get(catalog, &err);
+  if (!TEST_SUCCEEDED(defs != NULL, &err)) {
+    goto cleanup;
+  }
+  TEST_CHECK(OV_ARRAY_LENGTH(defs->items) == 3);
+  TEST_MSG("want 3, got %zu", OV_ARRAY_LENGTH(defs->items));
+
+  // Enumeration through the effect name index finds the same scripts as a linear search
+  {
+    FILE *f = fopen(TEST_PATH("alias/realdata.object"), "rb");
+    if (!TEST_CHECK(f != NULL)) {
+      TEST_MSG("Failed to open realdata.object");
+      goto cleanup;
+    }
+    fseek(f, 0, SEEK_END);
+    long const size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    if (!OV_REALLOC(&alias_data, (size_t)size + 1, sizeof(char))) {
+      fclose(f);
+      goto cleanup;
+    }
+    alias_len = fread(alias_data, 1, (size_t)size, f);
+    alias_data[alias_len] = '\0';
+    fclose(f);
+  }
+  if (!TEST_SUCCEEDED(ptk_alias_enumerate_available_scripts(alias_data, alias_len, defs, &scripts, &err), &err)) {
+    goto cleanup;
+  }
+  TEST_CHECK(OV_ARRAY_LENGTH(scripts.items) == 3);
+  TEST_MSG("want 3, got %zu", OV_ARRAY_LENGTH(scripts.items));
+
+cleanup:
+  ptk_alias_available_scripts_free(&scripts);
+  if (alias_data) {
+    OV_FREE(&alias_data);
+  }
+  ptk_alias_script_catalog_destroy(&catalog);
+  if (dir_created) {
+    delete_catalog_file(dir, L"PSDToolKit.ini");
+    delete_catalog_file(dir, L"PSDToolKit.user.ini");
+    RemoveDirectoryW(dir);
+  }
+}
+
 TEST_LIST = {
     {"enumerate_available_scripts", test_enumerate_available_scripts},
     {"enumerate_available_scripts_partial", test_enumerate_available_scripts_partial},
     {"extract_animation_from_alias_blinker", test_extract_animation_from_alias_blinker},
     {"extract_animation_from_alias_lipsync_lab", test_extract_animation_from_alias_lipsync_lab},
     {"extract_animation_not_found", test_extract_animation_not_found},
+    {"script_catalog", test_script_catalog},
     {NULL, NULL},
 };
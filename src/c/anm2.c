@@ -2,12 +2,16 @@
 
 #include <ovarray.h>
 #include <ovcyrb64.h>
+#include <ovhashmap.h>
 #include <ovmo.h>
 #include <ovprintf.h>
 #include <ovprintf_ex.h>
 
 #include <ovl/file.h>
 
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+
 #include "json.h"
 
 // JSON metadata prefix/suffix
@@ -16,6 +20,9 @@ static char const json_suffix[] = "]==]";
 
 static size_t const json_prefix_len = sizeof(json_prefix) - 1;
 
+// Default memory budget for undo history
+static size_t const default_undo_memory_limit = 64 * 1024 * 1024;
+
 struct param {
   uint32_t id;
   uintptr_t userdata;
@@ -39,10 +46,26 @@ struct selector {
   struct item *items; // ovarray
 };
 
+enum element_kind {
+  element_kind_selector,
+  element_kind_item,
+  element_kind_param,
+};
+
+// Location of an element, looked up by ID.
+// Positions are relative to the parent so that moving a selector or an item
+// does not require reindexing everything it contains.
+struct id_location {
+  uint32_t id;
+  enum element_kind kind;
+  uint32_t parent_id; // Selector ID for items, item ID for params
+  size_t idx;         // Position in doc->selectors, sel->items or it->params
+};
+
 // enum ptk_anm2_op_type is now defined in anm2.h
 
 struct ptk_anm2_op {
-  uint32_t id;        // ID of affected element
+  uint32_t id;        // ID of affected element (for transaction markers: non-zero if the group is a batch)
   uint32_t parent_id; // Parent ID (selector for item, item for param)
   uint32_t before_id; // For insert/move: ID of element before which to insert (0=end)
   enum ptk_anm2_op_type type;
@@ -59,9 +82,15 @@ struct ptk_anm2 {
   char *default_character_id;     // Default character ID for multi-script format
   bool exclusive_support_default; // Default value for exclusive support control checkbox
   struct selector *selectors;     // ovarray
+  struct ov_hashmap *id_index;    // ID -> struct id_location, kept in sync by apply_op
+  bool id_index_stale;            // true if updating id_index failed, lookups fall back to scanning
   struct ptk_anm2_op *undo_stack; // ovarray
   struct ptk_anm2_op *redo_stack; // ovarray
+  size_t undo_memory_usage;       // Estimated bytes held by undo_stack
+  size_t undo_memory_limit;       // 0 = unlimited
   int transaction_depth;
+  int batch_depth;              // > 0 while change notifications are coalesced
+  bool batch_changed;           // true if a change notification was held back during the batch
   uint64_t stored_checksum;     // checksum from JSON metadata (set by load)
   uint64_t calculated_checksum; // checksum calculated from script body (set by load)
   ptk_anm2_change_callback change_callback;
@@ -73,6 +102,106 @@ struct ptk_anm2 {
 
 static uint32_t generate_id(struct ptk_anm2 *const doc) { return doc->next_id++; }
 
+static void get_id_location_key(void const *const item, void const **const key, size_t *const key_bytes) {
+  struct id_location const *const loc = (struct id_location const *)item;
+  *key = &loc->id;
+  *key_bytes = sizeof(loc->id);
+}
+
+static struct id_location const *id_index_get(struct ptk_anm2 const *const doc, uint32_t const id) {
+  struct id_location const key = {.id = id};
+  return (struct id_location const *)OV_HASHMAP_GET(doc->id_index, &key);
+}
+
+static void id_index_set(struct ptk_anm2 *const doc,
+                         uint32_t const id,
+                         enum element_kind const kind,
+                         uint32_t const parent_id,
+                         size_t const idx) {
+  if (doc->id_index_stale) {
+    return;
+  }
+  struct id_location const loc = {
+      .id = id,
+      .kind = kind,
+      .parent_id = parent_id,
+      .idx = idx,
+  };
+  if (!OV_HASHMAP_SET(doc->id_index, &loc)) {
+    doc->id_index_stale = true;
+  }
+}
+
+static void id_index_delete(struct ptk_anm2 *const doc, uint32_t const id) {
+  struct id_location const key = {.id = id};
+  OV_HASHMAP_DELETE(doc->id_index, &key);
+}
+
+// Index params [first, end) of an item
+static void id_index_params(struct ptk_anm2 *const doc, struct item const *const it, size_t const first) {
+  size_t const n = OV_ARRAY_LENGTH(it->params);
+  for (size_t i = first; i < n; i++) {
+    id_index_set(doc, it->params[i].id, element_kind_param, it->id, i);
+  }
+}
+
+// Index items [first, last) of a selector, their params are not affected by the position of the item
+static void
+id_index_items(struct ptk_anm2 *const doc, struct selector const *const sel, size_t const first, size_t const last) {
+  for (size_t i = first; i < last; i++) {
+    id_index_set(doc, sel->items[i].id, element_kind_item, sel->id, i);
+  }
+}
+
+// Index a newly added item and its params
+static void id_index_add_item(struct ptk_anm2 *const doc, struct selector const *const sel, size_t const idx) {
+  id_index_items(doc, sel, idx, idx + 1);
+  id_index_params(doc, &sel->items[idx], 0);
+}
+
+// Index selectors [first, last), their items and params are not affected by the position of the selector
+static void id_index_selectors(struct ptk_anm2 *const doc, size_t const first, size_t const last) {
+  for (size_t i = first; i < last; i++) {
+    id_index_set(doc, doc->selectors[i].id, element_kind_selector, 0, i);
+  }
+}
+
+// Index a newly added selector and everything it contains
+static void id_index_add_selector(struct ptk_anm2 *const doc, size_t const idx) {
+  struct selector const *const sel = &doc->selectors[idx];
+  id_index_selectors(doc, idx, idx + 1);
+  size_t const n = OV_ARRAY_LENGTH(sel->items);
+  for (size_t i = 0; i < n; i++) {
+    id_index_add_item(doc, sel, i);
+  }
+}
+
+static void id_index_delete_item(struct ptk_anm2 *const doc, struct item const *const it) {
+  id_index_delete(doc, it->id);
+  size_t const n = OV_ARRAY_LENGTH(it->params);
+  for (size_t i = 0; i < n; i++) {
+    id_index_delete(doc, it->params[i].id);
+  }
+}
+
+static void id_index_delete_selector(struct ptk_anm2 *const doc, struct selector const *const sel) {
+  id_index_delete(doc, sel->id);
+  size_t const n = OV_ARRAY_LENGTH(sel->items);
+  for (size_t i = 0; i < n; i++) {
+    id_index_delete_item(doc, &sel->items[i]);
+  }
+}
+
+// Rebuild the index from scratch after a failed update
+static void id_index_rebuild(struct ptk_anm2 *const doc) {
+  OV_HASHMAP_CLEAR(doc->id_index);
+  doc->id_index_stale = false;
+  size_t const n = OV_ARRAY_LENGTH(doc->selectors);
+  for (size_t i = 0; i < n; i++) {
+    id_index_add_selector(doc, i);
+  }
+}
+
 static void param_free(struct param *p) {
   if (!p) {
     return;
@@ -162,6 +291,7 @@ static void op_free(struct ptk_anm2_op *op) {
     case ptk_anm2_op_reset:
     case ptk_anm2_op_transaction_begin:
     case ptk_anm2_op_transaction_end:
+    case ptk_anm2_op_batch:
     case ptk_anm2_op_set_label:
     case ptk_anm2_op_set_psd_path:
     case ptk_anm2_op_set_exclusive_support_default:
@@ -193,6 +323,72 @@ static void op_stack_clear(struct ptk_anm2_op **stack) {
   OV_ARRAY_DESTROY(stack);
 }
 
+static size_t str_memory_size(char const *s) { return s ? OV_ARRAY_LENGTH(s) : 0; }
+
+static size_t param_memory_size(struct param const *p) {
+  return sizeof(*p) + str_memory_size(p->key) + str_memory_size(p->value);
+}
+
+static size_t item_memory_size(struct item const *it) {
+  size_t size =
+      sizeof(*it) + str_memory_size(it->script_name) + str_memory_size(it->name) + str_memory_size(it->value);
+  size_t const n = it->params ? OV_ARRAY_LENGTH(it->params) : 0;
+  for (size_t i = 0; i < n; i++) {
+    size += param_memory_size(&it->params[i]);
+  }
+  return size;
+}
+
+static size_t selector_memory_size(struct selector const *sel) {
+  size_t size = sizeof(*sel) + str_memory_size(sel->name);
+  size_t const n = sel->items ? OV_ARRAY_LENGTH(sel->items) : 0;
+  for (size_t i = 0; i < n; i++) {
+    size += item_memory_size(&sel->items[i]);
+  }
+  return size;
+}
+
+// Estimate the memory held by an operation in the undo history
+static size_t op_memory_size(struct ptk_anm2_op const *op) {
+  size_t size = sizeof(*op) + str_memory_size(op->str_data);
+  if (!op->removed_data) {
+    return size;
+  }
+  switch (op->type) {
+  case ptk_anm2_op_selector_insert:
+  case ptk_anm2_op_selector_remove:
+    size += selector_memory_size((struct selector const *)op->removed_data);
+    break;
+  case ptk_anm2_op_item_insert:
+  case ptk_anm2_op_item_remove:
+    size += item_memory_size((struct item const *)op->removed_data);
+    break;
+  case ptk_anm2_op_param_insert:
+  case ptk_anm2_op_param_remove:
+    size += param_memory_size((struct param const *)op->removed_data);
+    break;
+  case ptk_anm2_op_reset:
+  case ptk_anm2_op_transaction_begin:
+  case ptk_anm2_op_transaction_end:
+  case ptk_anm2_op_batch:
+  case ptk_anm2_op_set_label:
+  case ptk_anm2_op_set_psd_path:
+  case ptk_anm2_op_set_exclusive_support_default:
+  case ptk_anm2_op_set_information:
+  case ptk_anm2_op_set_default_character_id:
+  case ptk_anm2_op_selector_set_name:
+  case ptk_anm2_op_selector_move:
+  case ptk_anm2_op_item_set_name:
+  case ptk_anm2_op_item_set_value:
+  case ptk_anm2_op_item_set_script_name:
+  case ptk_anm2_op_item_move:
+  case ptk_anm2_op_param_set_key:
+  case ptk_anm2_op_param_set_value:
+    break;
+  }
+  return size;
+}
+
 static bool strdup_to_array(char **dest, char const *src, struct ov_error *const err) {
   if (!dest) {
     OV_ERROR_SET_GENERIC(err, ov_error_generic_invalid_argument);
@@ -250,11 +446,29 @@ static void notify_change(
   if (op_type != ptk_anm2_op_reset) {
     doc->modified = true;
   }
+  if (doc->batch_depth > 0) {
+    if (op_type != ptk_anm2_op_transaction_begin && op_type != ptk_anm2_op_transaction_end) {
+      doc->batch_changed = true;
+    }
+    return;
+  }
   if (doc->change_callback) {
     doc->change_callback(doc->change_callback_userdata, op_type, id, parent_id, before_id);
   }
 }
 
+// Send the coalesced notification when leaving the outermost batch
+static void batch_leave(struct ptk_anm2 *doc) {
+  doc->batch_depth--;
+  if (doc->batch_depth > 0 || !doc->batch_changed) {
+    return;
+  }
+  doc->batch_changed = false;
+  if (doc->change_callback) {
+    doc->change_callback(doc->change_callback_userdata, ptk_anm2_op_batch, 0, 0, 0);
+  }
+}
+
 void ptk_anm2_set_change_callback(struct ptk_anm2 *doc, ptk_anm2_change_callback callback, void *userdata) {
   if (!doc) {
     return;
@@ -277,53 +491,110 @@ static void notify_state(struct ptk_anm2 const *doc) {
   }
 }
 
-static uint64_t calculate_checksum(char const *const script_body, size_t const body_len) {
+// Incremental cyrb64 checksum of a script body.
+// The body is hashed as 32-bit words with the last word zero-padded,
+// and it can be fed in chunks of any length and alignment without copying the whole body.
+struct body_checksum {
   struct ov_cyrb64 ctx;
-  size_t word_len = 0;
-  uint32_t *aligned_buf = NULL;
-  uint64_t result = 0;
-  bool success = false;
+  size_t start; // Offset of the body in the buffer
+  size_t pos;   // Offset of the first byte not hashed yet
+};
 
-  if (!script_body || body_len == 0) {
-    goto cleanup;
-  }
+static void body_checksum_init(struct body_checksum *const bc, size_t const start) {
+  ov_cyrb64_init(&bc->ctx, 0);
+  bc->start = start;
+  bc->pos = start;
+}
 
-  // Allocate aligned buffer for cyrb64
-  word_len = (body_len + 3) / 4;
-  if (!OV_REALLOC(&aligned_buf, word_len, sizeof(uint32_t))) {
-    goto cleanup;
+// Hash all complete 32-bit words appended since the last call.
+// Aligned input is hashed in place, unaligned input goes through a small stack buffer.
+static void body_checksum_update(struct body_checksum *const bc, char const *const buf, size_t const len) {
+  if (len - bc->pos >= sizeof(uint32_t) && ((uintptr_t)(buf + bc->pos) % sizeof(uint32_t)) == 0) {
+    size_t const n = (len - bc->pos) / sizeof(uint32_t);
+    ov_cyrb64_update(&bc->ctx, (uint32_t const *)(void const *)(buf + bc->pos), n);
+    bc->pos += n * sizeof(uint32_t);
+    return;
+  }
+  uint32_t words[256];
+  while (len - bc->pos >= sizeof(uint32_t)) {
+    size_t n = (len - bc->pos) / sizeof(uint32_t);
+    if (n > sizeof(words) / sizeof(words[0])) {
+      n = sizeof(words) / sizeof(words[0]);
+    }
+    memcpy(words, buf + bc->pos, n * sizeof(uint32_t));
+    ov_cyrb64_update(&bc->ctx, words, n);
+    bc->pos += n * sizeof(uint32_t);
   }
-  memset(aligned_buf, 0, word_len * sizeof(uint32_t));
-  memcpy(aligned_buf, script_body, body_len);
+}
 
-  ov_cyrb64_init(&ctx, 0);
-  ov_cyrb64_update(&ctx, aligned_buf, word_len);
-  result = ov_cyrb64_final(&ctx);
+// Hash the remaining bytes, zero-padded to a whole word
+static uint64_t body_checksum_final(struct body_checksum *const bc, char const *const buf, size_t const len) {
+  if (len == bc->start) {
+    return 0;
+  }
+  body_checksum_update(bc, buf, len);
+  if (bc->pos < len) {
+    uint32_t word = 0;
+    memcpy(&word, buf + bc->pos, len - bc->pos);
+    ov_cyrb64_update(&bc->ctx, &word, 1);
+    bc->pos = len;
+  }
+  return ov_cyrb64_final(&bc->ctx);
+}
 
-  success = true;
+static uint64_t calculate_checksum(char const *const script_body, size_t const body_len) {
+  if (!script_body || body_len == 0) {
+    return 0;
+  }
+  struct body_checksum bc;
+  body_checksum_init(&bc, 0);
+  return body_checksum_final(&bc, script_body, body_len);
+}
 
-cleanup:
-  if (aligned_buf) {
-    OV_FREE(&aligned_buf);
+// Reserve room for appending n bytes and a NUL terminator to an ovarray string.
+// Capacity grows geometrically so that repeated appends stay linear.
+static bool string_reserve(char **const dest, size_t const n, struct ov_error *const err) {
+  size_t const len = OV_ARRAY_LENGTH(*dest);
+  size_t const cap = OV_ARRAY_CAPACITY(*dest);
+  if (len + n + 1 <= cap) {
+    return true;
   }
-  if (!success) {
-    return 0;
+  size_t new_cap = cap * 2;
+  if (new_cap < len + n + 1) {
+    new_cap = len + n + 1;
   }
-  return result;
+  if (!OV_ARRAY_GROW(dest, new_cap)) {
+    OV_ERROR_SET_GENERIC(err, ov_error_generic_out_of_memory);
+    return false;
+  }
+  return true;
 }
 
-static bool escape_lua_string(char **const dest, char const *const src, struct ov_error *const err) {
-  size_t src_len = 0;
-  size_t j = 0;
+// Append src to an ovarray string.
+// OV_ARRAY_LENGTH is the string length (not including NUL terminator).
+static bool string_append(char **const dest, char const *const src, struct ov_error *const err) {
+  size_t const n = strlen(src);
+  if (!string_reserve(dest, n, err)) {
+    OV_ERROR_ADD_TRACE(err);
+    return false;
+  }
+  size_t const len = OV_ARRAY_LENGTH(*dest);
+  memcpy(*dest + len, src, n + 1);
+  OV_ARRAY_SET_LENGTH(*dest, len + n);
+  return true;
+}
 
-  src_len = strlen(src);
-  if (!OV_ARRAY_GROW(dest, src_len * 2 + 3)) {
-    OV_ERROR_SET_GENERIC(err, ov_error_generic_out_of_memory);
+// Append src as a quoted and escaped Lua string literal
+static bool append_lua_string(char **const dest, char const *const src, struct ov_error *const err) {
+  size_t const src_len = strlen(src);
+  if (!string_reserve(dest, src_len * 2 + 2, err)) {
+    OV_ERROR_ADD_TRACE(err);
     return false;
   }
 
-  j = 0;
-  (*dest)[j++] = '"';
+  char *const out = *dest;
+  size_t j = OV_ARRAY_LENGTH(*dest);
+  out[j++] = '"';
   for (size_t i = 0; i < src_len; i++) {
     char const c = src[i];
     char escaped = 0;
@@ -359,130 +630,114 @@ static bool escape_lua_string(char **const dest, char const *const src, struct o
       escaped = '\\';
       break;
     default:
-      (*dest)[j++] = c;
+      out[j++] = c;
       continue;
     }
-    (*dest)[j++] = '\\';
-    (*dest)[j++] = escaped;
+    out[j++] = '\\';
+    out[j++] = escaped;
   }
-  (*dest)[j++] = '"';
-  (*dest)[j] = '\0';
-  OV_ARRAY_SET_LENGTH(*dest, j + 1);
+  out[j++] = '"';
+  out[j] = '\0';
+  OV_ARRAY_SET_LENGTH(*dest, j);
   return true;
 }
 
-// Sanitize display name for --select@ format
+// Append display name for --select@ format
 // Replaces '=' with '＝' (U+FF1D) and ',' with '，' (U+FF0C)
 // to avoid breaking the selector syntax.
-// The dest buffer is reused; caller must destroy it after all calls.
-// OV_ARRAY_LENGTH returns the string length (not including NUL terminator).
-static bool sanitize_selector_name(char **const dest, char const *const src, struct ov_error *const err) {
-  OV_ARRAY_SET_LENGTH(*dest, 0);
-  if (!src || src[0] == '\0') {
-    return true;
+static bool append_selector_name(char **const dest, char const *const src, struct ov_error *const err) {
+  size_t const src_len = strlen(src);
+  if (!string_reserve(dest, src_len * 3, err)) {
+    OV_ERROR_ADD_TRACE(err);
+    return false;
   }
 
-  size_t const src_len = strlen(src);
-  size_t j = 0;
+  char *const out = *dest;
+  size_t j = OV_ARRAY_LENGTH(*dest);
   for (size_t i = 0; i < src_len; i++) {
     unsigned char const c = (unsigned char)src[i];
-    size_t const need = (c == '=' || c == ',') ? 3 : 1;
-    if (j + need + 1 > OV_ARRAY_CAPACITY(*dest)) {
-      size_t const new_cap = (OV_ARRAY_CAPACITY(*dest) + need + 1) * 2;
-      if (!OV_ARRAY_GROW(dest, new_cap)) {
-        OV_ERROR_SET_GENERIC(err, ov_error_generic_out_of_memory);
-        return false;
-      }
-    }
     if (c == '=') {
       // '=' -> '＝' (U+FF1D: 0xEF 0xBC 0x9D)
-      (*dest)[j++] = (char)0xEF;
-      (*dest)[j++] = (char)0xBC;
-      (*dest)[j++] = (char)0x9D;
+      out[j++] = (char)0xEF;
+      out[j++] = (char)0xBC;
+      out[j++] = (char)0x9D;
     } else if (c == ',') {
       // ',' -> '，' (U+FF0C: 0xEF 0xBC 0x8C)
-      (*dest)[j++] = (char)0xEF;
-      (*dest)[j++] = (char)0xBC;
-      (*dest)[j++] = (char)0x8C;
+      out[j++] = (char)0xEF;
+      out[j++] = (char)0xBC;
+      out[j++] = (char)0x8C;
     } else {
-      (*dest)[j++] = (char)c;
+      out[j++] = (char)c;
     }
   }
-  (*dest)[j] = '\0';
+  out[j] = '\0';
   OV_ARRAY_SET_LENGTH(*dest, j);
   return true;
 }
 
-// Helper function for generating a single param line
-// escaped is reused buffer, caller must destroy it after all calls
-static bool generate_param_line(char **const content,
-                                struct param const *const param,
-                                char **const escaped,
-                                struct ov_error *const err) {
-  // Escape key for Lua (use ["key"] syntax for safety with special chars)
-  if (!escape_lua_string(escaped, param->key ? param->key : "", err)) {
+// Append ",name=index" option for --select@ lines
+static bool append_selector_option(char **const dest,
+                                   char const *const display_name,
+                                   size_t const index,
+                                   struct ov_error *const err) {
+  if (!string_append(dest, ",", err) || !append_selector_name(dest, display_name, err)) {
     OV_ERROR_ADD_TRACE(err);
     return false;
   }
-  if (!ov_sprintf_append_char(content, err, "%1$s", "    [%1$s] = ", *escaped)) {
+  if (!ov_sprintf_append_char(dest, err, "%1$zu", "=%1$zu", index)) {
     OV_ERROR_ADD_TRACE(err);
     return false;
   }
+  return true;
+}
 
-  // Escape value for Lua (reuse buffer)
-  if (!escape_lua_string(escaped, param->value ? param->value : "", err)) {
-    OV_ERROR_ADD_TRACE(err);
-    return false;
-  }
-  if (!ov_sprintf_append_char(content, err, "%1$s", "%1$s,\n", *escaped)) {
+// Helper function for generating a single param line
+static bool generate_param_line(char **const content, struct param const *const param, struct ov_error *const err) {
+  // Escape key and value for Lua (use ["key"] syntax for safety with special chars)
+  if (!string_append(content, "    [", err) || !append_lua_string(content, param->key ? param->key : "", err) ||
+      !string_append(content, "] = ", err) || !append_lua_string(content, param->value ? param->value : "", err) ||
+      !string_append(content, ",\n", err)) {
     OV_ERROR_ADD_TRACE(err);
     return false;
   }
-
   return true;
 }
 
 // Generate animation code from script_name and params
 // Output format: require("script_name").new({ ["key"] = "value", ... }),
 static bool generate_animation_code(char **const content, struct item const *const item, struct ov_error *const err) {
-  char *escaped = NULL;
-  bool success = false;
-
   // require("script_name").new({
-  if (!ov_sprintf_append_char(content, err, "%1$s", "  require(\"%1$s\").new({\n", item->script_name)) {
+  if (!string_append(content, "  require(\"", err) || !string_append(content, item->script_name, err) ||
+      !string_append(content, "\").new({\n", err)) {
     OV_ERROR_ADD_TRACE(err);
-    goto cleanup;
+    return false;
   }
 
   // Output params as key-value pairs
-  {
-    size_t const params_len = OV_ARRAY_LENGTH(item->params);
-    for (size_t i = 0; i < params_len; i++) {
-      if (!generate_param_line(content, &item->params[i], &escaped, err)) {
-        OV_ERROR_ADD_TRACE(err);
-        goto cleanup;
-      }
+  size_t const params_len = OV_ARRAY_LENGTH(item->params);
+  for (size_t i = 0; i < params_len; i++) {
+    if (!generate_param_line(content, &item->params[i], err)) {
+      OV_ERROR_ADD_TRACE(err);
+      return false;
     }
   }
 
   // Close the table and function call
-  if (!ov_sprintf_append_char(content, err, NULL, "  }),\n")) {
+  if (!string_append(content, "  }),\n", err)) {
     OV_ERROR_ADD_TRACE(err);
-    goto cleanup;
-  }
-
-  success = true;
-
-cleanup:
-  if (escaped) {
-    OV_ARRAY_DESTROY(&escaped);
+    return false;
   }
-  return success;
+  return true;
 }
 
+// Append the JSON metadata line.
+// If checksum_pos is not NULL, it receives the offset in *content of the 16 hex digits of the checksum
+// so that the caller can patch them after the body is written.
+// Document strings are borrowed rather than copied, they only need to outlive the JSON writer.
 static bool generate_json_line(char **const content,
                                struct ptk_anm2 const *const doc,
                                uint64_t const checksum,
+                               size_t *const checksum_pos,
                                struct ov_error *const err) {
   yyjson_mut_doc *jdoc = NULL;
   yyjson_mut_val *root = NULL;
@@ -515,7 +770,7 @@ static bool generate_json_line(char **const content,
     for (size_t i = 0; i < selectors_len; i++) {
       struct selector const *const sel = &doc->selectors[i];
       yyjson_mut_val *sel_obj = yyjson_mut_obj(jdoc);
-      yyjson_mut_obj_add_strcpy(jdoc, sel_obj, "group", sel->name);
+      yyjson_mut_obj_add_str(jdoc, sel_obj, "group", sel->name);
 
       yyjson_mut_val *items = yyjson_mut_arr(jdoc);
       size_t const items_len = OV_ARRAY_LENGTH(sel->items);
@@ -525,9 +780,9 @@ static bool generate_json_line(char **const content,
         if (item->script_name) {
           // Animation item: {script: "name", n: "display name", params: [[key, value], ...]}
           yyjson_mut_val *item_obj = yyjson_mut_obj(jdoc);
-          yyjson_mut_obj_add_strcpy(jdoc, item_obj, "script", item->script_name);
+          yyjson_mut_obj_add_str(jdoc, item_obj, "script", item->script_name);
           if (item->name) {
-            yyjson_mut_obj_add_strcpy(jdoc, item_obj, "n", item->name);
+            yyjson_mut_obj_add_str(jdoc, item_obj, "n", item->name);
           }
 
           yyjson_mut_val *params_arr = yyjson_mut_arr(jdoc);
@@ -535,8 +790,8 @@ static bool generate_json_line(char **const content,
           for (size_t k = 0; k < params_len; k++) {
             struct param const *const p = &item->params[k];
             yyjson_mut_val *param_tuple = yyjson_mut_arr(jdoc);
-            yyjson_mut_arr_add_strcpy(jdoc, param_tuple, p->key ? p->key : "");
-            yyjson_mut_arr_add_strcpy(jdoc, param_tuple, p->value ? p->value : "");
+            yyjson_mut_arr_add_str(jdoc, param_tuple, p->key ? p->key : "");
+            yyjson_mut_arr_add_str(jdoc, param_tuple, p->value ? p->value : "");
             yyjson_mut_arr_add_val(params_arr, param_tuple);
           }
           yyjson_mut_obj_add_val(jdoc, item_obj, "params", params_arr);
@@ -544,8 +799,8 @@ static bool generate_json_line(char **const content,
         } else {
           // Value item: [name, value]
           yyjson_mut_val *item_arr = yyjson_mut_arr(jdoc);
-          yyjson_mut_arr_add_strcpy(jdoc, item_arr, item->name);
-          yyjson_mut_arr_add_strcpy(jdoc, item_arr, item->value);
+          yyjson_mut_arr_add_str(jdoc, item_arr, item->name);
+          yyjson_mut_arr_add_str(jdoc, item_arr, item->value);
           yyjson_mut_arr_add_val(items, item_arr);
         }
       }
@@ -557,12 +812,12 @@ static bool generate_json_line(char **const content,
 
   // psd path (required)
   if (doc->psd_path) {
-    yyjson_mut_obj_add_strcpy(jdoc, root, "psd", doc->psd_path);
+    yyjson_mut_obj_add_str(jdoc, root, "psd", doc->psd_path);
   }
 
   // label
   if (doc->label && doc->label[0] != '\0') {
-    yyjson_mut_obj_add_strcpy(jdoc, root, "label", doc->label);
+    yyjson_mut_obj_add_str(jdoc, root, "label", doc->label);
   }
 
   // exclusive_support_default (only store if false, true is the default)
@@ -572,12 +827,12 @@ static bool generate_json_line(char **const content,
 
   // information (only store if custom, NULL means auto-generate)
   if (doc->information && doc->information[0] != '\0') {
-    yyjson_mut_obj_add_strcpy(jdoc, root, "information", doc->information);
+    yyjson_mut_obj_add_str(jdoc, root, "information", doc->information);
   }
 
   // default_character_id (only store if set)
   if (doc->default_character_id && doc->default_character_id[0] != '\0') {
-    yyjson_mut_obj_add_strcpy(jdoc, root, "defaultCharacterId", doc->default_character_id);
+    yyjson_mut_obj_add_str(jdoc, root, "defaultCharacterId", doc->default_character_id);
   }
 
   // Write JSON to string using custom allocator
@@ -597,6 +852,17 @@ static bool generate_json_line(char **const content,
     goto cleanup;
   }
 
+  // version is written first and cannot contain the key, so the first match is the checksum
+  if (checksum_pos) {
+    static char const checksum_key[] = "\"checksum\":\"";
+    char const *const found = strstr(json_str, checksum_key);
+    if (!found) {
+      OV_ERROR_SET_GENERIC(err, ov_error_generic_fail);
+      goto cleanup;
+    }
+    *checksum_pos = OV_ARRAY_LENGTH(*content) + json_prefix_len + (size_t)(found - json_str) + sizeof(checksum_key) - 1;
+  }
+
   // Format: --[==[PTK:{json}]==]\n
   if (!ov_sprintf_append_char(content, err, "%1$s%2$s%3$s", "%1$s%2$s%3$s\n", json_prefix, json_str, json_suffix)) {
     OV_ERROR_ADD_TRACE(err);
@@ -615,16 +881,53 @@ cleanup:
   return success;
 }
 
+// Rough upper bound of the generated script size.
+// Every string is written once to the JSON line and about once to the body,
+// and escaping rarely more than doubles it.
+static size_t estimate_script_size(struct ptk_anm2 const *const doc) {
+  size_t size = 1024 + 3 * (str_memory_size(doc->label) + str_memory_size(doc->psd_path) +
+                            str_memory_size(doc->information) + str_memory_size(doc->default_character_id));
+  size_t const selectors_len = OV_ARRAY_LENGTH(doc->selectors);
+  for (size_t i = 0; i < selectors_len; i++) {
+    struct selector const *const sel = &doc->selectors[i];
+    size += 160 + 2 * str_memory_size(sel->name);
+    size_t const items_len = OV_ARRAY_LENGTH(sel->items);
+    for (size_t j = 0; j < items_len; j++) {
+      struct item const *const item = &sel->items[j];
+      size += 64 + 3 * (str_memory_size(item->name) + str_memory_size(item->script_name) +
+                        str_memory_size(item->value));
+      size_t const params_len = OV_ARRAY_LENGTH(item->params);
+      for (size_t k = 0; k < params_len; k++) {
+        size += 32 + 3 * (str_memory_size(item->params[k].key) + str_memory_size(item->params[k].value));
+      }
+    }
+  }
+  return size;
+}
+
+// Append the script to *content.
+// The JSON line is written first with a placeholder checksum, the body is hashed while it is appended,
+// and then the checksum digits are patched in place, so the body is never built or copied separately.
 static bool
 generate_script_content(struct ptk_anm2 const *const doc, char **const content, struct ov_error *const err) {
-  char *escaped = NULL;
-  char *sanitized = NULL;
-  char *body = NULL;
+  struct body_checksum bc;
+  size_t checksum_pos = 0;
   bool success = false;
 
+  if (!string_reserve(content, estimate_script_size(doc), err)) {
+    OV_ERROR_ADD_TRACE(err);
+    goto cleanup;
+  }
+
+  if (!generate_json_line(content, doc, 0, &checksum_pos, err)) {
+    OV_ERROR_ADD_TRACE(err);
+    goto cleanup;
+  }
+  body_checksum_init(&bc, OV_ARRAY_LENGTH(*content));
+
   // --label: line (only if label is set and not empty)
   if (doc->label && doc->label[0] != '\0') {
-    if (!ov_sprintf_append_char(&body, err, "%1$hs", "--label:%1$hs\n", doc->label)) {
+    if (!ov_sprintf_append_char(content, err, "%1$hs", "--label:%1$hs\n", doc->label)) {
       OV_ERROR_ADD_TRACE(err);
       goto cleanup;
     }
@@ -634,7 +937,7 @@ generate_script_content(struct ptk_anm2 const *const doc, char **const content,
   {
     if (doc->information && doc->information[0] != '\0') {
       // Use custom information text
-      if (!ov_sprintf_append_char(&body, err, "%1$s", "--information:%1$s\n", doc->information)) {
+      if (!ov_sprintf_append_char(content, err, "%1$s", "--information:%1$s\n", doc->information)) {
         OV_ERROR_ADD_TRACE(err);
         goto cleanup;
       }
@@ -652,7 +955,7 @@ generate_script_content(struct ptk_anm2 const *const doc, char **const content,
       if (filename && filename[0] != '\0') {
         char info[256];
         ov_snprintf_char(info, sizeof(info), "%1$hs", pgettext(".ptk.anm2", "PSD Layer Selector for %1$hs"), filename);
-        if (!ov_sprintf_append_char(&body, err, "%1$hs", "--information:%1$hs\n", info)) {
+        if (!ov_sprintf_append_char(content, err, "%1$hs", "--information:%1$hs\n", info)) {
           OV_ERROR_ADD_TRACE(err);
           goto cleanup;
         }
@@ -662,7 +965,7 @@ generate_script_content(struct ptk_anm2 const *const doc, char **const content,
 
   // --check@exclusive: line for exclusive support
   {
-    if (!ov_sprintf_append_char(&body,
+    if (!ov_sprintf_append_char(content,
                                 err,
                                 "%1$hs%2$d",
                                 "--check@exclusive:%1$hs,%2$d\n",
@@ -690,14 +993,14 @@ generate_script_content(struct ptk_anm2 const *const doc, char **const content,
       // Use fallback name if group is NULL (should not happen, but safety measure)
       char const *const group_name =
           sel->name ? sel->name : pgettext(".ptk.anm2 default name for unnamed selector", "Selector");
-      if (!ov_sprintf_append_char(&body, err, "%1$zu%2$hs", "--select@sel%1$zu:%2$hs", i + 1, group_name)) {
+      if (!ov_sprintf_append_char(content, err, "%1$zu%2$hs", "--select@sel%1$zu:%2$hs", i + 1, group_name)) {
         OV_ERROR_ADD_TRACE(err);
         goto cleanup;
       }
 
       // Insert a "(None)" option as the first item for selectors
       if (!ov_sprintf_append_char(
-              &body, err, "%1$hs", ",%1$hs=0", pgettext(".ptk.anm2 Unselected item name for selector", "(None)"))) {
+              content, err, "%1$hs", ",%1$hs=0", pgettext(".ptk.anm2 Unselected item name for selector", "(None)"))) {
         OV_ERROR_ADD_TRACE(err);
         goto cleanup;
       }
@@ -710,18 +1013,14 @@ generate_script_content(struct ptk_anm2 const *const doc, char **const content,
           display_name = item->script_name;
         }
         if (display_name && display_name[0] != '\0') {
-          if (!sanitize_selector_name(&sanitized, display_name, err)) {
-            OV_ERROR_ADD_TRACE(err);
-            goto cleanup;
-          }
-          if (!ov_sprintf_append_char(&body, err, "%1$s%2$zu", ",%1$s=%2$zu", sanitized, j + 1)) {
+          if (!append_selector_option(content, display_name, j + 1, err)) {
             OV_ERROR_ADD_TRACE(err);
             goto cleanup;
           }
         }
       }
 
-      if (!ov_sprintf_append_char(&body, err, NULL, "\n")) {
+      if (!ov_sprintf_append_char(content, err, NULL, "\n")) {
         OV_ERROR_ADD_TRACE(err);
         goto cleanup;
       }
@@ -744,7 +1043,7 @@ generate_script_content(struct ptk_anm2 const *const doc, char **const content,
 
     // Only wrap with psdcall if there are selectors to generate
     if (has_selectors) {
-      if (!ov_sprintf_append_char(&body, err, NULL, "require(\"PSDToolKit\").psdcall(function()\n")) {
+      if (!ov_sprintf_append_char(content, err, NULL, "require(\"PSDToolKit\").psdcall(function()\n")) {
         OV_ERROR_ADD_TRACE(err);
         goto cleanup;
       }
@@ -762,7 +1061,7 @@ generate_script_content(struct ptk_anm2 const *const doc, char **const content,
       cache_index++;
 
       // require("PSDToolKit").add_layer_selector(N, function() return {
-      if (!ov_sprintf_append_char(&body,
+      if (!ov_sprintf_append_char(content,
                                   err,
                                   "%1$zu",
                                   "require(\"PSDToolKit\").add_layer_selector(%1$zu, function() return {\n",
@@ -776,26 +1075,24 @@ generate_script_content(struct ptk_anm2 const *const doc, char **const content,
         struct item const *const item = &sel->items[j];
         if (item->script_name) {
           // Animation item
-          if (!generate_animation_code(&body, item, err)) {
+          if (!generate_animation_code(content, item, err)) {
             OV_ERROR_ADD_TRACE(err);
             goto cleanup;
           }
         } else {
           // Value item
-          if (!escape_lua_string(&escaped, item->value ? item->value : "", err)) {
-            OV_ERROR_ADD_TRACE(err);
-            goto cleanup;
-          }
-          if (!ov_sprintf_append_char(&body, err, "%1$s", "  %1$s,\n", escaped)) {
+          if (!string_append(content, "  ", err) ||
+              !append_lua_string(content, item->value ? item->value : "", err) ||
+              !string_append(content, ",\n", err)) {
             OV_ERROR_ADD_TRACE(err);
             goto cleanup;
           }
-          OV_ARRAY_DESTROY(&escaped);
         }
+        body_checksum_update(&bc, *content, OV_ARRAY_LENGTH(*content));
       }
 
       // } end, selN, {exclusive = exclusive ~= 0})
-      if (!ov_sprintf_append_char(&body, err, "%1$zu", "} end, sel%1$zu, {exclusive = exclusive ~= 0})\n", i + 1)) {
+      if (!ov_sprintf_append_char(content, err, "%1$zu", "} end, sel%1$zu, {exclusive = exclusive ~= 0})\n", i + 1)) {
         OV_ERROR_ADD_TRACE(err);
         goto cleanup;
       }
@@ -803,49 +1100,25 @@ generate_script_content(struct ptk_anm2 const *const doc, char **const content,
 
     // Close psdcall wrapper
     if (has_selectors) {
-      if (!ov_sprintf_append_char(&body, err, NULL, "end)\n")) {
+      if (!ov_sprintf_append_char(content, err, NULL, "end)\n")) {
         OV_ERROR_ADD_TRACE(err);
         goto cleanup;
       }
     }
   }
 
-  // Now calculate checksum and create JSON header with checksum
+  // Patch the placeholder with the checksum of the body
   {
-    size_t body_len = OV_ARRAY_LENGTH(body);
-    uint64_t checksum = calculate_checksum(body, body_len);
-
-    // Generate JSON line with checksum
-    if (!generate_json_line(content, doc, checksum, err)) {
-      OV_ERROR_ADD_TRACE(err);
-      goto cleanup;
-    }
-  }
-
-  // Append body to content
-  if (body) {
-    size_t body_len = OV_ARRAY_LENGTH(body);
-    size_t content_len = OV_ARRAY_LENGTH(*content);
-    if (!OV_ARRAY_GROW(content, content_len + body_len + 1)) {
-      OV_ERROR_SET_GENERIC(err, ov_error_generic_out_of_memory);
-      goto cleanup;
-    }
-    memcpy(*content + content_len, body, body_len + 1);
-    OV_ARRAY_SET_LENGTH(*content, content_len + body_len);
+    size_t const len = OV_ARRAY_LENGTH(*content);
+    uint64_t const checksum = body_checksum_final(&bc, *content, len);
+    char checksum_str[17];
+    ov_snprintf_char(checksum_str, sizeof(checksum_str), "%016llx", "%016llx", (unsigned long long)checksum);
+    memcpy(*content + checksum_pos, checksum_str, 16);
   }
 
   success = true;
 
 cleanup:
-  if (escaped) {
-    OV_ARRAY_DESTROY(&escaped);
-  }
-  if (sanitized) {
-    OV_ARRAY_DESTROY(&sanitized);
-  }
-  if (body) {
-    OV_ARRAY_DESTROY(&body);
-  }
   if (!success) {
     if (*content) {
       OV_ARRAY_DESTROY(content);
@@ -856,7 +1129,6 @@ cleanup:
 
 static bool
 generate_parts_override_script(struct ptk_anm2 const *const doc, char **const content, struct ov_error *const err) {
-  char *sanitized = NULL;
   bool success = false;
 
   // Note: Header (@OverwriteSelector) is added by caller (generate_obj2_content)
@@ -954,11 +1226,7 @@ generate_parts_override_script(struct ptk_anm2 const *const doc, char **const co
           display_name = item->script_name;
         }
         if (display_name && display_name[0] != '\0') {
-          if (!sanitize_selector_name(&sanitized, display_name, err)) {
-            OV_ERROR_ADD_TRACE(err);
-            goto cleanup;
-          }
-          if (!ov_sprintf_append_char(content, err, "%1$s%2$zu", ",%1$s=%2$zu", sanitized, j + 1)) {
+          if (!append_selector_option(content, display_name, j + 1, err)) {
             OV_ERROR_ADD_TRACE(err);
             goto cleanup;
           }
@@ -1008,23 +1276,13 @@ generate_parts_override_script(struct ptk_anm2 const *const doc, char **const co
   success = true;
 
 cleanup:
-  if (sanitized) {
-    OV_ARRAY_DESTROY(&sanitized);
-  }
   return success;
 }
 
 static bool
 generate_multiscript_content(struct ptk_anm2 const *const doc, char **const content, struct ov_error *const err) {
-  char *single_content = NULL;
   bool success = false;
 
-  // Generate single-script content first
-  if (!generate_script_content(doc, &single_content, err)) {
-    OV_ERROR_ADD_TRACE(err);
-    goto cleanup;
-  }
-
   // Add @Selector header before the single script content
   if (!ov_sprintf_append_char(
           content, err, "%1$hs", "@%1$hs\n", pgettext(".ptk.anm2 multi-script section name", "Selector"))) {
@@ -1032,16 +1290,10 @@ generate_multiscript_content(struct ptk_anm2 const *const doc, char **const cont
     goto cleanup;
   }
 
-  // Append single script content
-  {
-    size_t const single_len = OV_ARRAY_LENGTH(single_content);
-    size_t const content_len = OV_ARRAY_LENGTH(*content);
-    if (!OV_ARRAY_GROW(content, content_len + single_len + 1)) {
-      OV_ERROR_SET_GENERIC(err, ov_error_generic_out_of_memory);
-      goto cleanup;
-    }
-    memcpy(*content + content_len, single_content, single_len + 1);
-    OV_ARRAY_SET_LENGTH(*content, content_len + single_len);
+  // Single script content follows the header in the same buffer
+  if (!generate_script_content(doc, content, err)) {
+    OV_ERROR_ADD_TRACE(err);
+    goto cleanup;
   }
 
   // Note: Parts override script is now generated in a separate .obj2 file
@@ -1049,9 +1301,6 @@ generate_multiscript_content(struct ptk_anm2 const *const doc, char **const cont
   success = true;
 
 cleanup:
-  if (single_content) {
-    OV_ARRAY_DESTROY(&single_content);
-  }
   return success;
 }
 
@@ -1070,7 +1319,7 @@ static bool generate_obj2_content(struct ptk_anm2 const *const doc, char **const
   {
     // Calculate a dummy checksum (obj2 files don't need checksum verification)
     // We use 0 as the checksum since the obj2 content is auto-generated
-    if (!generate_json_line(content, doc, 0, err)) {
+    if (!generate_json_line(content, doc, 0, NULL, err)) {
       OV_ERROR_ADD_TRACE(err);
       goto cleanup;
     }
@@ -1111,6 +1360,9 @@ static void doc_cleanup(struct ptk_anm2 *doc) {
     }
     OV_ARRAY_DESTROY(&doc->selectors);
   }
+  if (doc->id_index) {
+    OV_HASHMAP_DESTROY(&doc->id_index);
+  }
   op_stack_clear(&doc->undo_stack);
   op_stack_clear(&doc->redo_stack);
 }
@@ -1128,6 +1380,7 @@ bool ptk_anm2_reset(struct ptk_anm2 *doc, struct ov_error *const err) {
   void *const cb_userdata = doc->change_callback_userdata;
   ptk_anm2_state_callback const state_cb = doc->state_callback;
   void *const state_cb_userdata = doc->state_callback_userdata;
+  size_t const undo_memory_limit = doc->undo_memory_limit;
 
   // Clean up document contents
   doc_cleanup(doc);
@@ -1141,7 +1394,13 @@ bool ptk_anm2_reset(struct ptk_anm2 *doc, struct ov_error *const err) {
       .change_callback_userdata = cb_userdata,
       .state_callback = state_cb,
       .state_callback_userdata = state_cb_userdata,
+      .undo_memory_limit = undo_memory_limit,
   };
+  doc->id_index = OV_HASHMAP_CREATE_DYNAMIC(sizeof(struct id_location), 64, get_id_location_key);
+  if (!doc->id_index) {
+    OV_ERROR_SET_GENERIC(err, ov_error_generic_out_of_memory);
+    goto cleanup;
+  }
   if (!strdup_to_array(&doc->label, pgettext(".ptk.anm2 label", "PSD"), err)) {
     OV_ERROR_ADD_TRACE(err);
     goto cleanup;
@@ -1165,7 +1424,7 @@ struct ptk_anm2 *ptk_anm2_create(struct ov_error *const err) {
     OV_ERROR_SET_GENERIC(err, ov_error_generic_out_of_memory);
     goto cleanup;
   }
-  *doc = (struct ptk_anm2){0};
+  *doc = (struct ptk_anm2){.undo_memory_limit = default_undo_memory_limit};
 
   if (!ptk_anm2_reset(doc, err)) {
     OV_ERROR_ADD_TRACE(err);
@@ -1199,16 +1458,61 @@ char const *ptk_anm2_get_label(struct ptk_anm2 const *doc) {
   return doc->label;
 }
 
-static bool push_undo_op(struct ptk_anm2 *doc, struct ptk_anm2_op const *op, struct ov_error *const err) {
-  bool success = false;
-
-  size_t const len = OV_ARRAY_LENGTH(doc->undo_stack);
-  if (!OV_ARRAY_GROW(&doc->undo_stack, len + 1)) {
-    OV_ERROR_SET_GENERIC(err, ov_error_generic_out_of_memory);
-    goto cleanup;
+// Discard the oldest undo steps while the history exceeds the memory budget.
+// A step is a single operation or a complete transaction group.
+// The newest step and an unfinished group are never discarded.
+static void trim_undo_history(struct ptk_anm2 *doc) {
+  if (doc->undo_memory_limit == 0 || doc->undo_memory_usage <= doc->undo_memory_limit) {
+    return;
   }
-  doc->undo_stack[len] = *op;
-  OV_ARRAY_SET_LENGTH(doc->undo_stack, len + 1);
+  size_t const len = OV_ARRAY_LENGTH(doc->undo_stack);
+  size_t usage = doc->undo_memory_usage;
+  size_t n = 0;
+  while (usage > doc->undo_memory_limit) {
+    size_t end = n + 1;
+    if (doc->undo_stack[n].type == ptk_anm2_op_transaction_begin) {
+      while (end < len && doc->undo_stack[end].type != ptk_anm2_op_transaction_end) {
+        end++;
+      }
+      end++;
+    }
+    if (end >= len) {
+      break;
+    }
+    for (size_t i = n; i < end; i++) {
+      usage -= op_memory_size(&doc->undo_stack[i]);
+      op_free(&doc->undo_stack[i]);
+    }
+    n = end;
+  }
+  if (n == 0) {
+    return;
+  }
+  memmove(doc->undo_stack, doc->undo_stack + n, (len - n) * sizeof(doc->undo_stack[0]));
+  OV_ARRAY_SET_LENGTH(doc->undo_stack, len - n);
+  doc->undo_memory_usage = usage;
+}
+
+// Remove the newest operation from the undo stack, transferring ownership to *op
+static void pop_undo_op(struct ptk_anm2 *doc, struct ptk_anm2_op *op) {
+  size_t const len = OV_ARRAY_LENGTH(doc->undo_stack);
+  *op = doc->undo_stack[len - 1];
+  OV_ARRAY_SET_LENGTH(doc->undo_stack, len - 1);
+  doc->undo_memory_usage -= op_memory_size(op);
+}
+
+static bool push_undo_op(struct ptk_anm2 *doc, struct ptk_anm2_op const *op, struct ov_error *const err) {
+  bool success = false;
+
+  size_t const len = OV_ARRAY_LENGTH(doc->undo_stack);
+  if (!OV_ARRAY_GROW(&doc->undo_stack, len + 1)) {
+    OV_ERROR_SET_GENERIC(err, ov_error_generic_out_of_memory);
+    goto cleanup;
+  }
+  doc->undo_stack[len] = *op;
+  OV_ARRAY_SET_LENGTH(doc->undo_stack, len + 1);
+  doc->undo_memory_usage += op_memory_size(op);
+  trim_undo_history(doc);
 
   success = true;
 
@@ -1218,40 +1522,35 @@ cleanup:
 
 static void clear_redo_stack(struct ptk_anm2 *doc) { op_stack_clear(&doc->redo_stack); }
 
+// Move op->str_data into *field and the previous value of *field into reverse_op->str_data.
+// Strings change hands instead of being copied, so each value exists only once in the document and history.
+static void move_str_data(char **const field, struct ptk_anm2_op *const op, struct ptk_anm2_op *const reverse_op) {
+  reverse_op->str_data = *field;
+  *field = op->str_data;
+  op->str_data = NULL;
+}
+
 // Apply a single operation (used for redo)
 // Returns the reverse operation via reverse_op (caller takes ownership of allocated fields)
-// NOTE: This function may consume op->removed_data (sets it to NULL after use)
+// NOTE: This function may consume op->removed_data and op->str_data (sets them to NULL after use)
 static bool
 apply_op(struct ptk_anm2 *doc, struct ptk_anm2_op *op, struct ptk_anm2_op *reverse_op, struct ov_error *const err) {
   bool success = false;
 
   *reverse_op = (struct ptk_anm2_op){.type = op->type};
 
+  if (doc->id_index_stale) {
+    id_index_rebuild(doc);
+  }
+
   switch (op->type) {
   case ptk_anm2_op_set_label:
-    // Save current value as reverse
-    if (!strdup_to_array(&reverse_op->str_data, doc->label, err)) {
-      OV_ERROR_ADD_TRACE(err);
-      goto cleanup;
-    }
-    // Apply new value (op->str_data is the value to apply)
-    if (!strdup_to_array(&doc->label, op->str_data, err)) {
-      OV_ERROR_ADD_TRACE(err);
-      goto cleanup;
-    }
+    // Swap in the new value; the current value becomes the reverse
+    move_str_data(&doc->label, op, reverse_op);
     break;
 
   case ptk_anm2_op_set_psd_path:
-    // Save current value as reverse
-    if (!strdup_to_array(&reverse_op->str_data, doc->psd_path, err)) {
-      OV_ERROR_ADD_TRACE(err);
-      goto cleanup;
-    }
-    // Apply new value
-    if (!strdup_to_array(&doc->psd_path, op->str_data, err)) {
-      OV_ERROR_ADD_TRACE(err);
-      goto cleanup;
-    }
+    move_str_data(&doc->psd_path, op, reverse_op);
     break;
 
   case ptk_anm2_op_set_exclusive_support_default:
@@ -1265,61 +1564,25 @@ apply_op(struct ptk_anm2 *doc, struct ptk_anm2_op *op, struct ptk_anm2_op *rever
     break;
 
   case ptk_anm2_op_set_information:
-    // Save current value as reverse
-    if (doc->information) {
-      if (!strdup_to_array(&reverse_op->str_data, doc->information, err)) {
-        OV_ERROR_ADD_TRACE(err);
-        goto cleanup;
-      }
-    } else {
-      reverse_op->str_data = NULL;
-    }
-    // Apply new value (op->str_data may be NULL for auto-generate mode)
-    if (doc->information) {
-      OV_ARRAY_DESTROY(&doc->information);
-    }
-    if (op->str_data) {
-      if (!strdup_to_array(&doc->information, op->str_data, err)) {
-        OV_ERROR_ADD_TRACE(err);
-        goto cleanup;
-      }
-    } else {
-      doc->information = NULL;
-    }
+    // op->str_data may be NULL for auto-generate mode
+    move_str_data(&doc->information, op, reverse_op);
     break;
 
   case ptk_anm2_op_set_default_character_id:
-    // Save current value as reverse
-    if (doc->default_character_id) {
-      if (!strdup_to_array(&reverse_op->str_data, doc->default_character_id, err)) {
-        OV_ERROR_ADD_TRACE(err);
-        goto cleanup;
-      }
-    } else {
-      reverse_op->str_data = NULL;
-    }
-    // Apply new value (op->str_data may be NULL to clear)
-    if (doc->default_character_id) {
-      OV_ARRAY_DESTROY(&doc->default_character_id);
-    }
-    if (op->str_data) {
-      if (!strdup_to_array(&doc->default_character_id, op->str_data, err)) {
-        OV_ERROR_ADD_TRACE(err);
-        goto cleanup;
-      }
-    } else {
-      doc->default_character_id = NULL;
-    }
+    // op->str_data may be NULL to clear
+    move_str_data(&doc->default_character_id, op, reverse_op);
     break;
 
   case ptk_anm2_op_transaction_begin:
     // TRANSACTION_BEGIN's reverse is TRANSACTION_END
     reverse_op->type = ptk_anm2_op_transaction_end;
+    reverse_op->id = op->id;
     break;
 
   case ptk_anm2_op_transaction_end:
     // TRANSACTION_END's reverse is TRANSACTION_BEGIN
     reverse_op->type = ptk_anm2_op_transaction_begin;
+    reverse_op->id = op->id;
     break;
 
   case ptk_anm2_op_selector_insert:
@@ -1359,6 +1622,8 @@ apply_op(struct ptk_anm2 *doc, struct ptk_anm2_op *op, struct ptk_anm2_op *rever
       // Insert the selector
       doc->selectors[idx] = *sel;
       OV_ARRAY_SET_LENGTH(doc->selectors, len + 1);
+      id_index_add_selector(doc, idx);
+      id_index_selectors(doc, idx + 1, len + 1);
 
       // Free the container (content is now owned by doc)
       OV_FREE(&sel);
@@ -1402,6 +1667,8 @@ apply_op(struct ptk_anm2 *doc, struct ptk_anm2_op *op, struct ptk_anm2_op *rever
         doc->selectors[i] = doc->selectors[i + 1];
       }
       OV_ARRAY_SET_LENGTH(doc->selectors, len - 1);
+      id_index_delete_selector(doc, removed_sel);
+      id_index_selectors(doc, idx, len - 1);
 
       // Reverse operation: INSERT with the saved selector
       reverse_op->type = ptk_anm2_op_selector_insert;
@@ -1431,11 +1698,9 @@ apply_op(struct ptk_anm2 *doc, struct ptk_anm2_op *op, struct ptk_anm2_op *rever
 
       size_t iidx = len;
       if (op->before_id != 0) {
-        for (size_t i = 0; i < len; i++) {
-          if (sel->items[i].id == op->before_id) {
-            iidx = i;
-            break;
-          }
+        size_t before_sidx = 0, before_iidx = 0;
+        if (ptk_anm2_find_item(doc, op->before_id, &before_sidx, &before_iidx) && before_sidx == sidx) {
+          iidx = before_iidx;
         }
       }
 
@@ -1450,6 +1715,8 @@ apply_op(struct ptk_anm2 *doc, struct ptk_anm2_op *op, struct ptk_anm2_op *rever
 
       sel->items[iidx] = *it;
       OV_ARRAY_SET_LENGTH(sel->items, len + 1);
+      id_index_add_item(doc, sel, iidx);
+      id_index_items(doc, sel, iidx + 1, len + 1);
 
       OV_FREE(&it);
       op->removed_data = NULL;
@@ -1487,6 +1754,8 @@ apply_op(struct ptk_anm2 *doc, struct ptk_anm2_op *op, struct ptk_anm2_op *rever
         sel->items[i] = sel->items[i + 1];
       }
       OV_ARRAY_SET_LENGTH(sel->items, len - 1);
+      id_index_delete_item(doc, removed_item);
+      id_index_items(doc, sel, iidx, len - 1);
 
       reverse_op->type = ptk_anm2_op_item_insert;
       reverse_op->before_id = next_id;
@@ -1518,11 +1787,10 @@ apply_op(struct ptk_anm2 *doc, struct ptk_anm2_op *op, struct ptk_anm2_op *rever
 
       size_t pidx = len;
       if (op->before_id != 0) {
-        for (size_t i = 0; i < len; i++) {
-          if (it->params[i].id == op->before_id) {
-            pidx = i;
-            break;
-          }
+        size_t before_sidx = 0, before_iidx = 0, before_pidx = 0;
+        if (ptk_anm2_find_param(doc, op->before_id, &before_sidx, &before_iidx, &before_pidx) &&
+            before_sidx == sidx && before_iidx == iidx) {
+          pidx = before_pidx;
         }
       }
 
@@ -1537,6 +1805,7 @@ apply_op(struct ptk_anm2 *doc, struct ptk_anm2_op *op, struct ptk_anm2_op *rever
 
       it->params[pidx] = *p;
       OV_ARRAY_SET_LENGTH(it->params, len + 1);
+      id_index_params(doc, it, pidx);
 
       uint32_t next_id = (pidx + 1 < len + 1) ? it->params[pidx + 1].id : 0;
 
@@ -1563,14 +1832,9 @@ apply_op(struct ptk_anm2 *doc, struct ptk_anm2_op *op, struct ptk_anm2_op *rever
 
       struct item *it = &doc->selectors[sidx].items[iidx];
       size_t const len = OV_ARRAY_LENGTH(it->params);
-      size_t pidx = len;
-      for (size_t i = 0; i < len; i++) {
-        if (it->params[i].id == op->id) {
-          pidx = i;
-          break;
-        }
-      }
-      if (pidx >= len) {
+      size_t param_sidx = 0, param_iidx = 0, pidx = 0;
+      if (!ptk_anm2_find_param(doc, op->id, &param_sidx, &param_iidx, &pidx) || param_sidx != sidx ||
+          param_iidx != iidx) {
         OV_ERROR_SET_GENERIC(err, ov_error_generic_invalid_argument);
         goto cleanup;
       }
@@ -1588,6 +1852,8 @@ apply_op(struct ptk_anm2 *doc, struct ptk_anm2_op *op, struct ptk_anm2_op *rever
         it->params[i] = it->params[i + 1];
       }
       OV_ARRAY_SET_LENGTH(it->params, len - 1);
+      id_index_delete(doc, removed_param->id);
+      id_index_params(doc, it, pidx);
 
       reverse_op->type = ptk_anm2_op_param_insert;
       reverse_op->removed_data = removed_param;
@@ -1606,14 +1872,7 @@ apply_op(struct ptk_anm2 *doc, struct ptk_anm2_op *op, struct ptk_anm2_op *rever
         goto cleanup;
       }
       struct selector *sel = &doc->selectors[sidx];
-      if (!strdup_to_array(&reverse_op->str_data, sel->name, err)) {
-        OV_ERROR_ADD_TRACE(err);
-        goto cleanup;
-      }
-      if (!strdup_to_array(&sel->name, op->str_data, err)) {
-        OV_ERROR_ADD_TRACE(err);
-        goto cleanup;
-      }
+      move_str_data(&sel->name, op, reverse_op);
       reverse_op->id = sel->id;
     }
     break;
@@ -1659,6 +1918,7 @@ apply_op(struct ptk_anm2 *doc, struct ptk_anm2_op *op, struct ptk_anm2_op *rever
           }
         }
         doc->selectors[to] = tmp;
+        id_index_selectors(doc, from < to ? from : to, (from < to ? to : from) + 1);
       }
 
       // Reverse operation: move back to original position
@@ -1677,14 +1937,7 @@ apply_op(struct ptk_anm2 *doc, struct ptk_anm2_op *op, struct ptk_anm2_op *rever
         goto cleanup;
       }
       struct item *it = &doc->selectors[sidx].items[iidx];
-      if (!strdup_to_array(&reverse_op->str_data, it->name, err)) {
-        OV_ERROR_ADD_TRACE(err);
-        goto cleanup;
-      }
-      if (!strdup_to_array(&it->name, op->str_data, err)) {
-        OV_ERROR_ADD_TRACE(err);
-        goto cleanup;
-      }
+      move_str_data(&it->name, op, reverse_op);
       reverse_op->id = it->id;
     }
     break;
@@ -1699,14 +1952,7 @@ apply_op(struct ptk_anm2 *doc, struct ptk_anm2_op *op, struct ptk_anm2_op *rever
         goto cleanup;
       }
       struct item *it = &doc->selectors[sidx].items[iidx];
-      if (!strdup_to_array(&reverse_op->str_data, it->value, err)) {
-        OV_ERROR_ADD_TRACE(err);
-        goto cleanup;
-      }
-      if (!strdup_to_array(&it->value, op->str_data, err)) {
-        OV_ERROR_ADD_TRACE(err);
-        goto cleanup;
-      }
+      move_str_data(&it->value, op, reverse_op);
       reverse_op->id = it->id;
     }
     break;
@@ -1721,14 +1967,7 @@ apply_op(struct ptk_anm2 *doc, struct ptk_anm2_op *op, struct ptk_anm2_op *rever
         goto cleanup;
       }
       struct item *it = &doc->selectors[sidx].items[iidx];
-      if (!strdup_to_array(&reverse_op->str_data, it->script_name, err)) {
-        OV_ERROR_ADD_TRACE(err);
-        goto cleanup;
-      }
-      if (!strdup_to_array(&it->script_name, op->str_data, err)) {
-        OV_ERROR_ADD_TRACE(err);
-        goto cleanup;
-      }
+      move_str_data(&it->script_name, op, reverse_op);
       reverse_op->id = it->id;
     }
     break;
@@ -1756,11 +1995,9 @@ apply_op(struct ptk_anm2 *doc, struct ptk_anm2_op *op, struct ptk_anm2_op *rever
 
       size_t to_iidx = to_len;
       if (op->before_id != 0) {
-        for (size_t i = 0; i < to_len; i++) {
-          if (to_sel->items[i].id == op->before_id) {
-            to_iidx = i;
-            break;
-          }
+        size_t before_sidx = 0, before_iidx = 0;
+        if (ptk_anm2_find_item(doc, op->before_id, &before_sidx, &before_iidx) && before_sidx == to_sidx) {
+          to_iidx = before_iidx;
         }
       }
 
@@ -1783,6 +2020,10 @@ apply_op(struct ptk_anm2 *doc, struct ptk_anm2_op *op, struct ptk_anm2_op *rever
             }
           }
           from_sel->items[to_iidx] = tmp;
+          id_index_items(doc,
+                         from_sel,
+                         from_iidx < to_iidx ? from_iidx : to_iidx,
+                         (from_iidx < to_iidx ? to_iidx : from_iidx) + 1);
         }
       } else {
         struct item tmp = from_sel->items[from_iidx];
@@ -1807,6 +2048,8 @@ apply_op(struct ptk_anm2 *doc, struct ptk_anm2_op *op, struct ptk_anm2_op *rever
           to_sel->items[i] = to_sel->items[i - 1];
         }
         to_sel->items[to_iidx] = tmp;
+        id_index_items(doc, from_sel, from_iidx, from_len - 1);
+        id_index_items(doc, to_sel, to_iidx, to_len + 1);
       }
 
       reverse_op->id = op->id;
@@ -1827,14 +2070,7 @@ apply_op(struct ptk_anm2 *doc, struct ptk_anm2_op *op, struct ptk_anm2_op *rever
       }
       struct item *item = &doc->selectors[sidx].items[iidx];
       struct param *p = &item->params[pidx];
-      if (!strdup_to_array(&reverse_op->str_data, p->key, err)) {
-        OV_ERROR_ADD_TRACE(err);
-        goto cleanup;
-      }
-      if (!strdup_to_array(&p->key, op->str_data, err)) {
-        OV_ERROR_ADD_TRACE(err);
-        goto cleanup;
-      }
+      move_str_data(&p->key, op, reverse_op);
       // Set parent_id (item_id) for change callback - same for both forward and reverse
       op->parent_id = item->id;
       reverse_op->id = op->id;
@@ -1854,14 +2090,7 @@ apply_op(struct ptk_anm2 *doc, struct ptk_anm2_op *op, struct ptk_anm2_op *rever
       }
       struct item *item = &doc->selectors[sidx].items[iidx];
       struct param *p = &item->params[pidx];
-      if (!strdup_to_array(&reverse_op->str_data, p->value, err)) {
-        OV_ERROR_ADD_TRACE(err);
-        goto cleanup;
-      }
-      if (!strdup_to_array(&p->value, op->str_data, err)) {
-        OV_ERROR_ADD_TRACE(err);
-        goto cleanup;
-      }
+      move_str_data(&p->value, op, reverse_op);
       // Set parent_id (item_id) for change callback - same for both forward and reverse
       op->parent_id = item->id;
       reverse_op->id = op->id;
@@ -1870,7 +2099,8 @@ apply_op(struct ptk_anm2 *doc, struct ptk_anm2_op *op, struct ptk_anm2_op *rever
     break;
 
   case ptk_anm2_op_reset:
-    // RESET is not used as an operation, only for notification
+  case ptk_anm2_op_batch:
+    // RESET and BATCH are not used as operations, only for notification
     OV_ERROR_SET_GENERIC(err, ov_error_generic_invalid_argument);
     goto cleanup;
   }
@@ -1951,6 +2181,7 @@ apply_op(struct ptk_anm2 *doc, struct ptk_anm2_op *op, struct ptk_anm2_op *rever
     notify_change(doc, op->type, 0, 0, 0);
     break;
   case ptk_anm2_op_reset:
+  case ptk_anm2_op_batch:
     break;
   }
 
@@ -3350,17 +3581,22 @@ bool ptk_anm2_undo(struct ptk_anm2 *doc, struct ov_error *const err) {
   }
 
   bool success = false;
+  bool batching = false;
   struct ptk_anm2_op op = {.type = ptk_anm2_op_transaction_begin};
   struct ptk_anm2_op reverse_op = {.type = ptk_anm2_op_transaction_begin};
 
   // Pop from undo stack
-  size_t len = OV_ARRAY_LENGTH(doc->undo_stack);
-  op = doc->undo_stack[len - 1];
-  OV_ARRAY_SET_LENGTH(doc->undo_stack, len - 1);
+  pop_undo_op(doc, &op);
 
   // Check if this is a TRANSACTION_END - if so, we need to undo until TRANSACTION_BEGIN
   bool const is_transaction = (op.type == ptk_anm2_op_transaction_end);
 
+  // A batch group is notified as a whole, like when it was first applied
+  if (is_transaction && op.id != 0) {
+    doc->batch_depth++;
+    batching = true;
+  }
+
   for (;;) {
     enum ptk_anm2_op_type const op_type = op.type;
 
@@ -3397,19 +3633,24 @@ bool ptk_anm2_undo(struct ptk_anm2 *doc, struct ov_error *const err) {
     }
 
     // Continue processing the group
-    len = OV_ARRAY_LENGTH(doc->undo_stack);
-    if (len == 0) {
+    if (OV_ARRAY_LENGTH(doc->undo_stack) == 0) {
       // Shouldn't happen in well-formed groups, but handle gracefully
       break;
     }
-    op = doc->undo_stack[len - 1];
-    OV_ARRAY_SET_LENGTH(doc->undo_stack, len - 1);
+    pop_undo_op(doc, &op);
+  }
+  if (batching) {
+    batching = false;
+    batch_leave(doc);
   }
   notify_state(doc);
 
   success = true;
 
 cleanup:
+  if (batching) {
+    batch_leave(doc);
+  }
   if (!success) {
     op_free(&op);
     op_free(&reverse_op);
@@ -3427,6 +3668,7 @@ bool ptk_anm2_redo(struct ptk_anm2 *doc, struct ov_error *const err) {
   }
 
   bool success = false;
+  bool batching = false;
   struct ptk_anm2_op op = {.type = ptk_anm2_op_transaction_begin};
   struct ptk_anm2_op reverse_op = {.type = ptk_anm2_op_transaction_begin};
 
@@ -3440,6 +3682,12 @@ bool ptk_anm2_redo(struct ptk_anm2 *doc, struct ov_error *const err) {
   //  TRANSACTION_END is at top, TRANSACTION_BEGIN is at bottom)
   bool const is_transaction = (op.type == ptk_anm2_op_transaction_end);
 
+  // A batch group is notified as a whole, like when it was first applied
+  if (is_transaction && op.id != 0) {
+    doc->batch_depth++;
+    batching = true;
+  }
+
   for (;;) {
     enum ptk_anm2_op_type const op_type = op.type;
 
@@ -3479,11 +3727,18 @@ bool ptk_anm2_redo(struct ptk_anm2 *doc, struct ov_error *const err) {
     op = doc->redo_stack[len - 1];
     OV_ARRAY_SET_LENGTH(doc->redo_stack, len - 1);
   }
+  if (batching) {
+    batching = false;
+    batch_leave(doc);
+  }
   notify_state(doc);
 
   success = true;
 
 cleanup:
+  if (batching) {
+    batch_leave(doc);
+  }
   if (!success) {
     op_free(&op);
     op_free(&reverse_op);
@@ -3497,6 +3752,22 @@ void ptk_anm2_clear_undo_history(struct ptk_anm2 *doc) {
   }
   op_stack_clear(&doc->undo_stack);
   op_stack_clear(&doc->redo_stack);
+  doc->undo_memory_usage = 0;
+}
+
+void ptk_anm2_set_undo_memory_limit(struct ptk_anm2 *doc, size_t max_bytes) {
+  if (!doc) {
+    return;
+  }
+  doc->undo_memory_limit = max_bytes;
+  trim_undo_history(doc);
+}
+
+size_t ptk_anm2_get_undo_memory_usage(struct ptk_anm2 const *doc) {
+  if (!doc) {
+    return 0;
+  }
+  return doc->undo_memory_usage;
 }
 
 bool ptk_anm2_begin_transaction(struct ptk_anm2 *doc, struct ov_error *const err) {
@@ -3506,8 +3777,9 @@ bool ptk_anm2_begin_transaction(struct ptk_anm2 *doc, struct ov_error *const err
   }
   if (doc->transaction_depth == 0) {
     // Push TRANSACTION_BEGIN marker when entering outermost transaction
+    // The marker records whether the group is a batch so that undo/redo can coalesce notifications
     clear_redo_stack(doc);
-    struct ptk_anm2_op op = {.type = ptk_anm2_op_transaction_begin};
+    struct ptk_anm2_op op = {.type = ptk_anm2_op_transaction_begin, .id = doc->batch_depth > 0 ? 1 : 0};
     if (!push_undo_op(doc, &op, err)) {
       OV_ERROR_ADD_TRACE(err);
       return false;
@@ -3534,15 +3806,16 @@ bool ptk_anm2_end_transaction(struct ptk_anm2 *doc, struct ov_error *const err)
     size_t const undo_len = OV_ARRAY_LENGTH(doc->undo_stack);
     if (undo_len > 0 && doc->undo_stack[undo_len - 1].type == ptk_anm2_op_transaction_begin) {
       // Empty transaction - remove TRANSACTION_BEGIN and don't push TRANSACTION_END
-      op_free(&doc->undo_stack[undo_len - 1]);
-      OV_ARRAY_SET_LENGTH(doc->undo_stack, undo_len - 1);
+      struct ptk_anm2_op op = {0};
+      pop_undo_op(doc, &op);
+      op_free(&op);
       // Notify state change to update toolbar (undo was enabled during begin_transaction)
       notify_state(doc);
       return true;
     }
 
     // Push TRANSACTION_END marker when exiting outermost transaction
-    struct ptk_anm2_op op = {.type = ptk_anm2_op_transaction_end};
+    struct ptk_anm2_op op = {.type = ptk_anm2_op_transaction_end, .id = doc->batch_depth > 0 ? 1 : 0};
     if (!push_undo_op(doc, &op, err)) {
       OV_ERROR_ADD_TRACE(err);
       return false;
@@ -3553,6 +3826,37 @@ bool ptk_anm2_end_transaction(struct ptk_anm2 *doc, struct ov_error *const err)
   return true;
 }
 
+bool ptk_anm2_begin_batch(struct ptk_anm2 *doc, struct ov_error *const err) {
+  if (!doc) {
+    OV_ERROR_SET_GENERIC(err, ov_error_generic_invalid_argument);
+    return false;
+  }
+  doc->batch_depth++;
+  if (!ptk_anm2_begin_transaction(doc, err)) {
+    OV_ERROR_ADD_TRACE(err);
+    batch_leave(doc);
+    return false;
+  }
+  return true;
+}
+
+bool ptk_anm2_end_batch(struct ptk_anm2 *doc, struct ov_error *const err) {
+  if (!doc) {
+    OV_ERROR_SET_GENERIC(err, ov_error_generic_invalid_argument);
+    return false;
+  }
+  if (doc->batch_depth <= 0) {
+    OV_ERROR_SET_GENERIC(err, ov_error_generic_invalid_argument);
+    return false;
+  }
+  bool const success = ptk_anm2_end_transaction(doc, err);
+  if (!success) {
+    OV_ERROR_ADD_TRACE(err);
+  }
+  batch_leave(doc);
+  return success;
+}
+
 // Parse animation item: {script: "name", n: "display name", params: [[key, value], ...]}
 static bool parse_item_animation(yyjson_val *item_val, struct item *it, struct ov_error *const err) {
   bool success = false;
@@ -3715,25 +4019,29 @@ cleanup:
   return success;
 }
 
+// Parse JSON metadata in place.
+// json must point into a file buffer returned by find_metadata, the json_suffix that follows it
+// is overwritten with the zero padding yyjson requires, and strings in the result point into the buffer.
+static yyjson_doc *read_metadata_insitu(char *const json, size_t const json_len, struct ov_error *const err) {
+  static_assert(sizeof(json_suffix) - 1 >= YYJSON_PADDING_SIZE, "json_suffix must be able to hold yyjson padding");
+  memset(json + json_len, 0, YYJSON_PADDING_SIZE);
+  yyjson_doc *const jdoc = yyjson_read_opts(json, json_len, YYJSON_READ_INSITU, ptk_json_get_alc(), NULL);
+  if (!jdoc) {
+    OV_ERROR_SET_GENERIC(err, ov_error_generic_fail);
+    return NULL;
+  }
+  return jdoc;
+}
+
 // Parse JSON metadata and populate doc
-static bool
-parse_metadata_json(char const *json_str, size_t json_len, struct ptk_anm2 *doc, struct ov_error *const err) {
+static bool parse_metadata_json(char *const json, size_t const json_len, struct ptk_anm2 *doc, struct ov_error *const err) {
   yyjson_doc *jdoc = NULL;
   yyjson_val *root = NULL;
   bool success = false;
-  char *json_buf = NULL;
-
-  if (!OV_ARRAY_GROW(&json_buf, json_len + 1)) {
-    OV_ERROR_SET_GENERIC(err, ov_error_generic_out_of_memory);
-    goto cleanup;
-  }
-  memcpy(json_buf, json_str, json_len);
-  json_buf[json_len] = '\0';
-  OV_ARRAY_SET_LENGTH(json_buf, json_len + 1);
 
-  jdoc = yyjson_read_opts(json_buf, json_len, 0, ptk_json_get_alc(), NULL);
+  jdoc = read_metadata_insitu(json, json_len, err);
   if (!jdoc) {
-    OV_ERROR_SET_GENERIC(err, ov_error_generic_fail);
+    OV_ERROR_ADD_TRACE(err);
     goto cleanup;
   }
 
@@ -3852,6 +4160,7 @@ parse_metadata_json(char const *json_str, size_t json_len, struct ptk_anm2 *doc,
         }
         doc->selectors[selectors_len] = sel;
         OV_ARRAY_SET_LENGTH(doc->selectors, selectors_len + 1);
+        id_index_add_selector(doc, selectors_len);
       }
     }
   }
@@ -3862,12 +4171,87 @@ cleanup:
   if (jdoc) {
     yyjson_doc_free(jdoc);
   }
-  if (json_buf) {
-    OV_ARRAY_DESTROY(&json_buf);
+  return success;
+}
+
+static bool read_file_content(wchar_t const *const path, char **const content, struct ov_error *const err) {
+  struct ovl_file *file = NULL;
+  size_t file_size = 0;
+  size_t bytes_read = 0;
+  bool success = false;
+
+  if (!ovl_file_open(path, &file, err)) {
+    OV_ERROR_ADD_TRACE(err);
+    goto cleanup;
+  }
+
+  if (!ovl_file_size(file, &file_size, err)) {
+    OV_ERROR_ADD_TRACE(err);
+    goto cleanup;
+  }
+
+  if (!OV_ARRAY_GROW(content, file_size + 1)) {
+    OV_ERROR_SET_GENERIC(err, ov_error_generic_out_of_memory);
+    goto cleanup;
+  }
+
+  if (!ovl_file_read(file, *content, file_size, &bytes_read, err)) {
+    OV_ERROR_ADD_TRACE(err);
+    goto cleanup;
+  }
+  (*content)[bytes_read] = '\0';
+  OV_ARRAY_SET_LENGTH(*content, bytes_read + 1);
+
+  success = true;
+
+cleanup:
+  if (file) {
+    ovl_file_close(file);
   }
   return success;
 }
 
+struct metadata_location {
+  char *json; // JSON text between json_prefix and json_suffix
+  size_t json_len;
+  char const *body; // Script body (everything after the JSON metadata line)
+  size_t body_len;
+};
+
+static bool find_metadata(char *const content, struct metadata_location *const loc, struct ov_error *const err) {
+  char const *prefix_pos = NULL;
+  char const *suffix_pos = NULL;
+
+  // Search for json_prefix at the beginning of any line
+  char const *search_start = content;
+  while ((prefix_pos = strstr(search_start, json_prefix)) != NULL) {
+    // Check if prefix is at the start of the content or at the start of a line
+    if (prefix_pos == content || prefix_pos[-1] == '\n') {
+      break; // Found valid prefix at line beginning
+    }
+    // Continue searching after this occurrence
+    search_start = prefix_pos + 1;
+  }
+  if (prefix_pos) {
+    suffix_pos = strstr(prefix_pos + json_prefix_len, json_suffix);
+  }
+  if (!prefix_pos || !suffix_pos) {
+    OV_ERROR_SET(err,
+                 ov_error_type_generic,
+                 ptk_anm2_error_invalid_format,
+                 gettext("The file does not appear to be a valid PSDToolKit anm2 script."));
+    return false;
+  }
+
+  loc->json = content + (prefix_pos - content) + json_prefix_len;
+  loc->json_len = (size_t)(suffix_pos - loc->json);
+
+  char const *const newline = strchr(suffix_pos, '\n');
+  loc->body = newline ? newline + 1 : NULL;
+  loc->body_len = newline ? strlen(newline + 1) : 0;
+  return true;
+}
+
 bool ptk_anm2_load(struct ptk_anm2 *doc, wchar_t const *path, struct ov_error *const err) {
   if (!doc || !path) {
     OV_ERROR_SET_GENERIC(err, ov_error_generic_invalid_argument);
@@ -3876,13 +4260,13 @@ bool ptk_anm2_load(struct ptk_anm2 *doc, wchar_t const *path, struct ov_error *c
 
   bool success = false;
   char *content = NULL;
-  struct ovl_file *file = NULL;
-  // Initialize temp with doc's callbacks so they survive through reset and swap
+  // Initialize temp with doc's callbacks and undo limit so they survive through reset and swap
   struct ptk_anm2 temp = {
       .change_callback = doc->change_callback,
       .change_callback_userdata = doc->change_callback_userdata,
       .state_callback = doc->state_callback,
       .state_callback_userdata = doc->state_callback_userdata,
+      .undo_memory_limit = doc->undo_memory_limit,
   };
 
   // Initialize temporary document (ptk_anm2_reset preserves callbacks)
@@ -3891,87 +4275,30 @@ bool ptk_anm2_load(struct ptk_anm2 *doc, wchar_t const *path, struct ov_error *c
     goto cleanup;
   }
 
-  // Read file content
-  {
-    size_t file_size = 0;
-    size_t bytes_read = 0;
-
-    if (!ovl_file_open(path, &file, err)) {
-      OV_ERROR_ADD_TRACE(err);
-      goto cleanup;
-    }
-
-    if (!ovl_file_size(file, &file_size, err)) {
-      OV_ERROR_ADD_TRACE(err);
-      goto cleanup;
-    }
-
-    if (!OV_ARRAY_GROW(&content, file_size + 1)) {
-      OV_ERROR_SET_GENERIC(err, ov_error_generic_out_of_memory);
-      goto cleanup;
-    }
-
-    if (!ovl_file_read(file, content, file_size, &bytes_read, err)) {
-      OV_ERROR_ADD_TRACE(err);
-      goto cleanup;
-    }
-    content[bytes_read] = '\0';
-    OV_ARRAY_SET_LENGTH(content, bytes_read + 1);
-
-    ovl_file_close(file);
-    file = NULL;
+  if (!read_file_content(path, &content, err)) {
+    OV_ERROR_ADD_TRACE(err);
+    goto cleanup;
   }
 
   // Find and parse JSON metadata line into temp
   {
-    char const *prefix_pos = NULL;
-    char const *suffix_pos = NULL;
-    char const *json_start = NULL;
-    size_t json_len;
-
-    // Search for json_prefix at the beginning of any line
-    char const *search_start = content;
-    while ((prefix_pos = strstr(search_start, json_prefix)) != NULL) {
-      // Check if prefix is at the start of the content or at the start of a line
-      if (prefix_pos == content || prefix_pos[-1] == '\n') {
-        break; // Found valid prefix at line beginning
-      }
-      // Continue searching after this occurrence
-      search_start = prefix_pos + 1;
-    }
-    if (prefix_pos) {
-      suffix_pos = strstr(prefix_pos + json_prefix_len, json_suffix);
-    }
-    if (!prefix_pos || !suffix_pos) {
-      OV_ERROR_SET(err,
-                   ov_error_type_generic,
-                   ptk_anm2_error_invalid_format,
-                   gettext("The file does not appear to be a valid PSDToolKit anm2 script."));
+    struct metadata_location loc;
+    if (!find_metadata(content, &loc, err)) {
+      OV_ERROR_ADD_TRACE(err);
       goto cleanup;
     }
 
-    json_start = prefix_pos + json_prefix_len;
-    json_len = (size_t)(suffix_pos - json_start);
-
     // Parse into temp (not doc) - doc_init already set default label, clear it first
     if (temp.label) {
       OV_ARRAY_DESTROY(&temp.label);
     }
 
-    if (!parse_metadata_json(json_start, json_len, &temp, err)) {
+    if (!parse_metadata_json(loc.json, loc.json_len, &temp, err)) {
       OV_ERROR_ADD_TRACE(err);
       goto cleanup;
     }
 
-    // Calculate checksum from script body (everything after the JSON metadata line)
-    char const *newline = strchr(suffix_pos, '\n');
-    if (newline) {
-      char const *script_body = newline + 1;
-      size_t body_len = strlen(script_body);
-      temp.calculated_checksum = calculate_checksum(script_body, body_len);
-    } else {
-      temp.calculated_checksum = 0;
-    }
+    temp.calculated_checksum = calculate_checksum(loc.body, loc.body_len);
   }
 
   // Swap contents
@@ -3994,9 +4321,6 @@ bool ptk_anm2_load(struct ptk_anm2 *doc, wchar_t const *path, struct ov_error *c
 cleanup:
   // Clean up temp if it still has resources (failure case)
   doc_cleanup(&temp);
-  if (file) {
-    ovl_file_close(file);
-  }
   if (content) {
     OV_ARRAY_DESTROY(&content);
   }
@@ -4154,6 +4478,415 @@ bool ptk_anm2_verify_checksum(struct ptk_anm2 const *doc) {
   return doc->stored_checksum == doc->calculated_checksum;
 }
 
+// Number of verification results kept by ptk_anm2_checksum_cache
+enum {
+  max_cached_checksums = 1024,
+};
+
+struct checksum_entry {
+  wchar_t *path; // ovarray, key for hashmap
+  size_t path_bytes;
+  uint64_t source_size;
+  uint64_t source_time;
+  uint64_t last_used;
+  bool match;
+};
+
+struct ptk_anm2_checksum_cache {
+  struct ov_hashmap *entries; // path -> checksum_entry
+  uint64_t tick;
+};
+
+static void get_checksum_entry_key(void const *const item, void const **const key, size_t *const key_bytes) {
+  struct checksum_entry const *const entry = (struct checksum_entry const *)item;
+  *key = entry->path;
+  *key_bytes = entry->path_bytes;
+}
+
+static void checksum_cache_evict_oldest(struct ptk_anm2_checksum_cache *const cache) {
+  size_t iter = 0;
+  struct checksum_entry *entry = NULL;
+  struct checksum_entry oldest = {0};
+  while (OV_HASHMAP_ITER(cache->entries, &iter, &entry)) {
+    if (!oldest.path || entry->last_used < oldest.last_used) {
+      oldest = *entry;
+    }
+  }
+  if (oldest.path) {
+    OV_HASHMAP_DELETE(cache->entries, &oldest);
+    OV_ARRAY_DESTROY(&oldest.path);
+  }
+}
+
+struct ptk_anm2_checksum_cache *ptk_anm2_checksum_cache_create(struct ov_error *const err) {
+  struct ptk_anm2_checksum_cache *cache = NULL;
+  bool success = false;
+
+  if (!OV_REALLOC(&cache, 1, sizeof(*cache))) {
+    OV_ERROR_SET_GENERIC(err, ov_error_generic_out_of_memory);
+    goto cleanup;
+  }
+  *cache = (struct ptk_anm2_checksum_cache){0};
+
+  cache->entries = OV_HASHMAP_CREATE_DYNAMIC(sizeof(struct checksum_entry), 64, get_checksum_entry_key);
+  if (!cache->entries) {
+    OV_ERROR_SET_GENERIC(err, ov_error_generic_out_of_memory);
+    goto cleanup;
+  }
+
+  success = true;
+
+cleanup:
+  if (!success) {
+    ptk_anm2_checksum_cache_destroy(&cache);
+  }
+  return cache;
+}
+
+void ptk_anm2_checksum_cache_destroy(struct ptk_anm2_checksum_cache **const cache_ptr) {
+  if (!cache_ptr || !*cache_ptr) {
+    return;
+  }
+  struct ptk_anm2_checksum_cache *const cache = *cache_ptr;
+  if (cache->entries) {
+    size_t iter = 0;
+    struct checksum_entry *entry = NULL;
+    while (OV_HASHMAP_ITER(cache->entries, &iter, &entry)) {
+      if (entry->path) {
+        OV_ARRAY_DESTROY(&entry->path);
+      }
+    }
+    OV_HASHMAP_DESTROY(&cache->entries);
+  }
+  OV_FREE(cache_ptr);
+}
+
+struct view_item {
+  char const *name;        // NULL if not set
+  char const *value;       // NULL for animation items
+  char const *script_name; // NULL for value items
+};
+
+struct view_selector {
+  char const *name;
+  size_t first_item; // Index into ptk_anm2_view.items
+  size_t item_count;
+};
+
+struct ptk_anm2_view {
+  char *content; // ovarray, file content, JSON strings point into it
+  yyjson_doc *jdoc;
+  char const *label;
+  char const *psd_path;
+  char const *information;
+  char const *default_character_id;
+  uint64_t stored_checksum;
+  char const *body; // Script body in content, used to verify the checksum
+  size_t body_len;
+  struct view_selector *selectors; // ovarray
+  struct view_item *items;         // ovarray, items of all selectors in order
+};
+
+static char const *view_get_str(yyjson_val *const obj, char const *const key) {
+  yyjson_val *const v = yyjson_obj_get(obj, key);
+  return v && yyjson_is_str(v) ? yyjson_get_str(v) : NULL;
+}
+
+static char const *view_get_arr_str(yyjson_val *const arr, size_t const idx) {
+  yyjson_val *const v = yyjson_arr_get(arr, idx);
+  return v && yyjson_is_str(v) ? yyjson_get_str(v) : NULL;
+}
+
+static bool view_index(struct ptk_anm2_view *const view, yyjson_val *const root, struct ov_error *const err) {
+  yyjson_val *const selectors = yyjson_obj_get(root, "selectors");
+  if (!selectors || !yyjson_is_arr(selectors)) {
+    return true;
+  }
+
+  // Count first so that both arrays are allocated once
+  size_t total_items = 0;
+  {
+    size_t idx, max;
+    yyjson_val *sel_val;
+    yyjson_arr_foreach(selectors, idx, max, sel_val) {
+      yyjson_val *const items = yyjson_obj_get(sel_val, "items");
+      if (items && yyjson_is_arr(items)) {
+        total_items += yyjson_arr_size(items);
+      }
+    }
+  }
+  if (!OV_ARRAY_GROW(&view->selectors, yyjson_arr_size(selectors)) ||
+      (total_items > 0 && !OV_ARRAY_GROW(&view->items, total_items))) {
+    OV_ERROR_SET_GENERIC(err, ov_error_generic_out_of_memory);
+    return false;
+  }
+
+  size_t num_selectors = 0;
+  size_t num_items = 0;
+  size_t idx, max;
+  yyjson_val *sel_val;
+  yyjson_arr_foreach(selectors, idx, max, sel_val) {
+    if (!yyjson_is_obj(sel_val)) {
+      continue;
+    }
+    struct view_selector *const sel = &view->selectors[num_selectors++];
+    *sel = (struct view_selector){
+        .name = view_get_str(sel_val, "group"),
+        .first_item = num_items,
+    };
+    yyjson_val *const items = yyjson_obj_get(sel_val, "items");
+    if (!items || !yyjson_is_arr(items)) {
+      continue;
+    }
+    size_t item_idx, item_max;
+    yyjson_val *item_val;
+    yyjson_arr_foreach(items, item_idx, item_max, item_val) {
+      if (yyjson_is_arr(item_val)) {
+        // Value item: [name, value]
+        view->items[num_items++] = (struct view_item){
+            .name = view_get_arr_str(item_val, 0),
+            .value = view_get_arr_str(item_val, 1),
+        };
+      } else if (yyjson_is_obj(item_val)) {
+        // Animation item: {script: "name", n: "display name", params: [...]}
+        view->items[num_items++] = (struct view_item){
+            .name = view_get_str(item_val, "n"),
+            .script_name = view_get_str(item_val, "script"),
+        };
+      }
+    }
+    sel->item_count = num_items - sel->first_item;
+  }
+  OV_ARRAY_SET_LENGTH(view->selectors, num_selectors);
+  if (view->items) {
+    OV_ARRAY_SET_LENGTH(view->items, num_items);
+  }
+  return true;
+}
+
+struct ptk_anm2_view *ptk_anm2_view_open(wchar_t const *const path, struct ov_error *const err) {
+  if (!path) {
+    OV_ERROR_SET_GENERIC(err, ov_error_generic_invalid_argument);
+    return NULL;
+  }
+
+  struct ptk_anm2_view *view = NULL;
+  bool success = false;
+
+  if (!OV_REALLOC(&view, 1, sizeof(*view))) {
+    OV_ERROR_SET_GENERIC(err, ov_error_generic_out_of_memory);
+    goto cleanup;
+  }
+  *view = (struct ptk_anm2_view){0};
+
+  if (!read_file_content(path, &view->content, err)) {
+    OV_ERROR_ADD_TRACE(err);
+    goto cleanup;
+  }
+
+  {
+    struct metadata_location loc;
+    if (!find_metadata(view->content, &loc, err)) {
+      OV_ERROR_ADD_TRACE(err);
+      goto cleanup;
+    }
+    view->jdoc = read_metadata_insitu(loc.json, loc.json_len, err);
+    if (!view->jdoc) {
+      OV_ERROR_ADD_TRACE(err);
+      goto cleanup;
+    }
+    view->body = loc.body;
+    view->body_len = loc.body_len;
+  }
+
+  {
+    yyjson_val *const root = yyjson_doc_get_root(view->jdoc);
+    if (!yyjson_is_obj(root)) {
+      OV_ERROR_SET_GENERIC(err, ov_error_generic_fail);
+      goto cleanup;
+    }
+    view->label = view_get_str(root, "label");
+    view->psd_path = view_get_str(root, "psd");
+    view->information = view_get_str(root, "information");
+    view->default_character_id = view_get_str(root, "defaultCharacterId");
+    {
+      char const *const checksum_str = view_get_str(root, "checksum");
+      view->stored_checksum = checksum_str ? strtoull(checksum_str, NULL, 16) : 0;
+    }
+    if (!view_index(view, root, err)) {
+      OV_ERROR_ADD_TRACE(err);
+      goto cleanup;
+    }
+  }
+
+  success = true;
+
+cleanup:
+  if (!success) {
+    ptk_anm2_view_close(&view);
+  }
+  return view;
+}
+
+void ptk_anm2_view_close(struct ptk_anm2_view **const view_ptr) {
+  if (!view_ptr || !*view_ptr) {
+    return;
+  }
+  struct ptk_anm2_view *const view = *view_ptr;
+  if (view->items) {
+    OV_ARRAY_DESTROY(&view->items);
+  }
+  if (view->selectors) {
+    OV_ARRAY_DESTROY(&view->selectors);
+  }
+  if (view->jdoc) {
+    yyjson_doc_free(view->jdoc);
+  }
+  if (view->content) {
+    OV_ARRAY_DESTROY(&view->content);
+  }
+  OV_FREE(view_ptr);
+}
+
+char const *ptk_anm2_view_get_label(struct ptk_anm2_view const *const view) { return view ? view->label : NULL; }
+
+char const *ptk_anm2_view_get_psd_path(struct ptk_anm2_view const *const view) {
+  return view ? view->psd_path : NULL;
+}
+
+char const *ptk_anm2_view_get_information(struct ptk_anm2_view const *const view) {
+  return view ? view->information : NULL;
+}
+
+char const *ptk_anm2_view_get_default_character_id(struct ptk_anm2_view const *const view) {
+  return view ? view->default_character_id : NULL;
+}
+
+size_t ptk_anm2_view_selector_count(struct ptk_anm2_view const *const view) {
+  return view ? OV_ARRAY_LENGTH(view->selectors) : 0;
+}
+
+char const *ptk_anm2_view_selector_get_name(struct ptk_anm2_view const *const view, size_t const sel_idx) {
+  if (!view || sel_idx >= OV_ARRAY_LENGTH(view->selectors)) {
+    return NULL;
+  }
+  return view->selectors[sel_idx].name;
+}
+
+size_t ptk_anm2_view_item_count(struct ptk_anm2_view const *const view, size_t const sel_idx) {
+  if (!view || sel_idx >= OV_ARRAY_LENGTH(view->selectors)) {
+    return 0;
+  }
+  return view->selectors[sel_idx].item_count;
+}
+
+static struct view_item const *
+view_get_item(struct ptk_anm2_view const *const view, size_t const sel_idx, size_t const item_idx) {
+  if (!view || sel_idx >= OV_ARRAY_LENGTH(view->selectors)) {
+    return NULL;
+  }
+  struct view_selector const *const sel = &view->selectors[sel_idx];
+  if (item_idx >= sel->item_count) {
+    return NULL;
+  }
+  return &view->items[sel->first_item + item_idx];
+}
+
+char const *
+ptk_anm2_view_item_get_name(struct ptk_anm2_view const *const view, size_t const sel_idx, size_t const item_idx) {
+  struct view_item const *const item = view_get_item(view, sel_idx, item_idx);
+  return item ? item->name : NULL;
+}
+
+char const *
+ptk_anm2_view_item_get_value(struct ptk_anm2_view const *const view, size_t const sel_idx, size_t const item_idx) {
+  struct view_item const *const item = view_get_item(view, sel_idx, item_idx);
+  return item ? item->value : NULL;
+}
+
+char const *ptk_anm2_view_item_get_script_name(struct ptk_anm2_view const *const view,
+                                               size_t const sel_idx,
+                                               size_t const item_idx) {
+  struct view_item const *const item = view_get_item(view, sel_idx, item_idx);
+  return item ? item->script_name : NULL;
+}
+
+ov_tribool ptk_anm2_verify_file_checksum(struct ptk_anm2_checksum_cache *const cache,
+                                         wchar_t const *const path,
+                                         struct ov_error *const err) {
+  if (!path) {
+    OV_ERROR_SET_GENERIC(err, ov_error_generic_invalid_argument);
+    return ov_indeterminate;
+  }
+
+  struct ptk_anm2_view *view = NULL;
+  struct checksum_entry new_entry = {0};
+  ov_tribool result = ov_indeterminate;
+
+  if (cache) {
+    WIN32_FILE_ATTRIBUTE_DATA attr;
+    if (!GetFileAttributesExW(path, GetFileExInfoStandard, &attr)) {
+      OV_ERROR_SET_HRESULT(err, HRESULT_FROM_WIN32(GetLastError()));
+      goto cleanup;
+    }
+    new_entry.source_size = ((uint64_t)attr.nFileSizeHigh << 32) | attr.nFileSizeLow;
+    new_entry.source_time =
+        ((uint64_t)attr.ftLastWriteTime.dwHighDateTime << 32) | attr.ftLastWriteTime.dwLowDateTime;
+
+    struct checksum_entry const key = {.path = ov_deconster_(path), .path_bytes = wcslen(path) * sizeof(wchar_t)};
+    struct checksum_entry *const found =
+        (struct checksum_entry *)ov_deconster_(OV_HASHMAP_GET(cache->entries, &key));
+    if (found) {
+      if (found->source_size == new_entry.source_size && found->source_time == new_entry.source_time) {
+        found->last_used = ++cache->tick;
+        result = found->match ? ov_true : ov_false;
+        goto cleanup;
+      }
+      // Modified since it was verified
+      struct checksum_entry stale = *found;
+      OV_HASHMAP_DELETE(cache->entries, &stale);
+      OV_ARRAY_DESTROY(&stale.path);
+    }
+  }
+
+  view = ptk_anm2_view_open(path, err);
+  if (!view) {
+    OV_ERROR_ADD_TRACE(err);
+    goto cleanup;
+  }
+  new_entry.match = view->stored_checksum == calculate_checksum(view->body, view->body_len);
+
+  if (cache) {
+    size_t const path_len = wcslen(path);
+    if (!OV_ARRAY_GROW(&new_entry.path, path_len + 1)) {
+      OV_ERROR_SET_GENERIC(err, ov_error_generic_out_of_memory);
+      goto cleanup;
+    }
+    memcpy(new_entry.path, path, (path_len + 1) * sizeof(wchar_t));
+    OV_ARRAY_SET_LENGTH(new_entry.path, path_len);
+    new_entry.path_bytes = path_len * sizeof(wchar_t);
+    new_entry.last_used = ++cache->tick;
+
+    if (OV_HASHMAP_COUNT(cache->entries) >= max_cached_checksums) {
+      checksum_cache_evict_oldest(cache);
+    }
+    if (!OV_HASHMAP_SET(cache->entries, &new_entry)) {
+      OV_ERROR_SET_GENERIC(err, ov_error_generic_out_of_memory);
+      goto cleanup;
+    }
+    new_entry.path = NULL; // ownership transferred to hashmap
+  }
+
+  result = new_entry.match ? ov_true : ov_false;
+
+cleanup:
+  if (new_entry.path) {
+    OV_ARRAY_DESTROY(&new_entry.path);
+  }
+  ptk_anm2_view_close(&view);
+  return result;
+}
+
 bool ptk_anm2_is_modified(struct ptk_anm2 const *doc) {
   if (!doc) {
     return false;
@@ -4309,30 +5042,11 @@ uint32_t *ptk_anm2_get_param_ids(struct ptk_anm2 const *doc, uint32_t item_id, s
 }
 
 uint32_t ptk_anm2_param_get_item_id(struct ptk_anm2 const *doc, uint32_t param_id) {
-  if (!doc || !doc->selectors || param_id == 0) {
+  size_t sel_idx = 0, item_idx = 0;
+  if (!ptk_anm2_find_param(doc, param_id, &sel_idx, &item_idx, NULL)) {
     return 0;
   }
-  size_t const sel_count = OV_ARRAY_LENGTH(doc->selectors);
-  for (size_t i = 0; i < sel_count; i++) {
-    struct selector const *sel = &doc->selectors[i];
-    if (!sel->items) {
-      continue;
-    }
-    size_t const item_count = OV_ARRAY_LENGTH(sel->items);
-    for (size_t j = 0; j < item_count; j++) {
-      struct item const *it = &sel->items[j];
-      if (!it->params) {
-        continue;
-      }
-      size_t const param_count = OV_ARRAY_LENGTH(it->params);
-      for (size_t k = 0; k < param_count; k++) {
-        if (it->params[k].id == param_id) {
-          return it->id;
-        }
-      }
-    }
-  }
-  return 0;
+  return doc->selectors[sel_idx].items[item_idx].id;
 }
 
 static uintptr_t param_get_userdata(struct ptk_anm2 const *doc, size_t sel_idx, size_t item_idx, size_t param_idx) {
@@ -4420,10 +5134,8 @@ void ptk_anm2_param_set_userdata(struct ptk_anm2 *doc, uint32_t id, uintptr_t us
   param_set_userdata(doc, sel_idx, item_idx, param_idx, userdata);
 }
 
-bool ptk_anm2_find_selector(struct ptk_anm2 const *doc, uint32_t id, size_t *out_sel_idx) {
-  if (!doc || !doc->selectors || id == 0) {
-    return false;
-  }
+// Linear searches used while the index is stale
+static bool scan_selector(struct ptk_anm2 const *doc, uint32_t id, size_t *out_sel_idx) {
   size_t const n = OV_ARRAY_LENGTH(doc->selectors);
   for (size_t i = 0; i < n; i++) {
     if (doc->selectors[i].id == id) {
@@ -4436,10 +5148,7 @@ bool ptk_anm2_find_selector(struct ptk_anm2 const *doc, uint32_t id, size_t *out
   return false;
 }
 
-bool ptk_anm2_find_item(struct ptk_anm2 const *doc, uint32_t id, size_t *out_sel_idx, size_t *out_item_idx) {
-  if (!doc || !doc->selectors || id == 0) {
-    return false;
-  }
+static bool scan_item(struct ptk_anm2 const *doc, uint32_t id, size_t *out_sel_idx, size_t *out_item_idx) {
   size_t const sel_count = OV_ARRAY_LENGTH(doc->selectors);
   for (size_t sel_idx = 0; sel_idx < sel_count; sel_idx++) {
     struct selector const *sel = &doc->selectors[sel_idx];
@@ -4462,11 +5171,8 @@ bool ptk_anm2_find_item(struct ptk_anm2 const *doc, uint32_t id, size_t *out_sel
   return false;
 }
 
-bool ptk_anm2_find_param(
+static bool scan_param(
     struct ptk_anm2 const *doc, uint32_t id, size_t *out_sel_idx, size_t *out_item_idx, size_t *out_param_idx) {
-  if (!doc || !doc->selectors || id == 0) {
-    return false;
-  }
   size_t const sel_count = OV_ARRAY_LENGTH(doc->selectors);
   for (size_t sel_idx = 0; sel_idx < sel_count; sel_idx++) {
     struct selector const *sel = &doc->selectors[sel_idx];
@@ -4498,3 +5204,73 @@ bool ptk_anm2_find_param(
   }
   return false;
 }
+
+bool ptk_anm2_find_selector(struct ptk_anm2 const *doc, uint32_t id, size_t *out_sel_idx) {
+  if (!doc || !doc->selectors || id == 0) {
+    return false;
+  }
+  if (doc->id_index_stale) {
+    return scan_selector(doc, id, out_sel_idx);
+  }
+  struct id_location const *const loc = id_index_get(doc, id);
+  if (!loc || loc->kind != element_kind_selector) {
+    return false;
+  }
+  if (out_sel_idx) {
+    *out_sel_idx = loc->idx;
+  }
+  return true;
+}
+
+bool ptk_anm2_find_item(struct ptk_anm2 const *doc, uint32_t id, size_t *out_sel_idx, size_t *out_item_idx) {
+  if (!doc || !doc->selectors || id == 0) {
+    return false;
+  }
+  if (doc->id_index_stale) {
+    return scan_item(doc, id, out_sel_idx, out_item_idx);
+  }
+  struct id_location const *const loc = id_index_get(doc, id);
+  if (!loc || loc->kind != element_kind_item) {
+    return false;
+  }
+  struct id_location const *const sel_loc = id_index_get(doc, loc->parent_id);
+  if (!sel_loc) {
+    return false;
+  }
+  if (out_sel_idx) {
+    *out_sel_idx = sel_loc->idx;
+  }
+  if (out_item_idx) {
+    *out_item_idx = loc->idx;
+  }
+  return true;
+}
+
+bool ptk_anm2_find_param(
+    struct ptk_anm2 const *doc, uint32_t id, size_t *out_sel_idx, size_t *out_item_idx, size_t *out_param_idx) {
+  if (!doc || !doc->selectors || id == 0) {
+    return false;
+  }
+  if (doc->id_index_stale) {
+    return scan_param(doc, id, out_sel_idx, out_item_idx, out_param_idx);
+  }
+  struct id_location const *const loc = id_index_get(doc, id);
+  if (!loc || loc->kind != element_kind_param) {
+    return false;
+  }
+  struct id_location const *const item_loc = id_index_get(doc, loc->parent_id);
+  struct id_location const *const sel_loc = item_loc ? id_index_get(doc, item_loc->parent_id) : NULL;
+  if (!sel_loc) {
+    return false;
+  }
+  if (out_sel_idx) {
+    *out_sel_idx = sel_loc->idx;
+  }
+  if (out_item_idx) {
+    *out_item_idx = item_loc->idx;
+  }
+  if (out_param_idx) {
+    *out_param_idx = loc->idx;
+  }
+  return true;
+}
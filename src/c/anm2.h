@@ -33,6 +33,9 @@ enum ptk_anm2_op_type {
   ptk_anm2_op_transaction_begin,
   ptk_anm2_op_transaction_end,
 
+  // Coalesced notification for a batch (see ptk_anm2_begin_batch)
+  ptk_anm2_op_batch,
+
   // Metadata operations
   ptk_anm2_op_set_label,
   ptk_anm2_op_set_psd_path,
@@ -185,6 +188,152 @@ NODISCARD bool ptk_anm2_save(struct ptk_anm2 *doc, wchar_t const *path, struct o
  */
 NODISCARD bool ptk_anm2_verify_checksum(struct ptk_anm2 const *doc);
 
+struct ptk_anm2_checksum_cache;
+
+/**
+ * @brief Create a cache of file checksum verification results
+ *
+ * Results are revalidated with the file size and last write time,
+ * so verifying unchanged files again only queries their attributes.
+ *
+ * @param err Error information
+ * @return New cache on success, NULL on failure
+ */
+NODISCARD struct ptk_anm2_checksum_cache *ptk_anm2_checksum_cache_create(struct ov_error *const err);
+
+/**
+ * @brief Destroy a checksum cache
+ *
+ * @param cache Pointer to cache to destroy, will be set to NULL
+ */
+void ptk_anm2_checksum_cache_destroy(struct ptk_anm2_checksum_cache **cache);
+
+/**
+ * @brief Verify checksum of an anm2 file without loading it
+ *
+ * The file is opened with ptk_anm2_view_open, so the metadata is parsed in place and the script body is hashed
+ * in the file buffer.
+ *
+ * @param cache Cache of previous results, or NULL to always read the file
+ * @param path Path to the anm2 file
+ * @param err Error information
+ * @return ov_true if checksum matches, ov_false if mismatch (manually edited), ov_indeterminate on error
+ */
+ov_tribool ptk_anm2_verify_file_checksum(struct ptk_anm2_checksum_cache *cache,
+                                         wchar_t const *path,
+                                         struct ov_error *const err);
+
+struct ptk_anm2_view;
+
+/**
+ * @brief Open a read-only view of an anm2 file
+ *
+ * Only the JSON metadata is parsed, in place in the file buffer, and no document is built.
+ * All strings returned by the view point into that buffer and stay valid until the view is closed.
+ * This is much cheaper than ptk_anm2_load when only names are needed, e.g. to list many files.
+ * Malformed selectors and items are skipped instead of failing.
+ *
+ * @param path Path to the anm2 file
+ * @param err Error information
+ * @return New view on success, NULL on failure
+ */
+NODISCARD struct ptk_anm2_view *ptk_anm2_view_open(wchar_t const *path, struct ov_error *const err);
+
+/**
+ * @brief Close a view
+ *
+ * @param view Pointer to view to close, will be set to NULL
+ */
+void ptk_anm2_view_close(struct ptk_anm2_view **view);
+
+/**
+ * @brief Get the label of a view
+ *
+ * @param view View handle
+ * @return String, or NULL if not stored in the file
+ */
+char const *ptk_anm2_view_get_label(struct ptk_anm2_view const *view);
+
+/**
+ * @brief Get the PSD file path of a view
+ *
+ * @param view View handle
+ * @return String, or NULL if not stored in the file
+ */
+char const *ptk_anm2_view_get_psd_path(struct ptk_anm2_view const *view);
+
+/**
+ * @brief Get the custom information text of a view
+ *
+ * @param view View handle
+ * @return String, or NULL if not stored in the file
+ */
+char const *ptk_anm2_view_get_information(struct ptk_anm2_view const *view);
+
+/**
+ * @brief Get the default character ID of a view
+ *
+ * @param view View handle
+ * @return String, or NULL if not stored in the file
+ */
+char const *ptk_anm2_view_get_default_character_id(struct ptk_anm2_view const *view);
+
+/**
+ * @brief Get the number of selectors in a view
+ *
+ * @param view View handle
+ * @return Number of selectors
+ */
+size_t ptk_anm2_view_selector_count(struct ptk_anm2_view const *view);
+
+/**
+ * @brief Get the group name of a selector in a view
+ *
+ * @param view View handle
+ * @param sel_idx Selector index
+ * @return Group name, or NULL if index is out of range
+ */
+char const *ptk_anm2_view_selector_get_name(struct ptk_anm2_view const *view, size_t sel_idx);
+
+/**
+ * @brief Get the number of items in a selector of a view
+ *
+ * @param view View handle
+ * @param sel_idx Selector index
+ * @return Number of items, 0 if index is out of range
+ */
+size_t ptk_anm2_view_item_count(struct ptk_anm2_view const *view, size_t sel_idx);
+
+/**
+ * @brief Get the display name of an item in a view
+ *
+ * @param view View handle
+ * @param sel_idx Selector index
+ * @param item_idx Item index within the selector
+ * @return Display name, or NULL if not set or index is out of range
+ */
+char const *ptk_anm2_view_item_get_name(struct ptk_anm2_view const *view, size_t sel_idx, size_t item_idx);
+
+/**
+ * @brief Get the layer path value of an item in a view
+ *
+ * @param view View handle
+ * @param sel_idx Selector index
+ * @param item_idx Item index within the selector
+ * @return Value, or NULL for animation items or if index is out of range
+ */
+char const *ptk_anm2_view_item_get_value(struct ptk_anm2_view const *view, size_t sel_idx, size_t item_idx);
+
+/**
+ * @brief Get the script name of an item in a view
+ *
+ * @param view View handle
+ * @param sel_idx Selector index
+ * @param item_idx Item index within the selector
+ * @return Script name, or NULL for value items or if index is out of range
+ */
+char const *ptk_anm2_view_item_get_script_name(struct ptk_anm2_view const *view, size_t sel_idx, size_t item_idx);
+
 /**
  * @brief Check if document has been modified since last save/load/reset
  *
@@ -692,6 +841,27 @@ NODISCARD bool ptk_anm2_redo(struct ptk_anm2 *doc, struct ov_error *const err);
  */
 void ptk_anm2_clear_undo_history(struct ptk_anm2 *doc);
 
+/**
+ * @brief Set the memory budget for undo history
+ *
+ * When the estimated memory held by the undo history exceeds the budget,
+ * the oldest undo steps are discarded. The most recent step is always kept.
+ * The redo history only holds undone steps and is not counted.
+ * New documents use a budget of 64 MiB, which is kept across reset and load.
+ *
+ * @param doc Document handle
+ * @param max_bytes Budget in bytes, 0 for unlimited
+ */
+void ptk_anm2_set_undo_memory_limit(struct ptk_anm2 *doc, size_t max_bytes);
+
+/**
+ * @brief Get the estimated memory held by the undo history
+ *
+ * @param doc Document handle
+ * @return Estimated size in bytes
+ */
+size_t ptk_anm2_get_undo_memory_usage(struct ptk_anm2 const *doc);
+
 /**
  * @brief Begin a transaction (group multiple operations for single undo)
  *
@@ -714,6 +884,32 @@ NODISCARD bool ptk_anm2_begin_transaction(struct ptk_anm2 *doc, struct ov_error
  */
 NODISCARD bool ptk_anm2_end_transaction(struct ptk_anm2 *doc, struct ov_error *const err);
 
+/**
+ * @brief Begin a batch (a transaction with coalesced change notifications)
+ *
+ * While a batch is open, change_callback is not invoked for individual operations.
+ * When the outermost batch ends, a single ptk_anm2_op_batch notification is sent
+ * if anything changed, so listeners should rebuild their view of the document.
+ * Undoing or redoing the batch is also notified as a single ptk_anm2_op_batch.
+ *
+ * Batches can be nested and can be opened inside a transaction.
+ * The undo group is marked as a batch only when the batch is the outermost transaction.
+ *
+ * @param doc Document handle
+ * @param err Error information
+ * @return true on success, false on failure
+ */
+NODISCARD bool ptk_anm2_begin_batch(struct ptk_anm2 *doc, struct ov_error *const err);
+
+/**
+ * @brief End a batch
+ *
+ * @param doc Document handle
+ * @param err Error information
+ * @return true on success, false on failure
+ */
+NODISCARD bool ptk_anm2_end_batch(struct ptk_anm2 *doc, struct ov_error *const err);
+
 /**
  * @brief Get the unique ID of a selector
  *
@@ -0,0 +1,315 @@
+// Include anm2.c directly to benchmark static functions
+#include "anm2.c"
+
+#include <ovtest.h>
+
+#include <stdio.h>
+#include <string.h>
+
+#include "bench.h"
+
+enum {
+  bench_selectors = 16,
+  bench_params_per_item = 2,
+};
+
+struct bench_result {
+  double insert_ns; // per inserted item, including its params
+  double edit_ns;   // per parameter value edit
+  double undo_ns;   // per undone edit
+};
+
+// Build a document with num_items animation items, then edit and undo every parameter in shuffled order
+static bool run_bench(size_t const num_items, struct bench_result *const result) {
+  struct ov_error err = {0};
+  struct ptk_anm2 *doc = NULL;
+  uint32_t *selector_ids = NULL;
+  uint32_t *param_ids = NULL;
+  bool success = false;
+
+  doc = ptk_anm2_create(&err);
+  if (!TEST_SUCCEEDED(doc != NULL, &err)) {
+    goto cleanup;
+  }
+  if (!TEST_CHECK(OV_ARRAY_GROW(&selector_ids, bench_selectors))) {
+    goto cleanup;
+  }
+  for (size_t i = 0; i < bench_selectors; i++) {
+    selector_ids[i] = ptk_anm2_selector_insert(doc, 0, "Group", 0, &err);
+    if (!TEST_SUCCEEDED(selector_ids[i] != 0, &err)) {
+      goto cleanup;
+    }
+  }
+  if (!TEST_CHECK(OV_ARRAY_GROW(&param_ids, num_items * bench_params_per_item))) {
+    goto cleanup;
+  }
+
+  {
+    double const start = ptk_bench_now();
+    for (size_t i = 0; i < num_items; i++) {
+      uint32_t const item_id =
+          ptk_anm2_item_insert_animation(doc, selector_ids[i % bench_selectors], "PSDToolKit.Blinker", "Blinker", &err);
+      if (!TEST_SUCCEEDED(item_id != 0, &err)) {
+        goto cleanup;
+      }
+      for (size_t j = 0; j < bench_params_per_item; j++) {
+        uint32_t const param_id = ptk_anm2_param_insert(doc, item_id, 0, "key", "value", &err);
+        if (!TEST_SUCCEEDED(param_id != 0, &err)) {
+          goto cleanup;
+        }
+        param_ids[i * bench_params_per_item + j] = param_id;
+      }
+    }
+    result->insert_ns = (ptk_bench_now() - start) * 1e9 / (double)num_items;
+  }
+
+  // Shuffle so that lookups do not follow insertion order
+  {
+    size_t const n = num_items * bench_params_per_item;
+    uint32_t seed = 12345;
+    for (size_t i = n - 1; i > 0; i--) {
+      seed = seed * 1103515245 + 12345;
+      size_t const j = (seed >> 8) % (i + 1);
+      uint32_t const tmp = param_ids[i];
+      param_ids[i] = param_ids[j];
+      param_ids[j] = tmp;
+    }
+  }
+
+  ptk_anm2_clear_undo_history(doc);
+  {
+    size_t const n = num_items * bench_params_per_item;
+    double const start = ptk_bench_now();
+    for (size_t i = 0; i < n; i++) {
+      if (!TEST_SUCCEEDED(ptk_anm2_param_set_value(doc, param_ids[i], "edited", &err), &err)) {
+        goto cleanup;
+      }
+    }
+    result->edit_ns = (ptk_bench_now() - start) * 1e9 / (double)n;
+  }
+  {
+    size_t const n = num_items * bench_params_per_item;
+    double const start = ptk_bench_now();
+    for (size_t i = 0; i < n; i++) {
+      if (!TEST_SUCCEEDED(ptk_anm2_undo(doc, &err), &err)) {
+        goto cleanup;
+      }
+    }
+    result->undo_ns = (ptk_bench_now() - start) * 1e9 / (double)n;
+  }
+  TEST_CHECK(strcmp(ptk_anm2_param_get_value(doc, param_ids[0]), "value") == 0);
+
+  success = true;
+
+cleanup:
+  if (param_ids) {
+    OV_ARRAY_DESTROY(&param_ids);
+  }
+  if (selector_ids) {
+    OV_ARRAY_DESTROY(&selector_ids);
+  }
+  ptk_anm2_destroy(&doc);
+  return success;
+}
+
+// Per-operation times should stay flat as the document grows.
+// The ID index itself is checked by test_id_index_large_document in anm2_test.c.
+static void bench_anm2_id_lookup_scaling(void) {
+  static size_t const sizes[] = {1000, 4000, 16000};
+  for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+    struct bench_result result = {0};
+    if (!run_bench(sizes[i], &result)) {
+      return;
+    }
+    printf("items=%6zu  insert %8.0f ns/item  edit %8.0f ns/op  undo %8.0f ns/op\n",
+           sizes[i],
+           result.insert_ns,
+           result.edit_ns,
+           result.undo_ns);
+  }
+}
+
+enum {
+  bench_save_items = 10000,
+  bench_save_iterations = 5,
+};
+
+// Build a document with bench_save_items items, half values and half animations, and time script generation
+static void bench_anm2_save_10k(void) {
+  struct ov_error err = {0};
+  struct ptk_anm2 *doc = NULL;
+  char *content = NULL;
+
+  doc = ptk_anm2_create(&err);
+  if (!TEST_SUCCEEDED(doc != NULL, &err)) {
+    goto cleanup;
+  }
+  if (!TEST_SUCCEEDED(ptk_anm2_set_psd_path(doc, "C:/path/to/character.psd", &err), &err)) {
+    goto cleanup;
+  }
+  {
+    uint32_t selector_id = 0;
+    for (size_t i = 0; i < bench_save_items; i++) {
+      if (i % (bench_save_items / bench_selectors) == 0) {
+        selector_id = ptk_anm2_selector_insert(doc, 0, "Group", 0, &err);
+        if (!TEST_SUCCEEDED(selector_id != 0, &err)) {
+          goto cleanup;
+        }
+      }
+      char name[64];
+      ov_snprintf_char(name, sizeof(name), "%1$zu", "Layer %1$zu", i);
+      if (i % 2 == 0) {
+        if (!TEST_SUCCEEDED(
+                ptk_anm2_item_insert_value(doc, selector_id, name, "v1.PSD/Layer/Path \"quoted\"", &err) != 0,
+                &err)) {
+          goto cleanup;
+        }
+        continue;
+      }
+      uint32_t const item_id = ptk_anm2_item_insert_animation(doc, selector_id, "PSDToolKit.Blinker", name, &err);
+      if (!TEST_SUCCEEDED(item_id != 0, &err)) {
+        goto cleanup;
+      }
+      for (size_t j = 0; j < bench_params_per_item; j++) {
+        if (!TEST_SUCCEEDED(ptk_anm2_param_insert(doc, item_id, 0, "key", "value", &err) != 0, &err)) {
+          goto cleanup;
+        }
+      }
+    }
+  }
+
+  {
+    double best = 0;
+    for (size_t i = 0; i < bench_save_iterations; i++) {
+      if (content) {
+        OV_ARRAY_SET_LENGTH(content, 0);
+      }
+      double const start = ptk_bench_now();
+      if (!TEST_SUCCEEDED(generate_script_content(doc, &content, &err), &err)) {
+        goto cleanup;
+      }
+      double const elapsed = ptk_bench_now() - start;
+      if (i == 0 || elapsed < best) {
+        best = elapsed;
+      }
+    }
+    printf("save items=%6d  %8.3f ms  %zu bytes\n", bench_save_items, best * 1e3, OV_ARRAY_LENGTH(content));
+  }
+
+  // The embedded checksum must match the one calculated on load
+  {
+    char const *const newline = strchr(content, '\n');
+    char const *const found = strstr(content, "\"checksum\":\"");
+    if (!TEST_CHECK(newline != NULL && found != NULL && found < newline)) {
+      goto cleanup;
+    }
+    char const *const body = newline + 1;
+    char expected[17];
+    ov_snprintf_char(expected,
+                     sizeof(expected),
+                     "%016llx",
+                     "%016llx",
+                     (unsigned long long)calculate_checksum(body, strlen(body)));
+    TEST_CHECK(strncmp(found + strlen("\"checksum\":\""), expected, 16) == 0);
+    TEST_MSG("expected %s", expected);
+  }
+
+cleanup:
+  if (content) {
+    OV_ARRAY_DESTROY(&content);
+  }
+  ptk_anm2_destroy(&doc);
+}
+
+enum {
+  bench_list_items = 200,
+  bench_list_files = 200,
+};
+
+// Open the same file bench_list_files times, as listing a folder of anm2 files would,
+// once with ptk_anm2_load and once with ptk_anm2_view_open
+static void bench_anm2_view_vs_load(void) {
+  struct ov_error err = {0};
+  struct ptk_anm2 *doc = NULL;
+  struct ptk_anm2 *loaded = NULL;
+  wchar_t temp_dir[MAX_PATH] = {0};
+  wchar_t temp_path[MAX_PATH] = {0};
+  double load_ns = 0;
+  double view_ns = 0;
+
+  if (!TEST_CHECK(GetTempPathW(MAX_PATH, temp_dir) != 0) ||
+      !TEST_CHECK(GetTempFileNameW(temp_dir, L"anm2", 0, temp_path) != 0)) {
+    goto cleanup;
+  }
+
+  doc = ptk_anm2_create(&err);
+  if (!TEST_SUCCEEDED(doc != NULL, &err)) {
+    goto cleanup;
+  }
+  if (!TEST_SUCCEEDED(ptk_anm2_set_psd_path(doc, "C:/path/to/character.psd", &err), &err)) {
+    goto cleanup;
+  }
+  {
+    uint32_t selector_id = 0;
+    for (size_t i = 0; i < bench_list_items; i++) {
+      if (i % (bench_list_items / bench_selectors) == 0) {
+        selector_id = ptk_anm2_selector_insert(doc, 0, "Group", 0, &err);
+        if (!TEST_SUCCEEDED(selector_id != 0, &err)) {
+          goto cleanup;
+        }
+      }
+      char name[64];
+      ov_snprintf_char(name, sizeof(name), "%1$zu", "Layer %1$zu", i);
+      if (!TEST_SUCCEEDED(ptk_anm2_item_insert_value(doc, selector_id, name, "v1.PSD/Layer/Path", &err) != 0, &err)) {
+        goto cleanup;
+      }
+    }
+  }
+  if (!TEST_SUCCEEDED(ptk_anm2_save(doc, temp_path, &err), &err)) {
+    goto cleanup;
+  }
+
+  loaded = ptk_anm2_create(&err);
+  if (!TEST_SUCCEEDED(loaded != NULL, &err)) {
+    goto cleanup;
+  }
+  {
+    double const start = ptk_bench_now();
+    for (size_t i = 0; i < bench_list_files; i++) {
+      if (!TEST_SUCCEEDED(ptk_anm2_load(loaded, temp_path, &err), &err)) {
+        goto cleanup;
+      }
+    }
+    load_ns = (ptk_bench_now() - start) * 1e9 / (double)bench_list_files;
+  }
+  {
+    double const start = ptk_bench_now();
+    for (size_t i = 0; i < bench_list_files; i++) {
+      struct ptk_anm2_view *view = ptk_anm2_view_open(temp_path, &err);
+      if (!TEST_SUCCEEDED(view != NULL, &err)) {
+        goto cleanup;
+      }
+      bool const ok = ptk_anm2_view_item_count(view, 0) == bench_list_items / bench_selectors;
+      ptk_anm2_view_close(&view);
+      if (!TEST_CHECK(ok)) {
+        goto cleanup;
+      }
+    }
+    view_ns = (ptk_bench_now() - start) * 1e9 / (double)bench_list_files;
+  }
+  printf("list items=%4d  load %10.0f ns/file  view %10.0f ns/file\n", bench_list_items, load_ns, view_ns);
+
+cleanup:
+  if (temp_path[0] != L'\0') {
+    DeleteFileW(temp_path);
+  }
+  ptk_anm2_destroy(&loaded);
+  ptk_anm2_destroy(&doc);
+}
+
+TEST_LIST = {
+    {"bench_anm2_id_lookup_scaling", bench_anm2_id_lookup_scaling},
+    {"bench_anm2_save_10k", bench_anm2_save_10k},
+    {"bench_anm2_view_vs_load", bench_anm2_view_vs_load},
+    {NULL, NULL},
+};
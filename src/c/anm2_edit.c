@@ -16,6 +16,7 @@ struct ptk_anm2_edit {
   struct ptk_anm2 *doc;
   struct anm2_selection *selection;
   struct ptk_anm2_script_mapper *script_mapper;
+  struct ptk_anm2_checksum_cache *checksum_cache;
   ptk_anm2_edit_view_callback view_callback;
   void *view_userdata;
   // Transaction tracking for group_begin/group_end events during UNDO/REDO
@@ -109,6 +110,7 @@ NODISCARD struct ptk_anm2_edit *ptk_anm2_edit_create(struct ov_error *err) {
   struct ptk_anm2_edit *out = NULL;
   struct ptk_anm2 *doc = NULL;
   struct ptk_anm2_script_mapper *script_mapper = NULL;
+  struct ptk_anm2_checksum_cache *checksum_cache = NULL;
 
   doc = ptk_anm2_create(err);
   if (!doc) {
@@ -123,6 +125,12 @@ NODISCARD struct ptk_anm2_edit *ptk_anm2_edit_create(struct ov_error *err) {
     OV_ERROR_REPORT(err, NULL);
   }
 
+  checksum_cache = ptk_anm2_checksum_cache_create(err);
+  if (!checksum_cache) {
+    OV_ERROR_ADD_TRACE(err);
+    goto cleanup;
+  }
+
   if (!OV_REALLOC(&out, 1, sizeof(*out))) {
     OV_ERROR_SET_GENERIC(err, ov_error_generic_out_of_memory);
     goto cleanup;
@@ -130,8 +138,10 @@ NODISCARD struct ptk_anm2_edit *ptk_anm2_edit_create(struct ov_error *err) {
   *out = (struct ptk_anm2_edit){
       .doc = doc,
       .script_mapper = script_mapper,
+      .checksum_cache = checksum_cache,
   };
-  script_mapper = NULL; // Ownership transferred
+  script_mapper = NULL;  // Ownership transferred
+  checksum_cache = NULL; // Ownership transferred
 
   out->selection = anm2_selection_create(doc, err);
   if (!out->selection) {
@@ -146,6 +156,7 @@ NODISCARD struct ptk_anm2_edit *ptk_anm2_edit_create(struct ov_error *err) {
   return out;
 
 cleanup:
+  ptk_anm2_checksum_cache_destroy(&checksum_cache);
   if (script_mapper) {
     ptk_anm2_script_mapper_destroy(&script_mapper);
   }
@@ -171,6 +182,7 @@ void ptk_anm2_edit_destroy(struct ptk_anm2_edit **edit) {
   if (p->script_mapper) {
     ptk_anm2_script_mapper_destroy(&p->script_mapper);
   }
+  ptk_anm2_checksum_cache_destroy(&p->checksum_cache);
   OV_FREE(&p);
   *edit = NULL;
 }
@@ -330,6 +342,17 @@ void ptk_anm2_edit_update_on_doc_op(
     notify_view(edit, &event);
     break;
 
+  case ptk_anm2_op_batch:
+    // Batch of operations: keep valid selections and request full rebuild
+    anm2_selection_refresh(edit->selection);
+    event.op = ptk_anm2_edit_view_treeview_rebuild;
+    notify_view(edit, &event);
+    event.op = ptk_anm2_edit_view_treeview_select;
+    notify_view(edit, &event);
+    event.op = ptk_anm2_edit_view_detail_refresh;
+    notify_view(edit, &event);
+    break;
+
   case ptk_anm2_op_selector_insert:
     event.op = ptk_anm2_edit_view_treeview_insert_selector;
     event.is_selector = true;
@@ -1431,24 +1454,41 @@ NODISCARD bool ptk_anm2_edit_end_transaction(struct ptk_anm2_edit *edit, bool su
   return true;
 }
 
-ov_tribool ptk_anm2_edit_verify_file_checksum(wchar_t const *path, struct ov_error *err) {
-  if (!path) {
+NODISCARD bool ptk_anm2_edit_begin_batch(struct ptk_anm2_edit *edit, struct ov_error *err) {
+  if (!edit || !edit->doc) {
     OV_ERROR_SET_GENERIC(err, ov_error_generic_invalid_argument);
-    return ov_indeterminate;
+    return false;
   }
-  struct ptk_anm2 *temp_doc = ptk_anm2_create(err);
-  if (!temp_doc) {
+  if (!ptk_anm2_begin_batch(edit->doc, err)) {
     OV_ERROR_ADD_TRACE(err);
+    return false;
+  }
+  return true;
+}
+
+NODISCARD bool ptk_anm2_edit_end_batch(struct ptk_anm2_edit *edit, bool success, struct ov_error *err) {
+  if (!edit || !edit->doc) {
+    OV_ERROR_SET_GENERIC(err, ov_error_generic_invalid_argument);
+    return false;
+  }
+  if (!ptk_anm2_end_batch(edit->doc, success ? err : NULL)) {
+    if (success) {
+      OV_ERROR_ADD_TRACE(err);
+    }
+    return false;
+  }
+  return true;
+}
+
+ov_tribool ptk_anm2_edit_verify_file_checksum(struct ptk_anm2_edit *edit, wchar_t const *path, struct ov_error *err) {
+  if (!edit || !path) {
+    OV_ERROR_SET_GENERIC(err, ov_error_generic_invalid_argument);
     return ov_indeterminate;
   }
-  ov_tribool result = ov_indeterminate;
-  if (!ptk_anm2_load(temp_doc, path, err)) {
+  ov_tribool const result = ptk_anm2_verify_file_checksum(edit->checksum_cache, path, err);
+  if (result == ov_indeterminate) {
     OV_ERROR_ADD_TRACE(err);
-    goto cleanup;
   }
-  result = ptk_anm2_verify_checksum(temp_doc) ? ov_true : ov_false;
-cleanup:
-  ptk_anm2_destroy(&temp_doc);
   return result;
 }
 
@@ -216,9 +216,14 @@ NODISCARD bool ptk_anm2_edit_redo(struct ptk_anm2_edit *edit, struct ov_error *e
 NODISCARD bool ptk_anm2_edit_begin_transaction(struct ptk_anm2_edit *edit, struct ov_error *err);
 NODISCARD bool ptk_anm2_edit_end_transaction(struct ptk_anm2_edit *edit, bool success, struct ov_error *err);
 
+// Batch support: a transaction whose changes are notified as one view rebuild
+NODISCARD bool ptk_anm2_edit_begin_batch(struct ptk_anm2_edit *edit, struct ov_error *err);
+NODISCARD bool ptk_anm2_edit_end_batch(struct ptk_anm2_edit *edit, bool success, struct ov_error *err);
+
 // Verify checksum of a file without loading it
+// Results are cached per path until the file size or last write time changes.
 // Returns: ov_true = checksum matches, ov_false = checksum mismatch (manually edited), ov_indeterminate = error
-ov_tribool ptk_anm2_edit_verify_file_checksum(wchar_t const *path, struct ov_error *err);
+ov_tribool ptk_anm2_edit_verify_file_checksum(struct ptk_anm2_edit *edit, wchar_t const *path, struct ov_error *err);
 
 NODISCARD bool ptk_anm2_edit_load(struct ptk_anm2_edit *edit, wchar_t const *path, struct ov_error *err);
 NODISCARD bool ptk_anm2_edit_save(struct ptk_anm2_edit *edit, wchar_t const *path, struct ov_error *err);
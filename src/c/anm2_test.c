@@ -1038,6 +1038,219 @@ cleanup:
   ptk_anm2_destroy(&doc);
 }
 
+// Check that every element is found at its actual position and that removed IDs are not indexed
+static bool id_index_matches_layout(struct ptk_anm2 const *doc) {
+  size_t total = 0;
+  size_t const sel_count = OV_ARRAY_LENGTH(doc->selectors);
+  for (size_t i = 0; i < sel_count; i++) {
+    struct selector const *sel = &doc->selectors[i];
+    size_t sel_idx = SIZE_MAX;
+    if (!ptk_anm2_find_selector(doc, sel->id, &sel_idx) || sel_idx != i) {
+      TEST_MSG("selector %u at %zu", sel->id, i);
+      return false;
+    }
+    ++total;
+    size_t const item_count = OV_ARRAY_LENGTH(sel->items);
+    for (size_t j = 0; j < item_count; j++) {
+      struct item const *it = &sel->items[j];
+      size_t item_idx = SIZE_MAX;
+      if (!ptk_anm2_find_item(doc, it->id, &sel_idx, &item_idx) || sel_idx != i || item_idx != j) {
+        TEST_MSG("item %u at %zu/%zu", it->id, i, j);
+        return false;
+      }
+      ++total;
+      size_t const param_count = OV_ARRAY_LENGTH(it->params);
+      for (size_t k = 0; k < param_count; k++) {
+        size_t param_idx = SIZE_MAX;
+        if (!ptk_anm2_find_param(doc, it->params[k].id, &sel_idx, &item_idx, &param_idx) || sel_idx != i ||
+            item_idx != j || param_idx != k) {
+          TEST_MSG("param %u at %zu/%zu/%zu", it->params[k].id, i, j, k);
+          return false;
+        }
+        ++total;
+      }
+    }
+  }
+  if (OV_HASHMAP_COUNT(doc->id_index) != total) {
+    TEST_MSG("index has %zu entries, document has %zu elements", OV_HASHMAP_COUNT(doc->id_index), total);
+    return false;
+  }
+  return true;
+}
+
+static uint32_t random_item_id(struct ptk_anm2 const *doc, uint32_t r) {
+  size_t const sel_count = OV_ARRAY_LENGTH(doc->selectors);
+  if (sel_count == 0) {
+    return 0;
+  }
+  struct selector const *sel = &doc->selectors[r % sel_count];
+  size_t const item_count = OV_ARRAY_LENGTH(sel->items);
+  if (item_count == 0) {
+    return 0;
+  }
+  return sel->items[(r / 7) % item_count].id;
+}
+
+static void test_id_index_consistency(void) {
+  struct ov_error err = {0};
+  struct ptk_anm2 *doc = ptk_anm2_create(&err);
+  TEST_ASSERT_SUCCEEDED(doc != NULL, &err);
+
+  uint32_t seed = 12345;
+  for (int step = 0; step < 400; step++) {
+    seed = seed * 1103515245 + 12345;
+    uint32_t const r = seed >> 8;
+    size_t const sel_count = OV_ARRAY_LENGTH(doc->selectors);
+    uint32_t const sel_id = sel_count ? doc->selectors[r % sel_count].id : 0;
+    uint32_t const item_id = random_item_id(doc, r);
+    switch (sel_count < 2 ? 0 : r % 9) {
+    case 0:
+      TEST_CHECK(ptk_anm2_selector_insert(doc, sel_id, "Group", 0, &err) != 0);
+      break;
+    case 1:
+      TEST_CHECK(ptk_anm2_item_insert_value(doc, item_id ? item_id : sel_id, "Item", "value", &err) != 0);
+      break;
+    case 2:
+      TEST_CHECK(ptk_anm2_item_insert_animation(doc, item_id ? item_id : sel_id, "Script", "Anim", &err) != 0);
+      break;
+    case 3:
+      if (item_id) {
+        TEST_CHECK(ptk_anm2_item_remove(doc, item_id, &err));
+      }
+      break;
+    case 4:
+      if (item_id) {
+        uint32_t const before_id = random_item_id(doc, r / 3);
+        if (before_id != item_id) {
+          TEST_CHECK(ptk_anm2_item_move(doc, item_id, before_id ? before_id : sel_id, &err));
+        }
+      }
+      break;
+    case 5:
+    case 6:
+      if (item_id && ptk_anm2_item_is_animation(doc, item_id)) {
+        size_t sel_idx = 0, item_idx = 0;
+        TEST_CHECK(ptk_anm2_find_item(doc, item_id, &sel_idx, &item_idx));
+        struct item const *it = &doc->selectors[sel_idx].items[item_idx];
+        size_t const param_count = OV_ARRAY_LENGTH(it->params);
+        if (param_count > 2 && r % 9 == 6) {
+          TEST_CHECK(ptk_anm2_param_remove(doc, it->params[(r / 5) % param_count].id, &err));
+        } else {
+          uint32_t const before_id = param_count ? it->params[(r / 5) % param_count].id : 0;
+          TEST_CHECK(ptk_anm2_param_insert(doc, item_id, before_id, "key", "value", &err) != 0);
+        }
+      }
+      break;
+    case 7:
+      TEST_CHECK(ptk_anm2_selector_move(doc, sel_id, doc->selectors[(r / 3) % sel_count].id, &err));
+      break;
+    case 8:
+      if (sel_count > 3) {
+        TEST_CHECK(ptk_anm2_selector_remove(doc, sel_id, &err));
+      }
+      break;
+    }
+    if (!TEST_CHECK(id_index_matches_layout(doc))) {
+      TEST_MSG("after step %d", step);
+      goto cleanup;
+    }
+  }
+
+  while (ptk_anm2_can_undo(doc)) {
+    TEST_CHECK(ptk_anm2_undo(doc, &err));
+    if (!TEST_CHECK(id_index_matches_layout(doc))) {
+      TEST_MSG("after undo");
+      goto cleanup;
+    }
+  }
+  TEST_CHECK(OV_ARRAY_LENGTH(doc->selectors) == 0);
+  while (ptk_anm2_can_redo(doc)) {
+    TEST_CHECK(ptk_anm2_redo(doc, &err));
+    if (!TEST_CHECK(id_index_matches_layout(doc))) {
+      TEST_MSG("after redo");
+      goto cleanup;
+    }
+  }
+
+  // Lookups keep working while the index is stale and the next edit rebuilds it
+  doc->id_index_stale = true;
+  TEST_CHECK(ptk_anm2_find_selector(doc, doc->selectors[0].id, NULL));
+  TEST_CHECK(ptk_anm2_selector_insert(doc, 0, "Group", 0, &err) != 0);
+  TEST_CHECK(!doc->id_index_stale);
+  TEST_CHECK(id_index_matches_layout(doc));
+
+cleanup:
+  ptk_anm2_destroy(&doc);
+}
+
+// Edits and undos in a large document must resolve every ID through the index.
+// A stale index would make each lookup scan the whole document.
+static void test_id_index_large_document(void) {
+  enum {
+    num_selectors = 16,
+    num_items = 4000,
+    params_per_item = 2,
+  };
+  struct ov_error err = {0};
+  uint32_t *param_ids = NULL;
+  struct ptk_anm2 *doc = ptk_anm2_create(&err);
+  TEST_ASSERT_SUCCEEDED(doc != NULL, &err);
+
+  uint32_t selector_ids[num_selectors] = {0};
+  for (size_t i = 0; i < num_selectors; i++) {
+    selector_ids[i] = ptk_anm2_selector_insert(doc, 0, "Group", 0, &err);
+    if (!TEST_SUCCEEDED(selector_ids[i] != 0, &err)) {
+      goto cleanup;
+    }
+  }
+  if (!TEST_CHECK(OV_ARRAY_GROW(&param_ids, num_items * params_per_item))) {
+    goto cleanup;
+  }
+  for (size_t i = 0; i < num_items; i++) {
+    uint32_t const item_id =
+        ptk_anm2_item_insert_animation(doc, selector_ids[i % num_selectors], "PSDToolKit.Blinker", "Blinker", &err);
+    if (!TEST_SUCCEEDED(item_id != 0, &err)) {
+      goto cleanup;
+    }
+    for (size_t j = 0; j < params_per_item; j++) {
+      uint32_t const param_id = ptk_anm2_param_insert(doc, item_id, 0, "key", "value", &err);
+      if (!TEST_SUCCEEDED(param_id != 0, &err)) {
+        goto cleanup;
+      }
+      param_ids[i * params_per_item + j] = param_id;
+    }
+  }
+  ptk_anm2_clear_undo_history(doc);
+
+  size_t const num_elements = num_selectors + num_items * (1 + params_per_item);
+  if (!TEST_CHECK(!doc->id_index_stale) || !TEST_CHECK(OV_HASHMAP_COUNT(doc->id_index) == num_elements)) {
+    TEST_MSG("index has %zu entries, want %zu", OV_HASHMAP_COUNT(doc->id_index), num_elements);
+    goto cleanup;
+  }
+  for (size_t i = 0; i < num_items * params_per_item; i++) {
+    if (!TEST_SUCCEEDED(ptk_anm2_param_set_value(doc, param_ids[i], "edited", &err), &err)) {
+      goto cleanup;
+    }
+  }
+  if (!TEST_CHECK(!doc->id_index_stale) || !TEST_CHECK(OV_HASHMAP_COUNT(doc->id_index) == num_elements)) {
+    goto cleanup;
+  }
+  for (size_t i = 0; i < num_items * params_per_item; i++) {
+    if (!TEST_SUCCEEDED(ptk_anm2_undo(doc, &err), &err)) {
+      goto cleanup;
+    }
+  }
+  TEST_CHECK(!doc->id_index_stale);
+  TEST_CHECK(id_index_matches_layout(doc));
+  TEST_CHECK(strcmp(ptk_anm2_param_get_value(doc, param_ids[0]), "value") == 0);
+
+cleanup:
+  if (param_ids) {
+    OV_ARRAY_DESTROY(&param_ids);
+  }
+  ptk_anm2_destroy(&doc);
+}
+
 static void test_find_param_by_id(void) {
   struct ov_error err = {0};
   uint32_t sel_id1 = 0;
@@ -1514,6 +1727,104 @@ cleanup:
   ptk_anm2_destroy(&doc);
 }
 
+static void test_change_callback_batch(void) {
+  struct ov_error err = {0};
+  struct callback_tracker tracker = {0};
+  uint32_t sel_id = 0;
+  struct ptk_anm2 *doc = ptk_anm2_create(&err);
+  TEST_ASSERT_SUCCEEDED(doc != NULL, &err);
+
+  ptk_anm2_set_change_callback(doc, test_change_callback_fn, &tracker);
+
+  // All operations in a batch are notified once, including nested transactions
+  callback_tracker_clear(&tracker);
+  if (!TEST_SUCCEEDED(ptk_anm2_begin_batch(doc, &err), &err)) {
+    goto cleanup;
+  }
+  sel_id = ptk_anm2_selector_insert(doc, 0, "Group1", 0, &err);
+  if (!TEST_SUCCEEDED(sel_id != 0, &err)) {
+    goto cleanup;
+  }
+  for (int i = 0; i < 500; i++) {
+    if (!TEST_SUCCEEDED(ptk_anm2_item_insert_value(doc, sel_id, "Item", "value", &err) != 0, &err)) {
+      goto cleanup;
+    }
+  }
+  if (!TEST_SUCCEEDED(ptk_anm2_begin_transaction(doc, &err), &err)) {
+    goto cleanup;
+  }
+  if (!TEST_SUCCEEDED(ptk_anm2_set_label(doc, "Label", &err), &err)) {
+    goto cleanup;
+  }
+  if (!TEST_SUCCEEDED(ptk_anm2_end_transaction(doc, &err), &err)) {
+    goto cleanup;
+  }
+  TEST_CHECK(tracker.count == 0);
+  TEST_MSG("want no callbacks inside batch, got %zu", tracker.count);
+  if (!TEST_SUCCEEDED(ptk_anm2_end_batch(doc, &err), &err)) {
+    goto cleanup;
+  }
+  TEST_CHECK(tracker.count == 1);
+  TEST_MSG("want 1 callback for batch, got %zu", tracker.count);
+  if (tracker.count >= 1) {
+    TEST_CHECK(tracker.records[0].op_type == ptk_anm2_op_batch);
+  }
+  TEST_CHECK(ptk_anm2_item_count(doc, sel_id) == 500);
+
+  // The batch is undone and redone as a single step with a single notification
+  callback_tracker_clear(&tracker);
+  if (!TEST_SUCCEEDED(ptk_anm2_undo(doc, &err), &err)) {
+    goto cleanup;
+  }
+  TEST_CHECK(tracker.count == 1);
+  TEST_MSG("want 1 callback for undo of batch, got %zu", tracker.count);
+  if (tracker.count >= 1) {
+    TEST_CHECK(tracker.records[0].op_type == ptk_anm2_op_batch);
+  }
+  TEST_CHECK(ptk_anm2_selector_count(doc) == 0);
+  TEST_CHECK(!ptk_anm2_can_undo(doc));
+
+  callback_tracker_clear(&tracker);
+  if (!TEST_SUCCEEDED(ptk_anm2_redo(doc, &err), &err)) {
+    goto cleanup;
+  }
+  TEST_CHECK(tracker.count == 1);
+  TEST_MSG("want 1 callback for redo of batch, got %zu", tracker.count);
+  if (tracker.count >= 1) {
+    TEST_CHECK(tracker.records[0].op_type == ptk_anm2_op_batch);
+  }
+  TEST_CHECK(ptk_anm2_item_count(doc, sel_id) == 500);
+  TEST_CHECK(strcmp(ptk_anm2_get_label(doc), "Label") == 0);
+
+  // An empty batch is not notified
+  callback_tracker_clear(&tracker);
+  if (!TEST_SUCCEEDED(ptk_anm2_begin_batch(doc, &err), &err)) {
+    goto cleanup;
+  }
+  if (!TEST_SUCCEEDED(ptk_anm2_end_batch(doc, &err), &err)) {
+    goto cleanup;
+  }
+  TEST_CHECK(tracker.count == 0);
+
+  // Operations after the batch are notified individually again
+  callback_tracker_clear(&tracker);
+  if (!TEST_SUCCEEDED(ptk_anm2_selector_insert(doc, 0, "Group2", 0, &err) != 0, &err)) {
+    goto cleanup;
+  }
+  TEST_CHECK(tracker.count == 1);
+  if (tracker.count >= 1) {
+    TEST_CHECK(tracker.records[0].op_type == ptk_anm2_op_selector_insert);
+  }
+
+  // Ending a batch that was not started fails
+  TEST_CHECK(!ptk_anm2_end_batch(doc, &err));
+  OV_ERROR_DESTROY(&err);
+
+cleanup:
+  callback_tracker_destroy(&tracker);
+  ptk_anm2_destroy(&doc);
+}
+
 static void test_undo_clears_redo(void) {
   struct ov_error err = {0};
   struct ptk_anm2 *doc = ptk_anm2_create(&err);
@@ -1587,6 +1898,173 @@ static void test_redo_empty_returns_false(void) {
   ptk_anm2_destroy(&doc);
 }
 
+// Helper to create a temporary file path
+static bool create_temp_path(wchar_t *buf, size_t buf_size) {
+#ifdef _WIN32
+  wchar_t temp_dir[MAX_PATH];
+  if (!GetTempPathW(MAX_PATH, temp_dir)) {
+    return false;
+  }
+  if (!GetTempFileNameW(temp_dir, L"anm2", 0, buf)) {
+    return false;
+  }
+  // Add .lua extension
+  size_t len = wcslen(buf);
+  if (len + 5 >= buf_size) {
+    return false;
+  }
+  wcscat(buf, L".lua");
+  return true;
+#else
+  (void)buf;
+  (void)buf_size;
+  return false;
+#endif
+}
+
+static void delete_temp_file(wchar_t const *path) {
+#ifdef _WIN32
+  DeleteFileW(path);
+  // Also delete the original temp file (without .lua extension)
+  wchar_t base_path[MAX_PATH];
+  wcscpy(base_path, path);
+  size_t len = wcslen(base_path);
+  if (len > 4 && wcscmp(base_path + len - 4, L".lua") == 0) {
+    base_path[len - 4] = L'\0';
+    DeleteFileW(base_path);
+  }
+#else
+  (void)path;
+#endif
+}
+
+static void test_undo_memory_limit(void) {
+  struct ov_error err = {0};
+  char value[128];
+  wchar_t temp_path[MAX_PATH] = {0};
+  size_t limit = 0;
+  size_t undo_count = 0;
+  struct ptk_anm2 *doc = ptk_anm2_create(&err);
+  TEST_ASSERT_SUCCEEDED(doc != NULL, &err);
+
+  uint32_t const sel_id = ptk_anm2_selector_insert(doc, 0, "Group", 0, &err);
+  if (!TEST_SUCCEEDED(sel_id != 0, &err)) {
+    goto cleanup;
+  }
+  uint32_t const item_id = ptk_anm2_item_insert_value(doc, sel_id, "Item", "original", &err);
+  if (!TEST_SUCCEEDED(item_id != 0, &err)) {
+    goto cleanup;
+  }
+  ptk_anm2_clear_undo_history(doc);
+  TEST_CHECK(ptk_anm2_get_undo_memory_usage(doc) == 0);
+
+  // Oldest edits are discarded to stay within the budget
+  limit = 4096;
+  ptk_anm2_set_undo_memory_limit(doc, limit);
+  for (int i = 0; i < 1000; i++) {
+    ov_snprintf_char(value, sizeof(value), "%1$0100d", "%1$0100d", i);
+    if (!TEST_SUCCEEDED(ptk_anm2_item_set_value(doc, item_id, value, &err), &err)) {
+      goto cleanup;
+    }
+    if (!TEST_CHECK(ptk_anm2_get_undo_memory_usage(doc) <= limit)) {
+      TEST_MSG("edit %d: usage %zu exceeds limit %zu", i, ptk_anm2_get_undo_memory_usage(doc), limit);
+      goto cleanup;
+    }
+  }
+  while (ptk_anm2_can_undo(doc)) {
+    if (!TEST_SUCCEEDED(ptk_anm2_undo(doc, &err), &err)) {
+      goto cleanup;
+    }
+    undo_count++;
+  }
+  TEST_CHECK(undo_count > 0 && undo_count < 1000);
+  TEST_MSG("undo_count=%zu", undo_count);
+  TEST_CHECK(strcmp(ptk_anm2_item_get_value(doc, item_id), "original") != 0);
+  TEST_CHECK(ptk_anm2_get_undo_memory_usage(doc) == 0);
+
+  // The newest step is kept as a whole even if it exceeds the budget
+  ptk_anm2_clear_undo_history(doc);
+  ptk_anm2_set_undo_memory_limit(doc, 1);
+  if (!TEST_SUCCEEDED(ptk_anm2_item_set_value(doc, item_id, "before", &err), &err)) {
+    goto cleanup;
+  }
+  if (!TEST_SUCCEEDED(ptk_anm2_begin_transaction(doc, &err), &err)) {
+    goto cleanup;
+  }
+  for (int i = 0; i < 3; i++) {
+    ov_snprintf_char(value, sizeof(value), "group%1$d", "group%1$d", i);
+    if (!TEST_SUCCEEDED(ptk_anm2_item_set_value(doc, item_id, value, &err), &err)) {
+      goto cleanup;
+    }
+  }
+  if (!TEST_SUCCEEDED(ptk_anm2_end_transaction(doc, &err), &err)) {
+    goto cleanup;
+  }
+  if (!TEST_SUCCEEDED(ptk_anm2_undo(doc, &err), &err)) {
+    goto cleanup;
+  }
+  TEST_CHECK(strcmp(ptk_anm2_item_get_value(doc, item_id), "before") == 0);
+  TEST_CHECK(!ptk_anm2_can_undo(doc));
+
+  // Redo restores the group and the budget applies again
+  if (!TEST_SUCCEEDED(ptk_anm2_redo(doc, &err), &err)) {
+    goto cleanup;
+  }
+  TEST_CHECK(strcmp(ptk_anm2_item_get_value(doc, item_id), "group2") == 0);
+
+  // 0 means unlimited
+  ptk_anm2_clear_undo_history(doc);
+  ptk_anm2_set_undo_memory_limit(doc, 0);
+  for (int i = 0; i < 1000; i++) {
+    ov_snprintf_char(value, sizeof(value), "%1$0100d", "%1$0100d", i);
+    if (!TEST_SUCCEEDED(ptk_anm2_item_set_value(doc, item_id, value, &err), &err)) {
+      goto cleanup;
+    }
+  }
+  undo_count = 0;
+  while (ptk_anm2_can_undo(doc)) {
+    if (!TEST_SUCCEEDED(ptk_anm2_undo(doc, &err), &err)) {
+      goto cleanup;
+    }
+    undo_count++;
+  }
+  TEST_CHECK(undo_count == 1000);
+  TEST_CHECK(strcmp(ptk_anm2_item_get_value(doc, item_id), "group2") == 0);
+
+  // The limit is kept when a document is loaded
+  if (!TEST_CHECK(create_temp_path(temp_path, MAX_PATH))) {
+    goto cleanup;
+  }
+  if (!TEST_SUCCEEDED(ptk_anm2_set_psd_path(doc, "test.psd", &err), &err) ||
+      !TEST_SUCCEEDED(ptk_anm2_save(doc, temp_path, &err), &err)) {
+    goto cleanup;
+  }
+  limit = 4096;
+  ptk_anm2_set_undo_memory_limit(doc, limit);
+  if (!TEST_SUCCEEDED(ptk_anm2_load(doc, temp_path, &err), &err)) {
+    goto cleanup;
+  }
+  if (!TEST_CHECK(OV_ARRAY_LENGTH(doc->selectors) == 1 && OV_ARRAY_LENGTH(doc->selectors[0].items) == 1)) {
+    goto cleanup;
+  }
+  for (int i = 0; i < 1000; i++) {
+    ov_snprintf_char(value, sizeof(value), "%1$0100d", "%1$0100d", i);
+    if (!TEST_SUCCEEDED(ptk_anm2_item_set_value(doc, doc->selectors[0].items[0].id, value, &err), &err)) {
+      goto cleanup;
+    }
+    if (!TEST_CHECK(ptk_anm2_get_undo_memory_usage(doc) <= limit)) {
+      TEST_MSG("edit %d after load: usage %zu exceeds limit %zu", i, ptk_anm2_get_undo_memory_usage(doc), limit);
+      goto cleanup;
+    }
+  }
+
+cleanup:
+  if (temp_path[0] != L'\0') {
+    delete_temp_file(temp_path);
+  }
+  ptk_anm2_destroy(&doc);
+}
+
 static void test_invalid_selector_index(void) {
   struct ov_error err = {0};
   struct ptk_anm2 *doc = ptk_anm2_create(&err);
@@ -1852,46 +2330,6 @@ cleanup:
   ptk_anm2_destroy(&doc);
 }
 
-// Helper to create a temporary file path
-static bool create_temp_path(wchar_t *buf, size_t buf_size) {
-#ifdef _WIN32
-  wchar_t temp_dir[MAX_PATH];
-  if (!GetTempPathW(MAX_PATH, temp_dir)) {
-    return false;
-  }
-  if (!GetTempFileNameW(temp_dir, L"anm2", 0, buf)) {
-    return false;
-  }
-  // Add .lua extension
-  size_t len = wcslen(buf);
-  if (len + 5 >= buf_size) {
-    return false;
-  }
-  wcscat(buf, L".lua");
-  return true;
-#else
-  (void)buf;
-  (void)buf_size;
-  return false;
-#endif
-}
-
-static void delete_temp_file(wchar_t const *path) {
-#ifdef _WIN32
-  DeleteFileW(path);
-  // Also delete the original temp file (without .lua extension)
-  wchar_t base_path[MAX_PATH];
-  wcscpy(base_path, path);
-  size_t len = wcslen(base_path);
-  if (len > 4 && wcscmp(base_path + len - 4, L".lua") == 0) {
-    base_path[len - 4] = L'\0';
-    DeleteFileW(base_path);
-  }
-#else
-  (void)path;
-#endif
-}
-
 static void test_save_load_roundtrip(void) {
   struct ov_error err = {0};
   struct ptk_anm2 *doc = NULL;
@@ -2620,6 +3058,196 @@ cleanup:
   ptk_anm2_destroy(&loaded_doc);
 }
 
+static void test_calculate_checksum_chunked(void) {
+  static char const body[] = "--check@exclusive:Exclusive Support,1\nrequire(\"PSDToolKit\")\n";
+  size_t const body_len = sizeof(body) - 1;
+  char buf[sizeof(body) + 8];
+  uint64_t const expected = calculate_checksum(body, body_len);
+
+  // Any alignment and any chunk size must produce the same checksum
+  for (size_t offset = 0; offset < 4; offset++) {
+    memcpy(buf + offset, body, body_len);
+    for (size_t chunk = 1; chunk <= 9; chunk++) {
+      struct body_checksum bc;
+      body_checksum_init(&bc, offset);
+      for (size_t len = offset; len < offset + body_len; len += chunk) {
+        body_checksum_update(&bc, buf, len);
+      }
+      uint64_t const got = body_checksum_final(&bc, buf, offset + body_len);
+      if (!TEST_CHECK(got == expected)) {
+        TEST_MSG("offset=%zu chunk=%zu got=%016llx expected=%016llx",
+                 offset,
+                 chunk,
+                 (unsigned long long)got,
+                 (unsigned long long)expected);
+        return;
+      }
+    }
+  }
+  TEST_CHECK(calculate_checksum(body, 0) == 0);
+}
+
+static void test_verify_file_checksum(void) {
+  struct ov_error err = {0};
+  struct ptk_anm2 *doc = NULL;
+  struct ptk_anm2_checksum_cache *cache = NULL;
+  struct ovl_file *file = NULL;
+  char *content = NULL;
+  wchar_t temp_path[MAX_PATH] = {0};
+  uint32_t sel_id = 0;
+
+  doc = ptk_anm2_create(&err);
+  TEST_ASSERT_SUCCEEDED(doc != NULL, &err);
+  cache = ptk_anm2_checksum_cache_create(&err);
+  if (!TEST_SUCCEEDED(cache != NULL, &err)) {
+    goto cleanup;
+  }
+
+  if (!TEST_CHECK(create_temp_path(temp_path, MAX_PATH))) {
+    TEST_MSG("Failed to create temp path");
+    goto cleanup;
+  }
+
+  if (!TEST_SUCCEEDED(ptk_anm2_set_psd_path(doc, "test.psd", &err), &err)) {
+    goto cleanup;
+  }
+  sel_id = ptk_anm2_selector_insert(doc, 0, "Group", 0, &err);
+  if (!TEST_SUCCEEDED(sel_id != 0, &err)) {
+    goto cleanup;
+  }
+  if (!TEST_SUCCEEDED(ptk_anm2_item_insert_value(doc, sel_id, "Item", "path", &err), &err)) {
+    goto cleanup;
+  }
+  if (!TEST_SUCCEEDED(ptk_anm2_save(doc, temp_path, &err), &err)) {
+    goto cleanup;
+  }
+
+  // Unmodified file matches, with or without the cache
+  TEST_CHECK(ptk_anm2_verify_file_checksum(NULL, temp_path, &err) == ov_true);
+  TEST_CHECK(ptk_anm2_verify_file_checksum(cache, temp_path, &err) == ov_true);
+  TEST_CHECK(ptk_anm2_verify_file_checksum(cache, temp_path, &err) == ov_true);
+
+  // Edit the script body by hand, the cached result must not be reused
+  if (!TEST_SUCCEEDED(read_file_content(temp_path, &content, &err), &err)) {
+    goto cleanup;
+  }
+  if (!TEST_SUCCEEDED(ovl_file_create(temp_path, &file, &err), &err)) {
+    goto cleanup;
+  }
+  {
+    static char const edit[] = "-- edited\n";
+    size_t const len = strlen(content);
+    size_t written = 0;
+    if (!TEST_SUCCEEDED(ovl_file_write(file, content, len, &written, &err), &err)) {
+      goto cleanup;
+    }
+    if (!TEST_SUCCEEDED(ovl_file_write(file, edit, sizeof(edit) - 1, &written, &err), &err)) {
+      goto cleanup;
+    }
+  }
+  ovl_file_close(file);
+  file = NULL;
+
+  TEST_CHECK(ptk_anm2_verify_file_checksum(cache, temp_path, &err) == ov_false);
+  TEST_CHECK(ptk_anm2_verify_file_checksum(NULL, temp_path, &err) == ov_false);
+
+cleanup:
+  if (file) {
+    ovl_file_close(file);
+  }
+  if (content) {
+    OV_ARRAY_DESTROY(&content);
+  }
+  if (temp_path[0] != L'\0') {
+    delete_temp_file(temp_path);
+  }
+  ptk_anm2_checksum_cache_destroy(&cache);
+  ptk_anm2_destroy(&doc);
+}
+
+static void test_view_matches_load(void) {
+  struct ov_error err = {0};
+  struct ptk_anm2 *doc = NULL;
+  struct ptk_anm2_view *view = NULL;
+  wchar_t temp_path[MAX_PATH] = {0};
+  uint32_t sel_id = 0;
+  uint32_t anim_id = 0;
+
+  doc = ptk_anm2_create(&err);
+  TEST_ASSERT_SUCCEEDED(doc != NULL, &err);
+
+  if (!TEST_CHECK(create_temp_path(temp_path, MAX_PATH))) {
+    TEST_MSG("Failed to create temp path");
+    goto cleanup;
+  }
+
+  if (!TEST_SUCCEEDED(ptk_anm2_set_psd_path(doc, "C:\\path\\test.psd", &err), &err)) {
+    goto cleanup;
+  }
+  if (!TEST_SUCCEEDED(ptk_anm2_set_label(doc, "ラベル", &err), &err)) {
+    goto cleanup;
+  }
+  if (!TEST_SUCCEEDED(ptk_anm2_set_default_character_id(doc, "mychar", &err), &err)) {
+    goto cleanup;
+  }
+  sel_id = ptk_anm2_selector_insert(doc, 0, "Group \"1\"", 0, &err);
+  if (!TEST_SUCCEEDED(sel_id != 0, &err)) {
+    goto cleanup;
+  }
+  if (!TEST_SUCCEEDED(ptk_anm2_item_insert_value(doc, sel_id, "Item\tA", "v1.layer/a", &err), &err)) {
+    goto cleanup;
+  }
+  anim_id = ptk_anm2_item_insert_animation(doc, sel_id, "PSDToolKit.Blinker", "目パチ", &err);
+  if (!TEST_SUCCEEDED(anim_id != 0, &err)) {
+    goto cleanup;
+  }
+  if (!TEST_SUCCEEDED(ptk_anm2_selector_insert(doc, 0, "Empty", 0, &err) != 0, &err)) {
+    goto cleanup;
+  }
+  if (!TEST_SUCCEEDED(ptk_anm2_save(doc, temp_path, &err), &err)) {
+    goto cleanup;
+  }
+
+  view = ptk_anm2_view_open(temp_path, &err);
+  if (!TEST_SUCCEEDED(view != NULL, &err)) {
+    goto cleanup;
+  }
+  TEST_CHECK(strcmp(ptk_anm2_view_get_label(view), "ラベル") == 0);
+  TEST_CHECK(strcmp(ptk_anm2_view_get_psd_path(view), "C:\\path\\test.psd") == 0);
+  TEST_CHECK(strcmp(ptk_anm2_view_get_default_character_id(view), "mychar") == 0);
+  TEST_CHECK(ptk_anm2_view_get_information(view) == NULL);
+  if (!TEST_CHECK(ptk_anm2_view_selector_count(view) == 2)) {
+    goto cleanup;
+  }
+  TEST_CHECK(strcmp(ptk_anm2_view_selector_get_name(view, 0), "Group \"1\"") == 0);
+  TEST_CHECK(strcmp(ptk_anm2_view_selector_get_name(view, 1), "Empty") == 0);
+  TEST_CHECK(ptk_anm2_view_item_count(view, 1) == 0);
+  if (!TEST_CHECK(ptk_anm2_view_item_count(view, 0) == 2)) {
+    goto cleanup;
+  }
+  TEST_CHECK(strcmp(ptk_anm2_view_item_get_name(view, 0, 0), "Item\tA") == 0);
+  TEST_CHECK(strcmp(ptk_anm2_view_item_get_value(view, 0, 0), "v1.layer/a") == 0);
+  TEST_CHECK(ptk_anm2_view_item_get_script_name(view, 0, 0) == NULL);
+  TEST_CHECK(strcmp(ptk_anm2_view_item_get_name(view, 0, 1), "目パチ") == 0);
+  TEST_CHECK(ptk_anm2_view_item_get_value(view, 0, 1) == NULL);
+  TEST_CHECK(strcmp(ptk_anm2_view_item_get_script_name(view, 0, 1), "PSDToolKit.Blinker") == 0);
+
+  // Out of range
+  TEST_CHECK(ptk_anm2_view_selector_get_name(view, 2) == NULL);
+  TEST_CHECK(ptk_anm2_view_item_count(view, 2) == 0);
+  TEST_CHECK(ptk_anm2_view_item_get_name(view, 0, 2) == NULL);
+
+  // Parsing in place must not break checksum verification of the same file
+  TEST_CHECK(ptk_anm2_verify_file_checksum(NULL, temp_path, &err) == ov_true);
+
+cleanup:
+  ptk_anm2_view_close(&view);
+  if (temp_path[0] != L'\0') {
+    delete_temp_file(temp_path);
+  }
+  ptk_anm2_destroy(&doc);
+}
+
 static void test_item_set_script_name(void) {
   struct ov_error err = {0};
   struct ptk_anm2 *doc = ptk_anm2_create(&err);
@@ -4798,6 +5426,8 @@ TEST_LIST = {
     {"find_selector_by_id", test_find_selector_by_id},
     {"find_item_by_id", test_find_item_by_id},
     {"find_param_by_id", test_find_param_by_id},
+    {"id_index_consistency", test_id_index_consistency},
+    {"id_index_large_document", test_id_index_large_document},
     // Metadata operations (Phase 4)
     {"set_label", test_set_label},
     {"set_psd_path", test_set_psd_path},
@@ -4809,11 +5439,13 @@ TEST_LIST = {
     {"change_callback_basic", test_change_callback_basic},
     {"change_callback_transaction", test_change_callback_transaction},
     {"change_callback_undo_redo_transaction", test_change_callback_undo_redo_transaction},
+    {"change_callback_batch", test_change_callback_batch},
     // UNDO/REDO edge cases (Phase 4)
     {"undo_clears_redo", test_undo_clears_redo},
     {"clear_undo_history", test_clear_undo_history},
     {"undo_empty_returns_false", test_undo_empty_returns_false},
     {"redo_empty_returns_false", test_redo_empty_returns_false},
+    {"undo_memory_limit", test_undo_memory_limit},
     // Error cases (Phase 4)
     {"invalid_selector_index", test_invalid_selector_index},
     {"invalid_item_index", test_invalid_item_index},
@@ -4835,6 +5467,9 @@ TEST_LIST = {
     {"generate_script_animation_params", test_generate_script_animation_params},
     {"generate_script_null_param_value", test_generate_script_null_param_value},
     {"verify_checksum", test_verify_checksum},
+    {"calculate_checksum_chunked", test_calculate_checksum_chunked},
+    {"verify_file_checksum", test_verify_file_checksum},
+    {"view_matches_load", test_view_matches_load},
     // Item script name tests (Phase 4)
     {"item_set_script_name", test_item_set_script_name},
     {"item_set_script_name_on_value_item", test_item_set_script_name_on_value_item},
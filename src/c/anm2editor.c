@@ -73,9 +73,10 @@ struct ptk_anm2editor {
   HWND window;
   ATOM window_class;
 
-  struct ptk_anm2_edit *edit_core;  // Edit core for selection and editing operations (owns doc)
-  struct aviutl2_edit_handle *edit; // Edit handle for accessing AviUtl2 edit section
-  wchar_t *file_path;               // ovarray, current file path (NULL for new document)
+  struct ptk_anm2_edit *edit_core;          // Edit core for selection and editing operations (owns doc)
+  struct aviutl2_edit_handle *edit;         // Edit handle for accessing AviUtl2 edit section
+  wchar_t *file_path;                       // ovarray, current file path (NULL for new document)
+  struct ptk_alias_script_catalog *scripts; // Script definitions for import, loaded in the background
 
   // UI components
   struct anm2editor_toolbar *toolbar;
@@ -690,7 +691,8 @@ static bool import_callback(void *const context,
     }
   }
 
-  if (!ptk_anm2_edit_begin_transaction(editor->edit_core, err)) {
+  // Use batch so that importing many scripts rebuilds the view only once
+  if (!ptk_anm2_edit_begin_batch(editor->edit_core, err)) {
     OV_ERROR_ADD_TRACE(err);
     goto cleanup;
   }
@@ -704,7 +706,7 @@ static bool import_callback(void *const context,
 
 cleanup:
   if (transaction_started) {
-    if (!ptk_anm2_edit_end_transaction(editor->edit_core, success, err)) {
+    if (!ptk_anm2_edit_end_batch(editor->edit_core, success, err)) {
       if (success) {
         OV_ERROR_ADD_TRACE(err);
       }
@@ -724,8 +726,14 @@ static void handle_cmd_import_scripts(struct ptk_anm2editor *editor) {
   char const *const current_psd_path = ptk_anm2_edit_get_psd_path(editor->edit_core);
   bool const has_selected_selector = (get_selected_selector_id(editor) != 0);
 
-  if (!anm2editor_import_execute(
-          editor->window, editor->edit, current_psd_path, has_selected_selector, import_callback, editor, &err)) {
+  if (!anm2editor_import_execute(editor->window,
+                                 editor->edit,
+                                 editor->scripts,
+                                 current_psd_path,
+                                 has_selected_selector,
+                                 import_callback,
+                                 editor,
+                                 &err)) {
     show_error_dialog(editor, &err);
   }
 }
@@ -1131,6 +1139,12 @@ bool ptk_anm2editor_create(struct ptk_anm2editor **editor_out,
   // Set view callback for edit_core
   ptk_anm2_edit_set_view_callback(editor->edit_core, on_edit_view_change, editor);
 
+  editor->scripts = ptk_alias_script_catalog_create(NULL, err);
+  if (!editor->scripts) {
+    OV_ERROR_ADD_TRACE(err);
+    goto cleanup;
+  }
+
   // Create window if requested
   if (window_out) {
     HINSTANCE const hinst = GetModuleHandleW(NULL);
@@ -1179,6 +1193,9 @@ bool ptk_anm2editor_create(struct ptk_anm2editor **editor_out,
 cleanup:
   if (!success) {
     if (editor) {
+      if (editor->scripts) {
+        ptk_alias_script_catalog_destroy(&editor->scripts);
+      }
       if (editor->edit_core) {
         ptk_anm2_edit_destroy(&editor->edit_core);
       }
@@ -1213,6 +1230,10 @@ void ptk_anm2editor_destroy(struct ptk_anm2editor **editor_ptr) {
     editor->window_class = 0;
   }
 
+  if (editor->scripts) {
+    ptk_alias_script_catalog_destroy(&editor->scripts);
+  }
+
   if (editor->edit_core) {
     ptk_anm2_edit_destroy(&editor->edit_core);
   }
@@ -1294,7 +1315,7 @@ bool ptk_anm2editor_open(struct ptk_anm2editor *editor, wchar_t const *path, str
   }
 
   // Verify checksum - warn if file was manually edited
-  checksum_result = ptk_anm2_edit_verify_file_checksum(selected_path, err);
+  checksum_result = ptk_anm2_edit_verify_file_checksum(editor->edit_core, selected_path, err);
   if (checksum_result == ov_indeterminate) {
     OV_ERROR_ADD_TRACE(err);
     goto cleanup;
@@ -1593,8 +1614,8 @@ bool ptk_anm2editor_add_value_items(struct ptk_anm2editor *editor,
   size_t sel_idx = 0;
   uint32_t selector_id = 0;
 
-  // Use transaction to group all operations for single undo
-  if (!ptk_anm2_edit_begin_transaction(editor->edit_core, err)) {
+  // Use batch to group all operations for single undo and a single view rebuild
+  if (!ptk_anm2_edit_begin_batch(editor->edit_core, err)) {
     OV_ERROR_ADD_TRACE(err);
     goto cleanup;
   }
@@ -1629,7 +1650,7 @@ bool ptk_anm2editor_add_value_items(struct ptk_anm2editor *editor,
 
 cleanup:
   if (transaction_started) {
-    if (!ptk_anm2_edit_end_transaction(editor->edit_core, success, err)) {
+    if (!ptk_anm2_edit_end_batch(editor->edit_core, success, err)) {
       if (success) {
         OV_ERROR_ADD_TRACE(err);
         success = false;
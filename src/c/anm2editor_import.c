@@ -148,6 +148,7 @@ static void show_hint_dialog(void *const parent_window, struct ov_error *const e
 
 bool anm2editor_import_execute(void *const parent_window,
                                struct aviutl2_edit_handle *const edit_handle,
+                               struct ptk_alias_script_catalog *const catalog,
                                char const *const current_psd_path,
                                bool const has_selected_selector,
                                anm2editor_import_callback const callback,
@@ -157,7 +158,7 @@ bool anm2editor_import_execute(void *const parent_window,
       .err = err,
       .success = false,
   };
-  struct ptk_alias_script_definitions defs = {0};
+  struct ptk_alias_script_definitions const *defs = NULL;
   struct ptk_alias_available_scripts *scripts = NULL;
   char *selector_name = NULL;
   bool success = false;
@@ -177,12 +178,13 @@ bool anm2editor_import_execute(void *const parent_window,
     goto cleanup;
   }
 
-  if (!ptk_alias_load_script_definitions(&defs, err)) {
+  defs = ptk_alias_script_catalog_get(catalog, err);
+  if (!defs) {
     OV_ERROR_ADD_TRACE(err);
     goto cleanup;
   }
 
-  if (!ptk_alias_enumerate_available_scripts(alias_ctx.alias, strlen(alias_ctx.alias), &defs, scripts, err)) {
+  if (!ptk_alias_enumerate_available_scripts(alias_ctx.alias, strlen(alias_ctx.alias), defs, scripts, err)) {
     OV_ERROR_ADD_TRACE(err);
     goto cleanup;
   }
@@ -299,7 +301,6 @@ cleanup:
     ptk_alias_available_scripts_free(scripts);
     OV_FREE(&scripts);
   }
-  ptk_alias_script_definitions_free(&defs);
   if (alias_ctx.alias) {
     OV_ARRAY_DESTROY(&alias_ctx.alias);
   }
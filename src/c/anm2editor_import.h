@@ -5,6 +5,7 @@
 
 struct aviutl2_edit_handle;
 struct ptk_alias_available_scripts;
+struct ptk_alias_script_catalog;
 
 /**
  * @brief Callback invoked when import data is ready
@@ -39,6 +40,7 @@ typedef bool (*anm2editor_import_callback)(void *context,
  *
  * @param parent_window Parent window handle (HWND cast to void*)
  * @param edit_handle AviUtl2 edit handle for accessing edit section
+ * @param catalog Script definitions catalog
  * @param current_psd_path Current PSD path in the editor (for comparison)
  * @param has_selected_selector true if a selector is currently selected
  * @param callback Callback to execute import
@@ -48,6 +50,7 @@ typedef bool (*anm2editor_import_callback)(void *context,
  */
 NODISCARD bool anm2editor_import_execute(void *parent_window,
                                          struct aviutl2_edit_handle *edit_handle,
+                                         struct ptk_alias_script_catalog *catalog,
                                          char const *current_psd_path,
                                          bool has_selected_selector,
                                          anm2editor_import_callback callback,
@@ -1,135 +1,151 @@
 #include "anm_to_anm2.h"
 
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+
 #include <ovarray.h>
 #include <ovmo.h>
+#include <ovthreads.h>
 #include <ovutf.h>
 
+#include <ovl/file.h>
+#include <ovl/path.h>
+
 #include <string.h>
 
+// Replacement rules for legacy API calls
+struct replacement_rule {
+  char const *old_str;
+  size_t old_len;
+  char const *new_str;
+  size_t new_len;
+};
+
+static struct replacement_rule const g_rules[] = {
+    {
+        .old_str = "require(\"PSDToolKit\").Blinker.new(",
+        .old_len = sizeof("require(\"PSDToolKit\").Blinker.new(") - 1,
+        .new_str = "require(\"PSDToolKit.Blinker\").new_legacy(",
+        .new_len = sizeof("require(\"PSDToolKit.Blinker\").new_legacy(") - 1,
+    },
+    {
+        .old_str = "require(\"PSDToolKit\").LipSyncSimple.new(",
+        .old_len = sizeof("require(\"PSDToolKit\").LipSyncSimple.new(") - 1,
+        .new_str = "require(\"PSDToolKit.LipSync\").new_legacy(",
+        .new_len = sizeof("require(\"PSDToolKit.LipSync\").new_legacy(") - 1,
+    },
+    {
+        .old_str = "require(\"PSDToolKit\").LipSyncLab.new(",
+        .old_len = sizeof("require(\"PSDToolKit\").LipSyncLab.new(") - 1,
+        .new_str = "require(\"PSDToolKit.LipSyncLab\").new_legacy(",
+        .new_len = sizeof("require(\"PSDToolKit.LipSyncLab\").new_legacy(") - 1,
+    },
+    {
+        .old_str = "PSD:addstate(",
+        .old_len = sizeof("PSD:addstate(") - 1,
+        .new_str = "require(\"PSDToolKit\").add_state_legacy(",
+        .new_len = sizeof("require(\"PSDToolKit\").add_state_legacy(") - 1,
+    },
+};
+static size_t const g_rules_count = sizeof(g_rules) / sizeof(g_rules[0]);
+
+struct rule_match {
+  size_t pos;
+  struct replacement_rule const *rule;
+};
+
 /**
- * @brief Replace all occurrences of old_str with new_str in the buffer
+ * @brief Apply all replacement rules in a single pass
+ *
+ * The source is scanned once, skipping bytes that cannot start any rule,
+ * and the output is allocated at its final size before copying.
+ * No rule produces text that another rule matches, so this gives the same
+ * result as replacing each rule over the whole buffer in turn.
  *
- * @param buf [in,out] Buffer to process (ovarray, will be modified)
- * @param old_str String to find
- * @param old_len Length of old_str
- * @param new_str Replacement string
- * @param new_len Length of new_str
+ * @param src Source data
+ * @param src_len Source data length in bytes
+ * @param dst [out] Output data (ovarray)
  * @param err [out] Error information
  * @return true on success, false on failure
  */
-static bool replace_all(
-    char **buf, char const *old_str, size_t old_len, char const *new_str, size_t new_len, struct ov_error *const err) {
-  if (!buf || !*buf || !old_str || old_len == 0) {
-    OV_ERROR_SET_GENERIC(err, ov_error_generic_invalid_argument);
-    return false;
-  }
-
+static bool apply_rules(char const *const src, size_t const src_len, char **const dst, struct ov_error *const err) {
+  struct rule_match *matches = NULL;
   char *result = NULL;
   bool success = false;
 
-  size_t const src_len = OV_ARRAY_LENGTH(*buf);
-  char const *src = *buf;
-  char const *pos = src;
-  char const *const end = src + src_len;
-
-  // First pass: count occurrences and calculate new size
-  size_t count = 0;
   {
-    char const *p = src;
-    while (p + old_len <= end) {
-      if (memcmp(p, old_str, old_len) == 0) {
-        count++;
-        p += old_len;
-      } else {
-        p++;
-      }
+    bool is_lead[256] = {0};
+    for (size_t i = 0; i < g_rules_count; i++) {
+      is_lead[(unsigned char)g_rules[i].old_str[0]] = true;
     }
-  }
-
-  if (count == 0) {
-    // No replacements needed
-    success = true;
-    goto cleanup;
-  }
 
-  {
-    // Calculate new size
-    size_t const new_size = src_len - (count * old_len) + (count * new_len);
+    // Find all matches and calculate the output size
+    size_t result_len = src_len;
+    size_t pos = 0;
+    while (pos < src_len) {
+      if (!is_lead[(unsigned char)src[pos]]) {
+        pos++;
+        continue;
+      }
+      struct replacement_rule const *rule = NULL;
+      for (size_t i = 0; i < g_rules_count; i++) {
+        if (g_rules[i].old_len <= src_len - pos && memcmp(src + pos, g_rules[i].old_str, g_rules[i].old_len) == 0) {
+          rule = &g_rules[i];
+          break;
+        }
+      }
+      if (!rule) {
+        pos++;
+        continue;
+      }
+      size_t const matches_len = OV_ARRAY_LENGTH(matches);
+      if (!OV_ARRAY_GROW(&matches, matches_len + 1)) {
+        OV_ERROR_SET_GENERIC(err, ov_error_generic_out_of_memory);
+        goto cleanup;
+      }
+      matches[matches_len] = (struct rule_match){.pos = pos, .rule = rule};
+      OV_ARRAY_SET_LENGTH(matches, matches_len + 1);
+      result_len = result_len - rule->old_len + rule->new_len;
+      pos += rule->old_len;
+    }
 
-    if (!OV_ARRAY_GROW(&result, new_size + 1)) {
+    if (!OV_ARRAY_GROW(&result, result_len + 1)) {
       OV_ERROR_SET_GENERIC(err, ov_error_generic_out_of_memory);
       goto cleanup;
     }
 
-    // Second pass: build result
+    // Copy unchanged runs and replacements
     char *d = result;
-    while (pos + old_len <= end) {
-      if (memcmp(pos, old_str, old_len) == 0) {
-        memcpy(d, new_str, new_len);
-        d += new_len;
-        pos += old_len;
-      } else {
-        *d++ = *pos++;
-      }
-    }
-    // Copy remaining bytes
-    while (pos < end) {
-      *d++ = *pos++;
+    size_t copied = 0;
+    size_t const matches_len = OV_ARRAY_LENGTH(matches);
+    for (size_t i = 0; i < matches_len; i++) {
+      struct rule_match const *const m = &matches[i];
+      memcpy(d, src + copied, m->pos - copied);
+      d += m->pos - copied;
+      memcpy(d, m->rule->new_str, m->rule->new_len);
+      d += m->rule->new_len;
+      copied = m->pos + m->rule->old_len;
     }
-    *d = '\0';
-    OV_ARRAY_SET_LENGTH(result, new_size);
-
-    // Swap buffers
-    OV_ARRAY_DESTROY(buf);
-    *buf = result;
-    result = NULL;
-    success = true;
+    memcpy(d, src + copied, src_len - copied);
+    result[result_len] = '\0';
+    OV_ARRAY_SET_LENGTH(result, result_len);
   }
 
+  *dst = result;
+  result = NULL;
+  success = true;
+
 cleanup:
   if (result) {
     OV_ARRAY_DESTROY(&result);
   }
+  if (matches) {
+    OV_ARRAY_DESTROY(&matches);
+  }
   return success;
 }
 
-// Replacement rules for legacy API calls
-struct replacement_rule {
-  char const *old_str;
-  size_t old_len;
-  char const *new_str;
-  size_t new_len;
-};
-
 bool ptk_anm_to_anm2(char const *src, size_t src_len, char **dst, struct ov_error *const err) {
-  static struct replacement_rule const rules[] = {
-      {
-          .old_str = "require(\"PSDToolKit\").Blinker.new(",
-          .old_len = sizeof("require(\"PSDToolKit\").Blinker.new(") - 1,
-          .new_str = "require(\"PSDToolKit.Blinker\").new_legacy(",
-          .new_len = sizeof("require(\"PSDToolKit.Blinker\").new_legacy(") - 1,
-      },
-      {
-          .old_str = "require(\"PSDToolKit\").LipSyncSimple.new(",
-          .old_len = sizeof("require(\"PSDToolKit\").LipSyncSimple.new(") - 1,
-          .new_str = "require(\"PSDToolKit.LipSync\").new_legacy(",
-          .new_len = sizeof("require(\"PSDToolKit.LipSync\").new_legacy(") - 1,
-      },
-      {
-          .old_str = "require(\"PSDToolKit\").LipSyncLab.new(",
-          .old_len = sizeof("require(\"PSDToolKit\").LipSyncLab.new(") - 1,
-          .new_str = "require(\"PSDToolKit.LipSyncLab\").new_legacy(",
-          .new_len = sizeof("require(\"PSDToolKit.LipSyncLab\").new_legacy(") - 1,
-      },
-      {
-          .old_str = "PSD:addstate(",
-          .old_len = sizeof("PSD:addstate(") - 1,
-          .new_str = "require(\"PSDToolKit\").add_state_legacy(",
-          .new_len = sizeof("require(\"PSDToolKit\").add_state_legacy(") - 1,
-      },
-  };
-  static size_t const rules_count = sizeof(rules) / sizeof(rules[0]);
-
   if (!dst) {
     OV_ERROR_SET_GENERIC(err, ov_error_generic_invalid_argument);
     return false;
@@ -199,21 +215,352 @@ bool ptk_anm_to_anm2(char const *src, size_t src_len, char **dst, struct ov_erro
   }
 
   // Step 3: Apply replacement rules
-  for (size_t i = 0; i < rules_count; i++) {
-    if (!replace_all(&utf8_buf, rules[i].old_str, rules[i].old_len, rules[i].new_str, rules[i].new_len, err)) {
+  if (!apply_rules(utf8_buf, OV_ARRAY_LENGTH(utf8_buf), dst, err)) {
+    OV_ERROR_ADD_TRACE(err);
+    goto cleanup;
+  }
+
+  success = true;
+
+cleanup:
+  if (utf8_buf) {
+    OV_ARRAY_DESTROY(&utf8_buf);
+  }
+  return success;
+}
+
+struct batch_file {
+  wchar_t *src_path; // ovarray
+  wchar_t *dst_path; // ovarray
+  double elapsed;
+  struct ov_error err;
+  bool failed;
+};
+
+struct batch {
+  struct batch_file *files; // ovarray
+  size_t next;              // index of the next file to convert, guarded by mtx
+  mtx_t mtx;
+  double frequency;
+};
+
+/**
+ * @brief Convert one *.anm file to *.anm2
+ *
+ * @param src_path Source file path
+ * @param dst_path Destination file path, must not exist
+ * @param err [out] Error information
+ * @return true on success, false on failure
+ */
+static bool convert_file(wchar_t const *const src_path, wchar_t const *const dst_path, struct ov_error *const err) {
+  struct ovl_file *src_file = NULL;
+  struct ovl_file *dst_file = NULL;
+  char *src_data = NULL;
+  char *dst_data = NULL;
+  bool success = false;
+
+  if (GetFileAttributesW(dst_path) != INVALID_FILE_ATTRIBUTES) {
+    OV_ERROR_SET_HRESULT(err, HRESULT_FROM_WIN32(ERROR_FILE_EXISTS));
+    goto cleanup;
+  }
+
+  {
+    uint64_t file_size = 0;
+    size_t bytes_read = 0;
+    if (!ovl_file_open(src_path, &src_file, err)) {
+      OV_ERROR_ADD_TRACE(err);
+      goto cleanup;
+    }
+    if (!ovl_file_size(src_file, &file_size, err)) {
+      OV_ERROR_ADD_TRACE(err);
+      goto cleanup;
+    }
+    if (!OV_ARRAY_GROW(&src_data, file_size + 1)) {
+      OV_ERROR_SET_GENERIC(err, ov_error_generic_out_of_memory);
+      goto cleanup;
+    }
+    if (!ovl_file_read(src_file, src_data, (size_t)file_size, &bytes_read, err)) {
+      OV_ERROR_ADD_TRACE(err);
+      goto cleanup;
+    }
+    src_data[bytes_read] = '\0';
+    OV_ARRAY_SET_LENGTH(src_data, bytes_read);
+  }
+
+  if (!ptk_anm_to_anm2(src_data, OV_ARRAY_LENGTH(src_data), &dst_data, err)) {
+    OV_ERROR_ADD_TRACE(err);
+    goto cleanup;
+  }
+
+  {
+    size_t bytes_written = 0;
+    if (!ovl_file_create(dst_path, &dst_file, err)) {
+      OV_ERROR_ADD_TRACE(err);
+      goto cleanup;
+    }
+    if (!ovl_file_write(dst_file, dst_data, OV_ARRAY_LENGTH(dst_data), &bytes_written, err)) {
       OV_ERROR_ADD_TRACE(err);
       goto cleanup;
     }
   }
 
-  // Transfer ownership
-  *dst = utf8_buf;
-  utf8_buf = NULL;
   success = true;
 
 cleanup:
-  if (utf8_buf) {
-    OV_ARRAY_DESTROY(&utf8_buf);
+  if (src_file) {
+    ovl_file_close(src_file);
+  }
+  if (dst_file) {
+    ovl_file_close(dst_file);
+    if (!success) {
+      // Do not leave a partial file behind, the next run would refuse to overwrite it
+      DeleteFileW(dst_path);
+    }
+  }
+  if (src_data) {
+    OV_ARRAY_DESTROY(&src_data);
+  }
+  if (dst_data) {
+    OV_ARRAY_DESTROY(&dst_data);
+  }
+  return success;
+}
+
+static int batch_worker(void *const userdata) {
+  struct batch *const b = (struct batch *)userdata;
+  size_t const n = OV_ARRAY_LENGTH(b->files);
+  for (;;) {
+    mtx_lock(&b->mtx);
+    size_t const i = b->next++;
+    mtx_unlock(&b->mtx);
+    if (i >= n) {
+      break;
+    }
+    struct batch_file *const f = &b->files[i];
+    LARGE_INTEGER start, end;
+    QueryPerformanceCounter(&start);
+    f->failed = !convert_file(f->src_path, f->dst_path, &f->err);
+    QueryPerformanceCounter(&end);
+    f->elapsed = (double)(end.QuadPart - start.QuadPart) / b->frequency;
+  }
+  return 0;
+}
+
+/**
+ * @brief Build a path in dir, adding a separator when needed
+ *
+ * @param dir Directory path
+ * @param dir_len Length of dir
+ * @param name File name
+ * @param name_len Length of name
+ * @param ext Extension to append including the dot, or NULL
+ * @param path [out] Path (ovarray)
+ * @param err [out] Error information
+ * @return true on success, false on failure
+ */
+static bool build_path(wchar_t const *const dir,
+                       size_t const dir_len,
+                       wchar_t const *const name,
+                       size_t const name_len,
+                       wchar_t const *const ext,
+                       wchar_t **const path,
+                       struct ov_error *const err) {
+  bool const need_sep = dir_len > 0 && dir[dir_len - 1] != L'\\' && dir[dir_len - 1] != L'/';
+  size_t const ext_len = ext ? wcslen(ext) : 0;
+  size_t const len = dir_len + (need_sep ? 1 : 0) + name_len + ext_len;
+  if (!OV_ARRAY_GROW(path, len + 1)) {
+    OV_ERROR_SET_GENERIC(err, ov_error_generic_out_of_memory);
+    return false;
+  }
+  wchar_t *p = *path;
+  memcpy(p, dir, dir_len * sizeof(wchar_t));
+  p += dir_len;
+  if (need_sep) {
+    *p++ = L'\\';
+  }
+  memcpy(p, name, name_len * sizeof(wchar_t));
+  p += name_len;
+  if (ext_len) {
+    memcpy(p, ext, ext_len * sizeof(wchar_t));
+  }
+  (*path)[len] = L'\0';
+  OV_ARRAY_SET_LENGTH(*path, len);
+  return true;
+}
+
+/**
+ * @brief List *.anm files in a directory
+ *
+ * FindFirstFileW patterns can also match longer extensions through short names,
+ * so the extension is checked again here.
+ *
+ * @param dir Directory path
+ * @param files [in,out] Files (ovarray)
+ * @param err [out] Error information
+ * @return true on success, false on failure
+ */
+static bool list_anm_files(wchar_t const *const dir, struct batch_file **const files, struct ov_error *const err) {
+  static wchar_t const pattern_name[] = L"*.anm";
+  static wchar_t const anm_ext[] = L".anm";
+  size_t const dir_len = wcslen(dir);
+  wchar_t *pattern = NULL;
+  HANDLE find_handle = INVALID_HANDLE_VALUE;
+  WIN32_FIND_DATAW find_data = {0};
+  struct batch_file file = {0};
+  bool success = false;
+
+  if (!build_path(dir, dir_len, pattern_name, wcslen(pattern_name), NULL, &pattern, err)) {
+    OV_ERROR_ADD_TRACE(err);
+    goto cleanup;
+  }
+
+  find_handle = FindFirstFileW(pattern, &find_data);
+  if (find_handle == INVALID_HANDLE_VALUE) {
+    DWORD const error = GetLastError();
+    if (error == ERROR_FILE_NOT_FOUND) {
+      success = true; // No *.anm files
+      goto cleanup;
+    }
+    OV_ERROR_SET_HRESULT(err, HRESULT_FROM_WIN32(error));
+    goto cleanup;
+  }
+
+  do {
+    if (find_data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) {
+      continue;
+    }
+    wchar_t const *const ext = ovl_path_find_ext(find_data.cFileName);
+    if (!ext || _wcsicmp(ext, anm_ext) != 0) {
+      continue;
+    }
+    size_t const base_len = (size_t)(ext - find_data.cFileName);
+    if (!build_path(dir, dir_len, find_data.cFileName, wcslen(find_data.cFileName), NULL, &file.src_path, err) ||
+        !build_path(dir, dir_len, find_data.cFileName, base_len, L".anm2", &file.dst_path, err)) {
+      OV_ERROR_ADD_TRACE(err);
+      goto cleanup;
+    }
+    size_t const len = OV_ARRAY_LENGTH(*files);
+    if (!OV_ARRAY_GROW(files, len + 1)) {
+      OV_ERROR_SET_GENERIC(err, ov_error_generic_out_of_memory);
+      goto cleanup;
+    }
+    (*files)[len] = file;
+    OV_ARRAY_SET_LENGTH(*files, len + 1);
+    file = (struct batch_file){0};
+  } while (FindNextFileW(find_handle, &find_data));
+
+  success = true;
+
+cleanup:
+  if (file.src_path) {
+    OV_ARRAY_DESTROY(&file.src_path);
+  }
+  if (file.dst_path) {
+    OV_ARRAY_DESTROY(&file.dst_path);
+  }
+  if (find_handle != INVALID_HANDLE_VALUE) {
+    FindClose(find_handle);
+  }
+  if (pattern) {
+    OV_ARRAY_DESTROY(&pattern);
+  }
+  return success;
+}
+
+bool ptk_anm_to_anm2_convert_directory(wchar_t const *const dir,
+                                       size_t num_threads,
+                                       ptk_anm_to_anm2_result_callback const callback,
+                                       void *const userdata,
+                                       struct ov_error *const err) {
+  if (!dir) {
+    OV_ERROR_SET_GENERIC(err, ov_error_generic_invalid_argument);
+    return false;
+  }
+
+  struct batch b = {0};
+  thrd_t *threads = NULL;
+  size_t threads_created = 0;
+  bool mtx_initialized = false;
+  bool success = false;
+
+  if (!list_anm_files(dir, &b.files, err)) {
+    OV_ERROR_ADD_TRACE(err);
+    goto cleanup;
+  }
+
+  {
+    size_t const num_files = OV_ARRAY_LENGTH(b.files);
+    if (num_threads == 0) {
+      SYSTEM_INFO si;
+      GetSystemInfo(&si);
+      num_threads = si.dwNumberOfProcessors;
+    }
+    if (num_threads > num_files) {
+      num_threads = num_files;
+    }
+
+    LARGE_INTEGER frequency;
+    QueryPerformanceFrequency(&frequency);
+    b.frequency = (double)frequency.QuadPart;
+    if (mtx_init(&b.mtx, mtx_plain) != thrd_success) {
+      OV_ERROR_SET_GENERIC(err, ov_error_generic_fail);
+      goto cleanup;
+    }
+    mtx_initialized = true;
+
+    if (num_threads > 0 && !OV_ARRAY_GROW(&threads, num_threads)) {
+      OV_ERROR_SET_GENERIC(err, ov_error_generic_out_of_memory);
+      goto cleanup;
+    }
+    for (size_t i = 0; i < num_threads; i++) {
+      if (thrd_create(&threads[i], batch_worker, &b) != thrd_success) {
+        break;
+      }
+      threads_created++;
+    }
+    if (threads_created == 0) {
+      // Convert on this thread when no worker could be started
+      batch_worker(&b);
+    }
+    for (size_t i = 0; i < threads_created; i++) {
+      thrd_join(threads[i], NULL);
+    }
+    threads_created = 0;
+
+    if (callback) {
+      for (size_t i = 0; i < num_files; i++) {
+        struct batch_file const *const f = &b.files[i];
+        callback(userdata,
+                 &(struct ptk_anm_to_anm2_file_result){
+                     .src_path = f->src_path,
+                     .dst_path = f->dst_path,
+                     .elapsed = f->elapsed,
+                     .err = f->failed ? &f->err : NULL,
+                 });
+      }
+    }
+  }
+
+  success = true;
+
+cleanup:
+  for (size_t i = 0; i < threads_created; i++) {
+    thrd_join(threads[i], NULL);
+  }
+  if (threads) {
+    OV_ARRAY_DESTROY(&threads);
+  }
+  if (mtx_initialized) {
+    mtx_destroy(&b.mtx);
+  }
+  if (b.files) {
+    size_t const n = OV_ARRAY_LENGTH(b.files);
+    for (size_t i = 0; i < n; i++) {
+      OV_ARRAY_DESTROY(&b.files[i].src_path);
+      OV_ARRAY_DESTROY(&b.files[i].dst_path);
+      OV_ERROR_DESTROY(&b.files[i].err);
+    }
+    OV_ARRAY_DESTROY(&b.files);
   }
   return success;
 }
@@ -37,3 +37,42 @@ enum ptk_anm_to_anm2_error {
  * @return true on success, false on failure
  */
 NODISCARD bool ptk_anm_to_anm2(char const *src, size_t src_len, char **dst, struct ov_error *err);
+
+/**
+ * @brief Result of converting one file in ptk_anm_to_anm2_convert_directory
+ */
+struct ptk_anm_to_anm2_file_result {
+  wchar_t const *src_path;    ///< Source *.anm file path
+  wchar_t const *dst_path;    ///< Destination *.anm2 file path
+  double elapsed;             ///< Time spent reading, converting and writing the file in seconds
+  struct ov_error const *err; ///< Error for this file, NULL on success
+};
+
+/**
+ * @brief Callback receiving the result of each converted file
+ *
+ * @param userdata User data pointer
+ * @param result Result of one file, valid only during the call
+ */
+typedef void (*ptk_anm_to_anm2_result_callback)(void *userdata, struct ptk_anm_to_anm2_file_result const *result);
+
+/**
+ * @brief Convert every *.anm file in a directory to *.anm2 in parallel
+ *
+ * Each name.anm is written to name.anm2 in the same directory.
+ * Existing *.anm2 files are not overwritten and are reported as errors.
+ * Files are converted by a pool of worker threads, and the callback is called
+ * on the calling thread for each file in directory order after all conversions finish.
+ *
+ * @param dir Directory path
+ * @param num_threads Number of worker threads, 0 to use the number of processors
+ * @param callback Callback for per-file results (can be NULL)
+ * @param userdata User data for the callback
+ * @param err [out] Error information
+ * @return true if the directory was processed, false on failure. Per-file failures are reported to the callback.
+ */
+NODISCARD bool ptk_anm_to_anm2_convert_directory(wchar_t const *dir,
+                                                 size_t num_threads,
+                                                 ptk_anm_to_anm2_result_callback callback,
+                                                 void *userdata,
+                                                 struct ov_error *err);
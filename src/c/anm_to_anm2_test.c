@@ -20,6 +20,9 @@
 #include <stdio.h>
 #include <string.h>
 
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+
 // Helper function to read file contents
 static bool read_file(char const *path, char **data, size_t *len) {
   FILE *f = fopen(path, "rb");
@@ -253,6 +256,152 @@ static void test_anm_to_anm2_not_legacy_script(void) {
   OV_ERROR_DESTROY(&err);
 }
 
+static bool read_batch_file(wchar_t const *dir, wchar_t const *name, char **data, size_t *len) {
+  wchar_t path[MAX_PATH];
+  wcscpy(path, dir);
+  wcscat(path, name);
+  FILE *f = _wfopen(path, L"rb");
+  if (!f) {
+    return false;
+  }
+  fseek(f, 0, SEEK_END);
+  long const size = ftell(f);
+  fseek(f, 0, SEEK_SET);
+  if (!OV_REALLOC(data, (size_t)size + 1, sizeof(char))) {
+    fclose(f);
+    return false;
+  }
+  *len = fread(*data, 1, (size_t)size, f);
+  (*data)[*len] = '\0';
+  fclose(f);
+  return true;
+}
+
+static bool write_batch_file(wchar_t const *dir, wchar_t const *name, char const *data, size_t len) {
+  wchar_t path[MAX_PATH];
+  wcscpy(path, dir);
+  wcscat(path, name);
+  FILE *f = _wfopen(path, L"wb");
+  if (!f) {
+    return false;
+  }
+  bool const ok = fwrite(data, 1, len, f) == len;
+  fclose(f);
+  return ok;
+}
+
+static void delete_batch_file(wchar_t const *dir, wchar_t const *name) {
+  wchar_t path[MAX_PATH];
+  wcscpy(path, dir);
+  wcscat(path, name);
+  DeleteFileW(path);
+}
+
+struct batch_results {
+  size_t count;
+  size_t converted;
+  size_t already_exists;
+  size_t not_legacy;
+  bool negative_elapsed;
+};
+
+static void collect_batch_result(void *userdata, struct ptk_anm_to_anm2_file_result const *result) {
+  struct batch_results *const r = (struct batch_results *)userdata;
+  r->count++;
+  if (result->elapsed < 0) {
+    r->negative_elapsed = true;
+  }
+  if (!result->err) {
+    r->converted++;
+  } else if (ov_error_is(result->err, ov_error_type_hresult, (int)HRESULT_FROM_WIN32(ERROR_FILE_EXISTS))) {
+    r->already_exists++;
+  } else if (ov_error_is(result->err, ov_error_type_generic, ptk_anm_to_anm2_error_not_legacy_script)) {
+    r->not_legacy++;
+  }
+}
+
+static void test_anm_to_anm2_convert_directory(void) {
+  static char const not_legacy[] = "-- comment\nlocal x = 1\n";
+  static char const text[] = "not a script";
+  struct ov_error err = {0};
+  char *input = NULL;
+  size_t input_len = 0;
+  char *expected = NULL;
+  size_t expected_len = 0;
+  char *output = NULL;
+  size_t output_len = 0;
+  wchar_t dir[MAX_PATH];
+
+  {
+    DWORD const len = GetTempPathW(MAX_PATH, dir);
+    if (!TEST_CHECK(len > 0 && len + 32 < MAX_PATH)) {
+      return;
+    }
+    wcscat(dir, L"ptk_anm_to_anm2_batch\\");
+    CreateDirectoryW(dir, NULL);
+  }
+
+  if (!TEST_CHECK(read_file(TEST_PATH("anm_to_anm2/legacy.anm"), &input, &input_len)) ||
+      !TEST_CHECK(read_file(TEST_PATH("anm_to_anm2/legacy.ptk.anm2"), &expected, &expected_len))) {
+    goto cleanup;
+  }
+  if (!TEST_CHECK(write_batch_file(dir, L"legacy1.anm", input, input_len)) ||
+      !TEST_CHECK(write_batch_file(dir, L"legacy2.anm", input, input_len)) ||
+      !TEST_CHECK(write_batch_file(dir, L"plain.anm", not_legacy, sizeof(not_legacy) - 1)) ||
+      !TEST_CHECK(write_batch_file(dir, L"notes.txt", text, sizeof(text) - 1))) {
+    goto cleanup;
+  }
+
+  {
+    struct batch_results r = {0};
+    if (!TEST_SUCCEEDED(ptk_anm_to_anm2_convert_directory(dir, 2, collect_batch_result, &r, &err), &err)) {
+      goto cleanup;
+    }
+    TEST_CHECK(r.count == 3);
+    TEST_MSG("want 3, got %zu", r.count);
+    TEST_CHECK(r.converted == 2);
+    TEST_MSG("want 2, got %zu", r.converted);
+    TEST_CHECK(r.not_legacy == 1);
+    TEST_CHECK(!r.negative_elapsed);
+  }
+
+  if (!TEST_CHECK(read_batch_file(dir, L"legacy2.anm2", &output, &output_len))) {
+    goto cleanup;
+  }
+  TEST_CHECK(output_len == expected_len && memcmp(output, expected, expected_len) == 0);
+  TEST_MSG("converted file should match legacy.ptk.anm2");
+
+  // Existing *.anm2 files are not overwritten
+  {
+    struct batch_results r = {0};
+    if (!TEST_SUCCEEDED(ptk_anm_to_anm2_convert_directory(dir, 0, collect_batch_result, &r, &err), &err)) {
+      goto cleanup;
+    }
+    TEST_CHECK(r.count == 3);
+    TEST_CHECK(r.already_exists == 2);
+    TEST_MSG("want 2, got %zu", r.already_exists);
+  }
+
+cleanup:
+  OV_ERROR_DESTROY(&err);
+  delete_batch_file(dir, L"legacy1.anm");
+  delete_batch_file(dir, L"legacy2.anm");
+  delete_batch_file(dir, L"legacy1.anm2");
+  delete_batch_file(dir, L"legacy2.anm2");
+  delete_batch_file(dir, L"plain.anm");
+  delete_batch_file(dir, L"notes.txt");
+  RemoveDirectoryW(dir);
+  if (output) {
+    OV_FREE(&output);
+  }
+  if (expected) {
+    OV_FREE(&expected);
+  }
+  if (input) {
+    OV_FREE(&input);
+  }
+}
+
 TEST_LIST = {
     {"anm_to_anm2_legacy", test_anm_to_anm2_legacy},
     {"anm_to_anm2_at_legacy", test_anm_to_anm2_at_legacy},
@@ -260,5 +409,6 @@ TEST_LIST = {
     {"anm_to_anm2_null_src", test_anm_to_anm2_null_src},
     {"anm_to_anm2_null_dst", test_anm_to_anm2_null_dst},
     {"anm_to_anm2_not_legacy_script", test_anm_to_anm2_not_legacy_script},
+    {"anm_to_anm2_convert_directory", test_anm_to_anm2_convert_directory},
     {NULL, NULL},
 };
@@ -0,0 +1,9 @@
+#include "bench.h"
+
+#include <time.h>
+
+double ptk_bench_now(void) {
+  struct timespec ts;
+  timespec_get(&ts, TIME_UTC);
+  return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
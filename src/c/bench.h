@@ -0,0 +1,8 @@
+#pragma once
+
+/**
+ * @brief Get the current time for benchmarks
+ *
+ * @return Time in seconds
+ */
+double ptk_bench_now(void);
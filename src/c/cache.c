@@ -19,6 +19,7 @@ enum {
   CACHEKEY_HEX_LEN = 16,
   MEMORY_CACHE_LIMIT = 256 * 1024 * 1024, // 256MB
   FILE_CACHE_LIMIT = 256 * 1024 * 1024,   // 256MB
+  DELTA_CHAIN_LIMIT = 8,                  // max number of delta entries between an entry and its full image
 };
 
 // Convert uint64 cache key to 16-character hex string
@@ -35,9 +36,13 @@ struct cache_entry {
   char cachekey_hex[CACHEKEY_HEX_LEN + 1]; // key for hashmap
   int32_t width;
   int32_t height;
-  uint8_t *data;    // BGRA pixel data (memory tier only)
-  size_t data_size; // width * height * 4
+  uint8_t *data;    // BGRA pixel data, or rects followed by their pixels for delta entries (memory tier only)
+  size_t data_size; // width * height * 4, or size of rects and their pixels for delta entries
   bool in_file;     // true if data is in file tier
+  // Delta entries (depth > 0) only hold the rectangles that differ from the base entry
+  uint64_t base_ckey;
+  size_t num_rects;
+  int depth;
   // LRU doubly-linked list
   struct cache_entry *lru_prev;
   struct cache_entry *lru_next;
@@ -236,16 +241,17 @@ read_entry_from_file(struct ptk_cache const *const c, struct cache_entry *entry,
   }
 
   // Allocate and read pixel data
-  data_size = (size_t)width * (size_t)height * 4;
-  if (!OV_REALLOC(&entry->data, data_size, 1)) {
-    OV_ERROR_SET_GENERIC(err, ov_error_generic_out_of_memory);
-    goto cleanup;
-  }
-  if (!ReadFile(file, entry->data, (DWORD)data_size, &bytes_read, NULL) || bytes_read != data_size) {
-    OV_ERROR_SET_HRESULT(err, HRESULT_FROM_WIN32(GetLastError()));
-    goto cleanup;
+  data_size = entry->data_size;
+  if (data_size > 0) {
+    if (!OV_REALLOC(&entry->data, data_size, 1)) {
+      OV_ERROR_SET_GENERIC(err, ov_error_generic_out_of_memory);
+      goto cleanup;
+    }
+    if (!ReadFile(file, entry->data, (DWORD)data_size, &bytes_read, NULL) || bytes_read != data_size) {
+      OV_ERROR_SET_HRESULT(err, HRESULT_FROM_WIN32(GetLastError()));
+      goto cleanup;
+    }
   }
-  entry->data_size = data_size;
 
   result = true;
 
@@ -310,6 +316,23 @@ cleanup:
   return result;
 }
 
+// Remove entry from either tier and free it
+static void remove_entry(struct ptk_cache *const c, struct cache_entry *entry) {
+  if (entry->in_file) {
+    delete_entry_file(c, entry);
+    c->file_used -= entry->data_size;
+  } else {
+    c->memory_used -= entry->data_size;
+  }
+  lru_remove(c, entry);
+  struct cache_entry *entry_for_delete = entry;
+  OV_HASHMAP_DELETE(c->entries, &entry_for_delete);
+  if (entry->data) {
+    OV_FREE(&entry->data);
+  }
+  OV_FREE(&entry);
+}
+
 // Evict entries from file tier (delete)
 static void evict_file_tier(struct ptk_cache *const c) {
   while (c->file_used > FILE_CACHE_LIMIT && c->lru_head) {
@@ -323,13 +346,145 @@ static void evict_file_tier(struct ptk_cache *const c) {
     }
 
     // Delete file and remove from cache
-    delete_entry_file(c, entry);
-    c->file_used -= entry->data_size;
-    lru_remove(c, entry);
-    struct cache_entry *entry_for_delete = entry;
-    OV_HASHMAP_DELETE(c->entries, &entry_for_delete);
-    OV_FREE(&entry);
+    remove_entry(c, entry);
+  }
+}
+
+// Look up entry by cache key, NULL if not cached
+static struct cache_entry *find_entry(struct ptk_cache *const c, uint64_t const ckey) {
+  struct cache_entry key_entry = {0};
+  ckey_to_hex(ckey, key_entry.cachekey_hex);
+  struct cache_entry *key_ptr = &key_entry;
+  void const *const const_ptr = OV_HASHMAP_GET(c->entries, &key_ptr);
+  return const_ptr ? *(struct cache_entry *const *)const_ptr : NULL;
+}
+
+// Check that every base entry needed to reconstruct entry is still cached.
+// Deltas are not evicted together with their base, so a chain can break at any point.
+static bool is_reconstructable(struct ptk_cache *const c, struct cache_entry const *entry) {
+  while (entry->depth > 0) {
+    struct cache_entry const *const base = find_entry(c, entry->base_ckey);
+    // Base entries always have a smaller depth, which also rules out cycles
+    if (!base || base->depth >= entry->depth || base->width != entry->width || base->height != entry->height) {
+      return false;
+    }
+    entry = base;
+  }
+  return true;
+}
+
+// Add a new entry and evict older entries if needed
+static bool insert_entry(struct ptk_cache *const c, struct cache_entry *entry, struct ov_error *const err) {
+  if (!OV_HASHMAP_SET(c->entries, &entry)) {
+    OV_ERROR_SET_GENERIC(err, ov_error_generic_out_of_memory);
+    return false;
+  }
+
+  // Add to LRU (entry is heap-allocated, address is stable)
+  lru_add(c, entry);
+  c->memory_used += entry->data_size;
+
+  // Evict if needed
+  if (c->memory_used > MEMORY_CACHE_LIMIT) {
+    struct ov_error evict_err = {0};
+    if (!evict_memory_to_file(c, &evict_err)) {
+      // Non-fatal, just log
+      ptk_logf_warn(&evict_err, "%1$hs", "%1$hs", "failed to evict cache to file tier");
+      OV_ERROR_REPORT(&evict_err, NULL);
+    }
+  }
+  if (c->file_used > FILE_CACHE_LIMIT) {
+    evict_file_tier(c);
+  }
+  return true;
+}
+
+// Make sure entry data is in the memory tier
+static bool load_entry(struct ptk_cache *const c, struct cache_entry *entry, struct ov_error *const err) {
+  if (!entry->in_file) {
+    return true;
+  }
+  // Make entry the newest so that the eviction below does not write it back
+  lru_touch(c, entry);
+  if (!read_entry_from_file(c, entry, err)) {
+    OV_ERROR_ADD_TRACE(err);
+    return false;
+  }
+  entry->in_file = false;
+  c->file_used -= entry->data_size;
+  c->memory_used += entry->data_size;
+  // Delete file
+  delete_entry_file(c, entry);
+
+  // Evict if needed
+  if (c->memory_used > MEMORY_CACHE_LIMIT) {
+    struct ov_error evict_err = {0};
+    if (!evict_memory_to_file(c, &evict_err)) {
+      ptk_logf_warn(&evict_err, "%1$hs", "%1$hs", "failed to evict cache to file tier");
+      OV_ERROR_REPORT(&evict_err, NULL);
+    }
+  }
+  return true;
+}
+
+// Build the full image of entry into a newly allocated *data.
+// Leaves *data NULL if the image cannot be reconstructed because a base entry is gone.
+static bool
+reconstruct_entry(struct ptk_cache *const c, struct cache_entry *entry, uint8_t **data, struct ov_error *const err) {
+  size_t const image_size = (size_t)entry->width * (size_t)entry->height * 4;
+  bool result = false;
+
+  if (entry->depth > 0) {
+    // Base entries always have a smaller depth, which also rules out cycles
+    // when a key is evicted and stored again later.
+    struct cache_entry *base = find_entry(c, entry->base_ckey);
+    if (!base || base->depth >= entry->depth || base->width != entry->width || base->height != entry->height) {
+      result = true;
+      goto cleanup;
+    }
+    lru_touch(c, base);
+    if (!reconstruct_entry(c, base, data, err)) {
+      OV_ERROR_ADD_TRACE(err);
+      goto cleanup;
+    }
+    if (!*data) {
+      result = true;
+      goto cleanup;
+    }
+  } else if (!OV_REALLOC(data, image_size, 1)) {
+    OV_ERROR_SET_GENERIC(err, ov_error_generic_out_of_memory);
+    goto cleanup;
+  }
+
+  if (!load_entry(c, entry, err)) {
+    OV_ERROR_ADD_TRACE(err);
+    goto cleanup;
+  }
+
+  if (entry->depth == 0) {
+    memcpy(*data, entry->data, image_size);
+  } else {
+    // Apply patches
+    struct ptk_cache_rect const *const rects = (struct ptk_cache_rect const *)(void const *)entry->data;
+    uint8_t const *src = entry->data + entry->num_rects * sizeof(struct ptk_cache_rect);
+    size_t const stride = (size_t)entry->width * 4;
+    for (size_t i = 0; i < entry->num_rects; ++i) {
+      size_t const row_size = (size_t)rects[i].width * 4;
+      uint8_t *dst = *data + (size_t)rects[i].y * stride + (size_t)rects[i].x * 4;
+      for (int32_t y = 0; y < rects[i].height; ++y) {
+        memcpy(dst, src, row_size);
+        dst += stride;
+        src += row_size;
+      }
+    }
+  }
+  result = true;
+
+cleanup:
+  if (!result && *data) {
+    OV_FREE(data);
   }
+  return result;
 }
 
 // Try to lock a directory (for orphan detection)
@@ -619,28 +774,22 @@ bool ptk_cache_put(struct ptk_cache *const c,
     return false;
   }
 
-  char cachekey_hex[CACHEKEY_HEX_LEN + 1];
-  ckey_to_hex(ckey, cachekey_hex);
-
   bool result = false;
   size_t const data_size = (size_t)width * (size_t)height * 4;
   struct cache_entry *new_entry = NULL;
 
-  // Check if already exists - need a temporary entry for key lookup
-  struct cache_entry key_entry = {0};
-  memcpy(key_entry.cachekey_hex, cachekey_hex, CACHEKEY_HEX_LEN);
-  struct cache_entry *key_ptr = &key_entry;
-
   // Look up existing entry
   {
-    void const *const_ptr = OV_HASHMAP_GET(c->entries, &key_ptr);
-    if (const_ptr) {
-      // Entry exists - get pointer from hashmap
-      struct cache_entry *existing = *(struct cache_entry *const *)const_ptr;
-      // Already cached, just touch LRU
-      lru_touch(c, existing);
-      result = true;
-      goto cleanup;
+    struct cache_entry *existing = find_entry(c, ckey);
+    if (existing) {
+      if (is_reconstructable(c, existing)) {
+        // Already cached, just touch LRU
+        lru_touch(c, existing);
+        result = true;
+        goto cleanup;
+      }
+      // A delta whose base is gone can never be read again, replace it
+      remove_entry(c, existing);
     }
   }
 
@@ -650,7 +799,7 @@ bool ptk_cache_put(struct ptk_cache *const c,
     goto cleanup;
   }
   *new_entry = (struct cache_entry){0};
-  memcpy(new_entry->cachekey_hex, cachekey_hex, CACHEKEY_HEX_LEN);
+  ckey_to_hex(ckey, new_entry->cachekey_hex);
   new_entry->width = width;
   new_entry->height = height;
   new_entry->data_size = data_size;
@@ -663,30 +812,109 @@ bool ptk_cache_put(struct ptk_cache *const c,
   }
   memcpy(new_entry->data, data, data_size);
 
-  // Add pointer to hashmap
-  if (!OV_HASHMAP_SET(c->entries, &new_entry)) {
-    OV_ERROR_SET_GENERIC(err, ov_error_generic_out_of_memory);
+  if (!insert_entry(c, new_entry, err)) {
+    OV_ERROR_ADD_TRACE(err);
     goto cleanup;
   }
 
-  // Add to LRU (new_entry is heap-allocated, address is stable)
-  lru_add(c, new_entry);
-  c->memory_used += data_size;
+  new_entry = NULL; // ownership transferred to hashmap
+  result = true;
 
-  // Evict if needed
-  if (c->memory_used > MEMORY_CACHE_LIMIT) {
-    struct ov_error evict_err = {0};
-    if (!evict_memory_to_file(c, &evict_err)) {
-      // Non-fatal, just log
-      ptk_logf_warn(&evict_err, "%1$hs", "%1$hs", "failed to evict cache to file tier");
-      OV_ERROR_REPORT(&evict_err, NULL);
+cleanup:
+  if (new_entry) {
+    if (new_entry->data) {
+      OV_FREE(&new_entry->data);
     }
+    OV_FREE(&new_entry);
   }
-  if (c->file_used > FILE_CACHE_LIMIT) {
-    evict_file_tier(c);
+  return result;
+}
+
+bool ptk_cache_put_delta(struct ptk_cache *const c,
+                         uint64_t ckey,
+                         uint64_t base_ckey,
+                         struct ptk_cache_rect const *rects,
+                         size_t num_rects,
+                         void const *pixels,
+                         bool *stored,
+                         struct ov_error *const err) {
+  if (!c || !stored || ckey == base_ckey || (num_rects > 0 && (!rects || !pixels))) {
+    OV_ERROR_SET_GENERIC(err, ov_error_generic_invalid_argument);
+    return false;
+  }
+
+  *stored = false;
+
+  bool result = false;
+  struct cache_entry *new_entry = NULL;
+  struct cache_entry *base = NULL;
+  size_t const rects_size = num_rects * sizeof(struct ptk_cache_rect);
+  size_t pixels_size = 0;
+
+  {
+    struct cache_entry *existing = find_entry(c, ckey);
+    if (existing) {
+      if (is_reconstructable(c, existing)) {
+        // Already cached, just touch LRU
+        lru_touch(c, existing);
+        *stored = true;
+        result = true;
+        goto cleanup;
+      }
+      // A delta whose base is gone can never be read again, replace it
+      remove_entry(c, existing);
+    }
+  }
+
+  base = find_entry(c, base_ckey);
+  if (!base || base->depth >= DELTA_CHAIN_LIMIT) {
+    // Cannot be stored as a delta - not an error
+    result = true;
+    goto cleanup;
+  }
+
+  for (size_t i = 0; i < num_rects; ++i) {
+    struct ptk_cache_rect const *const r = &rects[i];
+    if (r->x < 0 || r->y < 0 || r->width <= 0 || r->height <= 0 || r->x > base->width - r->width ||
+        r->y > base->height - r->height) {
+      OV_ERROR_SET_GENERIC(err, ov_error_generic_invalid_argument);
+      goto cleanup;
+    }
+    pixels_size += (size_t)r->width * (size_t)r->height * 4;
+  }
+
+  if (!OV_REALLOC(&new_entry, 1, sizeof(struct cache_entry))) {
+    OV_ERROR_SET_GENERIC(err, ov_error_generic_out_of_memory);
+    goto cleanup;
+  }
+  *new_entry = (struct cache_entry){0};
+  ckey_to_hex(ckey, new_entry->cachekey_hex);
+  new_entry->width = base->width;
+  new_entry->height = base->height;
+  new_entry->data_size = rects_size + pixels_size;
+  new_entry->in_file = false;
+  new_entry->base_ckey = base_ckey;
+  new_entry->num_rects = num_rects;
+  new_entry->depth = base->depth + 1;
+
+  if (new_entry->data_size > 0) {
+    if (!OV_REALLOC(&new_entry->data, new_entry->data_size, 1)) {
+      OV_ERROR_SET_GENERIC(err, ov_error_generic_out_of_memory);
+      goto cleanup;
+    }
+    memcpy(new_entry->data, rects, rects_size);
+    memcpy(new_entry->data + rects_size, pixels, pixels_size);
+  }
+
+  // The base is needed to reconstruct the new entry
+  lru_touch(c, base);
+  if (!insert_entry(c, new_entry, err)) {
+    OV_ERROR_ADD_TRACE(err);
+    goto cleanup;
   }
 
   new_entry = NULL; // ownership transferred to hashmap
+  *stored = true;
   result = true;
 
 cleanup:
@@ -710,69 +938,44 @@ bool ptk_cache_get(struct ptk_cache *const c,
     return false;
   }
 
-  char cachekey_hex[CACHEKEY_HEX_LEN + 1];
-  ckey_to_hex(ckey, cachekey_hex);
-
   *data = NULL;
   *width = 0;
   *height = 0;
 
   bool result = false;
-  struct cache_entry *entry = NULL;
-
-  // Create temporary entry for key lookup
-  struct cache_entry key_entry = {0};
-  memcpy(key_entry.cachekey_hex, cachekey_hex, CACHEKEY_HEX_LEN);
-  struct cache_entry *key_ptr = &key_entry;
-
-  // Look up entry
-  {
-    void const *const_ptr = OV_HASHMAP_GET(c->entries, &key_ptr);
-    if (!const_ptr) {
-      // Cache miss - not an error
-      result = true;
-      goto cleanup;
-    }
-    entry = *(struct cache_entry *const *)const_ptr;
+  uint8_t *pixels = NULL;
+  struct cache_entry *entry = find_entry(c, ckey);
+  if (!entry) {
+    // Cache miss - not an error
+    result = true;
+    goto cleanup;
   }
 
   // Touch LRU
   lru_touch(c, entry);
 
-  // If in file tier, read back to memory
-  if (entry->in_file) {
-    if (!read_entry_from_file(c, entry, err)) {
-      OV_ERROR_ADD_TRACE(err);
-      goto cleanup;
-    }
-    entry->in_file = false;
-    c->file_used -= entry->data_size;
-    c->memory_used += entry->data_size;
-    // Delete file
-    delete_entry_file(c, entry);
-
-    // Evict if needed
-    if (c->memory_used > MEMORY_CACHE_LIMIT) {
-      struct ov_error evict_err = {0};
-      if (!evict_memory_to_file(c, &evict_err)) {
-        ptk_logf_warn(&evict_err, "%1$hs", "%1$hs", "failed to evict cache to file tier");
-        OV_ERROR_REPORT(&evict_err, NULL);
-      }
-    }
+  // Build a copy for caller, reading back from the file tier and applying deltas as needed
+  if (!reconstruct_entry(c, entry, &pixels, err)) {
+    OV_ERROR_ADD_TRACE(err);
+    goto cleanup;
   }
-
-  // Allocate and copy data for caller
-  if (!OV_REALLOC(data, entry->data_size, 1)) {
-    OV_ERROR_SET_GENERIC(err, ov_error_generic_out_of_memory);
+  if (!pixels) {
+    // Base entry is gone - treat as cache miss and drop the entry that can no longer be read
+    remove_entry(c, entry);
+    result = true;
     goto cleanup;
   }
-  memcpy(*data, entry->data, entry->data_size);
+  *data = pixels;
   *width = entry->width;
   *height = entry->height;
+  pixels = NULL;
 
   result = true;
 
 cleanup:
+  if (pixels) {
+    OV_FREE(&pixels);
+  }
   return result;
 }
 
@@ -44,10 +44,51 @@ void ptk_cache_destroy(struct ptk_cache **c);
 NODISCARD bool ptk_cache_put(
     struct ptk_cache *c, uint64_t ckey, void const *data, int32_t width, int32_t height, struct ov_error *err);
 
+/**
+ * Rectangle of a delta entry, in the pixel coordinates of the stored data.
+ */
+struct ptk_cache_rect {
+  int32_t x;
+  int32_t y;
+  int32_t width;
+  int32_t height;
+};
+
+/**
+ * Store rendered image data as a difference from another cached entry.
+ *
+ * Consecutive frames of lipsync and blink animations differ only in small areas,
+ * so only the patched rectangles are stored. The full image is reconstructed by ptk_cache_get.
+ * The entry has the same dimensions as the base entry.
+ *
+ * If the base entry is not cached or its delta chain is too long, nothing is stored
+ * and *stored is set to false (not an error); the caller should store a full image instead.
+ *
+ * @param c Cache instance
+ * @param ckey 64-bit cache key
+ * @param base_ckey 64-bit cache key of the base entry
+ * @param rects Patched rectangles, must lie inside the base image
+ * @param num_rects Number of rectangles
+ * @param pixels BGRA pixel data of rects, packed row by row in the order of rects
+ * @param stored Output: true if the entry is cached
+ * @param err Error details on failure
+ * @return true on success, false on failure
+ */
+NODISCARD bool ptk_cache_put_delta(struct ptk_cache *c,
+                                   uint64_t ckey,
+                                   uint64_t base_ckey,
+                                   struct ptk_cache_rect const *rects,
+                                   size_t num_rects,
+                                   void const *pixels,
+                                   bool *stored,
+                                   struct ov_error *err);
+
 /**
  * Retrieve cached image data.
  *
  * On cache hit, allocates and returns a copy of the pixel data.
+ * Entries stored by ptk_cache_put_delta are reconstructed from their base entries;
+ * if a base entry has already been evicted, it is treated as a cache miss.
  * On cache miss, sets *data to NULL (not an error).
  * The caller is responsible for freeing the returned data with OV_FREE.
  *
@@ -1,18 +1,19 @@
-#include "cache.h"
+// Stub out external dependencies before including cache.c
 #include "logf.h"
 
-#include <ovtest.h>
-
-#include <stdarg.h>
-#include <string.h>
-
-// Stub for logging functions (cache.c depends on logf.h)
 void ptk_logf_warn(struct ov_error const *const err, char const *const reference, char const *const format, ...) {
   (void)err;
   (void)reference;
   (void)format;
 }
 
+// Include cache.c directly to test static functions
+#include "cache.c"
+
+#include <ovtest.h>
+
+#include <stdarg.h>
+
 static void test_cache_create_and_destroy(void) {
   struct ov_error err = {0};
   struct ptk_cache *c = NULL;
@@ -494,6 +495,207 @@ static void test_cache_multiple_instances(void) {
   ptk_cache_destroy(&c2);
 }
 
+static void test_cache_put_delta(void) {
+  struct ov_error err = {0};
+  struct ptk_cache *c = NULL;
+  void *output_data = NULL;
+  int32_t width = 0;
+  int32_t height = 0;
+  bool stored = false;
+
+  c = ptk_cache_create(&err);
+  if (!TEST_SUCCEEDED(c != NULL, &err)) {
+    return;
+  }
+
+  // 3x2 base image
+  uint8_t base[24] = {0};
+  for (size_t i = 0; i < sizeof(base); ++i) {
+    base[i] = (uint8_t)i;
+  }
+  if (!TEST_SUCCEEDED(ptk_cache_put(c, 0x6261736562617365ULL, base, 3, 2, &err), &err)) {
+    goto cleanup;
+  }
+
+  // Patch the right two pixels of the bottom row
+  struct ptk_cache_rect const rect = {.x = 1, .y = 1, .width = 2, .height = 1};
+  uint8_t const patch[8] = {0xa0, 0xa1, 0xa2, 0xa3, 0xb0, 0xb1, 0xb2, 0xb3};
+  if (!TEST_SUCCEEDED(
+          ptk_cache_put_delta(c, 0x64656c7461303031ULL, 0x6261736562617365ULL, &rect, 1, patch, &stored, &err),
+          &err)) {
+    goto cleanup;
+  }
+  TEST_CHECK(stored);
+
+  // Delta on top of delta
+  struct ptk_cache_rect const rect2 = {.x = 0, .y = 0, .width = 1, .height = 1};
+  uint8_t const patch2[4] = {0xc0, 0xc1, 0xc2, 0xc3};
+  if (!TEST_SUCCEEDED(
+          ptk_cache_put_delta(c, 0x64656c7461303032ULL, 0x64656c7461303031ULL, &rect2, 1, patch2, &stored, &err),
+          &err)) {
+    goto cleanup;
+  }
+  TEST_CHECK(stored);
+
+  if (!TEST_SUCCEEDED(ptk_cache_get(c, 0x64656c7461303032ULL, &output_data, &width, &height, &err), &err)) {
+    goto cleanup;
+  }
+  if (TEST_CHECK(output_data != NULL)) {
+    uint8_t want[24];
+    memcpy(want, base, sizeof(want));
+    memcpy(want + 16, patch, sizeof(patch));
+    memcpy(want, patch2, sizeof(patch2));
+    TEST_CHECK(width == 3);
+    TEST_MSG("want 3, got %d", width);
+    TEST_CHECK(height == 2);
+    TEST_MSG("want 2, got %d", height);
+    TEST_CHECK(memcmp(output_data, want, sizeof(want)) == 0);
+    TEST_DUMP("want:", want, sizeof(want));
+    TEST_DUMP("got:", output_data, sizeof(want));
+  }
+
+cleanup:
+  if (output_data) {
+    OV_FREE(&output_data);
+  }
+  ptk_cache_destroy(&c);
+}
+
+static void test_cache_put_delta_without_base(void) {
+  struct ov_error err = {0};
+  struct ptk_cache *c = NULL;
+  void *output_data = NULL;
+  int32_t width = 0;
+  int32_t height = 0;
+  bool stored = true;
+
+  c = ptk_cache_create(&err);
+  if (!TEST_SUCCEEDED(c != NULL, &err)) {
+    return;
+  }
+
+  // Missing base - not an error, but nothing is stored
+  struct ptk_cache_rect const rect = {.x = 0, .y = 0, .width = 1, .height = 1};
+  uint8_t const patch[4] = {1, 2, 3, 4};
+  if (!TEST_SUCCEEDED(
+          ptk_cache_put_delta(c, 0x64656c7461303031ULL, 0x6261736562617365ULL, &rect, 1, patch, &stored, &err),
+          &err)) {
+    goto cleanup;
+  }
+  TEST_CHECK(!stored);
+  if (!TEST_SUCCEEDED(ptk_cache_get(c, 0x64656c7461303031ULL, &output_data, &width, &height, &err), &err)) {
+    goto cleanup;
+  }
+  TEST_CHECK(output_data == NULL);
+
+  // Rectangle outside of the base image
+  uint8_t const base[16] = {0};
+  if (!TEST_SUCCEEDED(ptk_cache_put(c, 0x6261736562617365ULL, base, 2, 2, &err), &err)) {
+    goto cleanup;
+  }
+  struct ptk_cache_rect const outside = {.x = 1, .y = 1, .width = 2, .height = 1};
+  TEST_FAILED_WITH(
+      ptk_cache_put_delta(c, 0x64656c7461303031ULL, 0x6261736562617365ULL, &outside, 1, patch, &stored, &err),
+      &err,
+      ov_error_type_generic,
+      ov_error_generic_invalid_argument);
+
+  // Base cleared after the delta is stored - treated as a cache miss
+  if (!TEST_SUCCEEDED(
+          ptk_cache_put_delta(c, 0x64656c7461303031ULL, 0x6261736562617365ULL, &rect, 1, patch, &stored, &err),
+          &err)) {
+    goto cleanup;
+  }
+  TEST_CHECK(stored);
+  ptk_cache_clear(c);
+  if (!TEST_SUCCEEDED(ptk_cache_put(c, 0x64656c7461303032ULL, base, 2, 2, &err), &err)) {
+    goto cleanup;
+  }
+  if (!TEST_SUCCEEDED(ptk_cache_get(c, 0x64656c7461303031ULL, &output_data, &width, &height, &err), &err)) {
+    goto cleanup;
+  }
+  TEST_CHECK(output_data == NULL);
+
+cleanup:
+  if (output_data) {
+    OV_FREE(&output_data);
+  }
+  ptk_cache_destroy(&c);
+}
+
+static void test_cache_put_delta_after_base_evicted(void) {
+  struct ov_error err = {0};
+  struct ptk_cache *c = NULL;
+  void *output_data = NULL;
+  int32_t width = 0;
+  int32_t height = 0;
+  bool stored = false;
+
+  c = ptk_cache_create(&err);
+  if (!TEST_SUCCEEDED(c != NULL, &err)) {
+    return;
+  }
+
+  uint8_t const base[16] = {0};
+  uint8_t full[16];
+  for (size_t i = 0; i < sizeof(full); ++i) {
+    full[i] = (uint8_t)(0x80 + i);
+  }
+  struct ptk_cache_rect const rect = {.x = 0, .y = 0, .width = 1, .height = 1};
+  uint8_t const patch[4] = {1, 2, 3, 4};
+
+  if (!TEST_SUCCEEDED(ptk_cache_put(c, 0x6261736562617365ULL, base, 2, 2, &err), &err) ||
+      !TEST_SUCCEEDED(
+          ptk_cache_put_delta(c, 0x64656c7461303031ULL, 0x6261736562617365ULL, &rect, 1, patch, &stored, &err),
+          &err) ||
+      !TEST_SUCCEEDED(
+          ptk_cache_put_delta(c, 0x64656c7461303032ULL, 0x6261736562617365ULL, &rect, 1, patch, &stored, &err),
+          &err)) {
+    goto cleanup;
+  }
+  TEST_CHECK(stored);
+
+  // Evict only the base, leaving both deltas behind
+  remove_entry(c, find_entry(c, 0x6261736562617365ULL));
+
+  // Putting the same key as a full image replaces the unreadable delta
+  if (!TEST_SUCCEEDED(ptk_cache_put(c, 0x64656c7461303031ULL, full, 2, 2, &err), &err) ||
+      !TEST_SUCCEEDED(ptk_cache_get(c, 0x64656c7461303031ULL, &output_data, &width, &height, &err), &err)) {
+    goto cleanup;
+  }
+  if (TEST_CHECK(output_data != NULL)) {
+    TEST_CHECK(memcmp(output_data, full, sizeof(full)) == 0);
+    TEST_DUMP("want:", full, sizeof(full));
+    TEST_DUMP("got:", output_data, sizeof(full));
+    OV_FREE(&output_data);
+  }
+
+  // Putting the same key as a delta of another base replaces it too
+  if (!TEST_SUCCEEDED(
+          ptk_cache_put_delta(c, 0x64656c7461303032ULL, 0x64656c7461303031ULL, &rect, 1, patch, &stored, &err),
+          &err)) {
+    goto cleanup;
+  }
+  TEST_CHECK(stored);
+  if (!TEST_SUCCEEDED(ptk_cache_get(c, 0x64656c7461303032ULL, &output_data, &width, &height, &err), &err)) {
+    goto cleanup;
+  }
+  if (TEST_CHECK(output_data != NULL)) {
+    uint8_t want[16];
+    memcpy(want, full, sizeof(want));
+    memcpy(want, patch, sizeof(patch));
+    TEST_CHECK(memcmp(output_data, want, sizeof(want)) == 0);
+    TEST_DUMP("want:", want, sizeof(want));
+    TEST_DUMP("got:", output_data, sizeof(want));
+  }
+
+cleanup:
+  if (output_data) {
+    OV_FREE(&output_data);
+  }
+  ptk_cache_destroy(&c);
+}
+
 TEST_LIST = {
     {"test_cache_create_and_destroy", test_cache_create_and_destroy},
     {"test_cache_put_invalid_args", test_cache_put_invalid_args},
@@ -505,5 +707,8 @@ TEST_LIST = {
     {"test_cache_large_image", test_cache_large_image},
     {"test_cache_recreate_clears_data", test_cache_recreate_clears_data},
     {"test_cache_multiple_instances", test_cache_multiple_instances},
+    {"test_cache_put_delta", test_cache_put_delta},
+    {"test_cache_put_delta_without_base", test_cache_put_delta_without_base},
+    {"test_cache_put_delta_after_base_evicted", test_cache_put_delta_after_base_evicted},
     {NULL, NULL},
 };
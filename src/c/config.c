@@ -26,6 +26,8 @@ struct ptk_config {
   bool debug_mode;
   // Resize quality (ptk_resize_quality)
   int resize_quality;
+  // Soft memory limit of the helper process in MiB, 0 means no limit
+  int memory_limit_mib;
 };
 
 static bool get_dll_directory(NATIVE_CHAR **const dir, struct ov_error *const err) {
@@ -90,6 +92,7 @@ struct ptk_config *ptk_config_create(struct ov_error *const err) {
       .external_object_audio_text = false,
       .debug_mode = false,
       .resize_quality = ptk_resize_quality_beautiful,
+      .memory_limit_mib = 0,
   };
 
   result = cfg;
@@ -153,6 +156,7 @@ static char const g_json_key_external_wav_txt_pair[] = "external_wav_txt_pair";
 static char const g_json_key_external_object_audio_text[] = "external_object_audio_text";
 static char const g_json_key_debug_mode[] = "debug_mode";
 static char const g_json_key_resize_quality[] = "resize_quality";
+static char const g_json_key_memory_limit_mib[] = "memory_limit_mib";
 
 bool ptk_config_load(struct ptk_config *const config, struct ov_error *const err) {
   if (!config) {
@@ -259,6 +263,11 @@ bool ptk_config_load(struct ptk_config *const config, struct ov_error *const err
     if (val && yyjson_is_int(val)) {
       config->resize_quality = (int)yyjson_get_int(val);
     }
+
+    val = yyjson_obj_get(root, g_json_key_memory_limit_mib);
+    if (val && yyjson_is_int(val)) {
+      config->memory_limit_mib = (int)yyjson_get_int(val);
+    }
   }
 
   result = true;
@@ -315,6 +324,7 @@ bool ptk_config_save(struct ptk_config const *const config, struct ov_error *con
     yyjson_mut_obj_add_bool(doc, root, g_json_key_external_object_audio_text, config->external_object_audio_text);
     yyjson_mut_obj_add_bool(doc, root, g_json_key_debug_mode, config->debug_mode);
     yyjson_mut_obj_add_int(doc, root, g_json_key_resize_quality, config->resize_quality);
+    yyjson_mut_obj_add_int(doc, root, g_json_key_memory_limit_mib, config->memory_limit_mib);
 
     json_str = yyjson_mut_write_opts(doc, YYJSON_WRITE_PRETTY, ptk_json_get_alc(), NULL, NULL);
     if (!json_str) {
@@ -522,3 +532,23 @@ bool ptk_config_set_resize_quality(struct ptk_config *const config, int const va
   config->resize_quality = value;
   return true;
 }
+
+bool ptk_config_get_memory_limit_mib(struct ptk_config const *const config,
+                                     int *const value,
+                                     struct ov_error *const err) {
+  if (!config || !value) {
+    OV_ERROR_SET_GENERIC(err, ov_error_generic_invalid_argument);
+    return false;
+  }
+  *value = config->memory_limit_mib;
+  return true;
+}
+
+bool ptk_config_set_memory_limit_mib(struct ptk_config *const config, int const value, struct ov_error *const err) {
+  if (!config) {
+    OV_ERROR_SET_GENERIC(err, ov_error_generic_invalid_argument);
+    return false;
+  }
+  config->memory_limit_mib = value;
+  return true;
+}
@@ -91,3 +91,10 @@ enum ptk_resize_quality {
 
 bool ptk_config_get_resize_quality(struct ptk_config const *const config, int *const value, struct ov_error *const err);
 bool ptk_config_set_resize_quality(struct ptk_config *const config, int const value, struct ov_error *const err);
+
+// Memory limit setting - soft memory limit of the helper process in MiB, 0 means no limit
+
+bool ptk_config_get_memory_limit_mib(struct ptk_config const *const config,
+                                     int *const value,
+                                     struct ov_error *const err);
+bool ptk_config_set_memory_limit_mib(struct ptk_config *const config, int const value, struct ov_error *const err);
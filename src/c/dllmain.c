@@ -432,6 +432,18 @@ static void script_module_detect_encoding(struct aviutl2_script_module_param *pa
   ptk_script_module_detect_encoding(g_script_module, param);
 }
 
+static void script_module_get_audio_level(struct aviutl2_script_module_param *param) {
+  ptk_script_module_get_audio_level(g_script_module, param);
+}
+
+static void script_module_get_voice_level(struct aviutl2_script_module_param *param) {
+  ptk_script_module_get_voice_level(g_script_module, param);
+}
+
+static void script_module_get_phoneme(struct aviutl2_script_module_param *param) {
+  ptk_script_module_get_phoneme(g_script_module, param);
+}
+
 static bool load_gcmzdrops(struct aviutl2_script_module_table *const script_module_table, struct ov_error *const err) {
   wchar_t *path = NULL;
   void *dll_hinst = NULL;
@@ -585,6 +597,9 @@ void __declspec(dllexport) RegisterPlugin(struct aviutl2_host_app_table *host) {
       {L"draw", script_module_draw},
       {L"read_text_file", script_module_read_text_file},
       {L"detect_encoding", script_module_detect_encoding},
+      {L"get_audio_level", script_module_get_audio_level},
+      {L"get_voice_level", script_module_get_voice_level},
+      {L"get_phoneme", script_module_get_phoneme},
       {NULL, NULL},
   };
   static wchar_t script_module_information[64];
@@ -12,15 +12,18 @@
 static char const g_global_section_internal_name[] = "][";
 static char const g_empty_section_internal_name[] = "]]";
 
+// Sections and entries do not own their strings.
+// name and line point into one of the loaded buffers, which live until the reader is destroyed.
 struct ptk_ini_reader {
   struct ov_hashmap *sections;
+  char **buffers; // ovarray of ovarray, one copy of each loaded source
 };
 
 struct section {
   char const *name;
   size_t name_len;
   size_t line_number;
-  char *line;
+  char const *line;
   size_t line_len;
   struct ov_hashmap *entries;
 };
@@ -29,7 +32,7 @@ struct entry {
   char const *name;
   size_t name_len;
   size_t line_number;
-  char *line;
+  char const *line;
   size_t line_len;
 };
 
@@ -98,33 +101,11 @@ static void internal_section_name_to_section(char const *const internal_name,
   }
 }
 
-static void cleanup_entry(struct entry *const e) {
-  if (!e) {
-    return;
-  }
-  if (e->name) {
-    OV_FREE(&e->name);
-  }
-  if (e->line) {
-    OV_FREE(&e->line);
-  }
-}
-
 static void cleanup_section(struct section *const s) {
   if (!s) {
     return;
   }
-  if (s->name) {
-    OV_FREE(&s->name);
-  }
-  if (s->line) {
-    OV_FREE(&s->line);
-  }
   if (s->entries) {
-    struct entry *e = NULL;
-    for (size_t i = 0; OV_HASHMAP_ITER(s->entries, &i, &e);) {
-      cleanup_entry(e);
-    }
     OV_HASHMAP_DESTROY(&s->entries);
   }
 }
@@ -170,6 +151,13 @@ void ptk_ini_reader_destroy(struct ptk_ini_reader **const rp) {
     }
     OV_HASHMAP_DESTROY(&r->sections);
   }
+  if (r->buffers) {
+    size_t const n = OV_ARRAY_LENGTH(r->buffers);
+    for (size_t i = 0; i < n; i++) {
+      OV_ARRAY_DESTROY(&r->buffers[i]);
+    }
+    OV_ARRAY_DESTROY(&r->buffers);
+  }
   OV_FREE(rp);
 }
 
@@ -217,8 +205,6 @@ static struct ov_hashmap *get_or_create_section_entries(struct ptk_ini_reader *c
 
   struct ov_hashmap *result = NULL;
   struct ov_hashmap *entries = NULL;
-  char *name = NULL;
-  char *sline = NULL;
 
   {
     struct section const *found = (struct section const *)OV_HASHMAP_GET(r->sections,
@@ -237,43 +223,21 @@ static struct ov_hashmap *get_or_create_section_entries(struct ptk_ini_reader *c
     goto cleanup;
   }
 
-  if (section_len > 0) {
-    if (!OV_REALLOC(&name, section_len, sizeof(char))) {
-      goto cleanup;
-    }
-    memcpy(name, section, section_len);
-  }
-
-  if (line && line_len > 0) {
-    if (!OV_REALLOC(&sline, line_len, sizeof(char))) {
-      goto cleanup;
-    }
-    memcpy(sline, line, line_len);
-  }
-
   if (!OV_HASHMAP_SET(r->sections,
                       &((struct section){
-                          .name = name,
+                          .name = section,
                           .name_len = section_len,
                           .line_number = line_number,
-                          .line = sline,
+                          .line = line,
                           .line_len = line_len,
                           .entries = entries,
                       }))) {
     goto cleanup;
   }
   result = entries;
-  name = NULL;
-  sline = NULL;
   entries = NULL;
 
 cleanup:
-  if (sline) {
-    OV_FREE(&sline);
-  }
-  if (name) {
-    OV_FREE(&name);
-  }
   if (entries) {
     OV_HASHMAP_DESTROY(&entries);
   }
@@ -289,48 +253,17 @@ static bool add_entry(struct ov_hashmap *const entries,
   if (!entries || !key) {
     return false;
   }
-
-  bool success = false;
-  char *name = NULL;
-  char *sline = NULL;
-
-  if (key_len > 0) {
-    if (!OV_REALLOC(&name, key_len, sizeof(char))) {
-      goto cleanup;
-    }
-    memcpy(name, key, key_len);
-  }
-
-  if (line && line_len > 0) {
-    if (!OV_REALLOC(&sline, line_len, sizeof(char))) {
-      goto cleanup;
-    }
-    memcpy(sline, line, line_len);
-  }
-
   if (!OV_HASHMAP_SET(entries,
                       &((struct entry){
-                          .name = name,
+                          .name = key,
                           .name_len = key_len,
-                          .line = sline,
+                          .line = line,
                           .line_len = line_len,
                           .line_number = line_number,
                       }))) {
-    goto cleanup;
-  }
-
-  name = NULL;
-  sline = NULL;
-  success = true;
-
-cleanup:
-  if (sline) {
-    OV_FREE(&sline);
-  }
-  if (name) {
-    OV_FREE(&name);
+    return false;
   }
-  return success;
+  return true;
 }
 
 static void trim_whitespace(char const *const str, size_t const str_len, char const **const start, size_t *const len) {
@@ -367,95 +300,92 @@ static void trim_whitespace(char const *const str, size_t const str_len, char co
   *len = (size_t)(trimmed_end - trimmed_start + 1);
 }
 
-struct parse_context {
-  struct ptk_ini_reader *r;
-  struct ov_hashmap *section_entries;
-};
+void ptk_ini_scanner_init(struct ptk_ini_scanner *const scanner, void const *const ptr, size_t const size) {
+  if (!scanner) {
+    return;
+  }
+  char const *content = (char const *)ptr;
+  size_t content_size = ptr ? size : 0;
 
-static bool parse_line(struct parse_context *const ctx,
-                       char const *const line,
-                       size_t const line_len,
-                       size_t const line_number,
-                       struct ov_error *const err) {
-  if (!ctx || !line) {
-    OV_ERROR_SET_GENERIC(err, ov_error_generic_invalid_argument);
+  // Handle UTF-8 BOM
+  if (content_size >= 3 && (unsigned char)content[0] == 0xEF && (unsigned char)content[1] == 0xBB &&
+      (unsigned char)content[2] == 0xBF) {
+    content += 3;
+    content_size -= 3;
+  }
+
+  *scanner = (struct ptk_ini_scanner){
+      .pos = content,
+      .end = content ? content + content_size : NULL,
+  };
+}
+
+bool ptk_ini_scanner_next(struct ptk_ini_scanner *const scanner) {
+  if (!scanner) {
     return false;
   }
 
-  bool result = false;
+  while (scanner->pos < scanner->end) {
+    char const *const line = scanner->pos;
+    char const *line_end = line;
+    while (line_end < scanner->end && *line_end != '\r' && *line_end != '\n') {
+      line_end++;
+    }
+    size_t const line_len = (size_t)(line_end - line);
+    scanner->pos = line_end;
+    if (scanner->pos < scanner->end && *scanner->pos == '\r') {
+      scanner->pos++;
+    }
+    if (scanner->pos < scanner->end && *scanner->pos == '\n') {
+      scanner->pos++;
+    }
+    scanner->line_number++;
 
-  {
     char const *trimmed;
     size_t trimmed_len;
     trim_whitespace(line, line_len, &trimmed, &trimmed_len);
 
-    // Empty line - skip
-    if (trimmed_len == 0) {
-      result = true;
-      goto cleanup;
-    }
-
-    // Comment line - skip
-    if (*trimmed == '#' || *trimmed == ';') {
-      result = true;
-      goto cleanup;
+    // Empty line or comment line - skip
+    if (trimmed_len == 0 || *trimmed == '#' || *trimmed == ';') {
+      continue;
     }
 
     // Section header [section]
     if (*trimmed == '[') {
-      char const *end = strchr(trimmed, ']');
-      if (end && end < trimmed + trimmed_len) {
-        // Extract section name between [ and ]
-        char const *section_content = trimmed + 1;
-        size_t section_content_len = (size_t)(end - section_content);
-
-        char const *section_start;
-        size_t section_len;
-        trim_whitespace(section_content, section_content_len, &section_start, &section_len);
-        if (section_len == 0) {
-          section_start = g_empty_section_internal_name;
-          section_len = sizeof(g_empty_section_internal_name) - 1;
-        }
-
-        ctx->section_entries =
-            get_or_create_section_entries(ctx->r, section_start, section_len, line_number, line, line_len);
-        if (!ctx->section_entries) {
-          OV_ERROR_SET_GENERIC(err, ov_error_generic_out_of_memory);
-          goto cleanup;
-        }
-        result = true;
-        goto cleanup;
+      char const *const end = (char const *)memchr(trimmed, ']', trimmed_len);
+      if (!end) {
+        // Malformed section header - ignore
+        continue;
       }
-      // Malformed section header - ignore
-      result = true;
-      goto cleanup;
+      // Extract section name between [ and ]
+      char const *const section_content = trimmed + 1;
+      trim_whitespace(section_content, (size_t)(end - section_content), &scanner->section, &scanner->section_len);
+      scanner->name = NULL;
+      scanner->name_len = 0;
+      scanner->line = line;
+      scanner->line_len = line_len;
+      return true;
     }
 
     // Key-value pair
-    char const *equals = strchr(trimmed, '=');
-    if (equals && equals < trimmed + trimmed_len) {
-      // Extract key part
-      size_t key_content_len = (size_t)(equals - trimmed);
-
-      char const *key_start;
-      size_t key_len;
-      trim_whitespace(trimmed, key_content_len, &key_start, &key_len);
-      if (key_start && key_len > 0 && ctx->section_entries) {
-        if (!add_entry(ctx->section_entries, line, line_len, line_number, key_start, key_len)) {
-          OV_ERROR_SET_GENERIC(err, ov_error_generic_out_of_memory);
-          goto cleanup;
-        }
-      }
-      result = true;
-      goto cleanup;
+    char const *const equals = (char const *)memchr(trimmed, '=', trimmed_len);
+    if (!equals) {
+      // Unrecognized line format - ignore
+      continue;
     }
+    char const *key_start;
+    size_t key_len;
+    trim_whitespace(trimmed, (size_t)(equals - trimmed), &key_start, &key_len);
+    if (key_len == 0) {
+      continue;
+    }
+    scanner->name = key_start;
+    scanner->name_len = key_len;
+    scanner->line = line;
+    scanner->line_len = line_len;
+    return true;
   }
-
-  // Unrecognized line format - ignore
-  result = true;
-
-cleanup:
-  return result;
+  return false;
 }
 
 static bool parse(struct ptk_ini_reader *const reader,
@@ -470,42 +400,42 @@ static bool parse(struct ptk_ini_reader *const reader,
   bool result = false;
 
   {
-    struct parse_context ctx = {
-        .r = reader,
-        // create global section
-        .section_entries = get_or_create_section_entries(reader,
-                                                         g_global_section_internal_name,
-                                                         sizeof(g_global_section_internal_name) - 1,
-                                                         1, // global section starts at line 1
-                                                         NULL,
-                                                         0),
-    };
-    if (!ctx.section_entries) {
+    // create global section
+    struct ov_hashmap *section_entries = get_or_create_section_entries(reader,
+                                                                       g_global_section_internal_name,
+                                                                       sizeof(g_global_section_internal_name) - 1,
+                                                                       1, // global section starts at line 1
+                                                                       NULL,
+                                                                       0);
+    if (!section_entries) {
       OV_ERROR_SET_GENERIC(err, ov_error_generic_out_of_memory);
       goto cleanup;
     }
 
-    char const *line_start = buffer;
-    char const *const buffer_end = buffer + buffer_size;
-    size_t line_number = 1;
-    while (line_start < buffer_end) {
-      char const *line_end = line_start;
-      while (line_end < buffer_end && *line_end != '\r' && *line_end != '\n') {
-        line_end++;
+    struct ptk_ini_scanner scanner;
+    ptk_ini_scanner_init(&scanner, buffer, buffer_size);
+    while (ptk_ini_scanner_next(&scanner)) {
+      if (!scanner.name) {
+        char const *section_name;
+        size_t section_len;
+        section_to_internal_section_name_n(scanner.section, scanner.section_len, &section_name, &section_len);
+        section_entries = get_or_create_section_entries(
+            reader, section_name, section_len, scanner.line_number, scanner.line, scanner.line_len);
+        if (!section_entries) {
+          OV_ERROR_SET_GENERIC(err, ov_error_generic_out_of_memory);
+          goto cleanup;
+        }
+        continue;
       }
-      size_t const line_len = (size_t)(line_end - line_start);
-      if (!parse_line(&ctx, line_start, line_len, line_number, err)) {
-        OV_ERROR_ADD_TRACE(err);
+      if (!add_entry(section_entries,
+                     scanner.line,
+                     scanner.line_len,
+                     scanner.line_number,
+                     scanner.name,
+                     scanner.name_len)) {
+        OV_ERROR_SET_GENERIC(err, ov_error_generic_out_of_memory);
         goto cleanup;
       }
-      line_start = line_end;
-      if (line_start < buffer_end && *line_start == '\r') {
-        line_start++;
-      }
-      if (line_start < buffer_end && *line_start == '\n') {
-        line_start++;
-      }
-      line_number++;
     }
   }
   result = true;
@@ -541,7 +471,8 @@ bool ptk_ini_reader_load(struct ptk_ini_reader *const reader,
     }
 
     size_t const buffer_size = (size_t)file_size;
-    if (!OV_ARRAY_GROW(&buffer, buffer_size)) {
+    size_t const num_buffers = OV_ARRAY_LENGTH(reader->buffers);
+    if (!OV_ARRAY_GROW(&reader->buffers, num_buffers + 1) || !OV_ARRAY_GROW(&buffer, buffer_size + 1)) {
       OV_ERROR_SET_GENERIC(err, ov_error_generic_out_of_memory);
       goto cleanup;
     }
@@ -555,17 +486,16 @@ bool ptk_ini_reader_load(struct ptk_ini_reader *const reader,
       OV_ERROR_SET(err, ov_error_type_generic, ov_error_generic_fail, "failed to read complete INI source");
       goto cleanup;
     }
+    buffer[buffer_size] = '\0';
+    OV_ARRAY_SET_LENGTH(buffer, buffer_size);
 
-    // Handle UTF-8 BOM
-    char const *content_start = buffer;
-    size_t content_size = bytes_read;
-    if (bytes_read >= 3 && (unsigned char)buffer[0] == 0xEF && (unsigned char)buffer[1] == 0xBB &&
-        (unsigned char)buffer[2] == 0xBF) {
-      content_start = buffer + 3;
-      content_size = bytes_read - 3;
-    }
+    // The reader keeps the buffer before parsing since entries point into it
+    reader->buffers[num_buffers] = buffer;
+    OV_ARRAY_SET_LENGTH(reader->buffers, num_buffers + 1);
+    char const *const content = buffer;
+    buffer = NULL;
 
-    if (!parse(reader, content_start, content_size, err)) {
+    if (!parse(reader, content, bytes_read, err)) {
       OV_ERROR_ADD_TRACE(err);
       goto cleanup;
     }
@@ -689,6 +619,13 @@ static struct ptk_ini_value extract_value_from_line(char const *const line, size
   return result;
 }
 
+struct ptk_ini_value ptk_ini_scanner_get_value(struct ptk_ini_scanner const *const scanner) {
+  if (!scanner || !scanner->name) {
+    return (struct ptk_ini_value){NULL, 0};
+  }
+  return extract_value_from_line(scanner->line, scanner->line_len);
+}
+
 struct ptk_ini_value
 ptk_ini_reader_get_value(struct ptk_ini_reader const *const reader, char const *const section, char const *const key) {
   struct ptk_ini_value result = {NULL, 0};
@@ -24,6 +24,9 @@ void ptk_ini_reader_destroy(struct ptk_ini_reader **const rp);
 /**
  * @brief Load INI data from ovl_source with UTF-8 support and BOM handling
  *
+ * The reader keeps one copy of the loaded data, and section names, entry names
+ * and values point into it until the reader is destroyed.
+ *
  * @param r INI reader instance
  * @param source Source to read data from
  * @param err [out] Error information on failure
@@ -158,3 +161,51 @@ size_t ptk_ini_reader_get_section_count(struct ptk_ini_reader const *const r);
  * @return Number of entries in the section (0 if section not found)
  */
 size_t ptk_ini_reader_get_entry_count(struct ptk_ini_reader const *const r, char const *const section);
+
+/**
+ * @brief Sequential scanner over INI data
+ *
+ * Walks section headers and entries in file order without building an index or allocating memory,
+ * so a lookup can stop as soon as the part it needs has been read.
+ * Names and values point into the scanned data.
+ * A copy of the structure can be used to resume scanning from the same position.
+ */
+struct ptk_ini_scanner {
+  char const *section; ///< Current section name (NULL for global section, NOT null-terminated)
+  size_t section_len;  ///< Length of section name
+  char const *name;    ///< Entry name (NULL on a section header line, NOT null-terminated)
+  size_t name_len;     ///< Length of entry name
+  size_t line_number;  ///< Line number of the current line
+  char const *line;    ///< Current line (internal)
+  size_t line_len;     ///< Length of current line (internal)
+  char const *pos;     ///< Start of the next line (internal)
+  char const *end;     ///< End of data (internal)
+};
+
+/**
+ * @brief Initialize a scanner over INI data in memory, skipping the UTF-8 BOM
+ *
+ * @param scanner Scanner to initialize
+ * @param ptr Pointer to INI data, must outlive the scanner
+ * @param size Size of INI data in bytes
+ */
+void ptk_ini_scanner_init(struct ptk_ini_scanner *const scanner, void const *const ptr, size_t const size);
+
+/**
+ * @brief Advance to the next section header or entry
+ *
+ * On a section header, section is updated and name is NULL.
+ * On an entry, name is set and section is the section it belongs to.
+ *
+ * @param scanner Scanner
+ * @return true if a section header or entry was found, false at the end of data
+ */
+bool ptk_ini_scanner_next(struct ptk_ini_scanner *const scanner);
+
+/**
+ * @brief Get the value of the current entry
+ *
+ * @param scanner Scanner positioned on an entry
+ * @return Result structure with pointer and size (ptr is NULL on a section header line)
+ */
+struct ptk_ini_value ptk_ini_scanner_get_value(struct ptk_ini_scanner const *const scanner);
@@ -0,0 +1,145 @@
+#include <ovtest.h>
+
+#include <ovarray.h>
+#include <ovprintf.h>
+#include <ovprintf_ex.h>
+
+#include <stdio.h>
+#include <string.h>
+
+#include "bench.h"
+#include "ini_reader.h"
+
+enum {
+  bench_objects = 2000,
+  bench_effects_per_object = 4,
+  bench_params_per_effect = 16,
+  bench_runs = 5,
+};
+
+// Build an object alias similar to an exported scene, a few megabytes in size
+static bool build_alias(char **const alias, struct ov_error *const err) {
+  for (size_t i = 0; i < bench_objects; i++) {
+    if (!ov_sprintf_append_char(alias,
+                                err,
+                                "%1$zu%2$zu%3$zu",
+                                "[Object.%1$zu]\r\nlayer=%2$zu\r\nframe=%3$zu,%3$zu\r\n",
+                                i,
+                                i % 100,
+                                i * 10)) {
+      OV_ERROR_ADD_TRACE(err);
+      return false;
+    }
+    for (size_t j = 0; j < bench_effects_per_object; j++) {
+      if (!ov_sprintf_append_char(alias,
+                                  err,
+                                  "%1$zu%2$zu",
+                                  "[Object.%1$zu.%2$zu]\r\neffect.name=Effect %2$zu@PSDToolKit\r\n",
+                                  i,
+                                  j)) {
+        OV_ERROR_ADD_TRACE(err);
+        return false;
+      }
+      for (size_t k = 0; k < bench_params_per_effect; k++) {
+        if (!ov_sprintf_append_char(alias,
+                                    err,
+                                    "%1$zu%2$zu",
+                                    "Parameter %1$zu=C:\\path\\to\\character.psd|%2$zu.0\r\n",
+                                    k,
+                                    i + k)) {
+          OV_ERROR_ADD_TRACE(err);
+          return false;
+        }
+      }
+    }
+  }
+  return true;
+}
+
+// Load the whole alias into a reader, best of bench_runs
+static void bench_ini_reader_load(void) {
+  struct ov_error err = {0};
+  char *alias = NULL;
+  double best = 0;
+
+  if (!TEST_SUCCEEDED(build_alias(&alias, &err), &err)) {
+    goto cleanup;
+  }
+  size_t const alias_len = OV_ARRAY_LENGTH(alias);
+
+  for (int run = 0; run < bench_runs; run++) {
+    struct ptk_ini_reader *reader = NULL;
+    if (!TEST_SUCCEEDED(ptk_ini_reader_create(&reader, &err), &err)) {
+      goto cleanup;
+    }
+    double const start = ptk_bench_now();
+    bool const loaded = ptk_ini_reader_load_memory(reader, alias, alias_len, &err);
+    double const elapsed = ptk_bench_now() - start;
+    ptk_ini_reader_destroy(&reader);
+    if (!TEST_SUCCEEDED(loaded, &err)) {
+      goto cleanup;
+    }
+    if (run == 0 || elapsed < best) {
+      best = elapsed;
+    }
+  }
+  printf("alias %zu bytes  load %8.3f ms  %8.1f MB/s\n", alias_len, best * 1e3, (double)alias_len / best / 1e6);
+
+cleanup:
+  if (alias) {
+    OV_ARRAY_DESTROY(&alias);
+  }
+}
+
+// Scan to one early section, as ptk_alias_extract_animation does, best of bench_runs
+static void bench_ini_scanner_find_section(void) {
+  static char const target[] = "Object.10.2";
+  struct ov_error err = {0};
+  char *alias = NULL;
+  double best = 0;
+
+  if (!TEST_SUCCEEDED(build_alias(&alias, &err), &err)) {
+    goto cleanup;
+  }
+  size_t const alias_len = OV_ARRAY_LENGTH(alias);
+
+  for (int run = 0; run < bench_runs; run++) {
+    size_t entries = 0;
+    double const start = ptk_bench_now();
+    struct ptk_ini_scanner scanner;
+    ptk_ini_scanner_init(&scanner, alias, alias_len);
+    bool in_target = false;
+    while (ptk_ini_scanner_next(&scanner)) {
+      if (!scanner.name) {
+        if (in_target) {
+          break;
+        }
+        in_target =
+            scanner.section_len == sizeof(target) - 1 && strncmp(scanner.section, target, scanner.section_len) == 0;
+        continue;
+      }
+      if (in_target) {
+        entries++;
+      }
+    }
+    double const elapsed = ptk_bench_now() - start;
+    if (!TEST_CHECK(entries == 1 + bench_params_per_effect)) {
+      goto cleanup;
+    }
+    if (run == 0 || elapsed < best) {
+      best = elapsed;
+    }
+  }
+  printf("scan to %s  %8.3f ms\n", target, best * 1e3);
+
+cleanup:
+  if (alias) {
+    OV_ARRAY_DESTROY(&alias);
+  }
+}
+
+TEST_LIST = {
+    {"bench_ini_reader_load", bench_ini_reader_load},
+    {"bench_ini_scanner_find_section", bench_ini_scanner_find_section},
+    {NULL, NULL},
+};
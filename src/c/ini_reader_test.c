@@ -1,6 +1,8 @@
 #include <ovtest.h>
 
+#include <ovarray.h>
 #include <ovprintf.h>
+#include <ovprintf_ex.h>
 
 #include <string.h>
 
@@ -529,6 +531,180 @@ static void test_iter_entries_n(void) {
   ptk_ini_reader_destroy(&reader);
 }
 
+static void check_name_equals(char const *name, size_t name_len, char const *expected) {
+  if (!expected) {
+    TEST_CHECK(name == NULL);
+    TEST_MSG("want NULL, got '%.*s'", (int)name_len, name);
+    return;
+  }
+  TEST_CHECK(name != NULL && name_len == strlen(expected) && strncmp(name, expected, name_len) == 0);
+  TEST_MSG("want '%s', got '%.*s'", expected, (int)name_len, name ? name : "");
+}
+
+static void test_scanner(void) {
+  static char const data[] = "\xEF\xBB\xBF"
+                             "global_key = global_value\r\n"
+                             "; comment\r\n"
+                             "[ section1 ]\n"
+                             "key1 = value1 ; inline comment\n"
+                             "[malformed\n"
+                             "not an entry\n"
+                             " = no key\n"
+                             "key2=value2\n"
+                             "[]\n"
+                             "empty_key=empty_value";
+  struct ptk_ini_scanner scanner;
+  ptk_ini_scanner_init(&scanner, data, sizeof(data) - 1);
+
+  TEST_ASSERT(ptk_ini_scanner_next(&scanner));
+  TEST_CHECK(scanner.section == NULL);
+  check_name_equals(scanner.name, scanner.name_len, "global_key");
+  check_value_equals(ptk_ini_scanner_get_value(&scanner), "global_value");
+  TEST_CHECK(scanner.line_number == 1);
+
+  TEST_ASSERT(ptk_ini_scanner_next(&scanner));
+  check_name_equals(scanner.section, scanner.section_len, "section1");
+  check_name_equals(scanner.name, scanner.name_len, NULL);
+  check_value_equals(ptk_ini_scanner_get_value(&scanner), NULL);
+  TEST_CHECK(scanner.line_number == 3);
+
+  TEST_ASSERT(ptk_ini_scanner_next(&scanner));
+  check_name_equals(scanner.name, scanner.name_len, "key1");
+  check_value_equals(ptk_ini_scanner_get_value(&scanner), "value1");
+
+  // A copy resumes from the same position
+  struct ptk_ini_scanner resumed = scanner;
+
+  // Malformed lines are skipped and the current section is kept
+  TEST_ASSERT(ptk_ini_scanner_next(&scanner));
+  check_name_equals(scanner.section, scanner.section_len, "section1");
+  check_name_equals(scanner.name, scanner.name_len, "key2");
+  check_value_equals(ptk_ini_scanner_get_value(&scanner), "value2");
+  TEST_CHECK(scanner.line_number == 8);
+  TEST_MSG("want 8, got %zu", scanner.line_number);
+
+  TEST_ASSERT(ptk_ini_scanner_next(&scanner));
+  TEST_CHECK(scanner.section != NULL && scanner.section_len == 0);
+  check_name_equals(scanner.name, scanner.name_len, NULL);
+
+  TEST_ASSERT(ptk_ini_scanner_next(&scanner));
+  check_name_equals(scanner.name, scanner.name_len, "empty_key");
+  check_value_equals(ptk_ini_scanner_get_value(&scanner), "empty_value");
+
+  TEST_CHECK(!ptk_ini_scanner_next(&scanner));
+  TEST_CHECK(!ptk_ini_scanner_next(&scanner));
+
+  TEST_ASSERT(ptk_ini_scanner_next(&resumed));
+  check_name_equals(resumed.name, resumed.name_len, "key2");
+
+  ptk_ini_scanner_init(&scanner, NULL, 0);
+  TEST_CHECK(!ptk_ini_scanner_next(&scanner));
+}
+
+enum {
+  large_objects = 2000,
+  large_effects_per_object = 4,
+  large_params_per_effect = 16,
+};
+
+// Build an object alias similar to an exported scene, a few megabytes in size
+static bool build_large_alias(char **const alias, struct ov_error *const err) {
+  for (size_t i = 0; i < large_objects; i++) {
+    if (!ov_sprintf_append_char(alias,
+                                err,
+                                "%1$zu%2$zu%3$zu",
+                                "[Object.%1$zu]\r\nlayer=%2$zu\r\nframe=%3$zu,%3$zu\r\n",
+                                i,
+                                i % 100,
+                                i * 10)) {
+      OV_ERROR_ADD_TRACE(err);
+      return false;
+    }
+    for (size_t j = 0; j < large_effects_per_object; j++) {
+      if (!ov_sprintf_append_char(alias,
+                                  err,
+                                  "%1$zu%2$zu",
+                                  "[Object.%1$zu.%2$zu]\r\neffect.name=Effect %2$zu@PSDToolKit\r\n",
+                                  i,
+                                  j)) {
+        OV_ERROR_ADD_TRACE(err);
+        return false;
+      }
+      for (size_t k = 0; k < large_params_per_effect; k++) {
+        if (!ov_sprintf_append_char(alias,
+                                    err,
+                                    "%1$zu%2$zu",
+                                    "Parameter %1$zu=C:\\path\\to\\character.psd|%2$zu.0\r\n",
+                                    k,
+                                    i + k)) {
+          OV_ERROR_ADD_TRACE(err);
+          return false;
+        }
+      }
+    }
+  }
+  return true;
+}
+
+static void test_load_large_alias(void) {
+  struct ptk_ini_reader *reader = NULL;
+  struct ov_error err = {0};
+  char *alias = NULL;
+
+  if (!TEST_SUCCEEDED(build_large_alias(&alias, &err), &err)) {
+    goto cleanup;
+  }
+  size_t const alias_len = OV_ARRAY_LENGTH(alias);
+
+  if (!TEST_SUCCEEDED(ptk_ini_reader_create(&reader, &err), &err)) {
+    goto cleanup;
+  }
+  if (!TEST_SUCCEEDED(ptk_ini_reader_load_memory(reader, alias, alias_len, &err), &err)) {
+    goto cleanup;
+  }
+
+  {
+    size_t const want_sections = 1 + large_objects * (1 + large_effects_per_object);
+    size_t const sections = ptk_ini_reader_get_section_count(reader);
+    TEST_CHECK(sections == want_sections);
+    TEST_MSG("want %zu, got %zu", want_sections, sections);
+    TEST_CHECK(ptk_ini_reader_get_entry_count(reader, "Object.1999.3") == 1 + large_params_per_effect);
+    check_value_equals(ptk_ini_reader_get_value(reader, "Object.1999.3", "effect.name"), "Effect 3@PSDToolKit");
+    check_value_equals(ptk_ini_reader_get_value(reader, "Object.1234.0", "Parameter 15"),
+                       "C:\\path\\to\\character.psd|1249.0");
+  }
+
+  // Look up one early section with the scanner, which stops reading at the end of the section
+  {
+    static char const target[] = "Object.10.2";
+    size_t entries = 0;
+    struct ptk_ini_scanner scanner;
+    ptk_ini_scanner_init(&scanner, alias, alias_len);
+    bool in_target = false;
+    while (ptk_ini_scanner_next(&scanner)) {
+      if (!scanner.name) {
+        if (in_target) {
+          break;
+        }
+        in_target =
+            scanner.section_len == sizeof(target) - 1 && strncmp(scanner.section, target, scanner.section_len) == 0;
+        continue;
+      }
+      if (in_target) {
+        entries++;
+      }
+    }
+    TEST_CHECK(entries == 1 + large_params_per_effect);
+    TEST_MSG("want %d, got %zu", 1 + large_params_per_effect, entries);
+  }
+
+cleanup:
+  ptk_ini_reader_destroy(&reader);
+  if (alias) {
+    OV_ARRAY_DESTROY(&alias);
+  }
+}
+
 TEST_LIST = {
     {"create_destroy", test_create_destroy},
     {"key_value_operations", test_key_value_operations},
@@ -542,5 +718,7 @@ TEST_LIST = {
     {"empty_section_iteration", test_empty_section_iteration},
     {"get_value_n", test_get_value_n},
     {"iter_entries_n", test_iter_entries_n},
+    {"scanner", test_scanner},
+    {"load_large_alias", test_load_large_alias},
     {NULL, NULL},
 };
@@ -2,6 +2,7 @@
 
 #include "logf.h"
 #include "ovarray.h"
+#include "ovprintf.h"
 #include "ovthreads.h"
 
 #include <windows.h>
@@ -68,6 +69,10 @@ static bool write_uint32(HANDLE h, uint32_t const v, struct ov_error *const err)
   return write_all(h, &v, sizeof(v), err);
 }
 
+static bool write_uint64(HANDLE h, uint64_t const v, struct ov_error *const err) {
+  return write_all(h, &v, sizeof(v), err);
+}
+
 static bool write_float32(HANDLE h, float const v, struct ov_error *const err) {
   return write_all(h, &v, sizeof(v), err);
 }
@@ -350,6 +355,60 @@ cleanup:
   return result;
 }
 
+static wchar_t const memory_limit_env_name[] = L"PSDTOOLKIT_MEMORY_LIMIT_MIB=";
+
+/**
+ * Build an environment block for the helper process.
+ *
+ * Copies the environment of the current process and sets PSDTOOLKIT_MEMORY_LIMIT_MIB,
+ * which the helper passes to debug.SetMemoryLimit.
+ */
+static bool build_environment(wchar_t **const dest, uint32_t const memory_limit_mib, struct ov_error *const err) {
+  enum { name_len = sizeof(memory_limit_env_name) / sizeof(memory_limit_env_name[0]) - 1 };
+  wchar_t *strings = NULL;
+  wchar_t var[64];
+  bool result = false;
+
+  strings = GetEnvironmentStringsW();
+  if (!strings) {
+    OV_ERROR_SET_HRESULT(err, HRESULT_FROM_WIN32(GetLastError()));
+    goto cleanup;
+  }
+  ov_snprintf_wchar(
+      var, sizeof(var) / sizeof(var[0]), L"%1$ls%2$u", L"%1$ls%2$u", memory_limit_env_name, memory_limit_mib);
+  {
+    size_t const var_len = wcslen(var);
+    size_t len = 0;
+    for (wchar_t const *p = strings; *p; p += wcslen(p) + 1) {
+      len += wcslen(p) + 1;
+    }
+    if (!OV_ARRAY_GROW(dest, len + var_len + 2)) {
+      OV_ERROR_SET_GENERIC(err, ov_error_generic_out_of_memory);
+      goto cleanup;
+    }
+    len = 0;
+    for (wchar_t const *p = strings; *p; p += wcslen(p) + 1) {
+      size_t const n = wcslen(p);
+      if (n >= name_len && CompareStringOrdinal(p, name_len, memory_limit_env_name, name_len, TRUE) == CSTR_EQUAL) {
+        continue;
+      }
+      memcpy(*dest + len, p, (n + 1) * sizeof(wchar_t));
+      len += n + 1;
+    }
+    memcpy(*dest + len, var, (var_len + 1) * sizeof(wchar_t));
+    len += var_len + 1;
+    (*dest)[len++] = L'\0';
+    OV_ARRAY_SET_LENGTH(*dest, len);
+  }
+  result = true;
+
+cleanup:
+  if (strings) {
+    FreeEnvironmentStringsW(strings);
+  }
+  return result;
+}
+
 bool ipc_init(struct ipc **const ipc, struct ipc_options const *const opt, struct ov_error *const err) {
   if (!ipc || !opt || !opt->exe_path) {
     OV_ERROR_SET_GENERIC(err, ov_error_generic_invalid_argument);
@@ -362,6 +421,7 @@ bool ipc_init(struct ipc **const ipc, struct ipc_options const *const opt, struc
   HANDLE h_stdout_r = INVALID_HANDLE_VALUE;
   HANDLE h_stdout_w = INVALID_HANDLE_VALUE;
   wchar_t *cmdline = NULL;
+  wchar_t *environment = NULL;
   bool result = false;
 
   if (!OV_REALLOC(&self, 1, sizeof(struct ipc))) {
@@ -419,7 +479,21 @@ bool ipc_init(struct ipc **const ipc, struct ipc_options const *const opt, struc
     cmdline[exe_path_len + 2] = L'\0';
     OV_ARRAY_SET_LENGTH(cmdline, exe_path_len + 3);
 
-    if (!CreateProcessW(opt->exe_path, cmdline, NULL, NULL, TRUE, CREATE_NO_WINDOW, NULL, opt->working_dir, &si, &pi)) {
+    if (opt->memory_limit_mib && !build_environment(&environment, opt->memory_limit_mib, err)) {
+      OV_ERROR_ADD_TRACE(err);
+      goto cleanup;
+    }
+
+    if (!CreateProcessW(opt->exe_path,
+                        cmdline,
+                        NULL,
+                        NULL,
+                        TRUE,
+                        CREATE_NO_WINDOW | CREATE_UNICODE_ENVIRONMENT,
+                        environment,
+                        opt->working_dir,
+                        &si,
+                        &pi)) {
       HRESULT hr = HRESULT_FROM_WIN32(GetLastError());
       if (hr == HRESULT_FROM_WIN32(ERROR_FILE_NOT_FOUND) || hr == HRESULT_FROM_WIN32(ERROR_PATH_NOT_FOUND)) {
         OV_ERROR_SET(err, ov_error_type_generic, ptk_ipc_error_target_not_found, NULL);
@@ -467,6 +541,9 @@ bool ipc_init(struct ipc **const ipc, struct ipc_options const *const opt, struc
   result = true;
 
 cleanup:
+  if (environment) {
+    OV_ARRAY_DESTROY(&environment);
+  }
   if (cmdline) {
     OV_ARRAY_DESTROY(&cmdline);
   }
@@ -628,14 +705,24 @@ bool ipc_draw(struct ipc *const self,
               void *const p,
               int32_t const width,
               int32_t const height,
+              uint64_t const ckey,
+              bool const allow_delta,
+              struct ipc_draw_result *const draw_result,
               struct ov_error *const err) {
   uint32_t const cmd = FOURCC('D', 'R', 'A', 'W');
   uint32_t reply = 0;
   int32_t len = 0;
+  int32_t num_rects = 0;
+  size_t patch_size = 0;
   bool result = false;
   size_t const required_size = (size_t)width * (size_t)height * 4;
   int32_t shm_resized = 0;
 
+  draw_result->base_ckey = 0;
+  if (draw_result->rects) {
+    OV_ARRAY_SET_LENGTH(draw_result->rects, 0);
+  }
+
   // Ensure shared memory is large enough
   if (self->shm_size < required_size) {
     // Close existing mapping if any
@@ -673,7 +760,8 @@ bool ipc_draw(struct ipc *const self,
   mtx_lock(&self->mtx_stdin);
   if (!write_uint32(self->h_stdin, cmd, err) || !write_int32(self->h_stdin, id, err) ||
       !write_string(self->h_stdin, path_utf8, err) || !write_int32(self->h_stdin, width, err) ||
-      !write_int32(self->h_stdin, height, err) || !write_int32(self->h_stdin, shm_resized, err)) {
+      !write_int32(self->h_stdin, height, err) || !write_int32(self->h_stdin, shm_resized, err) ||
+      !write_uint64(self->h_stdin, ckey, err) || !write_int32(self->h_stdin, allow_delta ? 1 : 0, err)) {
     mtx_unlock(&self->mtx_stdin);
     OV_ERROR_ADD_TRACE(err);
     goto cleanup;
@@ -689,7 +777,40 @@ bool ipc_draw(struct ipc *const self,
     OV_ERROR_ADD_TRACE(err);
     goto cleanup;
   }
-  if (len > width * height * 4) {
+  if (len < 0 || (size_t)len > required_size) {
+    OV_ERROR_SET_GENERIC(err, ov_error_generic_fail);
+    goto cleanup;
+  }
+  if (!read_uint64(self->h_stdout, &draw_result->base_ckey, err) || !read_int32(self->h_stdout, &num_rects, err)) {
+    OV_ERROR_ADD_TRACE(err);
+    goto cleanup;
+  }
+  if (num_rects < 0 || (draw_result->base_ckey == 0 && num_rects != 0)) {
+    OV_ERROR_SET_GENERIC(err, ov_error_generic_fail);
+    goto cleanup;
+  }
+  if (num_rects > 0) {
+    if (!OV_ARRAY_GROW(&draw_result->rects, (size_t)num_rects)) {
+      OV_ERROR_SET_GENERIC(err, ov_error_generic_out_of_memory);
+      goto cleanup;
+    }
+  }
+  for (int32_t i = 0; i < num_rects; ++i) {
+    struct ipc_draw_rect r = {0};
+    if (!read_int32(self->h_stdout, &r.x, err) || !read_int32(self->h_stdout, &r.y, err) ||
+        !read_int32(self->h_stdout, &r.width, err) || !read_int32(self->h_stdout, &r.height, err)) {
+      OV_ERROR_ADD_TRACE(err);
+      goto cleanup;
+    }
+    if (r.x < 0 || r.y < 0 || r.width <= 0 || r.height <= 0 || r.x > width - r.width || r.y > height - r.height) {
+      OV_ERROR_SET_GENERIC(err, ov_error_generic_fail);
+      goto cleanup;
+    }
+    draw_result->rects[i] = r;
+    OV_ARRAY_SET_LENGTH(draw_result->rects, (size_t)i + 1);
+    patch_size += (size_t)r.width * (size_t)r.height * 4;
+  }
+  if (draw_result->base_ckey && patch_size != (size_t)len) {
     OV_ERROR_SET_GENERIC(err, ov_error_generic_fail);
     goto cleanup;
   }
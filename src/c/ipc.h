@@ -56,6 +56,7 @@ struct ipc_export_layer_names_params {
 struct ipc_options {
   wchar_t const *exe_path;
   wchar_t const *working_dir;
+  uint32_t memory_limit_mib; // Soft memory limit of the helper process, 0 for no limit
   void *userdata;
   void (*on_update_editing_image_state)(void *const userdata,
                                         struct ipc_update_editing_image_state_params *const params);
@@ -72,12 +73,52 @@ NODISCARD bool
 ipc_update_current_project_path(struct ipc *const ipc, char const *const path_utf8, struct ov_error *const err);
 NODISCARD bool ipc_clear_files(struct ipc *const ipc, struct ov_error *const err);
 NODISCARD bool ipc_deserialize(struct ipc *const ipc, char const *const src_utf8, struct ov_error *const err);
+/**
+ * @brief Rectangle patched by a delta frame, in top-down pixel coordinates
+ */
+struct ipc_draw_rect {
+  int32_t x;
+  int32_t y;
+  int32_t width;
+  int32_t height;
+};
+
+/**
+ * @brief Result of ipc_draw
+ *
+ * If base_ckey is 0, the buffer holds a full frame.
+ * Otherwise the buffer holds the pixels of rects packed row by row (rect after rect),
+ * which must be applied on top of the frame stored with base_ckey.
+ */
+struct ipc_draw_result {
+  uint64_t base_ckey;
+  struct ipc_draw_rect *rects; ///< OV_ARRAY, caller must destroy with OV_ARRAY_DESTROY
+};
+
+/**
+ * @brief Render an image
+ *
+ * @param ipc IPC instance
+ * @param id Object ID
+ * @param path_utf8 PSD file path
+ * @param p Output buffer, at least width * height * 4 bytes
+ * @param width Image width in pixels
+ * @param height Image height in pixels
+ * @param ckey Cache key the frame will be stored with
+ * @param allow_delta Whether the helper may reply with a delta frame
+ * @param draw_result Output: frame kind and patched rectangles
+ * @param err Error details on failure
+ * @return true on success, false on failure
+ */
 NODISCARD bool ipc_draw(struct ipc *const ipc,
                         int32_t const id,
                         char const *const path_utf8,
                         void *const p,
                         int32_t const width,
                         int32_t const height,
+                        uint64_t const ckey,
+                        bool const allow_delta,
+                        struct ipc_draw_result *const draw_result,
                         struct ov_error *const err);
 NODISCARD bool ipc_get_layer_names(struct ipc *const ipc,
                                    int32_t const id,
@@ -0,0 +1,507 @@
+#include "lab.h"
+
+#include <ovarray.h>
+#include <ovhashmap.h>
+#include <ovthreads.h>
+#include <ovutf.h>
+
+#include <ovl/file.h>
+
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+
+#include <string.h>
+
+// Time unit of .lab files: 100 nanoseconds (1e7 per second)
+static double const lab_time_unit = 10000000.0;
+
+// Number of parsed files kept in memory
+enum {
+  max_cached_labs = 16,
+};
+
+// Larger files are not .lab files
+static uint64_t const max_lab_size = 16 * 1024 * 1024;
+
+struct phoneme {
+  char const *name; // key for hashmap, points to names[id]
+  size_t len;
+  uint32_t id;
+};
+
+struct lab {
+  char *path; // UTF-8 path, key for hashmap (OV_ARRAY)
+  size_t path_len;
+  uint64_t source_size;
+  uint64_t source_time;
+  uint64_t last_used;
+  double *starts;     // OV_ARRAY, sorted
+  double *ends;       // OV_ARRAY, same length as starts
+  uint32_t *phonemes; // OV_ARRAY of phoneme ids, same length as starts
+};
+
+struct ptk_lab_cache {
+  mtx_t mtx;
+  struct ov_hashmap *labs;     // path -> lab* (pointer to heap-allocated lab)
+  struct ov_hashmap *phonemes; // name -> phoneme
+  char **names;                // OV_ARRAY of OV_ARRAY strings, index is phoneme id
+  uint64_t tick;
+};
+
+static void get_lab_key(void const *const item, void const **const key, size_t *const key_bytes) {
+  struct lab *const *const lab_ptr = (struct lab *const *)item;
+  *key = (*lab_ptr)->path;
+  *key_bytes = (*lab_ptr)->path_len;
+}
+
+static void get_phoneme_key(void const *const item, void const **const key, size_t *const key_bytes) {
+  struct phoneme const *const p = (struct phoneme const *)item;
+  *key = p->name;
+  *key_bytes = p->len;
+}
+
+static void lab_destroy(struct lab **const lab) {
+  if (!lab || !*lab) {
+    return;
+  }
+  if ((*lab)->path) {
+    OV_ARRAY_DESTROY(&(*lab)->path);
+  }
+  if ((*lab)->starts) {
+    OV_ARRAY_DESTROY(&(*lab)->starts);
+  }
+  if ((*lab)->ends) {
+    OV_ARRAY_DESTROY(&(*lab)->ends);
+  }
+  if ((*lab)->phonemes) {
+    OV_ARRAY_DESTROY(&(*lab)->phonemes);
+  }
+  OV_FREE(lab);
+}
+
+static bool intern_phoneme(struct ptk_lab_cache *const lc,
+                           char const *const name,
+                           size_t const len,
+                           uint32_t *const id,
+                           struct ov_error *const err) {
+  struct phoneme const key = {.name = name, .len = len};
+  struct phoneme const *const found = (struct phoneme const *)OV_HASHMAP_GET(lc->phonemes, &key);
+  if (found) {
+    *id = found->id;
+    return true;
+  }
+
+  char *s = NULL;
+  size_t const n = OV_ARRAY_LENGTH(lc->names);
+  if (!OV_ARRAY_GROW(&s, len + 1)) {
+    OV_ERROR_SET_GENERIC(err, ov_error_generic_out_of_memory);
+    return false;
+  }
+  memcpy(s, name, len);
+  s[len] = '\0';
+  OV_ARRAY_SET_LENGTH(s, len);
+  if (!OV_ARRAY_GROW(&lc->names, n + 1)) {
+    OV_ARRAY_DESTROY(&s);
+    OV_ERROR_SET_GENERIC(err, ov_error_generic_out_of_memory);
+    return false;
+  }
+  lc->names[n] = s;
+  OV_ARRAY_SET_LENGTH(lc->names, n + 1);
+  struct phoneme const item = {.name = s, .len = len, .id = (uint32_t)n};
+  if (!OV_HASHMAP_SET(lc->phonemes, &item)) {
+    // Keep the name in names, it is released with the cache
+    OV_ERROR_SET_GENERIC(err, ov_error_generic_out_of_memory);
+    return false;
+  }
+  *id = (uint32_t)n;
+  return true;
+}
+
+static bool is_space(char const c) { return c == ' ' || c == '\t' || c == '\v' || c == '\f'; }
+
+// Parse a time made of digits and at most one dot
+static bool parse_time(char const **const p, char const *const end, double *const value) {
+  char const *s = *p;
+  double v = 0.0;
+  double scale = 0.0;
+  bool digits = false;
+  for (; s < end; ++s) {
+    if (*s >= '0' && *s <= '9') {
+      if (scale > 0.0) {
+        v += (double)(*s - '0') * scale;
+        scale *= 0.1;
+      } else {
+        v = v * 10.0 + (double)(*s - '0');
+      }
+      digits = true;
+    } else if (*s == '.' && scale == 0.0) {
+      scale = 0.1;
+    } else {
+      break;
+    }
+  }
+  if (!digits) {
+    return false;
+  }
+  *p = s;
+  *value = v;
+  return true;
+}
+
+// Parse "start end phoneme", returns false if the line is not an entry
+static bool parse_line(char const *p,
+                       char const *const end,
+                       double *const start,
+                       double *const stop,
+                       char const **const name,
+                       size_t *const name_len) {
+  while (p < end && is_space(*p)) {
+    ++p;
+  }
+  if (!parse_time(&p, end, start) || p == end || !is_space(*p)) {
+    return false;
+  }
+  while (p < end && is_space(*p)) {
+    ++p;
+  }
+  if (!parse_time(&p, end, stop) || p == end || !is_space(*p)) {
+    return false;
+  }
+  while (p < end && is_space(*p)) {
+    ++p;
+  }
+  char const *e = end;
+  while (e > p && is_space(e[-1])) {
+    --e;
+  }
+  if (e == p) {
+    return false;
+  }
+  *name = p;
+  *name_len = (size_t)(e - p);
+  return true;
+}
+
+static bool parse_lab(struct ptk_lab_cache *const lc,
+                      char const *const content,
+                      size_t const len,
+                      struct lab *const lab,
+                      struct ov_error *const err) {
+  char const *p = content;
+  char const *const end = content + len;
+  size_t n = 0;
+  while (p < end) {
+    char const *eol = memchr(p, '\n', (size_t)(end - p));
+    if (!eol) {
+      eol = end;
+    }
+    char const *line_end = eol;
+    if (line_end > p && line_end[-1] == '\r') {
+      --line_end;
+    }
+    double start = 0.0, stop = 0.0;
+    char const *name = NULL;
+    size_t name_len = 0;
+    if (parse_line(p, line_end, &start, &stop, &name, &name_len)) {
+      uint32_t id = 0;
+      if (!intern_phoneme(lc, name, name_len, &id, err)) {
+        OV_ERROR_ADD_TRACE(err);
+        return false;
+      }
+      if (!OV_ARRAY_GROW(&lab->starts, n + 1) || !OV_ARRAY_GROW(&lab->ends, n + 1) ||
+          !OV_ARRAY_GROW(&lab->phonemes, n + 1)) {
+        OV_ERROR_SET_GENERIC(err, ov_error_generic_out_of_memory);
+        return false;
+      }
+      lab->starts[n] = start / lab_time_unit;
+      lab->ends[n] = stop / lab_time_unit;
+      lab->phonemes[n] = id;
+      ++n;
+      OV_ARRAY_SET_LENGTH(lab->starts, n);
+      OV_ARRAY_SET_LENGTH(lab->ends, n);
+      OV_ARRAY_SET_LENGTH(lab->phonemes, n);
+    }
+    p = eol + 1;
+  }
+  return true;
+}
+
+// Returns the index of the entry where starts[i] <= time < ends[i], or SIZE_MAX
+static size_t find_entry(struct lab const *const lab, double const time) {
+  size_t lo = 0;
+  size_t hi = lab->starts ? OV_ARRAY_LENGTH(lab->starts) : 0;
+  while (lo < hi) {
+    size_t const mid = lo + (hi - lo) / 2;
+    if (time < lab->starts[mid]) {
+      hi = mid;
+    } else if (time >= lab->ends[mid]) {
+      lo = mid + 1;
+    } else {
+      return mid;
+    }
+  }
+  return SIZE_MAX;
+}
+
+static bool read_file(wchar_t const *const path, char **const dest, struct ov_error *const err) {
+  struct ovl_file *file = NULL;
+  bool success = false;
+  {
+    uint64_t file_size = 0;
+    size_t bytes_read = 0;
+    if (!ovl_file_open(path, &file, err)) {
+      OV_ERROR_ADD_TRACE(err);
+      goto cleanup;
+    }
+    if (!ovl_file_size(file, &file_size, err)) {
+      OV_ERROR_ADD_TRACE(err);
+      goto cleanup;
+    }
+    if (file_size > max_lab_size) {
+      OV_ERROR_SET_GENERIC(err, ov_error_generic_fail);
+      goto cleanup;
+    }
+    if (!OV_ARRAY_GROW(dest, (size_t)file_size + 1)) {
+      OV_ERROR_SET_GENERIC(err, ov_error_generic_out_of_memory);
+      goto cleanup;
+    }
+    if (!ovl_file_read(file, *dest, (size_t)file_size, &bytes_read, err)) {
+      OV_ERROR_ADD_TRACE(err);
+      goto cleanup;
+    }
+    (*dest)[bytes_read] = '\0';
+    OV_ARRAY_SET_LENGTH(*dest, bytes_read);
+  }
+  success = true;
+cleanup:
+  if (file) {
+    ovl_file_close(file);
+  }
+  return success;
+}
+
+static void evict_oldest(struct ptk_lab_cache *const lc) {
+  size_t iter = 0;
+  struct lab **lab_ptr = NULL;
+  struct lab *oldest = NULL;
+  while (OV_HASHMAP_ITER(lc->labs, &iter, &lab_ptr)) {
+    if (!oldest || (*lab_ptr)->last_used < oldest->last_used) {
+      oldest = *lab_ptr;
+    }
+  }
+  if (oldest) {
+    OV_HASHMAP_DELETE(lc->labs, &oldest);
+    lab_destroy(&oldest);
+  }
+}
+
+// Returns the parsed file, or NULL in *lab if the file does not exist
+static bool get_lab(struct ptk_lab_cache *const lc,
+                    char const *const path_utf8,
+                    struct lab **const lab,
+                    struct ov_error *const err) {
+  wchar_t *path = NULL;
+  char *content = NULL;
+  struct lab *new_lab = NULL;
+  bool success = false;
+
+  {
+    size_t const path_len = strlen(path_utf8);
+    size_t const wide_len = ov_utf8_to_wchar_len(path_utf8, path_len);
+    if (wide_len == 0) {
+      OV_ERROR_SET_GENERIC(err, ov_error_generic_invalid_argument);
+      goto cleanup;
+    }
+    if (!OV_ARRAY_GROW(&path, wide_len + 1)) {
+      OV_ERROR_SET_GENERIC(err, ov_error_generic_out_of_memory);
+      goto cleanup;
+    }
+    ov_utf8_to_wchar(path_utf8, path_len, path, wide_len + 1, NULL);
+
+    WIN32_FILE_ATTRIBUTE_DATA attr;
+    if (!GetFileAttributesExW(path, GetFileExInfoStandard, &attr)) {
+      *lab = NULL;
+      success = true;
+      goto cleanup;
+    }
+    uint64_t const source_size = ((uint64_t)attr.nFileSizeHigh << 32) | attr.nFileSizeLow;
+    uint64_t const source_time =
+        ((uint64_t)attr.ftLastWriteTime.dwHighDateTime << 32) | attr.ftLastWriteTime.dwLowDateTime;
+
+    struct lab key_lab = {.path = ov_deconster_(path_utf8), .path_len = path_len};
+    struct lab *key_ptr = &key_lab;
+    void const *const found = OV_HASHMAP_GET(lc->labs, &key_ptr);
+    if (found) {
+      struct lab *cached = *(struct lab *const *)found;
+      if (cached->source_size == source_size && cached->source_time == source_time) {
+        cached->last_used = ++lc->tick;
+        *lab = cached;
+        success = true;
+        goto cleanup;
+      }
+      // Modified since it was parsed
+      OV_HASHMAP_DELETE(lc->labs, &cached);
+      lab_destroy(&cached);
+    }
+
+    if (!OV_REALLOC(&new_lab, 1, sizeof(*new_lab))) {
+      OV_ERROR_SET_GENERIC(err, ov_error_generic_out_of_memory);
+      goto cleanup;
+    }
+    *new_lab = (struct lab){
+        .path_len = path_len,
+        .source_size = source_size,
+        .source_time = source_time,
+    };
+    if (!OV_ARRAY_GROW(&new_lab->path, path_len + 1)) {
+      OV_ERROR_SET_GENERIC(err, ov_error_generic_out_of_memory);
+      goto cleanup;
+    }
+    memcpy(new_lab->path, path_utf8, path_len + 1);
+    OV_ARRAY_SET_LENGTH(new_lab->path, path_len);
+
+    if (!read_file(path, &content, err)) {
+      OV_ERROR_ADD_TRACE(err);
+      goto cleanup;
+    }
+    if (!parse_lab(lc, content, OV_ARRAY_LENGTH(content), new_lab, err)) {
+      OV_ERROR_ADD_TRACE(err);
+      goto cleanup;
+    }
+    new_lab->last_used = ++lc->tick;
+
+    if (OV_HASHMAP_COUNT(lc->labs) >= max_cached_labs) {
+      evict_oldest(lc);
+    }
+    if (!OV_HASHMAP_SET(lc->labs, &new_lab)) {
+      OV_ERROR_SET_GENERIC(err, ov_error_generic_out_of_memory);
+      goto cleanup;
+    }
+    *lab = new_lab;
+    new_lab = NULL; // ownership transferred to hashmap
+  }
+
+  success = true;
+
+cleanup:
+  lab_destroy(&new_lab);
+  if (content) {
+    OV_ARRAY_DESTROY(&content);
+  }
+  if (path) {
+    OV_ARRAY_DESTROY(&path);
+  }
+  return success;
+}
+
+struct ptk_lab_cache *ptk_lab_cache_create(struct ov_error *const err) {
+  struct ptk_lab_cache *lc = NULL;
+  bool success = false;
+
+  if (!OV_REALLOC(&lc, 1, sizeof(*lc))) {
+    OV_ERROR_SET_GENERIC(err, ov_error_generic_out_of_memory);
+    goto cleanup;
+  }
+  *lc = (struct ptk_lab_cache){0};
+  mtx_init(&lc->mtx, mtx_plain);
+
+  lc->labs = OV_HASHMAP_CREATE_DYNAMIC(sizeof(struct lab *), max_cached_labs, get_lab_key);
+  if (!lc->labs) {
+    OV_ERROR_SET_GENERIC(err, ov_error_generic_out_of_memory);
+    goto cleanup;
+  }
+  lc->phonemes = OV_HASHMAP_CREATE_DYNAMIC(sizeof(struct phoneme), 64, get_phoneme_key);
+  if (!lc->phonemes) {
+    OV_ERROR_SET_GENERIC(err, ov_error_generic_out_of_memory);
+    goto cleanup;
+  }
+
+  success = true;
+
+cleanup:
+  if (!success) {
+    ptk_lab_cache_destroy(&lc);
+  }
+  return lc;
+}
+
+void ptk_lab_cache_destroy(struct ptk_lab_cache **const lc_ptr) {
+  if (!lc_ptr || !*lc_ptr) {
+    return;
+  }
+  struct ptk_lab_cache *const lc = *lc_ptr;
+  if (lc->labs) {
+    size_t iter = 0;
+    struct lab **lab_ptr = NULL;
+    while (OV_HASHMAP_ITER(lc->labs, &iter, &lab_ptr)) {
+      lab_destroy(lab_ptr);
+    }
+    OV_HASHMAP_DESTROY(&lc->labs);
+  }
+  if (lc->phonemes) {
+    OV_HASHMAP_DESTROY(&lc->phonemes);
+  }
+  if (lc->names) {
+    size_t const n = OV_ARRAY_LENGTH(lc->names);
+    for (size_t i = 0; i < n; ++i) {
+      OV_ARRAY_DESTROY(&lc->names[i]);
+    }
+    OV_ARRAY_DESTROY(&lc->names);
+  }
+  mtx_destroy(&lc->mtx);
+  OV_FREE(lc_ptr);
+}
+
+bool ptk_lab_cache_get_phoneme(struct ptk_lab_cache *const lc,
+                               char const *const path_utf8,
+                               double const time,
+                               struct ptk_lab_phoneme_info *const info,
+                               struct ov_error *const err) {
+  if (!lc || !path_utf8 || !info) {
+    OV_ERROR_SET_GENERIC(err, ov_error_generic_invalid_argument);
+    return false;
+  }
+
+  bool success = false;
+  *info = (struct ptk_lab_phoneme_info){0};
+
+  mtx_lock(&lc->mtx);
+  {
+    struct lab *lab = NULL;
+    if (!get_lab(lc, path_utf8, &lab, err)) {
+      OV_ERROR_ADD_TRACE(err);
+      goto cleanup;
+    }
+    if (!lab) {
+      success = true;
+      goto cleanup;
+    }
+    size_t const index = find_entry(lab, time);
+    if (index == SIZE_MAX) {
+      success = true;
+      goto cleanup;
+    }
+    size_t const n = OV_ARRAY_LENGTH(lab->starts);
+    info->found = true;
+    info->index = index;
+    info->num_entries = n;
+    info->phoneme = lc->names[lab->phonemes[index]];
+    info->start = lab->starts[index];
+    info->end = lab->ends[index];
+    if (index > 0) {
+      info->prev_phoneme = lc->names[lab->phonemes[index - 1]];
+      info->prev_start = lab->starts[index - 1];
+      info->prev_end = lab->ends[index - 1];
+    }
+    if (index + 1 < n) {
+      info->next_phoneme = lc->names[lab->phonemes[index + 1]];
+      info->next_start = lab->starts[index + 1];
+      info->next_end = lab->ends[index + 1];
+    }
+  }
+  success = true;
+
+cleanup:
+  mtx_unlock(&lc->mtx);
+  return success;
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <ovbase.h>
+
+/**
+ * @brief Phoneme lookup result
+ *
+ * Phoneme names are interned by the cache and stay valid until the cache is destroyed.
+ * Times are in seconds.
+ */
+struct ptk_lab_phoneme_info {
+  bool found;         ///< false if the file is not available or time is outside all entries
+  size_t index;       ///< 0-based index of the entry
+  size_t num_entries; ///< Number of entries in the file
+  char const *phoneme;
+  double start;
+  double end;
+  char const *prev_phoneme; ///< Previous entry, NULL if index is 0
+  double prev_start;
+  double prev_end;
+  char const *next_phoneme; ///< Next entry, NULL if index is the last one
+  double next_start;
+  double next_end;
+};
+
+struct ptk_lab_cache;
+
+/**
+ * @brief Create a cache of parsed .lab files
+ *
+ * A .lab file contains one "start end phoneme" entry per line, with times in 100-nanosecond units.
+ * Parsed files are kept as packed arrays and revalidated with the file size and last write time.
+ *
+ * @param err [out] Error information on failure
+ * @return Cache, or NULL on failure
+ */
+NODISCARD struct ptk_lab_cache *ptk_lab_cache_create(struct ov_error *err);
+
+/**
+ * @brief Destroy a cache
+ *
+ * @param lc [in,out] Pointer to cache to destroy, will be set to NULL
+ */
+void ptk_lab_cache_destroy(struct ptk_lab_cache **lc);
+
+/**
+ * @brief Find the phoneme at a time
+ *
+ * Parses the file on first use or when it has been modified, then finds the entry with a binary search.
+ * A missing file is not an error, info->found is set to false instead.
+ *
+ * @param lc Cache
+ * @param path_utf8 Path to the .lab file (UTF-8)
+ * @param time Time in seconds
+ * @param info [out] Lookup result
+ * @param err [out] Error information on failure
+ * @return true on success, false on failure
+ */
+NODISCARD bool ptk_lab_cache_get_phoneme(struct ptk_lab_cache *lc,
+                                         char const *path_utf8,
+                                         double time,
+                                         struct ptk_lab_phoneme_info *info,
+                                         struct ov_error *err);
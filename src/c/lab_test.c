@@ -0,0 +1,128 @@
+// Include lab.c directly to test static functions
+#include "lab.c"
+
+#include <ovtest.h>
+
+#include <math.h>
+
+#ifndef SOURCE_DIR
+#  define SOURCE_DIR .
+#endif
+
+#define STR(x) #x
+#define STRINGIZE(x) STR(x)
+#define TEST_PATH(relative_path) STRINGIZE(SOURCE_DIR) "/test_data/lab/" relative_path
+
+static bool approx_eq(double const a, double const b) { return fabs(a - b) < 1e-9; }
+
+static void test_lab_parse(void) {
+  struct ov_error err = {0};
+  struct ptk_lab_cache *lc = ptk_lab_cache_create(&err);
+  if (!TEST_SUCCEEDED(lc != NULL, &err)) {
+    return;
+  }
+  struct lab lab = {0};
+  static char const content[] = "0 1500000 pau\r\n"
+                                "\r\n"
+                                "  1500000\t2200000   k  \n"
+                                "not an entry\n"
+                                "2200000 3800000.5 o\n"
+                                "3800000 4500000\n"
+                                "4500000 5000000 pau";
+  if (!TEST_SUCCEEDED(parse_lab(lc, content, sizeof(content) - 1, &lab, &err), &err)) {
+    goto cleanup;
+  }
+  if (!TEST_CHECK(OV_ARRAY_LENGTH(lab.starts) == 4)) {
+    TEST_MSG("got %zu", OV_ARRAY_LENGTH(lab.starts));
+    goto cleanup;
+  }
+  TEST_CHECK(approx_eq(lab.starts[0], 0.0));
+  TEST_CHECK(approx_eq(lab.ends[0], 0.15));
+  TEST_CHECK(approx_eq(lab.starts[1], 0.15));
+  TEST_CHECK(approx_eq(lab.ends[1], 0.22));
+  TEST_CHECK(approx_eq(lab.ends[2], 0.38000005));
+  TEST_CHECK(strcmp(lc->names[lab.phonemes[1]], "k") == 0);
+  TEST_CHECK(strcmp(lc->names[lab.phonemes[2]], "o") == 0);
+
+  // Phonemes are interned
+  TEST_CHECK(lab.phonemes[0] == lab.phonemes[3]);
+  TEST_CHECK(OV_ARRAY_LENGTH(lc->names) == 3);
+
+  TEST_CHECK(find_entry(&lab, 0.0) == 0);
+  TEST_CHECK(find_entry(&lab, 0.15) == 1);
+  TEST_CHECK(find_entry(&lab, 0.3) == 2);
+  TEST_CHECK(find_entry(&lab, 0.49) == 3);
+  TEST_CHECK(find_entry(&lab, 0.5) == SIZE_MAX);
+  TEST_CHECK(find_entry(&lab, -0.1) == SIZE_MAX);
+
+cleanup:
+  if (lab.starts) {
+    OV_ARRAY_DESTROY(&lab.starts);
+  }
+  if (lab.ends) {
+    OV_ARRAY_DESTROY(&lab.ends);
+  }
+  if (lab.phonemes) {
+    OV_ARRAY_DESTROY(&lab.phonemes);
+  }
+  ptk_lab_cache_destroy(&lc);
+}
+
+static void test_lab_cache_get_phoneme(void) {
+  struct ov_error err = {0};
+  struct ptk_lab_phoneme_info info = {0};
+  struct ptk_lab_cache *lc = ptk_lab_cache_create(&err);
+  if (!TEST_SUCCEEDED(lc != NULL, &err)) {
+    return;
+  }
+
+  if (!TEST_SUCCEEDED(ptk_lab_cache_get_phoneme(lc, TEST_PATH("konnichiwa.lab"), 0.3, &info, &err), &err)) {
+    goto cleanup;
+  }
+  TEST_CHECK(info.found);
+  TEST_CHECK(info.index == 2);
+  TEST_CHECK(info.num_entries == 11);
+  TEST_CHECK(strcmp(info.phoneme, "o") == 0);
+  TEST_CHECK(approx_eq(info.start, 0.22));
+  TEST_CHECK(approx_eq(info.end, 0.38));
+  TEST_CHECK(info.prev_phoneme && strcmp(info.prev_phoneme, "k") == 0);
+  TEST_CHECK(approx_eq(info.prev_end, 0.22));
+  TEST_CHECK(info.next_phoneme && strcmp(info.next_phoneme, "N") == 0);
+  TEST_CHECK(approx_eq(info.next_start, 0.38));
+
+  // First and last entries have no previous or next entry
+  if (!TEST_SUCCEEDED(ptk_lab_cache_get_phoneme(lc, TEST_PATH("konnichiwa.lab"), 0.0, &info, &err), &err)) {
+    goto cleanup;
+  }
+  TEST_CHECK(info.found && info.index == 0 && info.prev_phoneme == NULL);
+  if (!TEST_SUCCEEDED(ptk_lab_cache_get_phoneme(lc, TEST_PATH("konnichiwa.lab"), 1.29, &info, &err), &err)) {
+    goto cleanup;
+  }
+  TEST_CHECK(info.found && info.index == 10 && info.next_phoneme == NULL);
+  TEST_CHECK(strcmp(info.phoneme, "pau") == 0);
+
+  // The file is parsed once
+  TEST_CHECK(OV_HASHMAP_COUNT(lc->labs) == 1);
+
+  // Outside of all entries
+  if (!TEST_SUCCEEDED(ptk_lab_cache_get_phoneme(lc, TEST_PATH("konnichiwa.lab"), 5.0, &info, &err), &err)) {
+    goto cleanup;
+  }
+  TEST_CHECK(!info.found);
+
+  // A missing file is not an error
+  if (!TEST_SUCCEEDED(ptk_lab_cache_get_phoneme(lc, TEST_PATH("missing.lab"), 0.3, &info, &err), &err)) {
+    goto cleanup;
+  }
+  TEST_CHECK(!info.found);
+  TEST_CHECK(OV_HASHMAP_COUNT(lc->labs) == 1);
+
+cleanup:
+  ptk_lab_cache_destroy(&lc);
+}
+
+TEST_LIST = {
+    {"test_lab_parse", test_lab_parse},
+    {"test_lab_cache_get_phoneme", test_lab_cache_get_phoneme},
+    {NULL, NULL},
+};
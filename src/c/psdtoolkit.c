@@ -25,10 +25,12 @@
 #include "dialog.h"
 #include "error.h"
 #include "ipc.h"
+#include "lab.h"
 #include "layer.h"
 #include "logf.h"
 #include "script_module.h"
 #include "version.h"
+#include "voice_envelope.h"
 
 #include <commctrl.h>
 
@@ -39,6 +41,8 @@ struct psdtoolkit {
   struct ptk_cache *cache;
   struct ipc *ipc;
   struct ptk_script_module *script_module;
+  struct ptk_voice_envelopes *voice_envelopes;
+  struct ptk_lab_cache *lab_cache;
   HWND hwnd_psdtoolkit;
   HWND plugin_window;
   ATOM plugin_window_class;
@@ -149,6 +153,70 @@ static bool sm_get_drop_config(void *const userdata,
   return true;
 }
 
+// Flip rows vertically (top-down to bottom-up for BITMAP)
+static void flip_rows(uint8_t *const p, size_t const stride, int32_t const rows) {
+  for (int32_t y = 0; y < rows / 2; y++) {
+    uint8_t *top = p + (size_t)y * stride;
+    uint8_t *bottom = p + (size_t)(rows - 1 - y) * stride;
+    for (size_t x = 0; x < stride; x++) {
+      uint8_t tmp = top[x];
+      top[x] = bottom[x];
+      bottom[x] = tmp;
+    }
+  }
+}
+
+// Store a delta frame received from ipc_draw.
+// *stored is set to false if the base frame is no longer cached.
+static bool store_delta(struct psdtoolkit *const ptk,
+                        uint64_t const ckey,
+                        int32_t const height,
+                        struct ipc_draw_result const *const dr,
+                        uint8_t *const pixels,
+                        bool *const stored,
+                        struct ov_error *const err) {
+  struct ptk_cache_rect *rects = NULL;
+  size_t const num_rects = OV_ARRAY_LENGTH(dr->rects);
+  bool success = false;
+
+  if (num_rects > 0) {
+    if (!OV_ARRAY_GROW(&rects, num_rects)) {
+      OV_ERROR_SET_GENERIC(err, ov_error_generic_out_of_memory);
+      goto cleanup;
+    }
+  }
+
+  // Convert to bottom-up coordinates to match the full frames stored in the cache
+  {
+    uint8_t *patch = pixels;
+    for (size_t i = 0; i < num_rects; ++i) {
+      struct ipc_draw_rect const *const r = &dr->rects[i];
+      size_t const stride = (size_t)r->width * 4;
+      flip_rows(patch, stride, r->height);
+      patch += stride * (size_t)r->height;
+      rects[i] = (struct ptk_cache_rect){
+          .x = r->x,
+          .y = height - r->y - r->height,
+          .width = r->width,
+          .height = r->height,
+      };
+    }
+  }
+
+  if (!ptk_cache_put_delta(ptk->cache, ckey, dr->base_ckey, rects, num_rects, pixels, stored, err)) {
+    OV_ERROR_ADD_TRACE(err);
+    goto cleanup;
+  }
+
+  success = true;
+
+cleanup:
+  if (rects) {
+    OV_ARRAY_DESTROY(&rects);
+  }
+  return success;
+}
+
 static bool sm_draw(void *const userdata,
                     int const id,
                     char const *const path_utf8,
@@ -163,6 +231,7 @@ static bool sm_draw(void *const userdata,
   }
 
   uint8_t *pixels = NULL;
+  struct ipc_draw_result dr = {0};
   bool success = false;
 
   {
@@ -174,23 +243,36 @@ static bool sm_draw(void *const userdata,
     }
 
     // Call IPC to render
-    if (!ipc_draw(ptk->ipc, id, path_utf8, pixels, width, height, err)) {
+    // The helper replies with a delta frame if only a small area differs from the previous frame of this object.
+    if (!ipc_draw(ptk->ipc, id, path_utf8, pixels, width, height, ckey, true, &dr, err)) {
       OV_ERROR_ADD_TRACE(err);
       goto cleanup;
     }
 
-    // Flip vertically (top-down to bottom-up for BITMAP)
-    size_t const stride = (size_t)width * 4;
-    for (int y = 0; y < height / 2; y++) {
-      uint8_t *top = pixels + (size_t)y * stride;
-      uint8_t *bottom = pixels + (size_t)(height - 1 - y) * stride;
-      for (size_t x = 0; x < stride; x++) {
-        uint8_t tmp = top[x];
-        top[x] = bottom[x];
-        bottom[x] = tmp;
+    if (dr.base_ckey) {
+      bool stored = false;
+      if (!store_delta(ptk, ckey, height, &dr, pixels, &stored, err)) {
+        OV_ERROR_ADD_TRACE(err);
+        goto cleanup;
+      }
+      if (stored) {
+        success = true;
+        goto cleanup;
+      }
+      // The base frame has been evicted, request the full frame.
+      // The helper has just cached it, so this does not render again.
+      if (!ipc_draw(ptk->ipc, id, path_utf8, pixels, width, height, ckey, false, &dr, err)) {
+        OV_ERROR_ADD_TRACE(err);
+        goto cleanup;
+      }
+      if (dr.base_ckey) {
+        OV_ERROR_SET_GENERIC(err, ov_error_generic_unexpected);
+        goto cleanup;
       }
     }
 
+    flip_rows(pixels, (size_t)width * 4, height);
+
     // Store in cache
     if (!ptk_cache_put(ptk->cache, ckey, pixels, width, height, err)) {
       OV_ERROR_ADD_TRACE(err);
@@ -201,12 +283,60 @@ static bool sm_draw(void *const userdata,
   success = true;
 
 cleanup:
+  if (dr.rects) {
+    OV_ARRAY_DESTROY(&dr.rects);
+  }
   if (pixels) {
     OV_FREE(&pixels);
   }
   return success;
 }
 
+static bool sm_get_voice_level(void *const userdata,
+                               struct ptk_script_module_voice_level_params const *const params,
+                               double *const level,
+                               bool *const ready,
+                               struct ov_error *const err) {
+  struct psdtoolkit *const ptk = (struct psdtoolkit *)userdata;
+  if (!ptk || !ptk->voice_envelopes || !params || !level || !ready) {
+    OV_ERROR_SET_GENERIC(err, ov_error_generic_invalid_argument);
+    return false;
+  }
+  struct ptk_voice_envelope const *env = NULL;
+  if (!ptk_voice_envelopes_get(ptk->voice_envelopes, params->path_utf8, &env, err)) {
+    OV_ERROR_ADD_TRACE(err);
+    return false;
+  }
+  *ready = env != NULL;
+  *level = env ? ptk_voice_envelope_level(env,
+                                          params->time,
+                                          params->frames,
+                                          params->interval,
+                                          params->locut,
+                                          params->hicut,
+                                          params->mode)
+               : 0.0;
+  ptk_voice_envelopes_release(ptk->voice_envelopes, env);
+  return true;
+}
+
+static bool sm_get_phoneme(void *const userdata,
+                           char const *const path_utf8,
+                           double const time,
+                           struct ptk_lab_phoneme_info *const info,
+                           struct ov_error *const err) {
+  struct psdtoolkit *const ptk = (struct psdtoolkit *)userdata;
+  if (!ptk || !ptk->lab_cache) {
+    OV_ERROR_SET_GENERIC(err, ov_error_generic_invalid_argument);
+    return false;
+  }
+  if (!ptk_lab_cache_get_phoneme(ptk->lab_cache, path_utf8, time, info, err)) {
+    OV_ERROR_ADD_TRACE(err);
+    return false;
+  }
+  return true;
+}
+
 struct ptk_script_module *psdtoolkit_get_script_module(struct psdtoolkit *const ptk) {
   return ptk ? ptk->script_module : NULL;
 }
@@ -1024,8 +1154,13 @@ cleanup:
 static bool initialize_ipc(HINSTANCE const hinst, struct psdtoolkit *const ptk, struct ov_error *const err) {
   wchar_t *exe_path = NULL;
   wchar_t *working_dir = NULL;
+  int memory_limit_mib = 0;
   bool result = false;
 
+  if (!ptk_config_get_memory_limit_mib(ptk->config, &memory_limit_mib, err)) {
+    OV_ERROR_ADD_TRACE(err);
+    goto cleanup;
+  }
   if (!ovl_path_get_module_name(&exe_path, hinst, err)) {
     OV_ERROR_ADD_TRACE(err);
     goto cleanup;
@@ -1071,6 +1206,7 @@ static bool initialize_ipc(HINSTANCE const hinst, struct psdtoolkit *const ptk,
                 &(struct ipc_options){
                     .exe_path = exe_path,
                     .working_dir = working_dir,
+                    .memory_limit_mib = memory_limit_mib > 0 ? (uint32_t)memory_limit_mib : 0,
                     .userdata = ptk,
                     .on_update_editing_image_state = ipc_on_update_editing_image_state,
                     .on_export_faview_slider = ipc_on_export_faview_slider,
@@ -1206,6 +1342,18 @@ NODISCARD struct psdtoolkit *psdtoolkit_create(struct ptk_cache *const cache, st
       goto cleanup;
     }
 
+    ptk->voice_envelopes = ptk_voice_envelopes_create(err);
+    if (!ptk->voice_envelopes) {
+      OV_ERROR_ADD_TRACE(err);
+      goto cleanup;
+    }
+
+    ptk->lab_cache = ptk_lab_cache_create(err);
+    if (!ptk->lab_cache) {
+      OV_ERROR_ADD_TRACE(err);
+      goto cleanup;
+    }
+
     ptk->script_module = ptk_script_module_create(
         &(struct ptk_script_module_callbacks){
             .userdata = ptk,
@@ -1214,6 +1362,8 @@ NODISCARD struct psdtoolkit *psdtoolkit_create(struct ptk_cache *const cache, st
             .set_props = sm_set_props,
             .get_drop_config = sm_get_drop_config,
             .draw = sm_draw,
+            .get_voice_level = sm_get_voice_level,
+            .get_phoneme = sm_get_phoneme,
         },
         err);
     if (!ptk->script_module) {
@@ -1249,6 +1399,12 @@ void psdtoolkit_destroy(struct psdtoolkit **const ptk_ptr) {
   if (ptk->script_module) {
     ptk_script_module_destroy(&ptk->script_module);
   }
+  if (ptk->voice_envelopes) {
+    ptk_voice_envelopes_destroy(&ptk->voice_envelopes);
+  }
+  if (ptk->lab_cache) {
+    ptk_lab_cache_destroy(&ptk->lab_cache);
+  }
   if (ptk->ipc) {
     ipc_exit(&ptk->ipc);
   }
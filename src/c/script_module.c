@@ -5,6 +5,8 @@
 #endif
 #include <windows.h>
 
+#include <math.h>
+
 #include <ovarray.h>
 #include <ovmo.h>
 #include <ovrand.h>
@@ -13,7 +15,9 @@
 #include <aviutl2_module2.h>
 
 #include "error.h"
+#include "lab.h"
 #include "logf.h"
+#include "voice_envelope.h"
 
 // Convert uint64 cache key to 16-character hex string
 static void ckey_to_hex(uint64_t ckey, char hex[17]) {
@@ -52,6 +56,10 @@ static bool hex_to_ckey(char const *hex, uint64_t *ckey) {
 struct ptk_script_module {
   struct ptk_script_module_callbacks callbacks;
   struct ov_rand_xoshiro256pp rng;
+
+  float *band;             // Scratch buffer for get_audio_level
+  float *a_weights;        // A-weighting gain per fourier bin, index is the bin number
+  double a_weights_bin_hz; // Bin width a_weights was built for
 };
 
 struct ptk_script_module *ptk_script_module_create(struct ptk_script_module_callbacks const *const callbacks,
@@ -68,7 +76,9 @@ struct ptk_script_module *ptk_script_module_create(struct ptk_script_module_call
     return NULL;
   }
 
-  sm->callbacks = *callbacks;
+  *sm = (struct ptk_script_module){
+      .callbacks = *callbacks,
+  };
   ov_rand_xoshiro256pp_init(&sm->rng, ov_rand_get_global_hint());
   return sm;
 }
@@ -77,6 +87,12 @@ void ptk_script_module_destroy(struct ptk_script_module **const sm) {
   if (!sm || !*sm) {
     return;
   }
+  if ((*sm)->band) {
+    OV_ARRAY_DESTROY(&(*sm)->band);
+  }
+  if ((*sm)->a_weights) {
+    OV_ARRAY_DESTROY(&(*sm)->a_weights);
+  }
   OV_FREE(sm);
 }
 
@@ -590,3 +606,282 @@ void ptk_script_module_detect_encoding(struct ptk_script_module *const sm,
 
   param->push_result_int(encoding_unknown);
 }
+
+// Band level calculation for get_audio_level.
+// Each loop keeps band_lanes independent accumulators so the compiler can turn a block into one SIMD operation
+// without reassociating floating point math.
+enum {
+  band_lanes = 8,
+};
+
+static float band_sum_abs(float const *const v, size_t const n) {
+  float acc[band_lanes] = {0};
+  size_t i = 0;
+  for (; i + band_lanes <= n; i += band_lanes) {
+    for (size_t j = 0; j < band_lanes; ++j) {
+      acc[j] += fabsf(v[i + j]);
+    }
+  }
+  float sum = 0.f;
+  for (size_t j = 0; j < band_lanes; ++j) {
+    sum += acc[j];
+  }
+  for (; i < n; ++i) {
+    sum += fabsf(v[i]);
+  }
+  return sum;
+}
+
+static float band_sum_sq(float const *const v, size_t const n) {
+  float acc[band_lanes] = {0};
+  size_t i = 0;
+  for (; i + band_lanes <= n; i += band_lanes) {
+    for (size_t j = 0; j < band_lanes; ++j) {
+      acc[j] += v[i + j] * v[i + j];
+    }
+  }
+  float sum = 0.f;
+  for (size_t j = 0; j < band_lanes; ++j) {
+    sum += acc[j];
+  }
+  for (; i < n; ++i) {
+    sum += v[i] * v[i];
+  }
+  return sum;
+}
+
+static float band_sum_weighted_sq(float const *const v, float const *const w, size_t const n) {
+  float acc[band_lanes] = {0};
+  size_t i = 0;
+  for (; i + band_lanes <= n; i += band_lanes) {
+    for (size_t j = 0; j < band_lanes; ++j) {
+      float const x = v[i + j] * w[i + j];
+      acc[j] += x * x;
+    }
+  }
+  float sum = 0.f;
+  for (size_t j = 0; j < band_lanes; ++j) {
+    sum += acc[j];
+  }
+  for (; i < n; ++i) {
+    float const x = v[i] * w[i];
+    sum += x * x;
+  }
+  return sum;
+}
+
+static float band_peak(float const *const v, size_t const n) {
+  float acc[band_lanes] = {0};
+  size_t i = 0;
+  for (; i + band_lanes <= n; i += band_lanes) {
+    for (size_t j = 0; j < band_lanes; ++j) {
+      float const x = fabsf(v[i + j]);
+      acc[j] = acc[j] > x ? acc[j] : x;
+    }
+  }
+  float peak = 0.f;
+  for (size_t j = 0; j < band_lanes; ++j) {
+    peak = peak > acc[j] ? peak : acc[j];
+  }
+  for (; i < n; ++i) {
+    float const x = fabsf(v[i]);
+    peak = peak > x ? peak : x;
+  }
+  return peak;
+}
+
+static bool update_a_weights(struct ptk_script_module *const sm,
+                             double const bin_hz,
+                             size_t const num_bins,
+                             struct ov_error *const err) {
+  size_t const len = sm->a_weights ? OV_ARRAY_LENGTH(sm->a_weights) : 0;
+  if (len > num_bins && fabs(sm->a_weights_bin_hz - bin_hz) < 1e-9) {
+    return true;
+  }
+  if (!OV_ARRAY_GROW(&sm->a_weights, num_bins + 1)) {
+    OV_ERROR_SET_GENERIC(err, ov_error_generic_out_of_memory);
+    return false;
+  }
+  for (size_t i = 0; i <= num_bins; ++i) {
+    sm->a_weights[i] = (float)ptk_a_weighting((double)i * bin_hz);
+  }
+  OV_ARRAY_SET_LENGTH(sm->a_weights, num_bins + 1);
+  sm->a_weights_bin_hz = bin_hz;
+  return true;
+}
+
+void ptk_script_module_get_audio_level(struct ptk_script_module *const sm,
+                                       struct aviutl2_script_module_param *const param) {
+  struct ov_error err = {0};
+  double level = 0.0;
+  bool success = false;
+
+  if (!sm || !param) {
+    OV_ERROR_SET_GENERIC(&err, ov_error_generic_invalid_argument);
+    goto cleanup;
+  }
+
+  {
+    int const num_bins = param->get_param_array_num(0);
+    double const sample_rate = param->get_param_double(1);
+    double const locut = param->get_param_double(2);
+    double const hicut = param->get_param_double(3);
+    int const mode = param->get_param_int(4);
+
+    if (mode < ptk_audio_level_mode_mean || mode > ptk_audio_level_mode_a_weighted) {
+      OV_ERROR_SET_GENERIC(&err, ov_error_generic_invalid_argument);
+      goto cleanup;
+    }
+    if (num_bins <= 0 || !(sample_rate > 0.0)) {
+      // No audio
+      success = true;
+      goto cleanup;
+    }
+
+    // The buffer holds the first half of a (num_bins * 2)-point FFT.
+    // Bin numbers are 1-based to match the Lua buffer, bin 0 (DC) is never included.
+    double const bin_hz = sample_rate / (2.0 * (double)num_bins);
+    double const lo_d = floor(locut / bin_hz);
+    double const hi_d = ceil(hicut / bin_hz);
+    int const lo = lo_d < 1.0 ? 1 : lo_d > (double)num_bins ? num_bins + 1 : (int)lo_d;
+    int const hi = hi_d > (double)num_bins ? num_bins : hi_d < 0.0 ? 0 : (int)hi_d;
+    if (lo > hi) {
+      success = true;
+      goto cleanup;
+    }
+
+    // Only the bins in the band are read from the script
+    size_t const n = (size_t)(hi - lo + 1);
+    if (!OV_ARRAY_GROW(&sm->band, n)) {
+      OV_ERROR_SET_GENERIC(&err, ov_error_generic_out_of_memory);
+      goto cleanup;
+    }
+    for (size_t i = 0; i < n; ++i) {
+      sm->band[i] = (float)param->get_param_array_double(0, lo - 1 + (int)i);
+    }
+
+    switch (mode) {
+    case ptk_audio_level_mode_mean:
+      level = (double)band_sum_abs(sm->band, n) / (double)n;
+      break;
+    case ptk_audio_level_mode_rms:
+      level = sqrt((double)band_sum_sq(sm->band, n) / (double)n);
+      break;
+    case ptk_audio_level_mode_peak:
+      level = (double)band_peak(sm->band, n);
+      break;
+    case ptk_audio_level_mode_a_weighted:
+      if (!update_a_weights(sm, bin_hz, (size_t)num_bins, &err)) {
+        OV_ERROR_ADD_TRACE(&err);
+        goto cleanup;
+      }
+      level = sqrt((double)band_sum_weighted_sq(sm->band, sm->a_weights + lo, n) / (double)n);
+      break;
+    }
+  }
+
+  success = true;
+
+cleanup:
+  if (param) {
+    param->push_result_double(level);
+  }
+  if (!success) {
+    ptk_logf_error(&err, "%1$hs", "%1$hs", gettext("failed to get audio level."));
+    OV_ERROR_DESTROY(&err);
+  }
+}
+
+void ptk_script_module_get_voice_level(struct ptk_script_module *const sm,
+                                       struct aviutl2_script_module_param *const param) {
+  struct ov_error err = {0};
+  double level = 0.0;
+  bool ready = false;
+  bool success = false;
+
+  if (!sm->callbacks.get_voice_level) {
+    OV_ERROR_SET_GENERIC(&err, ov_error_generic_not_implemented_yet);
+    goto cleanup;
+  }
+
+  {
+    struct ptk_script_module_voice_level_params const params = {
+        .path_utf8 = param->get_param_string(0),
+        .time = param->get_param_double(1),
+        .locut = param->get_param_double(2),
+        .hicut = param->get_param_double(3),
+        .mode = param->get_param_int(4),
+        .frames = param->get_param_int(5),
+        .interval = param->get_param_double(6),
+    };
+    if (!params.path_utf8 || params.path_utf8[0] == '\0' || params.mode < ptk_audio_level_mode_mean ||
+        params.mode > ptk_audio_level_mode_a_weighted) {
+      OV_ERROR_SET_GENERIC(&err, ov_error_generic_invalid_argument);
+      goto cleanup;
+    }
+    if (!sm->callbacks.get_voice_level(sm->callbacks.userdata, &params, &level, &ready, &err)) {
+      OV_ERROR_ADD_TRACE(&err);
+      goto cleanup;
+    }
+  }
+
+  success = true;
+
+cleanup:
+  if (ready) {
+    param->push_result_double(level);
+  } else {
+    param->push_result_string(NULL);
+  }
+  if (!success) {
+    ptk_logf_error(&err, "%1$hs", "%1$hs", gettext("failed to get voice level."));
+    OV_ERROR_DESTROY(&err);
+  }
+}
+
+void ptk_script_module_get_phoneme(struct ptk_script_module *const sm,
+                                   struct aviutl2_script_module_param *const param) {
+  struct ov_error err = {0};
+  struct ptk_lab_phoneme_info info = {0};
+  bool success = false;
+
+  if (!sm->callbacks.get_phoneme) {
+    OV_ERROR_SET_GENERIC(&err, ov_error_generic_not_implemented_yet);
+    goto cleanup;
+  }
+
+  {
+    char const *const path_utf8 = param->get_param_string(0);
+    if (!path_utf8 || path_utf8[0] == '\0') {
+      OV_ERROR_SET_GENERIC(&err, ov_error_generic_invalid_argument);
+      goto cleanup;
+    }
+    if (!sm->callbacks.get_phoneme(sm->callbacks.userdata, path_utf8, param->get_param_double(1), &info, &err)) {
+      OV_ERROR_ADD_TRACE(&err);
+      goto cleanup;
+    }
+  }
+
+  success = true;
+
+cleanup:
+  if (success && info.found) {
+    param->push_result_int((int)info.index + 1);
+    param->push_result_int((int)info.num_entries);
+    param->push_result_string(info.phoneme);
+    param->push_result_double(info.start);
+    param->push_result_double(info.end);
+    param->push_result_string(info.prev_phoneme);
+    param->push_result_double(info.prev_start);
+    param->push_result_double(info.prev_end);
+    param->push_result_string(info.next_phoneme);
+    param->push_result_double(info.next_start);
+    param->push_result_double(info.next_end);
+  } else {
+    param->push_result_string(NULL);
+  }
+  if (!success) {
+    ptk_logf_error(&err, "%1$hs", "%1$hs", gettext("failed to get phoneme."));
+    OV_ERROR_DESTROY(&err);
+  }
+}
@@ -4,6 +4,7 @@
 
 struct aviutl2_script_module_param;
 struct ptk_script_module;
+struct ptk_lab_phoneme_info;
 
 /**
  * @brief Input parameters for set_props operation
@@ -46,6 +47,29 @@ struct ptk_script_module_drop_config {
   bool external_object_audio_text;
 };
 
+/**
+ * @brief How get_audio_level combines the fourier bins in the band
+ */
+enum ptk_audio_level_mode {
+  ptk_audio_level_mode_mean = 0,       ///< Mean of absolute amplitudes
+  ptk_audio_level_mode_rms = 1,        ///< Root mean square of amplitudes
+  ptk_audio_level_mode_peak = 2,       ///< Largest absolute amplitude
+  ptk_audio_level_mode_a_weighted = 3, ///< Root mean square of A-weighted amplitudes
+};
+
+/**
+ * @brief Input parameters for get_voice_level operation
+ */
+struct ptk_script_module_voice_level_params {
+  char const *path_utf8; ///< Path to the voice file (UTF-8)
+  double time;           ///< Time in seconds from the start of the voice file
+  double locut;          ///< Low frequency cutoff (Hz)
+  double hicut;          ///< High frequency cutoff (Hz)
+  int mode;              ///< ptk_audio_level_mode value
+  int frames;            ///< Number of video frames to average
+  double interval;       ///< Duration of a video frame in seconds
+};
+
 /**
  * @brief Callback function table for script module dependencies
  *
@@ -119,6 +143,39 @@ struct ptk_script_module_callbacks {
                int32_t height,
                uint64_t ckey,
                struct ov_error *err);
+
+  /**
+   * @brief Get the level of a voice file from its precomputed envelope
+   *
+   * The voice file is analysed in the background on first use.
+   *
+   * @param userdata Context pointer
+   * @param params Input parameters
+   * @param level [out] Level, valid only when ready is true
+   * @param ready [out] Receives false while the file is being analysed or cannot be analysed
+   * @param err [out] Error information on failure
+   * @return true on success, false on failure
+   */
+  bool (*get_voice_level)(void *userdata,
+                          struct ptk_script_module_voice_level_params const *params,
+                          double *level,
+                          bool *ready,
+                          struct ov_error *err);
+
+  /**
+   * @brief Find the phoneme at a time in a .lab file
+   * @param userdata Context pointer
+   * @param path_utf8 Path to the .lab file (UTF-8)
+   * @param time Time in seconds
+   * @param info [out] Lookup result, info->found is false if there is no phoneme at the time
+   * @param err [out] Error information on failure
+   * @return true on success, false on failure
+   */
+  bool (*get_phoneme)(void *userdata,
+                      char const *path_utf8,
+                      double time,
+                      struct ptk_lab_phoneme_info *info,
+                      struct ov_error *err);
 };
 
 /**
@@ -267,3 +324,62 @@ void ptk_script_module_read_text_file(struct ptk_script_module *sm, struct aviut
  * @param param Script module parameter interface
  */
 void ptk_script_module_detect_encoding(struct ptk_script_module *sm, struct aviutl2_script_module_param *param);
+
+/**
+ * @brief Script function: Get audio level of a frequency band
+ *
+ * Calculates the level of the fourier data returned by obj.getaudio(..., "fourier")
+ * within the locut-hicut range. The buffer is treated as the first half of a
+ * (array length * 2)-point FFT.
+ *
+ * Parameters from script:
+ *   [0] array: buf - Fourier data
+ *   [1] number: sample_rate - Sample rate of the audio
+ *   [2] number: locut - Low frequency cutoff (Hz)
+ *   [3] number: hicut - High frequency cutoff (Hz)
+ *   [4] int: mode - ptk_audio_level_mode value
+ *
+ * Pushes a number result containing the level, or 0 if the band is empty.
+ *
+ * @param sm Script module instance
+ * @param param Script module parameter interface
+ */
+void ptk_script_module_get_audio_level(struct ptk_script_module *sm, struct aviutl2_script_module_param *param);
+
+/**
+ * @brief Script function: Get audio level of a voice file from its precomputed envelope
+ *
+ * Unlike get_audio_level, the level only depends on the time, so it does not change
+ * with the order in which frames are rendered.
+ *
+ * Parameters from script:
+ *   [0] string: path_utf8 - Path to the voice file
+ *   [1] number: time - Time in seconds from the start of the voice file
+ *   [2] number: locut - Low frequency cutoff (Hz)
+ *   [3] number: hicut - High frequency cutoff (Hz)
+ *   [4] int: mode - ptk_audio_level_mode value
+ *   [5] int: frames - Number of video frames to average
+ *   [6] number: interval - Duration of a video frame in seconds
+ *
+ * Pushes a number result containing the level, or nil if the envelope is not available yet.
+ *
+ * @param sm Script module instance
+ * @param param Script module parameter interface
+ */
+void ptk_script_module_get_voice_level(struct ptk_script_module *sm, struct aviutl2_script_module_param *param);
+
+/**
+ * @brief Script function: Get the phoneme at a time in a .lab file
+ *
+ * Parameters from script:
+ *   [0] string: path_utf8 - Path to the .lab file
+ *   [1] number: time - Time in seconds
+ *
+ * Pushes nil if the file is not available or there is no phoneme at the time. Otherwise pushes
+ * index (int, 1-based), num_entries (int), phoneme (string), start (number), end (number),
+ * then phoneme, start and end of the previous and the next entries (nil, 0, 0 if there is none).
+ *
+ * @param sm Script module instance
+ * @param param Script module parameter interface
+ */
+void ptk_script_module_get_phoneme(struct ptk_script_module *sm, struct aviutl2_script_module_param *param);
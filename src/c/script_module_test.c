@@ -1,4 +1,5 @@
 #include "error.h"
+#include "lab.h"
 #include "logf.h"
 #include "script_module.h"
 
@@ -6,6 +7,7 @@
 
 #include <aviutl2_module2.h>
 
+#include <math.h>
 #include <stdarg.h>
 #include <string.h>
 
@@ -88,6 +90,28 @@ struct mock_context {
   // For get_preferred_languages test
   char const *pushed_array_strings[8];
   int pushed_array_string_count;
+
+  // For get_audio_level test
+  double const *param_array_doubles;
+  int param_array_num;
+  int param_array_reads;
+  double param_doubles[8];
+  double pushed_double;
+  int pushed_double_count;
+
+  // For get_voice_level test
+  bool get_voice_level_called;
+  bool get_voice_level_ready;
+  double get_voice_level_result;
+  struct ptk_script_module_voice_level_params voice_level_received;
+  int pushed_string_count;
+
+  // For get_phoneme test
+  struct ptk_lab_phoneme_info phoneme_result;
+  char const *get_phoneme_received_path;
+  double get_phoneme_received_time;
+  char const *pushed_strings[16];
+  double pushed_doubles[16];
 };
 
 static struct mock_context *g_ctx = NULL;
@@ -105,7 +129,13 @@ static void mock_push_result_int(int value) {
   }
 }
 
-static void mock_push_result_string(char const *value) { g_ctx->pushed_string = value; }
+static void mock_push_result_string(char const *value) {
+  g_ctx->pushed_string = value;
+  if (g_ctx->pushed_string_count < 16) {
+    g_ctx->pushed_strings[g_ctx->pushed_string_count] = value;
+  }
+  ++g_ctx->pushed_string_count;
+}
 
 static void mock_push_result_table_int(char const **keys, int *values, int num) {
   g_ctx->pushed_table_num = num;
@@ -144,6 +174,30 @@ static int mock_get_param_table_int(int index, char const *key) {
   return 0;
 }
 
+static double mock_get_param_double(int index) { return g_ctx->param_doubles[index]; }
+
+static int mock_get_param_array_num(int index) {
+  (void)index;
+  return g_ctx->param_array_num;
+}
+
+static double mock_get_param_array_double(int index, int key) {
+  (void)index;
+  ++g_ctx->param_array_reads;
+  if (key < 0 || key >= g_ctx->param_array_num) {
+    return 0.0;
+  }
+  return g_ctx->param_array_doubles[key];
+}
+
+static void mock_push_result_double(double value) {
+  g_ctx->pushed_double = value;
+  if (g_ctx->pushed_double_count < 16) {
+    g_ctx->pushed_doubles[g_ctx->pushed_double_count] = value;
+  }
+  ++g_ctx->pushed_double_count;
+}
+
 static char const *mock_get_param_table_string(int index, char const *key) {
   (void)index;
   (void)key;
@@ -220,6 +274,30 @@ static bool mock_draw_callback(
   return true;
 }
 
+static bool mock_get_voice_level_callback(void *userdata,
+                                          struct ptk_script_module_voice_level_params const *params,
+                                          double *level,
+                                          bool *ready,
+                                          struct ov_error *err) {
+  (void)userdata;
+  (void)err;
+  g_ctx->get_voice_level_called = true;
+  g_ctx->voice_level_received = *params;
+  *level = g_ctx->get_voice_level_result;
+  *ready = g_ctx->get_voice_level_ready;
+  return true;
+}
+
+static bool mock_get_phoneme_callback(
+    void *userdata, char const *path_utf8, double time, struct ptk_lab_phoneme_info *info, struct ov_error *err) {
+  (void)userdata;
+  (void)err;
+  g_ctx->get_phoneme_received_path = path_utf8;
+  g_ctx->get_phoneme_received_time = time;
+  *info = g_ctx->phoneme_result;
+  return true;
+}
+
 static void test_script_module_get_render_config(void) {
   struct mock_context ctx = {0};
   g_ctx = &ctx;
@@ -830,6 +908,228 @@ static void test_script_module_detect_encoding(void) {
   g_ctx = NULL;
 }
 
+static double get_audio_level(struct ptk_script_module *const sm,
+                              struct aviutl2_script_module_param *const param,
+                              double const locut,
+                              double const hicut,
+                              int const mode) {
+  g_ctx->param_doubles[2] = locut;
+  g_ctx->param_doubles[3] = hicut;
+  g_ctx->param_ints[4] = mode;
+  g_ctx->param_array_reads = 0;
+  g_ctx->pushed_double = -1.0;
+  g_ctx->pushed_double_count = 0;
+  ptk_script_module_get_audio_level(sm, param);
+  return g_ctx->pushed_double;
+}
+
+static bool approx_eq(double const a, double const b) { return fabs(a - b) < 1e-4; }
+
+static void test_script_module_get_audio_level(void) {
+  struct mock_context ctx = {0};
+  g_ctx = &ctx;
+
+  struct ov_error err = {0};
+  struct ptk_script_module_callbacks callbacks = {0};
+  struct ptk_script_module *sm = ptk_script_module_create(&callbacks, &err);
+  if (!TEST_SUCCEEDED(sm != NULL, &err)) {
+    return;
+  }
+
+  struct aviutl2_script_module_param param = {
+      .get_param_int = mock_get_param_int,
+      .get_param_double = mock_get_param_double,
+      .get_param_array_num = mock_get_param_array_num,
+      .get_param_array_double = mock_get_param_array_double,
+      .push_result_double = mock_push_result_double,
+  };
+
+  // 1024 bins at 48000 Hz, 23.4375 Hz per bin
+  static double bins[1024];
+  for (size_t i = 0; i < 1024; ++i) {
+    bins[i] = (i % 2) ? -(double)(i % 7) : (double)(i % 7);
+  }
+  ctx.param_array_doubles = bins;
+  ctx.param_array_num = 1024;
+  ctx.param_doubles[1] = 48000.0;
+
+  // Band 100-1000 Hz covers bins 4..43 (1-based), keys 3..42
+  double sum = 0.0, sum_sq = 0.0, peak = 0.0;
+  for (size_t i = 3; i <= 42; ++i) {
+    double const v = fabs(bins[i]);
+    sum += v;
+    sum_sq += v * v;
+    peak = v > peak ? v : peak;
+  }
+
+  TEST_CHECK(approx_eq(get_audio_level(sm, &param, 100, 1000, ptk_audio_level_mode_mean), sum / 40.0));
+  TEST_MSG("got %f want %f", ctx.pushed_double, sum / 40.0);
+  TEST_CHECK(ctx.pushed_double_count == 1);
+  TEST_CHECK(ctx.param_array_reads == 40);
+
+  TEST_CHECK(approx_eq(get_audio_level(sm, &param, 100, 1000, ptk_audio_level_mode_rms), sqrt(sum_sq / 40.0)));
+  TEST_CHECK(approx_eq(get_audio_level(sm, &param, 100, 1000, ptk_audio_level_mode_peak), peak));
+
+  {
+    // A-weighting attenuates low frequencies, and is close to 1.0 around 1 kHz
+    static double flat[1024];
+    for (size_t i = 0; i < 1024; ++i) {
+      flat[i] = 1.0;
+    }
+    ctx.param_array_doubles = flat;
+    double const low = get_audio_level(sm, &param, 30, 80, ptk_audio_level_mode_a_weighted);
+    double const mid = get_audio_level(sm, &param, 990, 1010, ptk_audio_level_mode_a_weighted);
+    TEST_CHECK(low > 0.0 && low < 0.1);
+    TEST_MSG("low %f", low);
+    TEST_CHECK(mid > 0.95 && mid < 1.05);
+    TEST_MSG("mid %f", mid);
+    ctx.param_array_doubles = bins;
+  }
+
+  // Band outside of the buffer
+  TEST_CHECK(get_audio_level(sm, &param, 30000, 40000, ptk_audio_level_mode_mean) == 0.0);
+  TEST_CHECK(ctx.pushed_double_count == 1);
+  TEST_CHECK(ctx.param_array_reads == 0);
+
+  // Empty buffer
+  ctx.param_array_num = 0;
+  TEST_CHECK(get_audio_level(sm, &param, 100, 1000, ptk_audio_level_mode_mean) == 0.0);
+  ctx.param_array_num = 1024;
+
+  // Unknown mode
+  TEST_CHECK(get_audio_level(sm, &param, 100, 1000, 99) == 0.0);
+  TEST_CHECK(ctx.pushed_double_count == 1);
+
+  ptk_script_module_destroy(&sm);
+  g_ctx = NULL;
+}
+
+static void test_script_module_get_voice_level(void) {
+  struct mock_context ctx = {0};
+  g_ctx = &ctx;
+
+  struct ov_error err = {0};
+  struct ptk_script_module_callbacks callbacks = {.get_voice_level = mock_get_voice_level_callback};
+  struct ptk_script_module *sm = ptk_script_module_create(&callbacks, &err);
+  if (!TEST_SUCCEEDED(sm != NULL, &err)) {
+    return;
+  }
+
+  struct aviutl2_script_module_param param = {
+      .get_param_string = mock_get_param_string,
+      .get_param_int = mock_get_param_int,
+      .get_param_double = mock_get_param_double,
+      .push_result_double = mock_push_result_double,
+      .push_result_string = mock_push_result_string,
+  };
+
+  ctx.param_strings[0] = "C:\\voice.wav";
+  ctx.param_doubles[1] = 1.5;
+  ctx.param_doubles[2] = 100.0;
+  ctx.param_doubles[3] = 1000.0;
+  ctx.param_ints[4] = ptk_audio_level_mode_rms;
+  ctx.param_ints[5] = 3;
+  ctx.param_doubles[6] = 1.0 / 30.0;
+
+  // Ready
+  ctx.get_voice_level_ready = true;
+  ctx.get_voice_level_result = 12.5;
+  ptk_script_module_get_voice_level(sm, &param);
+  TEST_CHECK(ctx.get_voice_level_called);
+  TEST_CHECK(strcmp(ctx.voice_level_received.path_utf8, "C:\\voice.wav") == 0);
+  TEST_CHECK(ctx.voice_level_received.time == 1.5);
+  TEST_CHECK(ctx.voice_level_received.locut == 100.0);
+  TEST_CHECK(ctx.voice_level_received.hicut == 1000.0);
+  TEST_CHECK(ctx.voice_level_received.mode == ptk_audio_level_mode_rms);
+  TEST_CHECK(ctx.voice_level_received.frames == 3);
+  TEST_CHECK(approx_eq(ctx.voice_level_received.interval, 1.0 / 30.0));
+  TEST_CHECK(ctx.pushed_double_count == 1);
+  TEST_CHECK(ctx.pushed_double == 12.5);
+  TEST_CHECK(ctx.pushed_string_count == 0);
+
+  // Not analysed yet, pushes nil
+  ctx.get_voice_level_ready = false;
+  ctx.pushed_double_count = 0;
+  ptk_script_module_get_voice_level(sm, &param);
+  TEST_CHECK(ctx.pushed_double_count == 0);
+  TEST_CHECK(ctx.pushed_string_count == 1);
+  TEST_CHECK(ctx.pushed_string == NULL);
+
+  // Invalid arguments do not reach the callback
+  ctx.get_voice_level_called = false;
+  ctx.pushed_string_count = 0;
+  ctx.param_ints[4] = 99;
+  ptk_script_module_get_voice_level(sm, &param);
+  TEST_CHECK(!ctx.get_voice_level_called);
+  TEST_CHECK(ctx.pushed_string_count == 1);
+
+  ptk_script_module_destroy(&sm);
+  g_ctx = NULL;
+}
+
+static void test_script_module_get_phoneme(void) {
+  struct mock_context ctx = {0};
+  g_ctx = &ctx;
+
+  struct ov_error err = {0};
+  struct ptk_script_module_callbacks callbacks = {.get_phoneme = mock_get_phoneme_callback};
+  struct ptk_script_module *sm = ptk_script_module_create(&callbacks, &err);
+  if (!TEST_SUCCEEDED(sm != NULL, &err)) {
+    return;
+  }
+
+  struct aviutl2_script_module_param param = {
+      .get_param_string = mock_get_param_string,
+      .get_param_double = mock_get_param_double,
+      .push_result_int = mock_push_result_int,
+      .push_result_double = mock_push_result_double,
+      .push_result_string = mock_push_result_string,
+  };
+
+  ctx.param_strings[0] = "C:\\voice.lab";
+  ctx.param_doubles[1] = 0.3;
+  ctx.phoneme_result = (struct ptk_lab_phoneme_info){
+      .found = true,
+      .index = 2,
+      .num_entries = 11,
+      .phoneme = "o",
+      .start = 0.22,
+      .end = 0.38,
+      .prev_phoneme = "k",
+      .prev_start = 0.15,
+      .prev_end = 0.22,
+      .next_phoneme = NULL,
+  };
+  ptk_script_module_get_phoneme(sm, &param);
+  TEST_CHECK(strcmp(ctx.get_phoneme_received_path, "C:\\voice.lab") == 0);
+  TEST_CHECK(ctx.get_phoneme_received_time == 0.3);
+  TEST_CHECK(ctx.pushed_int_count == 2);
+  TEST_CHECK(ctx.pushed_int_values[0] == 3); // 1-based
+  TEST_CHECK(ctx.pushed_int_values[1] == 11);
+  TEST_CHECK(ctx.pushed_string_count == 3);
+  TEST_CHECK(strcmp(ctx.pushed_strings[0], "o") == 0);
+  TEST_CHECK(strcmp(ctx.pushed_strings[1], "k") == 0);
+  TEST_CHECK(ctx.pushed_strings[2] == NULL);
+  TEST_CHECK(ctx.pushed_double_count == 6);
+  TEST_CHECK(ctx.pushed_doubles[0] == 0.22);
+  TEST_CHECK(ctx.pushed_doubles[1] == 0.38);
+  TEST_CHECK(ctx.pushed_doubles[3] == 0.22);
+
+  // Not found pushes a single nil
+  ctx.phoneme_result = (struct ptk_lab_phoneme_info){0};
+  ctx.pushed_int_count = 0;
+  ctx.pushed_string_count = 0;
+  ctx.pushed_double_count = 0;
+  ptk_script_module_get_phoneme(sm, &param);
+  TEST_CHECK(ctx.pushed_int_count == 0);
+  TEST_CHECK(ctx.pushed_double_count == 0);
+  TEST_CHECK(ctx.pushed_string_count == 1);
+  TEST_CHECK(ctx.pushed_strings[0] == NULL);
+
+  ptk_script_module_destroy(&sm);
+  g_ctx = NULL;
+}
+
 TEST_LIST = {
     {"test_script_module_get_render_config", test_script_module_get_render_config},
     {"test_script_module_generate_tag", test_script_module_generate_tag},
@@ -840,5 +1140,8 @@ TEST_LIST = {
     {"test_script_module_read_text_file", test_script_module_read_text_file},
     {"test_script_module_get_preferred_languages", test_script_module_get_preferred_languages},
     {"test_script_module_detect_encoding", test_script_module_detect_encoding},
+    {"test_script_module_get_audio_level", test_script_module_get_audio_level},
+    {"test_script_module_get_voice_level", test_script_module_get_voice_level},
+    {"test_script_module_get_phoneme", test_script_module_get_phoneme},
     {NULL, NULL},
 };
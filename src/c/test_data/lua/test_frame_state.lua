@@ -0,0 +1,136 @@
+--- Test for FrameState.lua frame tracking
+
+local test_dir = arg[0]:match("(.*[/\\])") or "./"
+package.path = test_dir .. "?.lua;" .. package.path
+
+local T = require("testlib")
+local TEST = T.TEST
+local TEST_CHECK = T.TEST_CHECK
+local TEST_MSG = T.TEST_MSG
+
+-- Get the source path from environment variable
+local source_dir = os.getenv("LUA_SOURCE_DIR")
+if not source_dir then
+	error("LUA_SOURCE_DIR environment variable not set")
+end
+
+package.path = source_dir .. "/PSDToolKit.lua/?.lua;" .. package.path
+
+local FrameState = require("FrameState")
+
+local function array_to_string(arr)
+	local parts = {}
+	for i, v in ipairs(arr) do
+		parts[i] = tostring(v)
+	end
+	return "{" .. table.concat(parts, ", ") .. "}"
+end
+
+local function array_eq(a, b)
+	if #a ~= #b then
+		return false
+	end
+	for i = 1, #a do
+		if a[i] ~= b[i] then
+			return false
+		end
+	end
+	return true
+end
+
+--- Previous implementation that scans and sorts an array, used as a reference
+local function new_reference(max_frames)
+	local recent_frames = {}
+	local access_counter = 0
+	return {
+		track = function(frame_number)
+			access_counter = access_counter + 1
+			for _, entry in ipairs(recent_frames) do
+				if entry.frame == frame_number then
+					entry.access_order = access_counter
+					return
+				end
+			end
+			table.insert(recent_frames, { frame = frame_number, access_order = access_counter })
+		end,
+		cleanup = function()
+			if #recent_frames <= max_frames then
+				return {}
+			end
+			table.sort(recent_frames, function(a, b)
+				return a.access_order < b.access_order
+			end)
+			local to_cleanup = {}
+			local remove_count = #recent_frames - max_frames
+			for i = 1, remove_count do
+				table.insert(to_cleanup, recent_frames[i].frame)
+			end
+			for _ = 1, remove_count do
+				table.remove(recent_frames, 1)
+			end
+			return to_cleanup
+		end,
+	}
+end
+
+TEST("frame_state_keeps_recent_frames", function()
+	FrameState.clear_all_frames()
+	for frame = 1, 4 do
+		FrameState.track_frame_access(frame)
+	end
+	TEST_CHECK(#FrameState.get_frames_to_cleanup() == 0)
+
+	-- Re-accessing frame 1 makes frame 2 the oldest
+	FrameState.track_frame_access(1)
+	FrameState.track_frame_access(5)
+	FrameState.track_frame_access(6)
+	local got = FrameState.get_frames_to_cleanup()
+	TEST_CHECK(array_eq(got, { 2, 3 }))
+	TEST_MSG("got %s", array_to_string(got))
+
+	-- Cleaned up frames are no longer tracked
+	TEST_CHECK(#FrameState.get_frames_to_cleanup() == 0)
+	FrameState.track_frame_access(2)
+	got = FrameState.get_frames_to_cleanup()
+	TEST_CHECK(array_eq(got, { 4 }))
+	TEST_MSG("got %s", array_to_string(got))
+end)
+
+TEST("frame_state_clear_all_frames", function()
+	FrameState.clear_all_frames()
+	for frame = 1, 10 do
+		FrameState.track_frame_access(frame)
+	end
+	FrameState.clear_all_frames()
+	TEST_CHECK(#FrameState.get_frames_to_cleanup() == 0)
+	for frame = 11, 15 do
+		FrameState.track_frame_access(frame)
+	end
+	local got = FrameState.get_frames_to_cleanup()
+	TEST_CHECK(array_eq(got, { 11 }))
+	TEST_MSG("got %s", array_to_string(got))
+end)
+
+TEST("frame_state_matches_reference", function()
+	FrameState.clear_all_frames()
+	local ref = new_reference(4)
+	local seed = 12345
+	for i = 1, 5000 do
+		seed = (seed * 1103515245 + 12345) % 2147483648
+		local frame = seed % 12
+		FrameState.track_frame_access(frame)
+		ref.track(frame)
+		if i % 3 == 0 then
+			local got = FrameState.get_frames_to_cleanup()
+			local want = ref.cleanup()
+			if not TEST_CHECK(array_eq(got, want)) then
+				TEST_MSG("i=%d got %s want %s", i, array_to_string(got), array_to_string(want))
+				return
+			end
+		end
+	end
+end)
+
+-- Run all tests
+T.run_all()
+os.exit(T.exit_code())
@@ -0,0 +1,146 @@
+--- Test for MovingAverage.lua
+
+local test_dir = arg[0]:match("(.*[/\\])") or "./"
+package.path = test_dir .. "?.lua;" .. package.path
+
+local T = require("testlib")
+local TEST = T.TEST
+local TEST_CHECK = T.TEST_CHECK
+local TEST_MSG = T.TEST_MSG
+local BENCH = T.BENCH
+
+-- Get the source path from environment variable
+local source_dir = os.getenv("LUA_SOURCE_DIR")
+if not source_dir then
+	error("LUA_SOURCE_DIR environment variable not set")
+end
+
+package.path = source_dir .. "/PSDToolKit.lua/?.lua;" .. package.path
+
+local MovingAverage = require("MovingAverage")
+
+--- Reference implementation that averages the last size values of history
+local function reference_average(history, size)
+	local first = math.max(1, #history - size + 1)
+	local sum = 0
+	for i = first, #history do
+		sum = sum + history[i]
+	end
+	return sum / (#history - first + 1)
+end
+
+--- Previous LipSync implementation, kept for benchmark comparison
+local function table_moving_average(vols, volume, size)
+	table.insert(vols, volume)
+	while #vols > size do
+		table.remove(vols, 1)
+	end
+	local sum = 0
+	for _, v in ipairs(vols) do
+		sum = sum + v
+	end
+	return sum / #vols
+end
+
+TEST("moving_average_partial_window", function()
+	local ma = MovingAverage.new(4)
+	TEST_CHECK(ma:average() == 0)
+	TEST_CHECK(ma:push(2) == 2)
+	TEST_CHECK(ma:push(4) == 3)
+	TEST_CHECK(ma:push(6) == 4)
+	TEST_CHECK(ma:average() == 4)
+end)
+
+TEST("moving_average_matches_reference", function()
+	for _, size in ipairs({ 1, 2, 3, 7, 100 }) do
+		local ma = MovingAverage.new(size)
+		local history = {}
+		for i = 1, 1000 do
+			local v = (i * 37) % 101
+			history[#history + 1] = v
+			local got = ma:push(v)
+			local want = reference_average(history, size)
+			if not TEST_CHECK(math.abs(got - want) < 1e-9) then
+				TEST_MSG("size=%d i=%d got=%f want=%f", size, i, got, want)
+				return
+			end
+		end
+	end
+end)
+
+TEST("moving_average_reset", function()
+	local ma = MovingAverage.new(3)
+	ma:push(10)
+	ma:push(20)
+	ma:reset()
+	TEST_CHECK(ma:average() == 0)
+	TEST_CHECK(ma:push(5) == 5)
+	TEST_CHECK(ma:push(7) == 6)
+end)
+
+TEST("moving_average_resize", function()
+	local ma = MovingAverage.new(3)
+	ma:push(10)
+	ma:push(20)
+	ma:resize(3)
+	TEST_CHECK(ma:average() == 15)
+	TEST_MSG("resize to the same size should keep values")
+	ma:resize(2)
+	TEST_CHECK(ma.size == 2)
+	TEST_CHECK(ma:average() == 15)
+	TEST_MSG("shrinking should keep the most recent values")
+	TEST_CHECK(ma:push(1) == 10.5)
+	TEST_CHECK(ma:push(3) == 2)
+	TEST_CHECK(ma:push(5) == 4)
+end)
+
+TEST("moving_average_resize_matches_reference", function()
+	local sizes = { 5, 2, 7, 3, 3, 1, 4 }
+	local ma = MovingAverage.new(sizes[1])
+	local history = {}
+	for step = 1, #sizes do
+		local size = sizes[step]
+		ma:resize(size)
+		local want = #history > 0 and reference_average(history, size) or 0
+		if not TEST_CHECK(math.abs(ma:average() - want) < 1e-9) then
+			TEST_MSG("after resize to %d got=%f want=%f", size, ma:average(), want)
+			return
+		end
+		-- Push enough values to move the ring position to a different place each time
+		for i = 1, step * 3 do
+			local v = (#history * 37) % 101
+			history[#history + 1] = v
+			local got = ma:push(v)
+			want = reference_average(history, size)
+			if not TEST_CHECK(math.abs(got - want) < 1e-9) then
+				TEST_MSG("size=%d i=%d got=%f want=%f", size, i, got, want)
+				return
+			end
+		end
+	end
+end)
+
+TEST("moving_average_invalid_size", function()
+	TEST_CHECK(MovingAverage.new(0).size == 1)
+	TEST_CHECK(MovingAverage.new(2.7).size == 2)
+	TEST_CHECK(MovingAverage.new(nil).size == 1)
+end)
+
+TEST("moving_average_benchmark", function()
+	local iterations = 20000
+	for _, size in ipairs({ 10, 100, 1000 }) do
+		local ma = MovingAverage.new(size)
+		local ring = BENCH(string.format("ring buffer size=%d", size), iterations, function(i)
+			ma:push(i % 97)
+		end)
+		local vols = {}
+		local tbl = BENCH(string.format("table.remove size=%d", size), iterations, function(i)
+			table_moving_average(vols, i % 97, size)
+		end)
+		TEST_CHECK(math.abs(ma:average() - reference_average(vols, size)) < 1e-9)
+	end
+end)
+
+-- Run all tests
+T.run_all()
+os.exit(T.exit_code())
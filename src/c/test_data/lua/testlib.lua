@@ -40,6 +40,21 @@ function M.TEST_MSG(msg, ...)
 	end
 end
 
+--- Measure the average time of a function
+-- @param name string: Benchmark name
+-- @param iterations number: Number of calls
+-- @param fn function: Function to measure, receives the iteration number
+-- @return number: Average time per call in seconds
+function M.BENCH(name, iterations, fn)
+	local start = os.clock()
+	for i = 1, iterations do
+		fn(i)
+	end
+	local elapsed = os.clock() - start
+	io.write(string.format("\n  %s: %d iterations, %.3f us/op", name, iterations, elapsed * 1e6 / iterations))
+	return elapsed / iterations
+end
+
 --- Run a single test
 -- @param test table: Test entry {name, fn}
 -- @return boolean: true if test passed
@@ -0,0 +1,976 @@
+#include "voice_envelope.h"
+
+#include <ovarray.h>
+#include <ovhashmap.h>
+#include <ovmo.h>
+#include <ovthreads.h>
+#include <ovutf.h>
+
+#include <ovl/file.h>
+
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+
+#include <math.h>
+#include <stddef.h>
+#include <string.h>
+
+#include "script_module.h"
+
+enum {
+  fft_size = 2048,
+  fft_bins = fft_size / 2,
+  envelope_frame_rate = 100,
+  envelope_bins_per_band = 4,
+  envelope_max_hz = 8000, // Upper limit of the LipSync hicut parameter
+  values_per_band = 3,    // mean, power, peak
+};
+
+// Encoded values are log2(1 + v) in 1/1024 octave steps
+static double const encode_scale = 1024.0;
+
+// Analysed files larger than this are rejected
+static uint64_t const max_wav_size = 512 * 1024 * 1024;
+
+static char const envelope_magic[4] = {'P', 'T', 'K', 'E'};
+static uint32_t const envelope_version = 1;
+
+struct envelope_header {
+  char magic[4];
+  uint32_t version;
+  uint64_t source_size;
+  uint64_t source_time;
+  uint32_t sample_rate;
+  uint32_t frame_rate;
+  uint32_t bins_per_band;
+  uint32_t num_bands;
+  uint32_t num_frames;
+  uint32_t reserved;
+};
+
+static uint16_t encode_value(double const v) {
+  double const e = log2(1.0 + v) * encode_scale + 0.5;
+  return e >= 65535.0 ? 65535 : e <= 0.0 ? 0 : (uint16_t)e;
+}
+
+static double decode_value(uint16_t const v) { return exp2((double)v / encode_scale) - 1.0; }
+
+double ptk_a_weighting(double const freq) {
+  double const f2 = freq * freq;
+  double const c1 = 20.598997 * 20.598997;
+  double const c2 = 107.65265 * 107.65265;
+  double const c3 = 737.86223 * 737.86223;
+  double const c4 = 12194.217 * 12194.217;
+  double const ra = (c4 * f2 * f2) / ((f2 + c1) * sqrt((f2 + c2) * (f2 + c3)) * (f2 + c4));
+  return ra * 1.2589254117941673; // +2.0 dB
+}
+
+// --- WAV parsing ---
+
+enum {
+  wave_format_pcm = 1,
+  wave_format_ieee_float = 3,
+  wave_format_extensible = 0xfffe,
+};
+
+struct wav_format {
+  uint16_t format;
+  uint16_t channels;
+  uint32_t sample_rate;
+  uint16_t block_align;
+  uint16_t bits;
+};
+
+static uint16_t read_u16(uint8_t const *const p) { return (uint16_t)(p[0] | (p[1] << 8)); }
+
+static uint32_t read_u32(uint8_t const *const p) {
+  return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static bool parse_wav(uint8_t const *const wav,
+                      size_t const wav_size,
+                      struct wav_format *const fmt,
+                      uint8_t const **const data,
+                      size_t *const data_size,
+                      struct ov_error *const err) {
+  if (wav_size < 12 || memcmp(wav, "RIFF", 4) != 0 || memcmp(wav + 8, "WAVE", 4) != 0) {
+    OV_ERROR_SET(err, ov_error_type_generic, ov_error_generic_fail, gettext("not a WAV file."));
+    return false;
+  }
+  bool has_fmt = false;
+  size_t pos = 12;
+  while (pos + 8 <= wav_size) {
+    uint8_t const *const chunk = wav + pos;
+    size_t const avail = wav_size - pos - 8;
+    size_t size = read_u32(chunk + 4);
+    if (memcmp(chunk, "fmt ", 4) == 0) {
+      if (size < 16 || size > avail) {
+        break;
+      }
+      *fmt = (struct wav_format){
+          .format = read_u16(chunk + 8),
+          .channels = read_u16(chunk + 10),
+          .sample_rate = read_u32(chunk + 12),
+          .block_align = read_u16(chunk + 20),
+          .bits = read_u16(chunk + 22),
+      };
+      if (fmt->format == wave_format_extensible && size >= 40) {
+        // The first two bytes of SubFormat GUID are the format tag
+        fmt->format = read_u16(chunk + 32);
+      }
+      has_fmt = true;
+    } else if (memcmp(chunk, "data", 4) == 0) {
+      if (!has_fmt) {
+        break;
+      }
+      // Streaming writers may leave the size unset, use the rest of the file
+      if (size > avail) {
+        size = avail;
+      }
+      bool const supported = fmt->channels > 0 && fmt->sample_rate > 0 &&
+                             fmt->block_align >= fmt->channels * (fmt->bits / 8) && fmt->bits % 8 == 0 &&
+                             ((fmt->format == wave_format_pcm && fmt->bits >= 8 && fmt->bits <= 32) ||
+                              (fmt->format == wave_format_ieee_float && (fmt->bits == 32 || fmt->bits == 64)));
+      if (!supported) {
+        OV_ERROR_SET(err, ov_error_type_generic, ov_error_generic_fail, gettext("unsupported WAV format."));
+        return false;
+      }
+      *data = chunk + 8;
+      *data_size = size;
+      return true;
+    }
+    if (size > avail) {
+      break;
+    }
+    pos += 8 + size + (size & 1);
+  }
+  OV_ERROR_SET(err, ov_error_type_generic, ov_error_generic_fail, gettext("broken WAV file."));
+  return false;
+}
+
+// Read one sample as [-1, 1]
+static double read_sample(uint8_t const *const p, struct wav_format const *const fmt) {
+  if (fmt->format == wave_format_ieee_float) {
+    if (fmt->bits == 32) {
+      float v;
+      memcpy(&v, p, sizeof(v));
+      return (double)v;
+    }
+    double v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+  }
+  switch (fmt->bits) {
+  case 8:
+    return ((double)p[0] - 128.0) / 128.0;
+  case 16:
+    return (double)(int16_t)read_u16(p) / 32768.0;
+  case 24:
+    return (double)((int32_t)(read_u32(p - 1) & 0xffffff00) >> 8) / 8388608.0;
+  case 32:
+    return (double)(int32_t)read_u32(p) / 2147483648.0;
+  }
+  return 0.0;
+}
+
+// --- FFT ---
+
+struct fft {
+  double re[fft_size];
+  double im[fft_size];
+  double cos_table[fft_size / 2];
+  double sin_table[fft_size / 2];
+  double window[fft_size];
+  uint16_t bitrev[fft_size];
+};
+
+static void fft_init(struct fft *const f) {
+  double const pi = 3.14159265358979323846;
+  for (size_t i = 0; i < fft_size / 2; ++i) {
+    double const a = -2.0 * pi * (double)i / (double)fft_size;
+    f->cos_table[i] = cos(a);
+    f->sin_table[i] = sin(a);
+  }
+  for (size_t i = 0; i < fft_size; ++i) {
+    f->window[i] = 0.5 - 0.5 * cos(2.0 * pi * (double)i / (double)fft_size);
+    size_t r = 0;
+    for (size_t bit = 1, rbit = fft_size >> 1; bit < fft_size; bit <<= 1, rbit >>= 1) {
+      if (i & bit) {
+        r |= rbit;
+      }
+    }
+    f->bitrev[i] = (uint16_t)r;
+  }
+}
+
+static void fft_run(struct fft *const f) {
+  for (size_t i = 0; i < fft_size; ++i) {
+    size_t const j = f->bitrev[i];
+    if (i < j) {
+      double const tr = f->re[i];
+      f->re[i] = f->re[j];
+      f->re[j] = tr;
+      double const ti = f->im[i];
+      f->im[i] = f->im[j];
+      f->im[j] = ti;
+    }
+  }
+  for (size_t len = 2; len <= fft_size; len <<= 1) {
+    size_t const half = len / 2;
+    size_t const step = fft_size / len;
+    for (size_t i = 0; i < fft_size; i += len) {
+      for (size_t k = 0; k < half; ++k) {
+        double const wr = f->cos_table[k * step];
+        double const wi = f->sin_table[k * step];
+        double const xr = f->re[i + k + half] * wr - f->im[i + k + half] * wi;
+        double const xi = f->re[i + k + half] * wi + f->im[i + k + half] * wr;
+        f->re[i + k + half] = f->re[i + k] - xr;
+        f->im[i + k + half] = f->im[i + k] - xi;
+        f->re[i + k] += xr;
+        f->im[i + k] += xi;
+      }
+    }
+  }
+}
+
+// --- Envelope ---
+
+bool ptk_voice_envelope_analyze_wav(void const *const wav,
+                                    size_t const wav_size,
+                                    struct ptk_voice_envelope *const env,
+                                    struct ov_error *const err) {
+  if (!wav || !env) {
+    OV_ERROR_SET_GENERIC(err, ov_error_generic_invalid_argument);
+    return false;
+  }
+
+  struct fft *f = NULL;
+  struct ptk_voice_envelope e = {0};
+  bool success = false;
+
+  {
+    struct wav_format fmt = {0};
+    uint8_t const *data = NULL;
+    size_t data_size = 0;
+    if (!parse_wav((uint8_t const *)wav, wav_size, &fmt, &data, &data_size, err)) {
+      OV_ERROR_ADD_TRACE(err);
+      goto cleanup;
+    }
+
+    size_t const num_samples = data_size / fmt.block_align;
+    double const bin_hz = (double)fmt.sample_rate / (double)fft_size;
+    double const max_bin = ceil((double)envelope_max_hz / bin_hz);
+    size_t const num_bins = max_bin < (double)fft_bins ? (size_t)max_bin : fft_bins;
+    e = (struct ptk_voice_envelope){
+        .sample_rate = fmt.sample_rate,
+        .frame_rate = envelope_frame_rate,
+        .bins_per_band = envelope_bins_per_band,
+        .num_bands = (uint32_t)((num_bins + envelope_bins_per_band - 1) / envelope_bins_per_band),
+        .num_frames = (uint32_t)(((uint64_t)num_samples * envelope_frame_rate + fmt.sample_rate - 1) / fmt.sample_rate),
+    };
+
+    size_t const num_values = (size_t)e.num_frames * e.num_bands * values_per_band;
+    if (!OV_ARRAY_GROW(&e.data, num_values > 0 ? num_values : 1)) {
+      OV_ERROR_SET_GENERIC(err, ov_error_generic_out_of_memory);
+      goto cleanup;
+    }
+    OV_ARRAY_SET_LENGTH(e.data, num_values);
+
+    if (!OV_REALLOC(&f, 1, sizeof(*f))) {
+      OV_ERROR_SET_GENERIC(err, ov_error_generic_out_of_memory);
+      goto cleanup;
+    }
+    fft_init(f);
+
+    // Amplitudes are in 16-bit sample units; a full scale sine gives about 32768 in its bin
+    double const scale = 32768.0 * 4.0 / (double)fft_size;
+    double const channel_scale = 1.0 / (double)fmt.channels;
+    size_t const bytes_per_sample = fmt.bits / 8;
+    uint16_t *out = e.data;
+    for (uint32_t frame = 0; frame < e.num_frames; ++frame) {
+      size_t const start = (size_t)((uint64_t)frame * fmt.sample_rate / envelope_frame_rate);
+      for (size_t i = 0; i < fft_size; ++i) {
+        double v = 0.0;
+        if (start + i < num_samples) {
+          uint8_t const *const p = data + (start + i) * fmt.block_align;
+          for (size_t ch = 0; ch < fmt.channels; ++ch) {
+            v += read_sample(p + ch * bytes_per_sample, &fmt);
+          }
+          v *= channel_scale;
+        }
+        f->re[i] = v * f->window[i];
+        f->im[i] = 0.0;
+      }
+      fft_run(f);
+      for (uint32_t band = 0; band < e.num_bands; ++band) {
+        double sum = 0.0, power = 0.0, peak = 0.0;
+        for (uint32_t j = 1; j <= envelope_bins_per_band; ++j) {
+          size_t const bin = band * envelope_bins_per_band + j; // bin numbers are 1-based, bin 0 is DC
+          double const amp = bin <= fft_bins ? hypot(f->re[bin], f->im[bin]) * scale : 0.0;
+          sum += amp;
+          power += amp * amp;
+          peak = amp > peak ? amp : peak;
+        }
+        *out++ = encode_value(sum / envelope_bins_per_band);
+        *out++ = encode_value(power / envelope_bins_per_band);
+        *out++ = encode_value(peak);
+      }
+    }
+  }
+
+  *env = e;
+  e = (struct ptk_voice_envelope){0};
+  success = true;
+
+cleanup:
+  if (f) {
+    OV_FREE(&f);
+  }
+  ptk_voice_envelope_destroy(&e);
+  return success;
+}
+
+void ptk_voice_envelope_destroy(struct ptk_voice_envelope *const env) {
+  if (!env) {
+    return;
+  }
+  if (env->data) {
+    OV_ARRAY_DESTROY(&env->data);
+  }
+  *env = (struct ptk_voice_envelope){0};
+}
+
+bool ptk_voice_envelope_serialize(struct ptk_voice_envelope const *const env,
+                                  uint64_t const source_size,
+                                  uint64_t const source_time,
+                                  uint8_t **const dest,
+                                  struct ov_error *const err) {
+  if (!env || !dest) {
+    OV_ERROR_SET_GENERIC(err, ov_error_generic_invalid_argument);
+    return false;
+  }
+  size_t const data_bytes = (size_t)env->num_frames * env->num_bands * values_per_band * sizeof(uint16_t);
+  size_t const total = sizeof(struct envelope_header) + data_bytes;
+  if (!OV_ARRAY_GROW(dest, total)) {
+    OV_ERROR_SET_GENERIC(err, ov_error_generic_out_of_memory);
+    return false;
+  }
+  struct envelope_header const h = {
+      .magic = {envelope_magic[0], envelope_magic[1], envelope_magic[2], envelope_magic[3]},
+      .version = envelope_version,
+      .source_size = source_size,
+      .source_time = source_time,
+      .sample_rate = env->sample_rate,
+      .frame_rate = env->frame_rate,
+      .bins_per_band = env->bins_per_band,
+      .num_bands = env->num_bands,
+      .num_frames = env->num_frames,
+  };
+  memcpy(*dest, &h, sizeof(h));
+  if (data_bytes) {
+    memcpy(*dest + sizeof(h), env->data, data_bytes);
+  }
+  OV_ARRAY_SET_LENGTH(*dest, total);
+  return true;
+}
+
+bool ptk_voice_envelope_deserialize(void const *const src,
+                                    size_t const src_size,
+                                    uint64_t const source_size,
+                                    uint64_t const source_time,
+                                    struct ptk_voice_envelope *const env,
+                                    struct ov_error *const err) {
+  if (!src || !env) {
+    OV_ERROR_SET_GENERIC(err, ov_error_generic_invalid_argument);
+    return false;
+  }
+  struct envelope_header h;
+  if (src_size < sizeof(h)) {
+    OV_ERROR_SET_GENERIC(err, ov_error_generic_fail);
+    return false;
+  }
+  memcpy(&h, src, sizeof(h));
+  if (memcmp(h.magic, envelope_magic, sizeof(envelope_magic)) != 0 || h.version != envelope_version ||
+      h.source_size != source_size || h.source_time != source_time || h.sample_rate == 0 || h.frame_rate == 0 ||
+      h.bins_per_band == 0) {
+    OV_ERROR_SET_GENERIC(err, ov_error_generic_fail);
+    return false;
+  }
+  size_t const num_values = (size_t)h.num_frames * h.num_bands * values_per_band;
+  if (src_size - sizeof(h) != num_values * sizeof(uint16_t)) {
+    OV_ERROR_SET_GENERIC(err, ov_error_generic_fail);
+    return false;
+  }
+  struct ptk_voice_envelope e = {
+      .sample_rate = h.sample_rate,
+      .frame_rate = h.frame_rate,
+      .bins_per_band = h.bins_per_band,
+      .num_bands = h.num_bands,
+      .num_frames = h.num_frames,
+  };
+  if (!OV_ARRAY_GROW(&e.data, num_values > 0 ? num_values : 1)) {
+    OV_ERROR_SET_GENERIC(err, ov_error_generic_out_of_memory);
+    return false;
+  }
+  if (num_values) {
+    memcpy(e.data, (uint8_t const *)src + sizeof(h), num_values * sizeof(uint16_t));
+  }
+  OV_ARRAY_SET_LENGTH(e.data, num_values);
+  *env = e;
+  return true;
+}
+
+static double envelope_level_at(struct ptk_voice_envelope const *const env,
+                                double const time,
+                                uint32_t const lo_band,
+                                uint32_t const hi_band,
+                                double const bin_hz,
+                                int const mode) {
+  double const pos = floor(time * (double)env->frame_rate + 1e-6);
+  if (pos < 0.0 || pos >= (double)env->num_frames) {
+    return 0.0;
+  }
+  uint16_t const *const values = env->data + (size_t)pos * env->num_bands * values_per_band;
+  double const n = (double)(hi_band - lo_band + 1);
+  double acc = 0.0;
+  for (uint32_t band = lo_band; band <= hi_band; ++band) {
+    uint16_t const *const v = values + band * values_per_band;
+    switch (mode) {
+    case ptk_audio_level_mode_mean:
+      acc += decode_value(v[0]);
+      break;
+    case ptk_audio_level_mode_rms:
+      acc += decode_value(v[1]);
+      break;
+    case ptk_audio_level_mode_peak: {
+      double const peak = decode_value(v[2]);
+      acc = peak > acc ? peak : acc;
+      break;
+    }
+    case ptk_audio_level_mode_a_weighted: {
+      double const center = ((double)band * env->bins_per_band + (env->bins_per_band + 1) * 0.5) * bin_hz;
+      double const w = ptk_a_weighting(center);
+      acc += decode_value(v[1]) * w * w;
+      break;
+    }
+    }
+  }
+  switch (mode) {
+  case ptk_audio_level_mode_mean:
+    return acc / n;
+  case ptk_audio_level_mode_rms:
+  case ptk_audio_level_mode_a_weighted:
+    return sqrt(acc / n);
+  }
+  return acc;
+}
+
+double ptk_voice_envelope_level(struct ptk_voice_envelope const *const env,
+                                double const time,
+                                int const frames,
+                                double const interval,
+                                double const locut,
+                                double const hicut,
+                                int const mode) {
+  if (!env || !env->num_bands || !env->num_frames) {
+    return 0.0;
+  }
+  // Same band as ptk_script_module_get_audio_level, then widened to whole bands
+  double const bin_hz = (double)env->sample_rate / (double)fft_size;
+  double const num_bins = (double)env->num_bands * env->bins_per_band;
+  double const lo_d = floor(locut / bin_hz);
+  double const hi_d = ceil(hicut / bin_hz);
+  double const lo = lo_d < 1.0 ? 1.0 : lo_d;
+  double const hi = hi_d > num_bins ? num_bins : hi_d;
+  if (lo > hi) {
+    return 0.0;
+  }
+  uint32_t const lo_band = (uint32_t)(lo - 1.0) / env->bins_per_band;
+  uint32_t const hi_band = (uint32_t)(hi - 1.0) / env->bins_per_band;
+
+  int const n = frames > 1 ? frames : 1;
+  double sum = 0.0;
+  for (int i = 0; i < n; ++i) {
+    sum += envelope_level_at(env, time - interval * (double)i, lo_band, hi_band, bin_hz, mode);
+  }
+  return sum / (double)n;
+}
+
+// --- Store ---
+
+enum envelope_state {
+  envelope_state_queued,
+  envelope_state_ready,
+  envelope_state_failed,
+};
+
+// Number of analysed files kept in memory
+enum {
+  max_cached_envelopes = 32,
+};
+
+// Minimum interval between checks whether a cached voice file has been modified
+static uint64_t const revalidate_interval_ms = 1000;
+
+struct envelope_entry {
+  char *path; // UTF-8 path, key for hashmap (OV_ARRAY)
+  size_t path_len;
+  wchar_t *wpath; // path for file access (OV_ARRAY)
+  enum envelope_state state;
+  // Size and last write time of the file when it was analysed, used to detect changes
+  uint64_t source_size;
+  uint64_t source_time;
+  uint64_t checked_at; // GetTickCount64() of the last check of the file
+  uint64_t last_used;
+  size_t refs; // one for the hashmap while the entry is in it, one per envelope returned to a caller
+  struct ptk_voice_envelope env;
+  struct envelope_entry *next; // next queued entry
+};
+
+struct ptk_voice_envelopes {
+  mtx_t mtx;
+  cnd_t cnd;
+  thrd_t thread;
+  bool thread_created;
+  bool exit_requested;
+  struct ov_hashmap *entries; // path -> envelope_entry* (pointer to heap-allocated entry)
+  struct envelope_entry *queue_head;
+  struct envelope_entry *queue_tail;
+  uint64_t tick;
+};
+
+static void get_entry_key(void const *const item, void const **const key, size_t *const key_bytes) {
+  struct envelope_entry *const *const entry_ptr = (struct envelope_entry *const *)item;
+  *key = (*entry_ptr)->path;
+  *key_bytes = (*entry_ptr)->path_len;
+}
+
+static void entry_destroy(struct envelope_entry **const entry) {
+  if (!entry || !*entry) {
+    return;
+  }
+  if ((*entry)->path) {
+    OV_ARRAY_DESTROY(&(*entry)->path);
+  }
+  if ((*entry)->wpath) {
+    OV_ARRAY_DESTROY(&(*entry)->wpath);
+  }
+  ptk_voice_envelope_destroy(&(*entry)->env);
+  OV_FREE(entry);
+}
+
+// Drop one reference, must be called with the store locked
+static void entry_release(struct envelope_entry **const entry) {
+  if (--(*entry)->refs == 0) {
+    entry_destroy(entry);
+  }
+  *entry = NULL;
+}
+
+static struct envelope_entry *
+find_entry(struct ptk_voice_envelopes *const ve, char const *const path_utf8, size_t const path_len) {
+  struct envelope_entry key_entry = {.path = ov_deconster_(path_utf8), .path_len = path_len};
+  struct envelope_entry *key_ptr = &key_entry;
+  void const *const found = OV_HASHMAP_GET(ve->entries, &key_ptr);
+  return found ? *(struct envelope_entry *const *)found : NULL;
+}
+
+// Remove an entry from the hashmap, it is freed once no caller uses its envelope
+static void remove_entry(struct ptk_voice_envelopes *const ve, struct envelope_entry *entry) {
+  OV_HASHMAP_DELETE(ve->entries, &entry);
+  entry_release(&entry);
+}
+
+// Remove the least recently used entry, except queued ones the analysis thread may be working on
+static void evict_oldest(struct ptk_voice_envelopes *const ve) {
+  size_t iter = 0;
+  struct envelope_entry **entry_ptr = NULL;
+  struct envelope_entry *oldest = NULL;
+  while (OV_HASHMAP_ITER(ve->entries, &iter, &entry_ptr)) {
+    if ((*entry_ptr)->state != envelope_state_queued && (!oldest || (*entry_ptr)->last_used < oldest->last_used)) {
+      oldest = *entry_ptr;
+    }
+  }
+  if (oldest) {
+    remove_entry(ve, oldest);
+  }
+}
+
+static bool read_file(wchar_t const *const path, uint8_t **const dest, struct ov_error *const err) {
+  struct ovl_file *file = NULL;
+  bool success = false;
+  {
+    uint64_t file_size = 0;
+    size_t bytes_read = 0;
+    if (!ovl_file_open(path, &file, err)) {
+      OV_ERROR_ADD_TRACE(err);
+      goto cleanup;
+    }
+    if (!ovl_file_size(file, &file_size, err)) {
+      OV_ERROR_ADD_TRACE(err);
+      goto cleanup;
+    }
+    if (file_size > max_wav_size) {
+      OV_ERROR_SET_GENERIC(err, ov_error_generic_fail);
+      goto cleanup;
+    }
+    if (!OV_ARRAY_GROW(dest, file_size > 0 ? (size_t)file_size : 1)) {
+      OV_ERROR_SET_GENERIC(err, ov_error_generic_out_of_memory);
+      goto cleanup;
+    }
+    if (!ovl_file_read(file, *dest, (size_t)file_size, &bytes_read, err)) {
+      OV_ERROR_ADD_TRACE(err);
+      goto cleanup;
+    }
+    OV_ARRAY_SET_LENGTH(*dest, bytes_read);
+  }
+  success = true;
+cleanup:
+  if (file) {
+    ovl_file_close(file);
+  }
+  return success;
+}
+
+static bool write_file(wchar_t const *const path,
+                       uint8_t const *const data,
+                       size_t const size,
+                       struct ov_error *const err) {
+  struct ovl_file *file = NULL;
+  bool success = false;
+  {
+    size_t written = 0;
+    if (!ovl_file_create(path, &file, err)) {
+      OV_ERROR_ADD_TRACE(err);
+      goto cleanup;
+    }
+    if (!ovl_file_write(file, data, size, &written, err)) {
+      OV_ERROR_ADD_TRACE(err);
+      goto cleanup;
+    }
+  }
+  success = true;
+cleanup:
+  if (file) {
+    ovl_file_close(file);
+    if (!success) {
+      DeleteFileW(path);
+    }
+  }
+  return success;
+}
+
+static bool get_file_stamp(wchar_t const *const path,
+                           uint64_t *const size,
+                           uint64_t *const time,
+                           struct ov_error *const err) {
+  WIN32_FILE_ATTRIBUTE_DATA attr;
+  if (!GetFileAttributesExW(path, GetFileExInfoStandard, &attr)) {
+    OV_ERROR_SET_HRESULT(err, HRESULT_FROM_WIN32(GetLastError()));
+    return false;
+  }
+  *size = ((uint64_t)attr.nFileSizeHigh << 32) | attr.nFileSizeLow;
+  *time = ((uint64_t)attr.ftLastWriteTime.dwHighDateTime << 32) | attr.ftLastWriteTime.dwLowDateTime;
+  return true;
+}
+
+// Analyse a voice file, or load the result of a previous analysis from the disk cache.
+// *source_size and *source_time receive the state of the file that was analysed, or 0 if it cannot be read.
+static bool load_envelope(wchar_t const *const path,
+                          struct ptk_voice_envelope *const env,
+                          uint64_t *const source_size,
+                          uint64_t *const source_time,
+                          struct ov_error *const err) {
+  static wchar_t const cache_ext[] = L".ptkenv";
+  wchar_t *cache_path = NULL;
+  uint8_t *content = NULL;
+  uint8_t *serialized = NULL;
+  bool success = false;
+
+  *source_size = 0;
+  *source_time = 0;
+  {
+    if (!get_file_stamp(path, source_size, source_time, err)) {
+      OV_ERROR_ADD_TRACE(err);
+      goto cleanup;
+    }
+
+    size_t const path_len = OV_ARRAY_LENGTH(path);
+    size_t const ext_len = sizeof(cache_ext) / sizeof(cache_ext[0]) - 1;
+    if (!OV_ARRAY_GROW(&cache_path, path_len + ext_len + 1)) {
+      OV_ERROR_SET_GENERIC(err, ov_error_generic_out_of_memory);
+      goto cleanup;
+    }
+    memcpy(cache_path, path, path_len * sizeof(wchar_t));
+    wcscpy(cache_path + path_len, cache_ext);
+    if (read_file(cache_path, &content, NULL) &&
+        ptk_voice_envelope_deserialize(content, OV_ARRAY_LENGTH(content), *source_size, *source_time, env, NULL)) {
+      success = true;
+      goto cleanup;
+    }
+
+    if (content) {
+      OV_ARRAY_DESTROY(&content);
+    }
+    if (!read_file(path, &content, err)) {
+      OV_ERROR_ADD_TRACE(err);
+      goto cleanup;
+    }
+    if (!ptk_voice_envelope_analyze_wav(content, OV_ARRAY_LENGTH(content), env, err)) {
+      OV_ERROR_ADD_TRACE(err);
+      goto cleanup;
+    }
+
+    // The disk cache is optional, the voice file may be in a read-only folder
+    if (ptk_voice_envelope_serialize(env, *source_size, *source_time, &serialized, NULL)) {
+      write_file(cache_path, serialized, OV_ARRAY_LENGTH(serialized), NULL);
+    }
+  }
+
+  success = true;
+
+cleanup:
+  if (serialized) {
+    OV_ARRAY_DESTROY(&serialized);
+  }
+  if (content) {
+    OV_ARRAY_DESTROY(&content);
+  }
+  if (cache_path) {
+    OV_ARRAY_DESTROY(&cache_path);
+  }
+  return success;
+}
+
+static int analysis_thread(void *const userdata) {
+  struct ptk_voice_envelopes *const ve = (struct ptk_voice_envelopes *)userdata;
+  mtx_lock(&ve->mtx);
+  for (;;) {
+    while (!ve->exit_requested && !ve->queue_head) {
+      cnd_wait(&ve->cnd, &ve->mtx);
+    }
+    if (ve->exit_requested) {
+      break;
+    }
+    struct envelope_entry *const entry = ve->queue_head;
+    ve->queue_head = entry->next;
+    if (!ve->queue_head) {
+      ve->queue_tail = NULL;
+    }
+    entry->next = NULL;
+    mtx_unlock(&ve->mtx);
+
+    // entry->wpath does not change after the entry is queued, and entry->env is only read once the state is ready
+    struct ov_error err = {0};
+    struct ptk_voice_envelope env = {0};
+    uint64_t source_size = 0;
+    uint64_t source_time = 0;
+    bool const ok = load_envelope(entry->wpath, &env, &source_size, &source_time, &err);
+    OV_ERROR_DESTROY(&err);
+
+    mtx_lock(&ve->mtx);
+    entry->source_size = source_size;
+    entry->source_time = source_time;
+    entry->checked_at = GetTickCount64();
+    if (ok) {
+      entry->env = env;
+      entry->state = envelope_state_ready;
+    } else {
+      entry->state = envelope_state_failed;
+    }
+  }
+  mtx_unlock(&ve->mtx);
+  return 0;
+}
+
+struct ptk_voice_envelopes *ptk_voice_envelopes_create(struct ov_error *const err) {
+  struct ptk_voice_envelopes *ve = NULL;
+  bool success = false;
+
+  if (!OV_REALLOC(&ve, 1, sizeof(*ve))) {
+    OV_ERROR_SET_GENERIC(err, ov_error_generic_out_of_memory);
+    goto cleanup;
+  }
+  *ve = (struct ptk_voice_envelopes){0};
+  mtx_init(&ve->mtx, mtx_plain);
+  cnd_init(&ve->cnd);
+
+  ve->entries = OV_HASHMAP_CREATE_DYNAMIC(sizeof(struct envelope_entry *), 16, get_entry_key);
+  if (!ve->entries) {
+    OV_ERROR_SET_GENERIC(err, ov_error_generic_out_of_memory);
+    goto cleanup;
+  }
+
+  if (thrd_create(&ve->thread, analysis_thread, ve) != thrd_success) {
+    OV_ERROR_SET_GENERIC(err, ov_error_generic_fail);
+    goto cleanup;
+  }
+  ve->thread_created = true;
+
+  success = true;
+
+cleanup:
+  if (!success) {
+    ptk_voice_envelopes_destroy(&ve);
+  }
+  return ve;
+}
+
+void ptk_voice_envelopes_destroy(struct ptk_voice_envelopes **const ve_ptr) {
+  if (!ve_ptr || !*ve_ptr) {
+    return;
+  }
+  struct ptk_voice_envelopes *const ve = *ve_ptr;
+  if (ve->thread_created) {
+    mtx_lock(&ve->mtx);
+    ve->exit_requested = true;
+    cnd_signal(&ve->cnd);
+    mtx_unlock(&ve->mtx);
+    thrd_join(ve->thread, NULL);
+  }
+  if (ve->entries) {
+    size_t iter = 0;
+    struct envelope_entry **entry_ptr = NULL;
+    while (OV_HASHMAP_ITER(ve->entries, &iter, &entry_ptr)) {
+      entry_destroy(entry_ptr);
+    }
+    OV_HASHMAP_DESTROY(&ve->entries);
+  }
+  cnd_destroy(&ve->cnd);
+  mtx_destroy(&ve->mtx);
+  OV_FREE(ve_ptr);
+}
+
+static void enqueue_entry(struct ptk_voice_envelopes *const ve, struct envelope_entry *const entry) {
+  entry->state = envelope_state_queued;
+  if (ve->queue_tail) {
+    ve->queue_tail->next = entry;
+  } else {
+    ve->queue_head = entry;
+  }
+  ve->queue_tail = entry;
+  cnd_signal(&ve->cnd);
+}
+
+bool ptk_voice_envelopes_get(struct ptk_voice_envelopes *const ve,
+                             char const *const path_utf8,
+                             struct ptk_voice_envelope const **const env,
+                             struct ov_error *const err) {
+  if (!ve || !path_utf8 || !env) {
+    OV_ERROR_SET_GENERIC(err, ov_error_generic_invalid_argument);
+    return false;
+  }
+
+  size_t const path_len = strlen(path_utf8);
+  struct envelope_entry *entry = NULL;
+  struct envelope_entry *checking = NULL;
+  bool success = false;
+
+  *env = NULL;
+  mtx_lock(&ve->mtx);
+  {
+    struct envelope_entry *e = find_entry(ve, path_utf8, path_len);
+    if (e) {
+      e->last_used = ++ve->tick;
+      if (e->state == envelope_state_queued) {
+        success = true;
+        goto cleanup;
+      }
+      uint64_t const now = GetTickCount64();
+      if (now - e->checked_at < revalidate_interval_ms) {
+        if (e->state == envelope_state_ready) {
+          ++e->refs;
+          *env = &e->env;
+        }
+        success = true;
+        goto cleanup;
+      }
+
+      // Same check as the disk cache, the file may have been regenerated at the same path.
+      // The lock is released while the file is checked, other callers keep using the current result meanwhile.
+      e->checked_at = now;
+      ++e->refs;
+      checking = e;
+      mtx_unlock(&ve->mtx);
+      uint64_t size = 0;
+      uint64_t time = 0;
+      get_file_stamp(e->wpath, &size, &time, NULL);
+      mtx_lock(&ve->mtx);
+
+      if (e->state == envelope_state_queued || find_entry(ve, path_utf8, path_len) != e) {
+        // Another caller has already requeued or replaced it
+        success = true;
+        goto cleanup;
+      }
+      if (size == e->source_size && time == e->source_time) {
+        if (e->state == envelope_state_ready) {
+          ++e->refs;
+          *env = &e->env;
+        }
+        success = true;
+        goto cleanup;
+      }
+      if (e->state == envelope_state_failed) {
+        // Nothing has been returned from a failed entry, it can be reused for the retry
+        enqueue_entry(ve, e);
+        success = true;
+        goto cleanup;
+      }
+      // Envelopes already returned stay valid until they are released
+      remove_entry(ve, e);
+    }
+
+    size_t const wide_len = ov_utf8_to_wchar_len(path_utf8, path_len);
+    if (wide_len == 0) {
+      // Not a usable path - nothing to analyse
+      success = true;
+      goto cleanup;
+    }
+    if (!OV_REALLOC(&entry, 1, sizeof(*entry))) {
+      OV_ERROR_SET_GENERIC(err, ov_error_generic_out_of_memory);
+      goto cleanup;
+    }
+    *entry = (struct envelope_entry){
+        .path_len = path_len,
+        .last_used = ++ve->tick,
+        .refs = 1,
+    };
+    if (!OV_ARRAY_GROW(&entry->path, path_len + 1) || !OV_ARRAY_GROW(&entry->wpath, wide_len + 1)) {
+      OV_ERROR_SET_GENERIC(err, ov_error_generic_out_of_memory);
+      goto cleanup;
+    }
+    memcpy(entry->path, path_utf8, path_len + 1);
+    OV_ARRAY_SET_LENGTH(entry->path, path_len);
+    ov_utf8_to_wchar(path_utf8, path_len, entry->wpath, wide_len + 1, NULL);
+    OV_ARRAY_SET_LENGTH(entry->wpath, wide_len);
+    if (OV_HASHMAP_COUNT(ve->entries) >= max_cached_envelopes) {
+      evict_oldest(ve);
+    }
+    if (!OV_HASHMAP_SET(ve->entries, &entry)) {
+      OV_ERROR_SET_GENERIC(err, ov_error_generic_out_of_memory);
+      goto cleanup;
+    }
+    enqueue_entry(ve, entry);
+    entry = NULL; // ownership transferred to hashmap
+  }
+  success = true;
+
+cleanup:
+  if (checking) {
+    entry_release(&checking);
+  }
+  mtx_unlock(&ve->mtx);
+  entry_destroy(&entry);
+  return success;
+}
+
+void ptk_voice_envelopes_release(struct ptk_voice_envelopes *const ve, struct ptk_voice_envelope const *const env) {
+  if (!ve || !env) {
+    return;
+  }
+  struct envelope_entry *entry =
+      (struct envelope_entry *)(void *)((char *)ov_deconster_(env) - offsetof(struct envelope_entry, env));
+  mtx_lock(&ve->mtx);
+  entry_release(&entry);
+  mtx_unlock(&ve->mtx);
+}
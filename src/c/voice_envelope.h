@@ -0,0 +1,161 @@
+#pragma once
+
+#include <ovbase.h>
+
+#include <stdint.h>
+
+/**
+ * Per-frame band levels of a voice file.
+ *
+ * The audio is analysed with a 2048-point FFT every 1/frame_rate seconds, the same bin layout
+ * as obj.getaudio(..., "fourier"). Every bins_per_band bins are merged into a band that keeps
+ * the mean amplitude, the mean power and the peak amplitude of its bins, so levels of any
+ * frequency range can be calculated without the original spectrum.
+ */
+struct ptk_voice_envelope {
+  uint32_t sample_rate;
+  uint32_t frame_rate;
+  uint32_t bins_per_band;
+  uint32_t num_bands;
+  uint32_t num_frames;
+  uint16_t *data; // num_frames * num_bands * 3 log-encoded values (mean, power, peak), OV_ARRAY
+};
+
+/**
+ * Analyse WAV file contents.
+ *
+ * Supports integer PCM (8/16/24/32 bits) and IEEE float (32/64 bits), including WAVE_FORMAT_EXTENSIBLE.
+ * Multichannel audio is mixed down to mono.
+ *
+ * @param wav WAV file contents
+ * @param wav_size Size of wav in bytes
+ * @param env [out] Analysis result, release with ptk_voice_envelope_destroy
+ * @param err Error details on failure
+ * @return true on success, false on failure
+ */
+NODISCARD bool
+ptk_voice_envelope_analyze_wav(void const *wav, size_t wav_size, struct ptk_voice_envelope *env, struct ov_error *err);
+
+/**
+ * Release the data of an envelope.
+ *
+ * @param env Envelope to release
+ */
+void ptk_voice_envelope_destroy(struct ptk_voice_envelope *env);
+
+/**
+ * Serialize an envelope for the disk cache.
+ *
+ * @param env Envelope to serialize
+ * @param source_size Size of the analysed file, stored to detect changes
+ * @param source_time Last write time of the analysed file, stored to detect changes
+ * @param dest [out] Serialized data, OV_ARRAY
+ * @param err Error details on failure
+ * @return true on success, false on failure
+ */
+NODISCARD bool ptk_voice_envelope_serialize(struct ptk_voice_envelope const *env,
+                                            uint64_t source_size,
+                                            uint64_t source_time,
+                                            uint8_t **dest,
+                                            struct ov_error *err);
+
+/**
+ * Deserialize an envelope written by ptk_voice_envelope_serialize.
+ *
+ * @param src Serialized data
+ * @param src_size Size of src in bytes
+ * @param source_size Expected size of the analysed file
+ * @param source_time Expected last write time of the analysed file
+ * @param env [out] Deserialized envelope, release with ptk_voice_envelope_destroy
+ * @param err Error details on failure
+ * @return true on success, false if the data is broken or does not belong to the file
+ */
+NODISCARD bool ptk_voice_envelope_deserialize(void const *src,
+                                              size_t src_size,
+                                              uint64_t source_size,
+                                              uint64_t source_time,
+                                              struct ptk_voice_envelope *env,
+                                              struct ov_error *err);
+
+/**
+ * Calculate the level of a frequency band.
+ *
+ * The result follows the definition of ptk_script_module_get_audio_level for the same band and mode,
+ * at the resolution of the bands. Times outside of the audio are silent.
+ * When frames is greater than 1, the levels at time, time - interval, time - interval * 2, ...
+ * are averaged, which gives the same smoothing as a moving average over video frames
+ * but does not depend on which frames were rendered before.
+ *
+ * @param env Envelope
+ * @param time Time in seconds from the start of the audio
+ * @param frames Number of levels to average, at least 1
+ * @param interval Time between averaged levels in seconds
+ * @param locut Low frequency cutoff (Hz)
+ * @param hicut High frequency cutoff (Hz)
+ * @param mode ptk_audio_level_mode value
+ * @return Level
+ */
+double ptk_voice_envelope_level(struct ptk_voice_envelope const *env,
+                                double time,
+                                int frames,
+                                double interval,
+                                double locut,
+                                double hicut,
+                                int mode);
+
+/**
+ * IEC 61672 A-weighting gain, normalized to 1.0 at 1 kHz.
+ *
+ * @param freq Frequency in Hz
+ * @return Gain
+ */
+double ptk_a_weighting(double freq);
+
+struct ptk_voice_envelopes;
+
+/**
+ * Create a store that analyses voice files in a background thread.
+ *
+ * Results are cached in memory for the most recently used files, and on disk next to the voice file
+ * as "<file>.ptkenv".
+ *
+ * @param err Error details on failure
+ * @return Store, or NULL on failure
+ */
+NODISCARD struct ptk_voice_envelopes *ptk_voice_envelopes_create(struct ov_error *err);
+
+/**
+ * Destroy a store.
+ *
+ * Waits for the running analysis to finish. All envelopes must have been released.
+ *
+ * @param ve Pointer to store pointer (will be set to NULL)
+ */
+void ptk_voice_envelopes_destroy(struct ptk_voice_envelopes **ve);
+
+/**
+ * Get the envelope of a voice file.
+ *
+ * If the file has not been analysed yet, the analysis is queued and NULL is returned.
+ * NULL is also returned if the file cannot be analysed, for example because it is not a WAV file.
+ * The size and last write time of the file are checked at most once a second, and a file that has
+ * changed since it was analysed, or since the analysis failed, is queued again.
+ *
+ * @param ve Store
+ * @param path_utf8 Path to the voice file
+ * @param env [out] Envelope, release with ptk_voice_envelopes_release, or NULL if not available
+ * @param err Error details on failure
+ * @return true on success, false on failure
+ */
+NODISCARD bool ptk_voice_envelopes_get(struct ptk_voice_envelopes *ve,
+                                       char const *path_utf8,
+                                       struct ptk_voice_envelope const **env,
+                                       struct ov_error *err);
+
+/**
+ * Release an envelope returned by ptk_voice_envelopes_get.
+ *
+ * @param ve Store
+ * @param env Envelope, may be NULL
+ */
+void ptk_voice_envelopes_release(struct ptk_voice_envelopes *ve, struct ptk_voice_envelope const *env);
@@ -0,0 +1,443 @@
+#include "voice_envelope.h"
+
+#include <ovarray.h>
+#include <ovprintf.h>
+#include <ovtest.h>
+#include <ovutf.h>
+
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "script_module.h"
+
+static double const pi = 3.14159265358979323846;
+
+static void put_u16(uint8_t *const p, uint16_t const v) {
+  p[0] = (uint8_t)(v & 0xff);
+  p[1] = (uint8_t)(v >> 8);
+}
+
+static void put_u32(uint8_t *const p, uint32_t const v) {
+  p[0] = (uint8_t)(v & 0xff);
+  p[1] = (uint8_t)((v >> 8) & 0xff);
+  p[2] = (uint8_t)((v >> 16) & 0xff);
+  p[3] = (uint8_t)(v >> 24);
+}
+
+// Build a WAV file with a sine wave of freq Hz and amplitude amp (0-1) in all channels
+static uint8_t *make_wav(uint16_t const format,
+                         uint16_t const channels,
+                         uint16_t const bits,
+                         uint32_t const sample_rate,
+                         size_t const num_samples,
+                         double const freq,
+                         double const amp) {
+  uint16_t const block_align = (uint16_t)(channels * bits / 8);
+  size_t const data_size = num_samples * block_align;
+  size_t const total = 44 + data_size;
+  uint8_t *wav = NULL;
+  if (!OV_ARRAY_GROW(&wav, total)) {
+    return NULL;
+  }
+  memset(wav, 0, total);
+  memcpy(wav, "RIFF", 4);
+  put_u32(wav + 4, (uint32_t)(total - 8));
+  memcpy(wav + 8, "WAVE", 4);
+  memcpy(wav + 12, "fmt ", 4);
+  put_u32(wav + 16, 16);
+  put_u16(wav + 20, format);
+  put_u16(wav + 22, channels);
+  put_u32(wav + 24, sample_rate);
+  put_u32(wav + 28, sample_rate * block_align);
+  put_u16(wav + 32, block_align);
+  put_u16(wav + 34, bits);
+  memcpy(wav + 36, "data", 4);
+  put_u32(wav + 40, (uint32_t)data_size);
+  for (size_t i = 0; i < num_samples; ++i) {
+    double const v = amp * sin(2.0 * pi * freq * (double)i / (double)sample_rate);
+    for (size_t ch = 0; ch < channels; ++ch) {
+      uint8_t *const p = wav + 44 + i * block_align + ch * (bits / 8);
+      if (format == 3 && bits == 32) {
+        float const f = (float)v;
+        memcpy(p, &f, sizeof(f));
+      } else if (bits == 16) {
+        put_u16(p, (uint16_t)(int16_t)lrint(v * 32767.0));
+      } else if (bits == 24) {
+        uint32_t const s = (uint32_t)(int32_t)lrint(v * 8388607.0);
+        p[0] = (uint8_t)(s & 0xff);
+        p[1] = (uint8_t)((s >> 8) & 0xff);
+        p[2] = (uint8_t)((s >> 16) & 0xff);
+      }
+    }
+  }
+  OV_ARRAY_SET_LENGTH(wav, total);
+  return wav;
+}
+
+static void test_voice_envelope_invalid(void) {
+  struct ov_error err = {0};
+  struct ptk_voice_envelope env = {0};
+  static char const not_wav[] = "RIFF\x04\x00\x00\x00AVI ";
+  TEST_CHECK(!ptk_voice_envelope_analyze_wav(not_wav, sizeof(not_wav) - 1, &env, &err));
+  OV_ERROR_DESTROY(&err);
+
+  // 16-bit float is not a valid format
+  uint8_t *wav = make_wav(3, 1, 16, 48000, 100, 1000.0, 0.5);
+  if (!TEST_CHECK(wav != NULL)) {
+    return;
+  }
+  TEST_CHECK(!ptk_voice_envelope_analyze_wav(wav, OV_ARRAY_LENGTH(wav), &env, &err));
+  OV_ERROR_DESTROY(&err);
+  TEST_CHECK(env.data == NULL);
+  OV_ARRAY_DESTROY(&wav);
+}
+
+static void test_voice_envelope_sine(void) {
+  struct ov_error err = {0};
+  struct ptk_voice_envelope env = {0};
+  // 48000 / 2048 * 44, exactly on a bin
+  double const freq = 1031.25;
+  uint8_t *wav = make_wav(1, 2, 16, 48000, 48000, freq, 0.5);
+  if (!TEST_CHECK(wav != NULL)) {
+    return;
+  }
+  if (!TEST_SUCCEEDED(ptk_voice_envelope_analyze_wav(wav, OV_ARRAY_LENGTH(wav), &env, &err), &err)) {
+    goto cleanup;
+  }
+  TEST_CHECK(env.sample_rate == 48000);
+  TEST_CHECK(env.frame_rate == 100);
+  TEST_CHECK(env.num_frames == 100);
+  TEST_MSG("num_frames %u", env.num_frames);
+
+  {
+    // The peak of a half scale sine is half of the 16-bit range
+    double const peak = ptk_voice_envelope_level(&env, 0.3, 1, 0.0, 950.0, 1100.0, ptk_audio_level_mode_peak);
+    TEST_CHECK(fabs(peak - 16384.0) < 16384.0 * 0.02);
+    TEST_MSG("peak %f", peak);
+
+    double const in_band = ptk_voice_envelope_level(&env, 0.3, 1, 0.0, 950.0, 1100.0, ptk_audio_level_mode_rms);
+    double const out_band = ptk_voice_envelope_level(&env, 0.3, 1, 0.0, 3000.0, 4000.0, ptk_audio_level_mode_rms);
+    TEST_CHECK(in_band > out_band * 100.0);
+    TEST_MSG("in %f out %f", in_band, out_band);
+
+    double const mean = ptk_voice_envelope_level(&env, 0.3, 1, 0.0, 950.0, 1100.0, ptk_audio_level_mode_mean);
+    TEST_CHECK(mean > 0.0 && mean <= in_band && in_band <= peak);
+
+    // Around 1 kHz A-weighting is close to 1.0
+    double const weighted =
+        ptk_voice_envelope_level(&env, 0.3, 1, 0.0, 950.0, 1100.0, ptk_audio_level_mode_a_weighted);
+    TEST_CHECK(fabs(weighted - in_band) < in_band * 0.05);
+    TEST_MSG("weighted %f rms %f", weighted, in_band);
+
+    // Outside of the audio is silent
+    TEST_CHECK(ptk_voice_envelope_level(&env, -1.0, 1, 0.0, 950.0, 1100.0, ptk_audio_level_mode_rms) == 0.0);
+    TEST_CHECK(ptk_voice_envelope_level(&env, 5.0, 1, 0.0, 950.0, 1100.0, ptk_audio_level_mode_rms) == 0.0);
+
+    // Averaging over frames that start before the audio halves the level
+    double const avg = ptk_voice_envelope_level(&env, 0.05, 2, 0.1, 950.0, 1100.0, ptk_audio_level_mode_rms);
+    double const single = ptk_voice_envelope_level(&env, 0.05, 1, 0.0, 950.0, 1100.0, ptk_audio_level_mode_rms);
+    TEST_CHECK(fabs(avg - single * 0.5) < single * 0.01);
+  }
+
+cleanup:
+  ptk_voice_envelope_destroy(&env);
+  OV_ARRAY_DESTROY(&wav);
+}
+
+static void test_voice_envelope_formats(void) {
+  struct ov_error err = {0};
+  struct ptk_voice_envelope ref = {0};
+  struct ptk_voice_envelope env = {0};
+  uint8_t *wav = make_wav(1, 1, 16, 44100, 22050, 440.0, 0.25);
+  if (!TEST_CHECK(wav != NULL)) {
+    return;
+  }
+  if (!TEST_SUCCEEDED(ptk_voice_envelope_analyze_wav(wav, OV_ARRAY_LENGTH(wav), &ref, &err), &err)) {
+    goto cleanup;
+  }
+  double const expected = ptk_voice_envelope_level(&ref, 0.2, 1, 0.0, 300.0, 600.0, ptk_audio_level_mode_rms);
+  TEST_CHECK(expected > 0.0);
+
+  static struct {
+    uint16_t format;
+    uint16_t bits;
+  } const formats[] = {{1, 24}, {3, 32}};
+  for (size_t i = 0; i < sizeof(formats) / sizeof(formats[0]); ++i) {
+    OV_ARRAY_DESTROY(&wav);
+    wav = make_wav(formats[i].format, 1, formats[i].bits, 44100, 22050, 440.0, 0.25);
+    if (!TEST_CHECK(wav != NULL)) {
+      goto cleanup;
+    }
+    if (!TEST_SUCCEEDED(ptk_voice_envelope_analyze_wav(wav, OV_ARRAY_LENGTH(wav), &env, &err), &err)) {
+      goto cleanup;
+    }
+    double const level = ptk_voice_envelope_level(&env, 0.2, 1, 0.0, 300.0, 600.0, ptk_audio_level_mode_rms);
+    TEST_CHECK(fabs(level - expected) < expected * 0.01);
+    TEST_MSG("format %d bits %d: got %f want %f", formats[i].format, formats[i].bits, level, expected);
+    ptk_voice_envelope_destroy(&env);
+  }
+
+cleanup:
+  ptk_voice_envelope_destroy(&env);
+  ptk_voice_envelope_destroy(&ref);
+  if (wav) {
+    OV_ARRAY_DESTROY(&wav);
+  }
+}
+
+static void test_voice_envelope_serialize(void) {
+  struct ov_error err = {0};
+  struct ptk_voice_envelope env = {0};
+  struct ptk_voice_envelope loaded = {0};
+  uint8_t *serialized = NULL;
+  uint8_t *wav = make_wav(1, 1, 16, 48000, 24000, 500.0, 0.5);
+  if (!TEST_CHECK(wav != NULL)) {
+    return;
+  }
+  if (!TEST_SUCCEEDED(ptk_voice_envelope_analyze_wav(wav, OV_ARRAY_LENGTH(wav), &env, &err), &err)) {
+    goto cleanup;
+  }
+  if (!TEST_SUCCEEDED(ptk_voice_envelope_serialize(&env, 1234, 5678, &serialized, &err), &err)) {
+    goto cleanup;
+  }
+  if (!TEST_SUCCEEDED(
+          ptk_voice_envelope_deserialize(serialized, OV_ARRAY_LENGTH(serialized), 1234, 5678, &loaded, &err), &err)) {
+    goto cleanup;
+  }
+  TEST_CHECK(loaded.sample_rate == env.sample_rate);
+  TEST_CHECK(loaded.num_bands == env.num_bands);
+  TEST_CHECK(loaded.num_frames == env.num_frames);
+  TEST_CHECK(memcmp(loaded.data, env.data, OV_ARRAY_LENGTH(env.data) * sizeof(uint16_t)) == 0);
+  ptk_voice_envelope_destroy(&loaded);
+
+  // The cache belongs to another version of the file
+  TEST_CHECK(!ptk_voice_envelope_deserialize(serialized, OV_ARRAY_LENGTH(serialized), 1234, 5679, &loaded, &err));
+  OV_ERROR_DESTROY(&err);
+
+  // Truncated
+  TEST_CHECK(!ptk_voice_envelope_deserialize(serialized, OV_ARRAY_LENGTH(serialized) - 1, 1234, 5678, &loaded, &err));
+  OV_ERROR_DESTROY(&err);
+  TEST_CHECK(loaded.data == NULL);
+
+cleanup:
+  ptk_voice_envelope_destroy(&loaded);
+  ptk_voice_envelope_destroy(&env);
+  if (serialized) {
+    OV_ARRAY_DESTROY(&serialized);
+  }
+  OV_ARRAY_DESTROY(&wav);
+}
+
+static bool write_test_file(wchar_t const *const path, void const *const data, size_t const size) {
+  FILE *f = _wfopen(path, L"wb");
+  if (!f) {
+    return false;
+  }
+  bool const ok = fwrite(data, 1, size, f) == size;
+  fclose(f);
+  return ok;
+}
+
+// Poll until the store returns an envelope with the sample rate, the store has no way to wait for the analysis
+static struct ptk_voice_envelope const *
+wait_envelope(struct ptk_voice_envelopes *const ve, char const *const path, uint32_t const sample_rate) {
+  struct ov_error err = {0};
+  for (int i = 0; i < 500; ++i) {
+    struct ptk_voice_envelope const *env = NULL;
+    if (!TEST_SUCCEEDED(ptk_voice_envelopes_get(ve, path, &env, &err), &err)) {
+      return NULL;
+    }
+    if (env && env->sample_rate == sample_rate) {
+      return env;
+    }
+    ptk_voice_envelopes_release(ve, env);
+    Sleep(10);
+  }
+  return NULL;
+}
+
+static void make_temp_path(wchar_t const *const name, wchar_t *const path, char *const path_utf8) {
+  DWORD const len = GetTempPathW(MAX_PATH, path);
+  if (len == 0 || len + wcslen(name) + 8 >= MAX_PATH) {
+    path[0] = L'\0';
+    path_utf8[0] = '\0';
+    return;
+  }
+  wcscat(path, name);
+  size_t const wlen = wcslen(path);
+  path_utf8[ov_wchar_to_utf8(path, wlen, path_utf8, MAX_PATH * 3, NULL)] = '\0';
+}
+
+static void delete_test_files(wchar_t const *const path) {
+  wchar_t cache_path[MAX_PATH];
+  wcscpy(cache_path, path);
+  wcscat(cache_path, L".ptkenv");
+  DeleteFileW(path);
+  DeleteFileW(cache_path);
+}
+
+static void test_voice_envelopes_reload(void) {
+  static char const not_wav[] = "not a wav file";
+  struct ov_error err = {0};
+  struct ptk_voice_envelopes *ve = NULL;
+  struct ptk_voice_envelope const *first = NULL;
+  struct ptk_voice_envelope const *second = NULL;
+  struct ptk_voice_envelope const *third = NULL;
+  uint8_t *wav = NULL;
+  wchar_t path[MAX_PATH];
+  char path_utf8[MAX_PATH * 3];
+
+  make_temp_path(L"ptk_voice_envelope_test.wav", path, path_utf8);
+  if (!TEST_CHECK(path[0] != L'\0')) {
+    return;
+  }
+
+  ve = ptk_voice_envelopes_create(&err);
+  if (!TEST_SUCCEEDED(ve != NULL, &err)) {
+    return;
+  }
+
+  wav = make_wav(1, 1, 16, 48000, 24000, 500.0, 0.5);
+  if (!TEST_CHECK(wav != NULL) || !TEST_CHECK(write_test_file(path, wav, OV_ARRAY_LENGTH(wav)))) {
+    goto cleanup;
+  }
+  OV_ARRAY_DESTROY(&wav);
+  first = wait_envelope(ve, path_utf8, 48000);
+  if (!TEST_CHECK(first != NULL)) {
+    goto cleanup;
+  }
+
+  // A file regenerated at the same path is analysed again once the store checks it
+  wav = make_wav(1, 1, 16, 24000, 6000, 500.0, 0.5);
+  if (!TEST_CHECK(wav != NULL) || !TEST_CHECK(write_test_file(path, wav, OV_ARRAY_LENGTH(wav)))) {
+    goto cleanup;
+  }
+  OV_ARRAY_DESTROY(&wav);
+  second = wait_envelope(ve, path_utf8, 24000);
+  if (!TEST_CHECK(second != NULL)) {
+    goto cleanup;
+  }
+  // Envelopes stay valid until they are released
+  TEST_CHECK(first->sample_rate == 48000);
+
+  // A failed analysis is retried once the file changes
+  if (!TEST_CHECK(write_test_file(path, not_wav, sizeof(not_wav) - 1))) {
+    goto cleanup;
+  }
+  for (int i = 0; i < 500; ++i) {
+    struct ptk_voice_envelope const *env = NULL;
+    if (!TEST_SUCCEEDED(ptk_voice_envelopes_get(ve, path_utf8, &env, &err), &err)) {
+      goto cleanup;
+    }
+    ptk_voice_envelopes_release(ve, env);
+    if (!env) {
+      break;
+    }
+    Sleep(10);
+  }
+  wav = make_wav(1, 1, 16, 16000, 4000, 500.0, 0.5);
+  if (!TEST_CHECK(wav != NULL) || !TEST_CHECK(write_test_file(path, wav, OV_ARRAY_LENGTH(wav)))) {
+    goto cleanup;
+  }
+  third = wait_envelope(ve, path_utf8, 16000);
+  TEST_CHECK(third != NULL);
+
+cleanup:
+  ptk_voice_envelopes_release(ve, third);
+  ptk_voice_envelopes_release(ve, second);
+  ptk_voice_envelopes_release(ve, first);
+  ptk_voice_envelopes_destroy(&ve);
+  delete_test_files(path);
+  if (wav) {
+    OV_ARRAY_DESTROY(&wav);
+  }
+}
+
+enum {
+  evict_test_files = 40,
+};
+
+static void test_voice_envelopes_evict(void) {
+  struct ov_error err = {0};
+  struct ptk_voice_envelopes *ve = NULL;
+  struct ptk_voice_envelope const *held = NULL;
+  uint8_t *wav = NULL;
+  wchar_t paths[evict_test_files][MAX_PATH];
+  char paths_utf8[evict_test_files][MAX_PATH * 3];
+
+  for (size_t i = 0; i < evict_test_files; ++i) {
+    wchar_t name[64];
+    ov_snprintf_wchar(name,
+                      sizeof(name) / sizeof(name[0]),
+                      L"ptk_voice_envelope_evict_%1$zu.wav",
+                      L"ptk_voice_envelope_evict_%1$zu.wav",
+                      i);
+    make_temp_path(name, paths[i], paths_utf8[i]);
+    if (!TEST_CHECK(paths[i][0] != L'\0')) {
+      return;
+    }
+  }
+
+  ve = ptk_voice_envelopes_create(&err);
+  if (!TEST_SUCCEEDED(ve != NULL, &err)) {
+    return;
+  }
+  wav = make_wav(1, 1, 16, 8000, 800, 500.0, 0.5);
+  if (!TEST_CHECK(wav != NULL)) {
+    goto cleanup;
+  }
+  for (size_t i = 0; i < evict_test_files; ++i) {
+    if (!TEST_CHECK(write_test_file(paths[i], wav, OV_ARRAY_LENGTH(wav)))) {
+      goto cleanup;
+    }
+  }
+
+  held = wait_envelope(ve, paths_utf8[0], 8000);
+  if (!TEST_CHECK(held != NULL)) {
+    goto cleanup;
+  }
+  for (size_t i = 1; i < evict_test_files; ++i) {
+    struct ptk_voice_envelope const *const env = wait_envelope(ve, paths_utf8[i], 8000);
+    if (!TEST_CHECK(env != NULL)) {
+      goto cleanup;
+    }
+    ptk_voice_envelopes_release(ve, env);
+  }
+
+  // The first file is the least recently used one, so it has been dropped and is queued again
+  {
+    struct ptk_voice_envelope const *env = NULL;
+    if (!TEST_SUCCEEDED(ptk_voice_envelopes_get(ve, paths_utf8[0], &env, &err), &err)) {
+      goto cleanup;
+    }
+    TEST_CHECK(env == NULL);
+    ptk_voice_envelopes_release(ve, env);
+  }
+  // but the envelope that is still held stays valid
+  TEST_CHECK(held->sample_rate == 8000);
+  TEST_CHECK(held->num_frames > 0);
+
+cleanup:
+  ptk_voice_envelopes_release(ve, held);
+  ptk_voice_envelopes_destroy(&ve);
+  for (size_t i = 0; i < evict_test_files; ++i) {
+    delete_test_files(paths[i]);
+  }
+  if (wav) {
+    OV_ARRAY_DESTROY(&wav);
+  }
+}
+
+TEST_LIST = {
+    {"test_voice_envelope_invalid", test_voice_envelope_invalid},
+    {"test_voice_envelope_sine", test_voice_envelope_sine},
+    {"test_voice_envelope_formats", test_voice_envelope_formats},
+    {"test_voice_envelope_serialize", test_voice_envelope_serialize},
+    {"test_voice_envelopes_reload", test_voice_envelopes_reload},
+    {"test_voice_envelopes_evict", test_voice_envelopes_evict},
+    {NULL, NULL},
+};
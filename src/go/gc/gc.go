@@ -1,16 +1,163 @@
 package gc
 
 import (
+	"os"
+	"runtime"
 	"runtime/debug"
+	"runtime/metrics"
+	"strconv"
+	"sync"
 	"sync/atomic"
 	"time"
+
+	"psdtoolkit/ods"
+)
+
+// Policy decides when memory is returned to the OS.
+//
+// Forcing a collection while the user is scrubbing the timeline adds latency to DRAW,
+// so memory is only returned after the process has been idle for a while,
+// and only if enough memory can be released. When the heap approaches MemoryLimit,
+// a much shorter pause is enough, because the runtime is already collecting
+// aggressively and returning memory early keeps the process below the limit.
+type Policy struct {
+	// MemoryLimit is the soft memory limit in bytes passed to debug.SetMemoryLimit.
+	// Zero or negative keeps the runtime default.
+	MemoryLimit int64
+	// IdleDelay is how long no activity must be reported before memory is returned to the OS.
+	IdleDelay time.Duration
+	// PressureDelay replaces IdleDelay while the heap is above PressureRatio of MemoryLimit.
+	PressureDelay time.Duration
+	PressureRatio float64
+	// MinRelease is the minimum estimated amount of releasable memory in bytes.
+	MinRelease uint64
+}
+
+var DefaultPolicy = Policy{
+	IdleDelay:     3 * time.Second,
+	PressureDelay: 500 * time.Millisecond,
+	PressureRatio: 0.8,
+	MinRelease:    32 * 1024 * 1024,
+}
+
+// MemoryLimitEnv is the environment variable the plugin uses to pass the soft memory limit in MiB.
+const MemoryLimitEnv = "PSDTOOLKIT_MEMORY_LIMIT_MIB"
+
+// MemoryLimitFromEnv returns the soft memory limit in bytes set by the plugin, or 0 if there is none.
+func MemoryLimitFromEnv() int64 {
+	mib, err := strconv.ParseInt(os.Getenv(MemoryLimitEnv), 10, 64)
+	if err != nil || mib <= 0 || mib >= 1<<43 {
+		return 0
+	}
+	return mib * 1024 * 1024
+}
+
+// Stats holds GC pause metrics and the history of forced releases.
+type Stats struct {
+	NumGC          int64
+	PauseTotal     time.Duration
+	PauseQuantiles [5]time.Duration // min, 25%, 50%, 75%, max of recent pauses
+	ForcedReleases uint64
+	LastRelease    time.Time
+	LastReleased   uint64 // estimated bytes released by the last forced release
+}
+
+var (
+	counter      int32
+	lastActivity int64 // UnixNano
+
+	statsMu sync.Mutex
+	stats   Stats
 )
 
-var counter int32
+// Touch reports activity. Memory is not returned to the OS until the process becomes idle again.
+func Touch() { atomic.StoreInt64(&lastActivity, time.Now().UnixNano()) }
+
+func EnterCS() { atomic.AddInt32(&counter, 1); Touch() }
+func LeaveCS() { atomic.AddInt32(&counter, -1); Touch() }
+
+// releasable estimates the heap memory that a forced collection can return to the OS.
+// liveAfterRelease is the heap size right after the previous forced release.
+func releasable(ms *runtime.MemStats, liveAfterRelease uint64) uint64 {
+	r := ms.HeapIdle - ms.HeapReleased
+	if ms.HeapAlloc > liveAfterRelease {
+		r += ms.HeapAlloc - liveAfterRelease
+	}
+	return r
+}
+
+// underPressure reports whether heapAlloc is close enough to MemoryLimit to release memory early.
+func (p *Policy) underPressure(heapAlloc uint64) bool {
+	return p.MemoryLimit > 0 && float64(heapAlloc) >= float64(p.MemoryLimit)*p.PressureRatio
+}
+
+// shouldRelease reports whether memory should be returned to the OS now.
+// checked reports whether the current idle period has already been evaluated.
+func (p *Policy) shouldRelease(idle time.Duration, checked bool, pressure bool) bool {
+	delay := p.IdleDelay
+	if pressure {
+		delay = p.PressureDelay
+	}
+	return idle >= delay && !checked
+}
+
+// heapAlloc returns the bytes of allocated heap objects, like MemStats.HeapAlloc,
+// without stopping the world.
+func heapAlloc() uint64 {
+	s := []metrics.Sample{{Name: "/memory/classes/heap/objects:bytes"}}
+	metrics.Read(s)
+	if s[0].Value.Kind() != metrics.KindUint64 {
+		return 0
+	}
+	return s[0].Value.Uint64()
+}
+
+func ReadStats() Stats {
+	var gs debug.GCStats
+	gs.PauseQuantiles = make([]time.Duration, 5)
+	debug.ReadGCStats(&gs)
+
+	statsMu.Lock()
+	s := stats
+	statsMu.Unlock()
+	s.NumGC = gs.NumGC
+	s.PauseTotal = gs.PauseTotal
+	copy(s.PauseQuantiles[:], gs.PauseQuantiles)
+	return s
+}
+
+func (p *Policy) release(liveAfterRelease *uint64) {
+	var ms runtime.MemStats
+	runtime.ReadMemStats(&ms)
+	r := releasable(&ms, *liveAfterRelease)
+	if r < p.MinRelease {
+		return
+	}
+	debug.FreeOSMemory()
+	runtime.ReadMemStats(&ms)
+	*liveAfterRelease = ms.HeapAlloc
+
+	statsMu.Lock()
+	stats.ForcedReleases++
+	stats.LastRelease = time.Now()
+	stats.LastReleased = r
+	statsMu.Unlock()
+
+	s := ReadStats()
+	ods.ODS("gc: released about %d bytes / NumGC: %d / PauseTotal: %v / Pause(min, 25%%, 50%%, 75%%, max): %v",
+		r, s.NumGC, s.PauseTotal, s.PauseQuantiles)
+}
 
-func Start(exitCh <-chan struct{}) <-chan struct{} {
+func Start(exitCh <-chan struct{}, policy Policy) <-chan struct{} {
+	if policy.MemoryLimit > 0 {
+		debug.SetMemoryLimit(policy.MemoryLimit)
+	}
+	Touch()
 	done := make(chan struct{})
 	go func() {
+		var liveAfterRelease uint64
+		var checked bool
+		checkedAt := atomic.LoadInt64(&lastActivity)
 		fpsTicker := time.NewTicker(time.Second)
 		for {
 			select {
@@ -18,15 +165,24 @@ func Start(exitCh <-chan struct{}) <-chan struct{} {
 				fpsTicker.Stop()
 				done <- struct{}{}
 				return
-			case <-fpsTicker.C:
-				if atomic.LoadInt32(&counter) == 0 {
-					debug.FreeOSMemory()
+			case now := <-fpsTicker.C:
+				if atomic.LoadInt32(&counter) != 0 {
+					continue
+				}
+				la := atomic.LoadInt64(&lastActivity)
+				if la != checkedAt {
+					// New activity since the last evaluation
+					checked = false
 				}
+				pressure := policy.MemoryLimit > 0 && policy.underPressure(heapAlloc())
+				if !policy.shouldRelease(now.Sub(time.Unix(0, la)), checked, pressure) {
+					continue
+				}
+				policy.release(&liveAfterRelease)
+				checked = true
+				checkedAt = la
 			}
 		}
 	}()
 	return done
 }
-
-func EnterCS() { atomic.AddInt32(&counter, 1) }
-func LeaveCS() { atomic.AddInt32(&counter, -1) }
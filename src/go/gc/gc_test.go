@@ -0,0 +1,96 @@
+package gc
+
+import (
+	"runtime"
+	"testing"
+	"time"
+)
+
+func TestShouldRelease(t *testing.T) {
+	p := Policy{IdleDelay: 3 * time.Second, PressureDelay: time.Second, MinRelease: 32}
+	testData := []struct {
+		Idle     time.Duration
+		Checked  bool
+		Pressure bool
+		Want     bool
+	}{
+		{Idle: 0, Checked: false, Want: false},
+		{Idle: 3*time.Second - 1, Checked: false, Want: false},
+		{Idle: 3 * time.Second, Checked: false, Want: true},
+		{Idle: time.Minute, Checked: false, Want: true},
+		{Idle: 3 * time.Second, Checked: true, Want: false},
+		{Idle: time.Minute, Checked: true, Want: false},
+		{Idle: time.Second - 1, Checked: false, Pressure: true, Want: false},
+		{Idle: time.Second, Checked: false, Pressure: true, Want: true},
+		{Idle: time.Second, Checked: true, Pressure: true, Want: false},
+	}
+	for i, data := range testData {
+		if got := p.shouldRelease(data.Idle, data.Checked, data.Pressure); got != data.Want {
+			t.Errorf("#%d: want %v got %v", i, data.Want, got)
+		}
+	}
+}
+
+func TestReleasable(t *testing.T) {
+	testData := []struct {
+		HeapIdle         uint64
+		HeapReleased     uint64
+		HeapAlloc        uint64
+		LiveAfterRelease uint64
+		Want             uint64
+	}{
+		{HeapIdle: 100, HeapReleased: 100, HeapAlloc: 50, LiveAfterRelease: 50, Want: 0},
+		{HeapIdle: 100, HeapReleased: 40, HeapAlloc: 50, LiveAfterRelease: 50, Want: 60},
+		{HeapIdle: 100, HeapReleased: 100, HeapAlloc: 80, LiveAfterRelease: 50, Want: 30},
+		{HeapIdle: 100, HeapReleased: 40, HeapAlloc: 80, LiveAfterRelease: 50, Want: 90},
+		{HeapIdle: 100, HeapReleased: 100, HeapAlloc: 30, LiveAfterRelease: 50, Want: 0},
+	}
+	for i, data := range testData {
+		ms := runtime.MemStats{
+			HeapIdle:     data.HeapIdle,
+			HeapReleased: data.HeapReleased,
+			HeapAlloc:    data.HeapAlloc,
+		}
+		if got := releasable(&ms, data.LiveAfterRelease); got != data.Want {
+			t.Errorf("#%d: want %d got %d", i, data.Want, got)
+		}
+	}
+}
+
+func TestUnderPressure(t *testing.T) {
+	testData := []struct {
+		MemoryLimit int64
+		HeapAlloc   uint64
+		Want        bool
+	}{
+		{MemoryLimit: 0, HeapAlloc: 1 << 40, Want: false},
+		{MemoryLimit: 1000, HeapAlloc: 799, Want: false},
+		{MemoryLimit: 1000, HeapAlloc: 800, Want: true},
+		{MemoryLimit: 1000, HeapAlloc: 2000, Want: true},
+	}
+	for i, data := range testData {
+		p := Policy{MemoryLimit: data.MemoryLimit, PressureRatio: 0.8}
+		if got := p.underPressure(data.HeapAlloc); got != data.Want {
+			t.Errorf("#%d: want %v got %v", i, data.Want, got)
+		}
+	}
+}
+
+func TestMemoryLimitFromEnv(t *testing.T) {
+	testData := []struct {
+		Value string
+		Want  int64
+	}{
+		{Value: "", Want: 0},
+		{Value: "abc", Want: 0},
+		{Value: "0", Want: 0},
+		{Value: "-5", Want: 0},
+		{Value: "512", Want: 512 * 1024 * 1024},
+	}
+	for i, data := range testData {
+		t.Setenv(MemoryLimitEnv, data.Value)
+		if got := MemoryLimitFromEnv(); got != data.Want {
+			t.Errorf("#%d: want %d got %d", i, data.Want, got)
+		}
+	}
+}
@@ -357,7 +357,7 @@ func (g *GUI) updateFontIfDPIChanged() {
 		g.layerView.SetFontHandles(g.font.MainHandle, g.font.SymbolHandle)
 		g.layerView.SetScale(g.uiScale())
 		if g.img != nil {
-			g.layerView.UpdateLayerThumbnails(g.img.PSD, g.scaledInt(24), g.do)
+			g.layerView.UpdateLayerThumbnails(g.img, g.scaledInt(24), g.do)
 		}
 	}
 }
@@ -379,7 +379,7 @@ func (g *GUI) changeSelectedImage() {
 	g.thumbnailer = g.editing.CreateThumbnailer(g.snapshot.SelectedIndex)
 	updateRenderedImage(g, g.img)
 	g.layerView.SetScale(g.uiScale())
-	g.layerView.UpdateLayerThumbnails(g.img.PSD, g.scaledInt(24), g.do)
+	g.layerView.UpdateLayerThumbnails(g.img, g.scaledInt(24), g.do)
 }
 
 func (g *GUI) update() {
@@ -469,6 +469,7 @@ func (g *GUI) update() {
 					modified = g.layerView.Render(ctx, g.img) || modified
 					if modified {
 						g.img.Modified = true
+						g.img.MarkChanged()
 						g.img.Layers.Normalize()
 						updateRenderedImage(g, g.img)
 					}
@@ -42,6 +42,9 @@ type LayerView struct {
 	thumbnailSize int
 	thumbnail     *nkhelper.Texture
 	thumbnailChip map[int]*nk.Image
+	// thumbnailKey identifies the sheet held in thumbnail, thumbnailWant the most recently requested one
+	thumbnailKey  thumbnailSheetKey
+	thumbnailWant thumbnailSheetKey
 
 	layerFavSelectedIndex int32
 
@@ -50,7 +53,10 @@ type LayerView struct {
 	ExportLayerNames   func(path string, names, values []string, selectedIndex int)
 }
 
-var jq = jobqueue.New(1)
+var (
+	jq         = jobqueue.Default.NewGroup()
+	sheetCache = newThumbnailSheetCache(64 * 1024 * 1024)
+)
 
 func (lv *LayerView) SetFontHandles(mainFontHandle, symbolFontHandle *nk.UserFont) {
 	lv.mainFontHandle = mainFontHandle
@@ -80,11 +86,42 @@ func New(mainFontHandle, symbolFontHandle *nk.UserFont) (*LayerView, error) {
 	return lv, nil
 }
 
-func (lv *LayerView) UpdateLayerThumbnails(tree *composite.Tree, size int, doMain func(func() error) error) {
-	jq.CancelAll()
+func (lv *LayerView) setThumbnailSheet(sheet *thumbnailSheet) {
+	lv.thumbnail.Update(sheet.Image)
 	lv.thumbnailChip = map[int]*nk.Image{}
+	lv.thumbnailKey = sheet.Key
+	for i, rect := range sheet.Rects {
+		img := lv.thumbnail.SubImage(nk.NkRect(
+			float32(rect.Min.X),
+			float32(rect.Min.Y),
+			float32(rect.Dx()),
+			float32(rect.Dy()),
+		))
+		lv.thumbnailChip[i] = &img
+	}
+}
+
+func (lv *LayerView) UpdateLayerThumbnails(im *img.Image, size int, doMain func(func() error) error) {
+	jq.CancelAll()
+	key := thumbnailSheetKey{FileHash: im.FileHash, Size: size}
+	if im.FilePath != nil {
+		key.FilePath = *im.FilePath
+	}
 	lv.thumbnailSize = size
+	lv.thumbnailWant = key
+	if sheet := sheetCache.Get(key); sheet != nil {
+		lv.setThumbnailSheet(sheet)
+		return
+	}
+	if lv.thumbnailKey.FilePath != key.FilePath || lv.thumbnailKey.FileHash != key.FileHash {
+		lv.thumbnailChip = map[int]*nk.Image{}
+	}
+	// Otherwise the current thumbnails are drawn scaled to the new size until the new sheet is ready.
+	tree := im.PSD
 	jq.Enqueue(func(ctx context.Context) error {
+		// TODO: Generate the thumbnails of the visible rows first, as separate jobs of jq,
+		// once the psd package can render the thumbnail of a single layer.
+		// Until then the whole sheet is generated in one job and shown when it is complete.
 		nrgba, ptMap, err := tree.ThumbnailSheet(ctx, size)
 		if err != nil {
 			doMain(func() error {
@@ -93,19 +130,21 @@ func (lv *LayerView) UpdateLayerThumbnails(tree *composite.Tree, size int, doMai
 			})
 			return nil
 		}
+		sheet := &thumbnailSheet{
+			Key:   key,
+			Image: nrgba,
+			Rects: make(map[int]image.Rectangle, len(ptMap)),
+		}
+		for i, rect := range ptMap {
+			sheet.Rects[i] = rect
+		}
+		sheetCache.Put(sheet)
 		if err = doMain(func() error {
-			lv.thumbnail.Update(nrgba)
-			lv.thumbnailChip = map[int]*nk.Image{}
-			lv.thumbnailSize = size
-			for i, rect := range ptMap {
-				img := lv.thumbnail.SubImage(nk.NkRect(
-					float32(rect.Min.X),
-					float32(rect.Min.Y),
-					float32(rect.Dx()),
-					float32(rect.Dy()),
-				))
-				lv.thumbnailChip[i] = &img
+			if lv.thumbnailWant != key {
+				// Superseded by a newer request
+				return nil
 			}
+			lv.setThumbnailSheet(sheet)
 			return nil
 		}); err != nil {
 			ods.ODS("layerview: failed to update thumbnail: %v", err)
@@ -170,6 +209,7 @@ func (lv *LayerView) Render(ctx *nk.Context, img *img.Image) bool {
 		case 1:
 			if img.PFV != nil && len(img.PFV.FaviewRoot.Children) > 0 {
 				nk.NkLayoutRowDynamic(ctx, comboHeight, 1)
+				selectedIndex := img.PFV.FaviewRoot.SelectedIndex
 				img.PFV.FaviewRoot.SelectedIndex = int(nk.NkComboString(
 					ctx,
 					img.PFV.FaviewRoot.ItemNameList,
@@ -178,6 +218,9 @@ func (lv *LayerView) Render(ctx *nk.Context, img *img.Image) bool {
 					comboItemHeight,
 					nk.NkVec2(rgn.W(), rgn.H()),
 				))
+				if img.PFV.FaviewRoot.SelectedIndex != selectedIndex {
+					img.MarkChanged()
+				}
 				children := img.PFV.FaviewRoot.Children[img.PFV.FaviewRoot.SelectedIndex].Children
 				for i := range children {
 					modified = lv.layoutFaview(ctx, img, 0, &children[i]) || modified
@@ -319,6 +362,7 @@ func (lv *LayerView) layoutLayer(ctx *nk.Context, image *img.Image, indent float
 	_, forceVisible := image.Layers.ForceVisible[img.SeqID(l.SeqID)]
 	thumb, _ := lv.thumbnailChip[l.SeqID]
 	nk.NkLayoutSpaceBegin(ctx, nk.Static, float32(28)*lv.scale, 3)
+	folderOpen := l.FolderOpen
 	if clicked := lv.layerTreeItem(ctx, indent, float32(lv.thumbnailSize), thumb, visible, forceVisible, l); clicked != 0 {
 		if clicked&1 == 1 {
 			ctrl := nkhelper.GetAsyncKeyState(nkhelper.VK_CONTROL) < 0
@@ -340,6 +384,9 @@ func (lv *LayerView) layoutLayer(ctx *nk.Context, image *img.Image, indent float
 		}
 	}
 	nk.NkLayoutSpaceEnd(ctx)
+	if l.FolderOpen != folderOpen {
+		image.MarkChanged()
+	}
 
 	if l.FolderOpen {
 		for i := len(l.Children) - 1; i >= 0; i-- {
@@ -426,10 +473,14 @@ func (lv *LayerView) layoutFavorites(ctx *nk.Context, img *img.Image, indent flo
 	modified := false
 	indentSize := float32(16) * lv.scale
 	nk.NkLayoutSpaceBegin(ctx, nk.Static, float32(28)*lv.scale, 4)
+	open := n.Open
 	if lv.layoutFavoriteItem(ctx, indent, n) {
 		modified = lv.selectFavoriteNode(img, n) || modified
 	}
 	nk.NkLayoutSpaceEnd(ctx)
+	if n.Open != open {
+		img.MarkChanged()
+	}
 
 	if (n.Folder() || n.Filter()) && n.Open {
 		for i := range n.Children {
@@ -545,6 +596,7 @@ func (lv *LayerView) selectFaviewNode(img *img.Image, n *img.FaviewNode, newSele
 		lv.ReportError(errors.Wrap(err, "layerview: cannot deserialize"))
 		return false
 	}
+	img.MarkChanged()
 	return m
 }
 
@@ -0,0 +1,62 @@
+package layerview
+
+import (
+	"image"
+	"sync"
+)
+
+// thumbnailSheetKey identifies a thumbnail sheet.
+// Layer thumbnails only depend on the file contents and the thumbnail size,
+// so a sheet can be reused when switching images, reopening a file or changing the size back.
+type thumbnailSheetKey struct {
+	FilePath string
+	FileHash uint32
+	Size     int
+}
+
+type thumbnailSheet struct {
+	Key   thumbnailSheetKey
+	Image *image.NRGBA
+	Rects map[int]image.Rectangle
+}
+
+// thumbnailSheetCache keeps recently generated thumbnail sheets up to limit bytes.
+type thumbnailSheetCache struct {
+	m      sync.Mutex
+	sheets []*thumbnailSheet // most recently used first
+	limit  int
+}
+
+func newThumbnailSheetCache(limit int) *thumbnailSheetCache {
+	return &thumbnailSheetCache{limit: limit}
+}
+
+func (c *thumbnailSheetCache) Get(key thumbnailSheetKey) *thumbnailSheet {
+	c.m.Lock()
+	defer c.m.Unlock()
+	for i, s := range c.sheets {
+		if s.Key == key {
+			copy(c.sheets[1:i+1], c.sheets[:i])
+			c.sheets[0] = s
+			return s
+		}
+	}
+	return nil
+}
+
+func (c *thumbnailSheetCache) Put(sheet *thumbnailSheet) {
+	c.m.Lock()
+	defer c.m.Unlock()
+	sheets := []*thumbnailSheet{sheet}
+	used := len(sheet.Image.Pix)
+	for _, s := range c.sheets {
+		if s.Key == sheet.Key {
+			continue
+		}
+		if used += len(s.Image.Pix); used > c.limit {
+			break
+		}
+		sheets = append(sheets, s)
+	}
+	c.sheets = sheets
+}
@@ -3,6 +3,7 @@ package mainview
 import (
 	"context"
 	"math"
+	"time"
 
 	"psdtoolkit/img"
 	"psdtoolkit/ods"
@@ -16,24 +17,30 @@ const (
 	vrmFastAfterBeautiful
 )
 
+// beautifulDelay postpones the beautiful pass after a fast one, so that rapid changes such as
+// clicking through layers only finish the fast render of each state and the beautiful render of the last one.
+const beautifulDelay = 200 * time.Millisecond
+
 func (mv *MainView) updateViewImage(mode viewResizeMode) {
 	if mv.currentImg == nil || mv.renderScaled == nil {
 		return
 	}
 
+	// Latest wins: a superseded render is cancelled, and stops at the next tile
 	jq.CancelAll()
-	jq.Enqueue(func(ctx context.Context) error {
-		// Calculate the scale based on zoom level
-		// zoom < 0 means downscale (scale < 1)
-		// zoom >= 0 means no downscale needed (scale = 1, magnification handled at display)
-		var scale float64 = 1.0
-		if mv.zoom < 0 {
-			scale = math.Pow(2, mv.zoom)
-		}
 
+	// Calculate the scale based on zoom level
+	// zoom < 0 means downscale (scale < 1)
+	// zoom >= 0 means no downscale needed (scale = 1, magnification handled at display)
+	var scale float64 = 1.0
+	if mv.zoom < 0 {
+		scale = math.Pow(2, mv.zoom)
+	}
+	currentImg := mv.currentImg
+	jq.EnqueueWithPriority(renderPriority, func(ctx context.Context) error {
 		// Render with fast quality first
 		if mode == vrmFast || mode == vrmFastAfterBeautiful {
-			resizedImage, err := mv.renderScaled(ctx, mv.currentImg, scale, img.ScaleQualityFast)
+			resizedImage, err := mv.renderScaled(ctx, currentImg, scale, img.ScaleQualityFast)
 			if err != nil || resizedImage == nil {
 				ods.ODS("renderScaled(fast): aborted or nil")
 				return nil
@@ -53,8 +60,16 @@ func (mv *MainView) updateViewImage(mode viewResizeMode) {
 			return nil
 		}
 
+		if mode == vrmFastAfterBeautiful {
+			select {
+			case <-time.After(beautifulDelay):
+			case <-ctx.Done():
+				return nil
+			}
+		}
+
 		// Render with beautiful quality
-		resizedImage, err := mv.renderScaled(ctx, mv.currentImg, scale, img.ScaleQualityBeautiful)
+		resizedImage, err := mv.renderScaled(ctx, currentImg, scale, img.ScaleQualityBeautiful)
 		if err != nil || resizedImage == nil {
 			ods.ODS("renderScaled(beautiful): aborted or nil")
 			return nil
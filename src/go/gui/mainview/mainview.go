@@ -89,7 +89,11 @@ type pendingState struct {
 	scrollY float64
 }
 
-var jq = jobqueue.New(1)
+// jq holds the preview rendering jobs; cancelling them does not affect other jobs in the shared queue.
+var jq = jobqueue.Default.NewGroup()
+
+// renderPriority runs preview rendering, which the user is waiting for, before background jobs such as thumbnails.
+const renderPriority = 1
 
 func New(bg image.Image) (*MainView, error) {
 	mv := &MainView{
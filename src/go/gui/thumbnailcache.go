@@ -16,55 +16,118 @@ const (
 	textureSize   = 512
 )
 
+// slotsPerRow is the number of thumbnail slots in a row of the texture sheet.
+const slotsPerRow = textureSize / thumbnailSize
+
 // ThumbnailCache manages the thumbnail texture sheet for the GUI.
 // It is owned by the GUI thread and should only be accessed from there.
+//
+// The sheet is a persistent atlas: each thumbnail occupies a slot for as long as it is in use,
+// so a changed thumbnail only needs its own slot to be redrawn.
 type ThumbnailCache struct {
 	sheet   *image.NRGBA
 	texture *nkhelper.Texture
 	images  []nk.Image
 
+	// slots maps each thumbnail to its slot index in the sheet
+	slots map[*image.NRGBA]int
+	// free holds released slot indices, next is the first slot index never used
+	free []int
+	next int
+
 	// Track last thumbnails to detect changes
 	lastThumbnails []*image.NRGBA
 }
 
 // NewThumbnailCache creates a new ThumbnailCache.
 func NewThumbnailCache() *ThumbnailCache {
-	return &ThumbnailCache{}
+	return &ThumbnailCache{
+		slots: map[*image.NRGBA]int{},
+	}
+}
+
+func slotRect(slot int) image.Rectangle {
+	x, y := (slot%slotsPerRow)*thumbnailSize, (slot/slotsPerRow)*thumbnailSize
+	return image.Rect(x, y, x+thumbnailSize, y+thumbnailSize)
 }
 
-// Update rebuilds the thumbnail sheet if needed and returns the nk.Image slice.
+// allocSlot returns a free slot index, or -1 if the sheet is full.
+func (c *ThumbnailCache) allocSlot() int {
+	if n := len(c.free); n > 0 {
+		slot := c.free[n-1]
+		c.free = c.free[:n-1]
+		return slot
+	}
+	if c.next >= slotsPerRow*slotsPerRow {
+		return -1
+	}
+	c.next++
+	return c.next - 1
+}
+
+// drawSlot clears the slot and draws thumb centered in it.
+func (c *ThumbnailCache) drawSlot(slot int, thumb *image.NRGBA) {
+	r := slotRect(slot)
+	draw.Draw(c.sheet, r, image.Transparent, image.Point{}, draw.Src)
+	draw.Draw(
+		c.sheet,
+		r,
+		thumb,
+		image.Pt(-(thumbnailSize-thumb.Rect.Dx())/2, -(thumbnailSize-thumb.Rect.Dy())/2),
+		draw.Over,
+	)
+}
+
+// Update redraws the slots of changed thumbnails if needed and returns the nk.Image slice.
 func (c *ThumbnailCache) Update(items []editing.Item) ([]nk.Image, error) {
 	if !c.needsUpdate(items) {
 		return c.images, nil
 	}
 
-	c.sheet = image.NewNRGBA(image.Rect(0, 0, textureSize, textureSize))
-	rects := make([]nk.Rect, len(items))
-	var tx, ty int
+	if c.sheet == nil {
+		c.sheet = image.NewNRGBA(image.Rect(0, 0, textureSize, textureSize))
+	}
 
+	// Release slots of thumbnails that are no longer used
+	used := make(map[*image.NRGBA]struct{}, len(items))
+	for _, item := range items {
+		if item.Thumbnail != nil {
+			used[item.Thumbnail] = struct{}{}
+		}
+	}
+	for thumb, slot := range c.slots {
+		if _, ok := used[thumb]; !ok {
+			delete(c.slots, thumb)
+			c.free = append(c.free, slot)
+		}
+	}
+
+	// Draw new thumbnails into free slots
+	rects := make([]nk.Rect, len(items))
+	drawn := false
 	for i, item := range items {
 		if item.Thumbnail == nil {
 			continue
 		}
-		draw.Draw(
-			c.sheet,
-			image.Rect(tx, ty, tx+thumbnailSize, ty+thumbnailSize),
-			item.Thumbnail,
-			image.Pt(-(thumbnailSize-item.Thumbnail.Rect.Dx())/2, -(thumbnailSize-item.Thumbnail.Rect.Dy())/2),
-			draw.Over,
-		)
-		rects[i] = nk.NkRect(float32(tx), float32(ty), thumbnailSize, thumbnailSize)
-		tx += thumbnailSize
-		if tx+thumbnailSize >= textureSize {
-			tx = 0
-			ty += thumbnailSize
+		slot, ok := c.slots[item.Thumbnail]
+		if !ok {
+			if slot = c.allocSlot(); slot < 0 {
+				continue
+			}
+			c.drawSlot(slot, item.Thumbnail)
+			c.slots[item.Thumbnail] = slot
+			drawn = true
 		}
+		r := slotRect(slot)
+		rects[i] = nk.NkRect(float32(r.Min.X), float32(r.Min.Y), thumbnailSize, thumbnailSize)
 	}
 
+	// The texture backend can only replace the whole image, so all slots changed
+	// in this call are uploaded at once, and nothing is uploaded if only slots were released.
 	var err error
 	if c.texture == nil {
 		c.texture, err = nkhelper.NewTexture(c.sheet)
-	} else {
+	} else if drawn {
 		err = c.texture.Update(c.sheet)
 	}
 	if err != nil {
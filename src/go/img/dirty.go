@@ -0,0 +1,88 @@
+package img
+
+import "image"
+
+// tilesRect returns the canvas area covered by the dirty tiles reported by the renderer.
+// Tiles are identified by their top-left position on the canvas.
+func tilesRect(tiles []image.Point, tileSize int, canvas image.Rectangle) image.Rectangle {
+	var r image.Rectangle
+	for _, pt := range tiles {
+		r = r.Union(image.Rect(pt.X, pt.Y, pt.X+tileSize, pt.Y+tileSize))
+	}
+	return r.Intersect(canvas)
+}
+
+// scaleDirtyRect maps a dirty area of canvas to the corresponding area of the canvas scaled to scaled.
+// The result is expanded by one pixel because resampling filters read neighbouring pixels.
+func scaleDirtyRect(dirty image.Rectangle, canvas image.Rectangle, scaled image.Rectangle) image.Rectangle {
+	if dirty.Empty() {
+		return image.Rectangle{}
+	}
+	sx := float64(scaled.Dx()) / float64(canvas.Dx())
+	sy := float64(scaled.Dy()) / float64(canvas.Dy())
+	r := image.Rect(
+		scaled.Min.X+int(float64(dirty.Min.X-canvas.Min.X)*sx)-1,
+		scaled.Min.Y+int(float64(dirty.Min.Y-canvas.Min.Y)*sy)-1,
+		scaled.Min.X+int(float64(dirty.Max.X-canvas.Min.X)*sx+0.999999)+1,
+		scaled.Min.Y+int(float64(dirty.Max.Y-canvas.Min.Y)*sy+0.999999)+1,
+	)
+	return r.Intersect(scaled)
+}
+
+// flipDirtyRect mirrors a dirty area inside bounds in the same way as the image is flipped.
+func flipDirtyRect(dirty image.Rectangle, bounds image.Rectangle, f Flip) image.Rectangle {
+	if dirty.Empty() {
+		return dirty
+	}
+	if f == FlipX || f == FlipXY {
+		dirty.Min.X, dirty.Max.X = bounds.Min.X+bounds.Max.X-dirty.Max.X, bounds.Min.X+bounds.Max.X-dirty.Min.X
+	}
+	if f == FlipY || f == FlipXY {
+		dirty.Min.Y, dirty.Max.Y = bounds.Min.Y+bounds.Max.Y-dirty.Max.Y, bounds.Min.Y+bounds.Max.Y-dirty.Min.Y
+	}
+	return dirty
+}
+
+// tileSet collects dirty tiles of a canvas without duplicates.
+// Tiles are identified by their top-left position on the canvas, as reported by the renderer.
+type tileSet struct {
+	canvas   image.Rectangle
+	tileSize int
+	cols     int
+	bits     []uint64      // one bit per tile, row-major
+	tiles    []image.Point // added tiles in order
+}
+
+func newTileSet(canvas image.Rectangle, tileSize int) *tileSet {
+	cols := (canvas.Dx() + tileSize - 1) / tileSize
+	rows := (canvas.Dy() + tileSize - 1) / tileSize
+	return &tileSet{
+		canvas:   canvas,
+		tileSize: tileSize,
+		cols:     cols,
+		bits:     make([]uint64, (cols*rows+63)/64),
+	}
+}
+
+// add records tiles that are not in the set yet. Tiles outside of the canvas are ignored.
+func (s *tileSet) add(tiles []image.Point) {
+	for _, pt := range tiles {
+		if !pt.In(s.canvas) {
+			continue
+		}
+		idx := (pt.Y-s.canvas.Min.Y)/s.tileSize*s.cols + (pt.X-s.canvas.Min.X)/s.tileSize
+		if bit := uint64(1) << uint(idx%64); s.bits[idx/64]&bit == 0 {
+			s.bits[idx/64] |= bit
+			s.tiles = append(s.tiles, pt)
+		}
+	}
+}
+
+// coverage returns the ratio of the canvas tiles that are in the set.
+func (s *tileSet) coverage() float64 {
+	rows := (s.canvas.Dy() + s.tileSize - 1) / s.tileSize
+	if s.cols == 0 || rows == 0 {
+		return 0
+	}
+	return float64(len(s.tiles)) / float64(s.cols*rows)
+}
@@ -0,0 +1,67 @@
+package img
+
+import (
+	"image"
+	"testing"
+)
+
+func TestTilesRect(t *testing.T) {
+	canvas := image.Rect(0, 0, 300, 200)
+	got := tilesRect([]image.Point{{0, 0}, {256, 128}}, 128, canvas)
+	if want := image.Rect(0, 0, 300, 200); got != want {
+		t.Errorf("want %v got %v", want, got)
+	}
+	if got := tilesRect(nil, 128, canvas); !got.Empty() {
+		t.Errorf("want empty got %v", got)
+	}
+}
+
+func TestScaleDirtyRect(t *testing.T) {
+	canvas := image.Rect(0, 0, 1000, 500)
+	scaled := scaleRect(canvas, 0.25)
+	got := scaleDirtyRect(image.Rect(100, 100, 200, 150), canvas, scaled)
+	if want := image.Rect(24, 24, 51, 39); got != want {
+		t.Errorf("want %v got %v", want, got)
+	}
+	got = scaleDirtyRect(image.Rect(0, 0, 1000, 500), canvas, scaled)
+	if got != scaled {
+		t.Errorf("want %v got %v", scaled, got)
+	}
+}
+
+func TestFlipDirtyRect(t *testing.T) {
+	bounds := image.Rect(0, 0, 100, 50)
+	dirty := image.Rect(10, 5, 30, 15)
+	testData := []struct {
+		Flip Flip
+		Want image.Rectangle
+	}{
+		{Flip: FlipNone, Want: image.Rect(10, 5, 30, 15)},
+		{Flip: FlipX, Want: image.Rect(70, 5, 90, 15)},
+		{Flip: FlipY, Want: image.Rect(10, 35, 30, 45)},
+		{Flip: FlipXY, Want: image.Rect(70, 35, 90, 45)},
+	}
+	for i, data := range testData {
+		if got := flipDirtyRect(dirty, bounds, data.Flip); got != data.Want {
+			t.Errorf("#%d: want %v got %v", i, data.Want, got)
+		}
+	}
+}
+
+func TestTileSet(t *testing.T) {
+	s := newTileSet(image.Rect(0, 0, 300, 200), 128)
+	s.add([]image.Point{{0, 0}, {256, 128}})
+	s.add([]image.Point{{256, 128}, {0, 0}, {128, 0}, {384, 0}})
+	want := []image.Point{{0, 0}, {256, 128}, {128, 0}}
+	if len(s.tiles) != len(want) {
+		t.Fatalf("want %v got %v", want, s.tiles)
+	}
+	for i := range want {
+		if s.tiles[i] != want[i] {
+			t.Errorf("#%d: want %v got %v", i, want[i], s.tiles[i])
+		}
+	}
+	if got := s.coverage(); got != 0.5 {
+		t.Errorf("coverage: want 0.5 got %v", got)
+	}
+}
@@ -4,6 +4,7 @@ import (
 	"context"
 	"image"
 	"sync"
+	"sync/atomic"
 	"time"
 
 	"github.com/disintegration/gift"
@@ -11,6 +12,7 @@ import (
 	"github.com/oov/psd/composite"
 	"github.com/pkg/errors"
 
+	"psdtoolkit/nrgbapool"
 	"psdtoolkit/warn"
 )
 
@@ -64,6 +66,14 @@ type Image struct {
 
 	Modified bool
 
+	// changes counts edits of the state saved by SerializeProject, see MarkChanged
+	changes uint64
+
+	// RecycleBuffers releases replaced canvases to nrgbapool.
+	// Only set this when every image returned by RenderWithScale is consumed
+	// before the next call, because the returned canvas may be reused afterwards.
+	RecycleBuffers bool
+
 	Scale        float32
 	ScaleQuality ScaleQuality
 	OffsetX      int
@@ -73,12 +83,24 @@ type Image struct {
 	// Key is ScaleQuality, value is the downscaled image at img.Scale
 	scaledImages map[ScaleQuality]*image.NRGBA
 	scaledScale  float32 // The scale value when scaledImages was generated
+	// flippedImages keeps the flip destination per quality so it is not allocated every render
+	flippedImages map[ScaleQuality]*image.NRGBA
 	// pendingDirtyTiles tracks dirty tiles per quality for differential downscale
 	pendingDirtyTiles map[ScaleQuality][]image.Point
+	// mipmaps keeps halved canvases per quality; unlike scaledImages they survive scale changes
+	mipmaps map[ScaleQuality]*mipmap
+	// lastRender holds the parameters of the previous RenderWithScale call for dirty area tracking
+	lastRender *renderParams
 
 	PFV *PFV
 }
 
+type renderParams struct {
+	scale   float64
+	quality ScaleQuality
+	flip    Flip
+}
+
 func (img *Image) Touch() {
 	img.Toucher.Touch()
 }
@@ -90,6 +112,8 @@ func (img *Image) LastAccess() time.Time {
 func (img *Image) Clone() *Image {
 	r := *img
 	r.image = nil
+	r.flippedImages = nil
+	r.lastRender = nil
 	return &r
 }
 
@@ -113,6 +137,7 @@ func (img *Image) SetFlipX(v bool) bool {
 	}
 	img.Layers.SetFlip(f)
 	img.Layers.Flip = f
+	img.MarkChanged()
 	return true
 }
 
@@ -127,9 +152,22 @@ func (img *Image) SetFlipY(v bool) bool {
 		f &= ^FlipY
 	}
 	img.Layers.SetFlip(f)
+	img.MarkChanged()
 	return true
 }
 
+// MarkChanged records an edit of the layer, flip or PFV state.
+// Code that changes them directly instead of through Image methods has to call this.
+func (img *Image) MarkChanged() {
+	atomic.AddUint64(&img.changes, 1)
+}
+
+// Changes returns a counter that is increased by every edit of the state saved by SerializeProject.
+// The project state is unchanged while the counter stays the same.
+func (img *Image) Changes() uint64 {
+	return atomic.LoadUint64(&img.changes)
+}
+
 func (img *Image) ScaledCanvasRect() image.Rectangle {
 	r := img.PSD.CanvasRect
 	r.Max.X = r.Min.X + int(float32(r.Dx())*img.Scale+0.5)
@@ -151,20 +189,39 @@ func (img *Image) Render(ctx context.Context) (*image.NRGBA, error) {
 // When applyFlip is false, the returned image does not have flip applied, which is useful
 // when the caller wants to apply flip together with other transformations (e.g., offset) in a single pass.
 func (img *Image) RenderWithScale(ctx context.Context, scale float64, quality ScaleQuality, applyFlip bool) (*image.NRGBA, error) {
+	nrgba, _, err := img.RenderWithScaleDirty(ctx, scale, quality, applyFlip)
+	return nrgba, err
+}
+
+// RenderWithScaleDirty works like RenderWithScale, and also returns the area of the result that may differ
+// from the result of the previous call. When the previous call used a different scale, quality or flip state,
+// the whole image is reported. The area is in the coordinate space of the returned image and is empty
+// when nothing has changed.
+func (img *Image) RenderWithScaleDirty(ctx context.Context, scale float64, quality ScaleQuality, applyFlip bool) (*image.NRGBA, image.Rectangle, error) {
 	var err error
+	var dirty image.Rectangle
 	tileSize := img.PSD.Renderer.TileSize()
+	canvas := img.PSD.CanvasRect
 
 	if img.image == nil {
 		img.image = image.NewNRGBA(img.PSD.CanvasRect)
 		err = img.PSD.Renderer.Render(ctx, img.image)
+		if err != nil {
+			// A cancelled initial render leaves the canvas incomplete, so start over next time
+			img.image = nil
+			return nil, image.Rectangle{}, errors.Wrap(err, "img: render failed")
+		}
+		dirty = canvas
 		// Clear scaled cache on initial render
 		img.scaledImages = nil
 		img.pendingDirtyTiles = nil
+		img.mipmaps = nil
 	} else {
 		dirtyTiles, err2 := img.PSD.Renderer.RenderDiffWithDirtyTiles(ctx, img.image)
 		if err2 != nil {
-			return nil, errors.Wrap(err2, "img: render failed")
+			return nil, image.Rectangle{}, errors.Wrap(err2, "img: render failed")
 		}
+		dirty = tilesRect(dirtyTiles, tileSize, canvas)
 		// Accumulate dirty tiles for each quality
 		if len(dirtyTiles) > 0 {
 			if img.pendingDirtyTiles == nil {
@@ -172,30 +229,22 @@ func (img *Image) RenderWithScale(ctx context.Context, scale float64, quality Sc
 			}
 			img.pendingDirtyTiles[ScaleQualityFast] = append(img.pendingDirtyTiles[ScaleQualityFast], dirtyTiles...)
 			img.pendingDirtyTiles[ScaleQualityBeautiful] = append(img.pendingDirtyTiles[ScaleQualityBeautiful], dirtyTiles...)
+			for _, m := range img.mipmaps {
+				m.markDirty(dirtyTiles, tileSize, canvas)
+			}
 		}
 	}
-	if err != nil {
-		return nil, errors.Wrap(err, "img: render failed")
-	}
 	img.Modified = false
 
 	nrgba := img.image
 
 	// Handle downscaling if scale < 1
 	if scale < 1 {
-		// Calculate scaled rect
-		r := img.PSD.CanvasRect
-		r.Max.X = r.Min.X + int(float64(r.Dx())*scale+0.5)
-		r.Max.Y = r.Min.Y + int(float64(r.Dy())*scale+0.5)
-		if r.Dx() < 1 {
-			r.Max.X = r.Min.X + 1
-		}
-		if r.Dy() < 1 {
-			r.Max.Y = r.Min.Y + 1
-		}
+		r := scaleRect(canvas, scale)
 
 		// Check if we need to reset cache (scale changed)
 		if img.scaledScale != float32(scale) {
+			img.releaseScaledImages()
 			img.scaledImages = nil
 			img.pendingDirtyTiles = nil
 			img.scaledScale = float32(scale)
@@ -211,48 +260,63 @@ func (img *Image) RenderWithScale(ctx context.Context, scale float64, quality Sc
 
 		// Use differential downscale if we have pending dirty tiles and a cached image
 		if hasCached && len(pendingTiles) > 0 {
-			switch quality {
-			case ScaleQualityFast:
-				if err = downscale.NRGBAFastPartial(ctx, cached, img.image, tileSize, tileSize, pendingTiles); err != nil {
-					return nil, errors.Wrap(err, "img: partial downscale failed")
-				}
-			case ScaleQualityBeautiful:
-				if err = downscale.NRGBAGammaPartialWithTable(ctx, cached, img.image, getGammaTable22(), tileSize, tileSize, pendingTiles); err != nil {
-					return nil, errors.Wrap(err, "img: partial downscale failed")
-				}
+			if err = downscalePartial(ctx, quality, cached, img.image, tileSize, pendingTiles); err != nil {
+				return nil, image.Rectangle{}, errors.Wrap(err, "img: partial downscale failed")
 			}
+			dirty = scaleDirtyRect(tilesRect(pendingTiles, tileSize, canvas), canvas, r)
 			// Clear pending dirty tiles for this quality
 			img.pendingDirtyTiles[quality] = nil
 			nrgba = cached
 		} else if hasCached && len(pendingTiles) == 0 {
 			// No changes, use cached
 			nrgba = cached
+			dirty = image.Rectangle{}
 		} else {
-			// Full downscale (initial or cache miss)
-			tmp := image.NewNRGBA(r)
-			switch quality {
-			case ScaleQualityFast:
-				if err = downscale.NRGBAFast(ctx, tmp, img.image); err != nil {
-					return nil, errors.Wrap(err, "img: downscale failed")
+			// Cache miss (initial or scale changed): resample from the nearest mip level
+			// so that scale animations do not downscale the full canvas every frame.
+			src := img.image
+			dirty = r
+			if level := mipLevelForScale(scale); level > 0 {
+				if img.mipmaps == nil {
+					img.mipmaps = make(map[ScaleQuality]*mipmap)
+				}
+				m, ok := img.mipmaps[quality]
+				if !ok {
+					m = &mipmap{}
+					img.mipmaps[quality] = m
+				}
+				exists, pending := m.state(level)
+				if src, err = m.level(ctx, quality, img.image, tileSize, level); err != nil {
+					return nil, image.Rectangle{}, err
 				}
-			case ScaleQualityBeautiful:
-				if err = downscale.NRGBAGammaWithTable(ctx, tmp, img.image, getGammaTable22()); err != nil {
-					return nil, errors.Wrap(err, "img: downscale failed")
+				if exists && src.Rect == r {
+					// The mip level was returned as is last time, so only its updated area has changed
+					dirty = scaleDirtyRect(tilesRect(pending, tileSize, canvas), canvas, r)
 				}
 			}
-			img.scaledImages[quality] = tmp
-			// Clear pending dirty tiles since we did full downscale
+			if src.Rect == r {
+				// The mip level already has the requested size
+				nrgba = src
+			} else {
+				tmp := nrgbapool.Get(r)
+				if err = downscaleFull(ctx, quality, tmp, src); err != nil {
+					nrgbapool.Put(tmp)
+					return nil, image.Rectangle{}, errors.Wrap(err, "img: downscale failed")
+				}
+				img.scaledImages[quality] = tmp
+				nrgba = tmp
+			}
+			// Clear pending dirty tiles since the result is up to date
 			if img.pendingDirtyTiles != nil {
 				img.pendingDirtyTiles[quality] = nil
 			}
-			nrgba = tmp
 		}
 	}
 
 	// Apply flip (only if requested)
 	f := img.Layers.Flip
 	if applyFlip && f != FlipNone {
-		tmp := image.NewNRGBA(nrgba.Rect)
+		tmp := img.flipBuffer(quality, nrgba.Rect)
 		g := gift.New()
 		if f == FlipX || f == FlipXY {
 			g.Add(gift.FlipHorizontal())
@@ -262,8 +326,66 @@ func (img *Image) RenderWithScale(ctx context.Context, scale float64, quality Sc
 		}
 		g.Draw(tmp, nrgba)
 		nrgba = tmp
+		dirty = flipDirtyRect(dirty, nrgba.Rect, f)
+	} else {
+		f = FlipNone
+	}
+	last := renderParams{scale: scale, quality: quality, flip: f}
+	if img.lastRender == nil || *img.lastRender != last {
+		dirty = nrgba.Rect
+		img.lastRender = &last
+	}
+	return nrgba, dirty, nil
+}
+
+// flipBuffer returns the cached flip destination for quality, reallocating it when the size has changed.
+func (img *Image) flipBuffer(quality ScaleQuality, r image.Rectangle) *image.NRGBA {
+	if buf := img.flippedImages[quality]; buf != nil {
+		if buf.Rect == r {
+			return buf
+		}
+		if img.RecycleBuffers {
+			nrgbapool.Put(buf)
+		}
+	}
+	if img.flippedImages == nil {
+		img.flippedImages = make(map[ScaleQuality]*image.NRGBA)
 	}
-	return nrgba, nil
+	buf := nrgbapool.Get(r)
+	img.flippedImages[quality] = buf
+	return buf
+}
+
+func (img *Image) releaseScaledImages() {
+	if !img.RecycleBuffers {
+		img.flippedImages = nil
+		return
+	}
+	for _, scaled := range img.scaledImages {
+		nrgbapool.Put(scaled)
+	}
+	for _, flipped := range img.flippedImages {
+		nrgbapool.Put(flipped)
+	}
+	img.flippedImages = nil
+}
+
+// ReleaseBuffers returns all cached canvases to nrgbapool if RecycleBuffers is set.
+// The image can still be rendered afterwards, but has to be rendered from scratch.
+func (img *Image) ReleaseBuffers() {
+	if !img.RecycleBuffers {
+		return
+	}
+	img.releaseScaledImages()
+	for _, m := range img.mipmaps {
+		m.release()
+	}
+	nrgbapool.Put(img.image)
+	img.image = nil
+	img.lastRender = nil
+	img.scaledImages = nil
+	img.pendingDirtyTiles = nil
+	img.mipmaps = nil
 }
 
 func (img *Image) Serialize() (string, error) {
@@ -279,6 +401,9 @@ func (img *Image) Deserialize(s string) (bool, error) {
 	if err != nil {
 		return false, err
 	}
+	if m {
+		img.MarkChanged()
+	}
 	return m, nil
 }
 
@@ -320,5 +445,6 @@ func (img *Image) DeserializeProject(state *ProjectState) (warn.Warning, error)
 	} else if w != nil {
 		wr = append(wr, w...)
 	}
+	img.MarkChanged()
 	return wr, nil
 }
@@ -0,0 +1,138 @@
+package img
+
+import (
+	"context"
+	"image"
+
+	"github.com/oov/downscale"
+	"github.com/pkg/errors"
+
+	"psdtoolkit/nrgbapool"
+)
+
+// maxMipLevel limits the depth of the mip pyramid (1/2 ... 1/256).
+const maxMipLevel = 8
+
+// mipmap holds progressively halved copies of the full resolution canvas for one ScaleQuality.
+// Levels are generated lazily and survive scale changes, so animating the scale only needs
+// a cheap resample from the nearest level instead of a full downscale of the canvas.
+//
+// Every level is generated directly from the full resolution canvas, which keeps the
+// dirty tile coordinates reported by the renderer valid for partial updates of any level.
+type mipmap struct {
+	levels  []*image.NRGBA // levels[i] is the canvas at 1/2^(i+1), nil until requested
+	pending []*tileSet     // dirty tiles not yet applied to levels[i], nil if there are none
+}
+
+// maxPendingCoverage is the ratio of dirty tiles above which a level is dropped instead of
+// updated, regenerating it from scratch is cheaper than a partial update of most of it.
+const maxPendingCoverage = 0.5
+
+// scaleRect returns r scaled by scale, keeping at least 1x1 pixel.
+func scaleRect(r image.Rectangle, scale float64) image.Rectangle {
+	r.Max.X = r.Min.X + int(float64(r.Dx())*scale+0.5)
+	r.Max.Y = r.Min.Y + int(float64(r.Dy())*scale+0.5)
+	if r.Dx() < 1 {
+		r.Max.X = r.Min.X + 1
+	}
+	if r.Dy() < 1 {
+		r.Max.Y = r.Min.Y + 1
+	}
+	return r
+}
+
+// mipLevelForScale returns the deepest mip level whose scale is still greater than or equal to scale.
+// Level 0 means the full resolution canvas.
+func mipLevelForScale(scale float64) int {
+	level := 0
+	for level < maxMipLevel && scale <= 1/float64(uint(2)<<level) {
+		level++
+	}
+	return level
+}
+
+func downscaleFull(ctx context.Context, quality ScaleQuality, dst, src *image.NRGBA) error {
+	switch quality {
+	case ScaleQualityFast:
+		return downscale.NRGBAFast(ctx, dst, src)
+	case ScaleQualityBeautiful:
+		return downscale.NRGBAGammaWithTable(ctx, dst, src, getGammaTable22())
+	}
+	return errors.Errorf("img: unknown scale quality %d", quality)
+}
+
+func downscalePartial(ctx context.Context, quality ScaleQuality, dst, src *image.NRGBA, tileSize int, tiles []image.Point) error {
+	switch quality {
+	case ScaleQualityFast:
+		return downscale.NRGBAFastPartial(ctx, dst, src, tileSize, tileSize, tiles)
+	case ScaleQualityBeautiful:
+		return downscale.NRGBAGammaPartialWithTable(ctx, dst, src, getGammaTable22(), tileSize, tileSize, tiles)
+	}
+	return errors.Errorf("img: unknown scale quality %d", quality)
+}
+
+// markDirty records dirty tiles of canvas for every generated level.
+// Levels that are mostly dirty are dropped, so an unused level does not keep collecting tiles.
+func (m *mipmap) markDirty(tiles []image.Point, tileSize int, canvas image.Rectangle) {
+	for i, l := range m.levels {
+		if l == nil {
+			continue
+		}
+		if m.pending[i] == nil {
+			m.pending[i] = newTileSet(canvas, tileSize)
+		}
+		m.pending[i].add(tiles)
+		if m.pending[i].coverage() > maxPendingCoverage {
+			// Not returned to nrgbapool, the level may have been handed out by the last render
+			m.levels[i] = nil
+			m.pending[i] = nil
+		}
+	}
+}
+
+// state reports whether level has been generated and which dirty tiles are not yet applied to it.
+func (m *mipmap) state(level int) (bool, []image.Point) {
+	i := level - 1
+	if i >= len(m.levels) || m.levels[i] == nil {
+		return false, nil
+	}
+	if m.pending[i] == nil {
+		return true, nil
+	}
+	return true, m.pending[i].tiles
+}
+
+// level returns the up-to-date mip level of src. level must be 1 or greater.
+func (m *mipmap) level(ctx context.Context, quality ScaleQuality, src *image.NRGBA, tileSize int, level int) (*image.NRGBA, error) {
+	for len(m.levels) < level {
+		m.levels = append(m.levels, nil)
+		m.pending = append(m.pending, nil)
+	}
+	i := level - 1
+	if m.levels[i] == nil {
+		l := nrgbapool.Get(scaleRect(src.Rect, 1/float64(uint(1)<<level)))
+		if err := downscaleFull(ctx, quality, l, src); err != nil {
+			nrgbapool.Put(l)
+			return nil, errors.Wrap(err, "img: mipmap generation failed")
+		}
+		m.levels[i] = l
+		m.pending[i] = nil
+		return l, nil
+	}
+	if m.pending[i] != nil {
+		if err := downscalePartial(ctx, quality, m.levels[i], src, tileSize, m.pending[i].tiles); err != nil {
+			return nil, errors.Wrap(err, "img: partial mipmap update failed")
+		}
+		m.pending[i] = nil
+	}
+	return m.levels[i], nil
+}
+
+// release returns all generated levels to nrgbapool.
+func (m *mipmap) release() {
+	for _, l := range m.levels {
+		nrgbapool.Put(l)
+	}
+	m.levels = nil
+	m.pending = nil
+}
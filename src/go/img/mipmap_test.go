@@ -0,0 +1,69 @@
+package img
+
+import (
+	"image"
+	"testing"
+)
+
+func TestMipLevelForScale(t *testing.T) {
+	testData := []struct {
+		Scale float64
+		Want  int
+	}{
+		{Scale: 1, Want: 0},
+		{Scale: 0.75, Want: 0},
+		{Scale: 0.5, Want: 1},
+		{Scale: 0.3, Want: 1},
+		{Scale: 0.25, Want: 2},
+		{Scale: 0.2, Want: 2},
+		{Scale: 0.125, Want: 3},
+		{Scale: 0.00001, Want: maxMipLevel},
+	}
+	for i, data := range testData {
+		if got := mipLevelForScale(data.Scale); data.Want != got {
+			t.Errorf("#%d: scale %v want %d got %d", i, data.Scale, data.Want, got)
+		}
+	}
+}
+
+func TestMipLevelIsLargeEnough(t *testing.T) {
+	canvas := image.Rect(0, 0, 1001, 777)
+	for scale := 0.001; scale < 1; scale += 0.001 {
+		level := mipLevelForScale(scale)
+		lr := scaleRect(canvas, 1/float64(uint(1)<<level))
+		r := scaleRect(canvas, scale)
+		if lr.Dx() < r.Dx() || lr.Dy() < r.Dy() {
+			t.Fatalf("scale %v: level %d (%v) is smaller than %v", scale, level, lr, r)
+		}
+	}
+}
+
+func TestMipmapMarkDirty(t *testing.T) {
+	canvas := image.Rect(0, 0, 512, 512)
+	m := &mipmap{
+		levels:  []*image.NRGBA{image.NewNRGBA(scaleRect(canvas, 0.5)), nil},
+		pending: []*tileSet{nil, nil},
+	}
+	// Repeated edits of the same area must not grow the pending list
+	for i := 0; i < 100; i++ {
+		m.markDirty([]image.Point{{0, 0}, {64, 0}}, 64, canvas)
+	}
+	if exists, pending := m.state(1); !exists || len(pending) != 2 {
+		t.Fatalf("want 2 pending tiles got %v (exists %v)", pending, exists)
+	}
+	if m.pending[1] != nil {
+		t.Errorf("level that has not been generated should not collect tiles")
+	}
+
+	// A level that is mostly dirty is dropped and regenerated on the next request
+	var tiles []image.Point
+	for y := 0; y < 512; y += 64 {
+		for x := 0; x < 512; x += 64 {
+			tiles = append(tiles, image.Pt(x, y))
+		}
+	}
+	m.markDirty(tiles[:40], 64, canvas)
+	if exists, _ := m.state(1); exists {
+		t.Errorf("want level to be dropped")
+	}
+}
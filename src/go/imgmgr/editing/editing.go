@@ -73,9 +73,16 @@ func (t *Thumbnailer) Update(img image.Image) {
 			// TODO: report error
 			return
 		}
+		// Encode here once, so that saving the project does not have to encode every thumbnail again
+		var b bytes.Buffer
+		if err := png.Encode(&b, thumb); err != nil {
+			// TODO: report error
+			return
+		}
 		t.editing.Requests <- UpdateThumbnailReq{
 			Index:     index,
 			Thumbnail: thumb,
+			PNG:       b.Bytes(),
 		}
 	})
 }
@@ -88,6 +95,11 @@ type Item struct {
 	LatestState string
 	Thumbnail   *image.NRGBA
 	ViewState   *img.ViewState // View settings (zoom, scroll) for this image
+
+	thumbnailPNG []byte // Thumbnail encoded as PNG
+	// encoded caches the serialized form of this item, valid while Image.Changes() is encodedChanges.
+	encoded        json.RawMessage
+	encodedChanges uint64
 }
 
 // Snapshot is a read-only copy of the editing state for GUI consumption.
@@ -198,13 +210,17 @@ func (ed *Editing) handle(req any) {
 
 	case UpdateThumbnailReq:
 		if r.Index >= 0 && r.Index < len(ed.images) {
-			ed.images[r.Index].Thumbnail = r.Thumbnail
+			it := &ed.images[r.Index]
+			it.Thumbnail = r.Thumbnail
+			it.thumbnailPNG = r.PNG
+			it.encoded = nil
 			ed.notifyChange()
 		}
 
 	case UpdateViewStateReq:
 		if r.Index >= 0 && r.Index < len(ed.images) {
 			ed.images[r.Index].ViewState = r.ViewState
+			ed.images[r.Index].encoded = nil
 			// No need to notify change for view state updates
 		}
 
@@ -314,27 +330,64 @@ type serializeRoot struct {
 	Images        []serializeData `json:"images"`
 }
 
+// encodedRoot is serializeRoot with already encoded images, so unchanged images can be written as is.
+type encodedRoot struct {
+	Version       int               `json:"version"`
+	SplitterWidth float32           `json:"splitterWidth,omitempty"`
+	Images        []json.RawMessage `json:"images"`
+}
+
+// encodedData is serializeData with an already encoded project state.
+type encodedData struct {
+	Image     json.RawMessage
+	Tag       int
+	Thumbnail []byte
+}
+
+// encode returns the serialized form of the item.
+// The result is cached and only rebuilt when the project state, the view state or the thumbnail has changed.
+func (it *Item) encode() (json.RawMessage, error) {
+	// Read the counter first, so an edit made while marshaling invalidates the result
+	changes := it.Image.Changes()
+	if it.encoded != nil && it.encodedChanges == changes {
+		return it.encoded, nil
+	}
+	ps := it.Image.SerializeProject()
+	// Include view state if available
+	ps.ViewState = it.ViewState
+	state, err := json.Marshal(ps)
+	if err != nil {
+		return nil, err
+	}
+	if it.thumbnailPNG == nil && it.Thumbnail != nil {
+		b := bytes.NewBufferString("")
+		if err := png.Encode(b, it.Thumbnail); err == nil {
+			it.thumbnailPNG = b.Bytes()
+		}
+	}
+	encoded, err := json.Marshal(encodedData{
+		Image:     state,
+		Tag:       it.Tag,
+		Thumbnail: it.thumbnailPNG,
+	})
+	if err != nil {
+		return nil, err
+	}
+	it.encoded, it.encodedChanges = encoded, changes
+	return encoded, nil
+}
+
 func (ed *Editing) serialize() (string, error) {
-	var images []serializeData
-	for _, item := range ed.images {
-		var thumb []byte
-		if item.Thumbnail != nil {
-			b := bytes.NewBufferString("")
-			if err := png.Encode(b, item.Thumbnail); err == nil {
-				thumb = b.Bytes()
-			}
+	var images []json.RawMessage
+	for i := range ed.images {
+		b, err := ed.images[i].encode()
+		if err != nil {
+			return "", err
 		}
-		ps := item.Image.SerializeProject()
-		// Include view state if available
-		ps.ViewState = item.ViewState
-		images = append(images, serializeData{
-			Image:     ps,
-			Tag:       item.Tag,
-			Thumbnail: thumb,
-		})
+		images = append(images, b)
 	}
 
-	root := serializeRoot{
+	root := encodedRoot{
 		Version:       1,
 		SplitterWidth: ed.SplitterWidth,
 		Images:        images,
@@ -400,6 +453,8 @@ func (ed *Editing) deserialize(state string) error {
 			if decoded, err := png.Decode(bytes.NewReader(d.Thumbnail)); err == nil {
 				it.Thumbnail = image.NewNRGBA(decoded.Bounds())
 				draw.Draw(it.Thumbnail, it.Thumbnail.Rect, decoded, image.Point{}, draw.Over)
+				// Keep the loaded PNG so it is not encoded again on the next save
+				it.thumbnailPNG = d.Thumbnail
 			}
 		}
 
@@ -1,7 +1,9 @@
 package editing
 
 import (
+	"bytes"
 	"encoding/json"
+	"image"
 	"testing"
 
 	"psdtoolkit/img"
@@ -158,3 +160,78 @@ func TestViewStateOmitEmpty(t *testing.T) {
 		t.Errorf("values should be zero after round-trip")
 	}
 }
+
+func TestSerializeReusesEncodedItems(t *testing.T) {
+	path := "/test/cached.psd"
+	thumb := image.NewNRGBA(image.Rect(0, 0, 4, 4))
+	ed := &Editing{
+		SplitterWidth: 320,
+		images: []Item{
+			{
+				Image:     &img.Image{FilePath: &path, Layers: &img.LayerManager{}},
+				Tag:       7,
+				Thumbnail: thumb,
+				ViewState: &img.ViewState{Zoom: 2},
+			},
+		},
+	}
+
+	s1, err := ed.serialize()
+	if err != nil {
+		t.Fatalf("failed to serialize: %v", err)
+	}
+	png1 := ed.images[0].thumbnailPNG
+	if png1 == nil {
+		t.Fatal("thumbnail PNG is not cached")
+	}
+
+	var root serializeRoot
+	if err := json.Unmarshal([]byte(s1), &root); err != nil {
+		t.Fatalf("failed to unmarshal: %v", err)
+	}
+	if root.Version != 1 || root.SplitterWidth != 320 || len(root.Images) != 1 {
+		t.Fatalf("unexpected root: %+v", root)
+	}
+	d := root.Images[0]
+	if d.Tag != 7 || d.Image.FilePath != path || d.Image.ViewState == nil || d.Image.ViewState.Zoom != 2 {
+		t.Errorf("unexpected image data: %+v", d)
+	}
+	if !bytes.Equal(d.Thumbnail, png1) {
+		t.Error("thumbnail does not match the cached PNG")
+	}
+
+	// Unchanged item is written from the cache
+	encoded := ed.images[0].encoded
+	s2, err := ed.serialize()
+	if err != nil {
+		t.Fatalf("failed to serialize: %v", err)
+	}
+	if s1 != s2 {
+		t.Errorf("output changed without modification:\n%s\n%s", s1, s2)
+	}
+	if &ed.images[0].encoded[0] != &encoded[0] {
+		t.Error("unchanged item was encoded again")
+	}
+
+	// An edit of the project state invalidates the cache
+	ed.images[0].Image.MarkChanged()
+	if _, err := ed.serialize(); err != nil {
+		t.Fatalf("failed to serialize: %v", err)
+	}
+	if &ed.images[0].encoded[0] == &encoded[0] {
+		t.Error("changed item was not encoded again")
+	}
+
+	// Changing the view state invalidates the cache, but the thumbnail is not encoded again
+	ed.handle(UpdateViewStateReq{Index: 0, ViewState: &img.ViewState{Zoom: 3}})
+	s3, err := ed.serialize()
+	if err != nil {
+		t.Fatalf("failed to serialize: %v", err)
+	}
+	if s3 == s1 {
+		t.Error("output did not change after modification")
+	}
+	if &ed.images[0].thumbnailPNG[0] != &png1[0] {
+		t.Error("thumbnail was encoded again")
+	}
+}
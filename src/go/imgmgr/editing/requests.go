@@ -96,6 +96,7 @@ type SelectReq struct {
 type UpdateThumbnailReq struct {
 	Index     int
 	Thumbnail *image.NRGBA
+	PNG       []byte // Thumbnail encoded as PNG, stored as is on serialize
 }
 
 // UpdateViewStateReq requests to update the view state for an item.
@@ -28,6 +28,8 @@ func (tp *Temporary) Load(id int, filePath string) (*img.Image, error) {
 	if err != nil {
 		return nil, errors.Wrapf(err, "temporary: failed to load %q", filePath)
 	}
+	// Rendered results are copied out immediately, so canvases can be recycled.
+	nimg.RecycleBuffers = true
 	if tp.images == nil {
 		tp.images = make(map[Key]*img.Image)
 	}
@@ -41,6 +43,7 @@ func (tp *Temporary) GC() {
 
 	for k, v := range tp.images {
 		if now.Sub(v.LastAccess()) > deadline {
+			v.ReleaseBuffers()
 			delete(tp.images, k)
 		}
 	}
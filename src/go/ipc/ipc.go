@@ -14,9 +14,11 @@ import (
 
 	"github.com/pkg/errors"
 
+	"psdtoolkit/gc"
 	"psdtoolkit/img"
 	"psdtoolkit/imgmgr/source"
 	"psdtoolkit/imgmgr/temporary"
+	"psdtoolkit/nrgbapool"
 	"psdtoolkit/ods"
 )
 
@@ -65,6 +67,46 @@ type cacheValue struct {
 	Data       []byte
 }
 
+type objectKey struct {
+	ID       int
+	FilePath string
+}
+
+// drawnFrame identifies the frame rendered last for an object.
+type drawnFrame struct {
+	Key   cacheKey
+	CKey  uint64 // cache key used by the plugin side to store the frame
+	FlipX bool
+	FlipY bool
+}
+
+// drawResult describes the data written to shared memory by draw.
+//
+// A full frame is width*height*4 bytes of BGRA pixels.
+// A delta frame only holds the pixels of Rects packed row by row, and must be applied
+// on top of the frame that the plugin side stored with the cache key Base.
+type drawResult struct {
+	DataLen int
+	Base    uint64 // 0 for a full frame
+	Rects   []image.Rectangle
+}
+
+// deltaWorthwhile reports whether sending the area dirty as a delta frame is cheaper than a full frame.
+// Small patches are what lipsync and blink animations produce; large ones are not worth
+// the reconstruction cost on the plugin side.
+func deltaWorthwhile(dirty image.Rectangle, width, height int) bool {
+	return dirty.Dx()*dirty.Dy()*2 <= width*height
+}
+
+// sameLayout reports whether a frame rendered with key and flip state has the same pixel layout as f,
+// so that the dirty area reported by the renderer can be applied on top of f.
+func (f *drawnFrame) sameLayout(key *cacheKey, flipX, flipY bool) bool {
+	return f.Key.Width == key.Width && f.Key.Height == key.Height &&
+		f.Key.OffsetX == key.OffsetX && f.Key.OffsetY == key.OffsetY &&
+		f.Key.Scale == key.Scale && f.Key.ScaleQuality == key.ScaleQuality &&
+		f.FlipX == flipX && f.FlipY == flipY
+}
+
 type IPC struct {
 	AddFile                  func(file string, tag int) error
 	UpdateCurrentProjectPath func(file string) error
@@ -79,6 +121,11 @@ type IPC struct {
 	cache  map[cacheKey]cacheValue
 	shm    *SharedMemory
 
+	// lastDrawn holds the last rendered frame per object, used to update only the dirty area on the next miss
+	lastDrawn map[objectKey]drawnFrame
+	// shmFrame identifies the frame currently held in shared memory, nil if unknown
+	shmFrame *cacheKey
+
 	queue     chan func()
 	reply     chan error
 	replyDone chan struct{}
@@ -97,27 +144,37 @@ func (ipc *IPC) load(id int, filePath string) (*img.Image, error) {
 	return ipc.tmpImg.Load(id, filePath)
 }
 
-func (ipc *IPC) draw(id int, filePath string, width, height int, shmResized bool) (dataLen int, err error) {
+// draw renders the image and writes it to shared memory.
+// ckey is the key the plugin side stores the frame with. If allowDelta is true, the result may be
+// a delta frame based on the previous frame of the same object.
+func (ipc *IPC) draw(id int, filePath string, width, height int, shmResized bool, ckey64 uint64, allowDelta bool) (res drawResult, err error) {
 	if ipc.shm == nil {
-		return 0, errors.New("ipc: shared memory not available")
+		return res, errors.New("ipc: shared memory not available")
 	}
 
-	dataLen = width * height * 4
+	dataLen := width * height * 4
 
 	// Open shared memory (always open fresh to allow C side to resize)
 	if err = ipc.shm.EnsureOpen(true); err != nil {
-		return 0, errors.Wrap(err, "ipc: could not open shared memory")
+		return res, errors.Wrap(err, "ipc: could not open shared memory")
 	}
 	// Close when done to allow C side to resize if needed
 	defer ipc.shm.Close()
 
+	// The contents of shared memory are unknown until this draw completes
+	shmFrame := ipc.shmFrame
+	ipc.shmFrame = nil
+	if shmResized {
+		shmFrame = nil
+	}
+
 	img, err := ipc.tmpImg.Load(id, filePath)
 	if err != nil {
-		return 0, errors.Wrap(err, "ipc: could not load")
+		return res, errors.Wrap(err, "ipc: could not load")
 	}
 	state, err := img.Serialize()
 	if err != nil {
-		return 0, errors.Wrap(err, "ipc: could not serialize state")
+		return res, errors.Wrap(err, "ipc: could not serialize state")
 	}
 
 	ckey := cacheKey{
@@ -139,17 +196,24 @@ func (ipc *IPC) draw(id int, filePath string, width, height int, shmResized bool
 		img.Modified = false
 		// Copy cached data to shared memory (sequential copy)
 		copy(ipc.shm.GetBuffer(dataLen), cv.Data)
-		return dataLen, nil
+		ipc.shmFrame = &ckey
+		res.DataLen = dataLen
+		return res, nil
 	}
 
+	okey := objectKey{ID: id, FilePath: filePath}
+	prev, hasPrev := ipc.lastDrawn[okey]
+	// The renderer reports changes relative to its previous call, so forget it until this draw succeeds
+	delete(ipc.lastDrawn, okey)
+
 	// Use RenderWithScale for differential rendering support.
 	// applyFlip=false: flip is NOT applied here - it will be done on GPU side
 	// via AviUtl's flip filter (obj.effect("反転")) for better performance.
 	// The flip info is sent to Lua via set_props, and Lua applies the flip filter.
 	// See copyWithOffsetBGRA() for details on how offset is adjusted for GPU flip.
-	nrgba, err := img.RenderWithScale(context.Background(), float64(img.Scale), img.ScaleQuality, false)
+	nrgba, dirty, err := img.RenderWithScaleDirty(context.Background(), float64(img.Scale), img.ScaleQuality, false)
 	if err != nil {
-		return 0, errors.Wrap(err, "ipc: could not render")
+		return res, errors.Wrap(err, "ipc: could not render")
 	}
 
 	offsetX := int(float32(-img.OffsetX) * img.Scale)
@@ -159,19 +223,74 @@ func (ipc *IPC) draw(id int, filePath string, width, height int, shmResized bool
 
 	// First write to regular memory (random access is fast)
 	// copyWithOffsetBGRA handles offset inversion for GPU-side flip
-	ret := image.NewNRGBA(image.Rect(0, 0, width, height))
-	copyWithOffsetBGRA(ret, nrgba, offsetX, offsetY, flipX, flipY)
+	// and overwrites every pixel, so a recycled buffer can be used as is.
+	ret := nrgbapool.Get(image.Rect(0, 0, width, height))
+	full := image.Rect(0, 0, width, height)
+	dstDirty := full
+	partial := hasPrev && prev.sameLayout(&ckey, flipX, flipY)
+	if partial {
+		dstDirty = dirtyRectWithOffset(ret, nrgba, dirty, offsetX, offsetY, flipX, flipY)
+	}
+	pv, hasPrevData := ipc.cache[prev.Key]
+	basedOnPrev := partial && hasPrevData
+	if basedOnPrev {
+		// Only the dirty area differs from the previous frame of this object
+		copy(ret.Pix, pv.Data)
+		copyRectWithOffsetBGRA(ret, nrgba, offsetX, offsetY, flipX, flipY, dstDirty)
+	} else {
+		copyWithOffsetBGRA(ret, nrgba, offsetX, offsetY, flipX, flipY)
+	}
 
 	// Then copy to shared memory (sequential copy is faster than random access)
-	copy(ipc.shm.GetBuffer(dataLen), ret.Pix)
+	if basedOnPrev && allowDelta && prev.CKey != 0 && deltaWorthwhile(dstDirty, width, height) {
+		// Only send the dirty area; the plugin side stores it as a patch on top of the previous frame
+		n := dstDirty.Dx() * 4
+		buf := ipc.shm.GetBuffer(n * dstDirty.Dy())
+		for y, o := dstDirty.Min.Y, 0; y < dstDirty.Max.Y; y, o = y+1, o+n {
+			lo := y*ret.Stride + dstDirty.Min.X*4
+			copy(buf[o:o+n], ret.Pix[lo:lo+n])
+		}
+		res.DataLen = n * dstDirty.Dy()
+		res.Base = prev.CKey
+		if !dstDirty.Empty() {
+			res.Rects = []image.Rectangle{dstDirty}
+		}
+		// Shared memory no longer holds a full frame
+		ipc.shmFrame = nil
+	} else {
+		ipc.copyFrameToShm(ret.Pix, dstDirty, ret.Stride, partial && shmFrame != nil && *shmFrame == prev.Key)
+		res.DataLen = dataLen
+		ipc.shmFrame = &ckey
+	}
 
 	// Cache the data
 	ipc.cache[ckey] = cacheValue{
 		LastAccess: time.Now(),
 		Data:       ret.Pix,
 	}
+	ipc.lastDrawn[okey] = drawnFrame{
+		Key:   ckey,
+		CKey:  ckey64,
+		FlipX: flipX,
+		FlipY: flipY,
+	}
 
-	return dataLen, nil
+	return res, nil
+}
+
+// copyFrameToShm copies a full frame to shared memory.
+// If onlyDirty is true, shared memory already holds the previous frame and only the rows of dirty are copied.
+func (ipc *IPC) copyFrameToShm(pix []byte, dirty image.Rectangle, stride int, onlyDirty bool) {
+	buf := ipc.shm.GetBuffer(len(pix))
+	if onlyDirty {
+		// Shared memory still holds the previous frame, so transfer only the dirty rows
+		lo, hi := dirty.Min.Y*stride, dirty.Max.Y*stride
+		if lo < hi {
+			copy(buf[lo:hi], pix[lo:hi])
+		}
+	} else {
+		copy(buf, pix)
+	}
 }
 
 func (ipc *IPC) getLayerNames(id int, filePath string) (string, error) {
@@ -407,19 +526,40 @@ func (ipc *IPC) dispatch(cmd string) error {
 			return err
 		}
 		shmResized := shmResizedInt != 0
-		ods.ODS("  Width: %d / Height: %d / ShmResized: %v", width, height, shmResized)
-		dataLen, err := ipc.draw(id, filePath, width, height, shmResized)
+		ckey, err := readUInt64()
+		if err != nil {
+			return err
+		}
+		allowDelta, err := readBool()
+		if err != nil {
+			return err
+		}
+		ods.ODS("  Width: %d / Height: %d / ShmResized: %v / CacheKey: %016x / AllowDelta: %v", width, height, shmResized, ckey, allowDelta)
+		res, err := ipc.draw(id, filePath, width, height, shmResized, ckey, allowDelta)
 		if err != nil {
 			return err
 		}
-		// Write reply: success flag, data length
+		// Write reply: success flag, data length, base cache key, patched rectangles
 		if err = writeUint32(0x80000000); err != nil {
 			return err
 		}
-		if err = writeInt32(int32(dataLen)); err != nil {
+		if err = writeInt32(int32(res.DataLen)); err != nil {
+			return err
+		}
+		if err = writeUint64(res.Base); err != nil {
+			return err
+		}
+		if err = writeInt32(int32(len(res.Rects))); err != nil {
 			return err
 		}
-		ods.ODS("  -> SharedMem(Len: %d)", dataLen)
+		for _, r := range res.Rects {
+			for _, v := range [4]int{r.Min.X, r.Min.Y, r.Dx(), r.Dy()} {
+				if err = writeInt32(int32(v)); err != nil {
+					return err
+				}
+			}
+		}
+		ods.ODS("  -> SharedMem(Len: %d / Base: %016x / Rects: %v)", res.DataLen, res.Base, res.Rects)
 		return nil
 
 	case "LNAM":
@@ -613,9 +753,15 @@ func (ipc *IPC) gc() {
 
 	for k, v := range ipc.cache {
 		if now.Sub(v.LastAccess) > deadline {
+			nrgbapool.PutPix(v.Data)
 			delete(ipc.cache, k)
 		}
 	}
+	for k, v := range ipc.lastDrawn {
+		if _, ok := ipc.cache[v.Key]; !ok {
+			delete(ipc.lastDrawn, k)
+		}
+	}
 }
 
 func (ipc *IPC) Main(exitCh chan<- struct{}) {
@@ -648,6 +794,7 @@ func (ipc *IPC) Main(exitCh chan<- struct{}) {
 				return
 			}
 			ods.ODS("%s", cmd)
+			gc.Touch()
 			if err := ipc.dispatch(cmd); err != nil {
 				ods.ODS("error: %v", err)
 				if err = writeReply(err); err != nil {
@@ -670,6 +817,8 @@ func New(srcs *source.Sources) *IPC {
 		cache:  map[cacheKey]cacheValue{},
 		shm:    shm,
 
+		lastDrawn: map[objectKey]drawnFrame{},
+
 		queue:     make(chan func()),
 		reply:     make(chan error),
 		replyDone: make(chan struct{}),
@@ -679,6 +828,8 @@ func New(srcs *source.Sources) *IPC {
 
 // RenderScaled renders an image at a specific scale with the given quality.
 // This method is safe to call from any goroutine as it uses the IPC queue for serialization.
+// When ctx is cancelled, the render stops at the next tile and its partial result is discarded,
+// so a superseded preview request does not delay the newer one.
 func (ipc *IPC) RenderScaled(ctx context.Context, im *img.Image, scale float64, quality img.ScaleQuality) (*image.NRGBA, error) {
 	var result *image.NRGBA
 	var err error
@@ -686,8 +837,12 @@ func (ipc *IPC) RenderScaled(ctx context.Context, im *img.Image, scale float64,
 	done := make(chan struct{})
 	select {
 	case ipc.queue <- func() {
+		defer close(done)
+		if err = ctx.Err(); err != nil {
+			// Superseded while waiting in the queue
+			return
+		}
 		result, err = im.RenderWithScale(ctx, scale, quality, true)
-		close(done)
 	}:
 	case <-ctx.Done():
 		return nil, ctx.Err()
@@ -37,9 +37,20 @@ func nrgbaToNBGRA(p []byte) {
 // Example: if flipY is on and offsetY is +100, we use -100 so the final position
 // after GPU flip matches what it would be if we did CPU flip with +100 offset.
 //
+// Every pixel of dst is overwritten, so dst does not need to be cleared beforehand.
+//
 // Uses parallel processing for performance.
 func copyWithOffsetBGRA(dst, src *image.NRGBA, offsetX, offsetY int, flipX, flipY bool) {
-	dstW, dstH := dst.Rect.Dx(), dst.Rect.Dy()
+	copyRectWithOffsetBGRA(dst, src, offsetX, offsetY, flipX, flipY, image.Rect(0, 0, dst.Rect.Dx(), dst.Rect.Dy()))
+}
+
+// copyRectWithOffsetBGRA works like copyWithOffsetBGRA but only writes the area r of dst.
+// r is relative to the top-left corner of dst.
+func copyRectWithOffsetBGRA(dst, src *image.NRGBA, offsetX, offsetY int, flipX, flipY bool, r image.Rectangle) {
+	r = r.Intersect(image.Rect(0, 0, dst.Rect.Dx(), dst.Rect.Dy()))
+	if r.Empty() {
+		return
+	}
 	srcW, srcH := src.Rect.Dx(), src.Rect.Dy()
 
 	// Invert offset for flipped axes to maintain correct positioning after GPU flip
@@ -52,16 +63,16 @@ func copyWithOffsetBGRA(dst, src *image.NRGBA, offsetX, offsetY int, flipX, flip
 	}
 
 	numWorkers := runtime.NumCPU()
-	rowsPerWorker := (dstH + numWorkers - 1) / numWorkers
+	rowsPerWorker := (r.Dy() + numWorkers - 1) / numWorkers
 
 	var wg sync.WaitGroup
 	for w := 0; w < numWorkers; w++ {
-		startY := w * rowsPerWorker
+		startY := r.Min.Y + w*rowsPerWorker
 		endY := startY + rowsPerWorker
-		if endY > dstH {
-			endY = dstH
+		if endY > r.Max.Y {
+			endY = r.Max.Y
 		}
-		if startY >= dstH {
+		if startY >= r.Max.Y {
 			break
 		}
 
@@ -69,19 +80,25 @@ func copyWithOffsetBGRA(dst, src *image.NRGBA, offsetX, offsetY int, flipX, flip
 		go func(startY, endY int) {
 			defer wg.Done()
 			for dy := startY; dy < endY; dy++ {
-				dstRowStart := (dy-dst.Rect.Min.Y)*dst.Stride - dst.Rect.Min.X*4
-				for dx := 0; dx < dstW; dx++ {
+				dstRowStart := dy * dst.Stride
+				for dx := r.Min.X; dx < r.Max.X; dx++ {
 					// Calculate source coordinates with offset
 					sx := dx - offsetX
 					sy := dy - offsetY
 
+					dstIdx := dstRowStart + dx*4
+
 					// Bounds check
 					if sx < 0 || sx >= srcW || sy < 0 || sy >= srcH {
-						continue // Leave dst pixel as zero (transparent)
+						// Transparent
+						dst.Pix[dstIdx+0] = 0
+						dst.Pix[dstIdx+1] = 0
+						dst.Pix[dstIdx+2] = 0
+						dst.Pix[dstIdx+3] = 0
+						continue
 					}
 
 					srcIdx := (sy-src.Rect.Min.Y)*src.Stride + (sx-src.Rect.Min.X)*4
-					dstIdx := dstRowStart + dx*4
 
 					// Copy with RGBA -> BGRA swap (only if alpha > 0)
 					if src.Pix[srcIdx+3] > 0 {
@@ -89,6 +106,11 @@ func copyWithOffsetBGRA(dst, src *image.NRGBA, offsetX, offsetY int, flipX, flip
 						dst.Pix[dstIdx+1] = src.Pix[srcIdx+1] // G <- G
 						dst.Pix[dstIdx+2] = src.Pix[srcIdx+0] // R <- B
 						dst.Pix[dstIdx+3] = src.Pix[srcIdx+3] // A <- A
+					} else {
+						dst.Pix[dstIdx+0] = 0
+						dst.Pix[dstIdx+1] = 0
+						dst.Pix[dstIdx+2] = 0
+						dst.Pix[dstIdx+3] = 0
 					}
 				}
 			}
@@ -97,6 +119,19 @@ func copyWithOffsetBGRA(dst, src *image.NRGBA, offsetX, offsetY int, flipX, flip
 	wg.Wait()
 }
 
+// dirtyRectWithOffset returns the area of dst written by copyWithOffsetBGRA that depends on
+// the area dirty of src. The result is relative to the top-left corner of dst.
+func dirtyRectWithOffset(dst, src *image.NRGBA, dirty image.Rectangle, offsetX, offsetY int, flipX, flipY bool) image.Rectangle {
+	if flipX {
+		offsetX = -offsetX
+	}
+	if flipY {
+		offsetY = -offsetY
+	}
+	r := dirty.Sub(src.Rect.Min).Add(image.Pt(offsetX, offsetY))
+	return r.Intersect(image.Rect(0, 0, dst.Rect.Dx(), dst.Rect.Dy()))
+}
+
 func readIDAndFilePath() (int, string, error) {
 	id, err := readInt32()
 	if err != nil {
@@ -1,8 +1,10 @@
 package jobqueue
 
 import (
+	"container/heap"
 	"context"
 	"errors"
+	"runtime"
 	"sync"
 	"sync/atomic"
 )
@@ -11,79 +13,196 @@ var Continue = errors.New("jobqueue: requested continue")
 
 type JobFunc func(context.Context) error
 
+// Default is a queue shared by the whole process, with one worker per CPU.
+var Default = New(runtime.NumCPU())
+
+type job struct {
+	f     JobFunc
+	prio  int
+	seq   uint64
+	group *Group
+}
+
+// jobHeap orders jobs by priority (higher first), then by enqueue order.
+type jobHeap []*job
+
+func (h jobHeap) Len() int { return len(h) }
+func (h jobHeap) Less(i, j int) bool {
+	if h[i].prio != h[j].prio {
+		return h[i].prio > h[j].prio
+	}
+	return h[i].seq < h[j].seq
+}
+func (h jobHeap) Swap(i, j int) { h[i], h[j] = h[j], h[i] }
+func (h *jobHeap) Push(x any)   { *h = append(*h, x.(*job)) }
+func (h *jobHeap) Pop() any {
+	old := *h
+	n := len(old)
+	j := old[n-1]
+	old[n-1] = nil
+	*h = old[:n-1]
+	return j
+}
+
+// JobQueue runs jobs on a fixed number of worker goroutines.
+// Pending jobs are started in order of priority, and jobs with the same priority in the order they were enqueued.
 type JobQueue struct {
-	queue  chan JobFunc
-	done   chan struct{}
-	ctx    context.Context
-	cancel context.CancelFunc
-	m      sync.Mutex
+	m       sync.Mutex
+	cond    *sync.Cond
+	pending jobHeap
+	running map[*job]context.CancelFunc
+	seq     uint64
+	closed  bool
+	workers sync.WaitGroup
+	def     *Group
 }
 
-func New(length int) *JobQueue {
+// Group is a set of jobs that can be cancelled together without affecting other jobs in the queue.
+type Group struct {
+	jq *JobQueue
+}
+
+// New creates a JobQueue with the given number of workers.
+func New(workers int) *JobQueue {
+	if workers < 1 {
+		workers = 1
+	}
 	jq := &JobQueue{
-		done: make(chan struct{}),
+		running: map[*job]context.CancelFunc{},
+	}
+	jq.cond = sync.NewCond(&jq.m)
+	jq.def = jq.NewGroup()
+	jq.workers.Add(workers)
+	for i := 0; i < workers; i++ {
+		go jq.work()
 	}
-	jq.init()
 	return jq
 }
 
-func (jq *JobQueue) init() {
-	jq.queue = make(chan JobFunc, cap(jq.queue))
-	jq.ctx, jq.cancel = context.WithCancel(context.Background())
-	go jq.work()
-}
-
-func (jq *JobQueue) final() {
-	close(jq.queue)
-	jq.cancel()
-	<-jq.done
+// NewGroup creates a new cancellation group.
+func (jq *JobQueue) NewGroup() *Group {
+	return &Group{jq: jq}
 }
 
+// Close cancels all jobs and stops the workers.
 func (jq *JobQueue) Close() {
 	jq.m.Lock()
-	jq.final()
-	close(jq.done)
-	jq.done = nil
+	if jq.closed {
+		jq.m.Unlock()
+		return
+	}
+	jq.closed = true
+	jq.cancel(nil)
+	jq.cond.Broadcast()
 	jq.m.Unlock()
+	jq.workers.Wait()
 }
 
+// CancelAll cancels all pending and running jobs of every group.
 func (jq *JobQueue) CancelAll() {
 	jq.m.Lock()
-	if jq.done != nil {
-		jq.final()
-		jq.init()
-	}
+	jq.cancel(nil)
 	jq.m.Unlock()
 }
 
+// Enqueue adds job to the default group with priority 0.
 func (jq *JobQueue) Enqueue(job JobFunc) {
+	jq.def.EnqueueWithPriority(0, job)
+}
+
+// EnqueueWithPriority adds job to the default group.
+func (jq *JobQueue) EnqueueWithPriority(prio int, job JobFunc) {
+	jq.def.EnqueueWithPriority(prio, job)
+}
+
+// cancel drops pending jobs and cancels running jobs of g, or of every group if g is nil.
+// jq.m must be held.
+func (jq *JobQueue) cancel(g *Group) {
+	if g == nil {
+		for i := range jq.pending {
+			jq.pending[i] = nil
+		}
+		jq.pending = jq.pending[:0]
+	} else {
+		n := 0
+		for _, j := range jq.pending {
+			if j.group != g {
+				jq.pending[n] = j
+				n++
+			}
+		}
+		for i := n; i < len(jq.pending); i++ {
+			jq.pending[i] = nil
+		}
+		jq.pending = jq.pending[:n]
+		heap.Init(&jq.pending)
+	}
+	for j, cancel := range jq.running {
+		if g == nil || j.group == g {
+			cancel()
+		}
+	}
+}
+
+// CancelAll cancels all pending and running jobs of the group.
+// Jobs enqueued afterwards run normally.
+func (g *Group) CancelAll() {
+	g.jq.m.Lock()
+	g.jq.cancel(g)
+	g.jq.m.Unlock()
+}
+
+// Enqueue adds job to the group with priority 0.
+func (g *Group) Enqueue(job JobFunc) {
+	g.EnqueueWithPriority(0, job)
+}
+
+// EnqueueWithPriority adds job to the group. Jobs with higher prio are started first.
+func (g *Group) EnqueueWithPriority(prio int, f JobFunc) {
+	jq := g.jq
 	jq.m.Lock()
-	if jq.done != nil {
-		jq.queue <- job
+	defer jq.m.Unlock()
+	if jq.closed {
+		return
 	}
-	jq.m.Unlock()
+	jq.seq++
+	heap.Push(&jq.pending, &job{f: f, prio: prio, seq: jq.seq, group: g})
+	jq.cond.Signal()
 }
 
 func (jq *JobQueue) work() {
-	defer func() {
-		if jq.ctx.Err() != context.Canceled {
-			jq.cancel()
+	defer jq.workers.Done()
+	for {
+		jq.m.Lock()
+		for len(jq.pending) == 0 && !jq.closed {
+			jq.cond.Wait()
 		}
-		jq.done <- struct{}{}
-	}()
-	for f := range jq.queue {
-		if jq.run(f) == context.Canceled {
-			break
+		if jq.closed {
+			jq.m.Unlock()
+			return
 		}
+		j := heap.Pop(&jq.pending).(*job)
+		ctx, cancel := context.WithCancel(context.Background())
+		jq.running[j] = cancel
+		jq.m.Unlock()
+
+		run(ctx, j.f)
+
+		jq.m.Lock()
+		delete(jq.running, j)
+		jq.m.Unlock()
+		cancel()
 	}
 }
 
-func (jq *JobQueue) run(job JobFunc) error {
+// run runs job until it finishes or ctx is cancelled.
+// A cancelled job is abandoned, so the worker can start the next job without waiting for it to notice.
+func run(ctx context.Context, job JobFunc) error {
 	var finished int32
 	finish := make(chan error, 1)
 	go func() {
 		for {
-			err := job(jq.ctx)
+			err := job(ctx)
 			if err == Continue && atomic.LoadInt32(&finished) == 0 {
 				continue
 			}
@@ -91,14 +210,11 @@ func (jq *JobQueue) run(job JobFunc) error {
 			break
 		}
 	}()
-	doneCh := jq.ctx.Done()
-	for {
-		select {
-		case err := <-finish:
-			return err
-		case <-doneCh:
-			atomic.StoreInt32(&finished, 1)
-			return jq.ctx.Err()
-		}
+	select {
+	case err := <-finish:
+		return err
+	case <-ctx.Done():
+		atomic.StoreInt32(&finished, 1)
+		return ctx.Err()
 	}
 }
@@ -2,7 +2,9 @@ package jobqueue
 
 import (
 	"context"
+	"runtime"
 	"sync"
+	"sync/atomic"
 	"testing"
 	"time"
 )
@@ -79,3 +81,123 @@ func TestCancelAll(t *testing.T) {
 		t.Errorf("want 0 got %d", l)
 	}
 }
+
+func TestPriority(t *testing.T) {
+	jq := New(1)
+	defer jq.Close()
+
+	// Keep the only worker busy while the other jobs are queued
+	block := make(chan struct{})
+	jq.Enqueue(func(ctx context.Context) error {
+		<-block
+		return nil
+	})
+
+	var got []int
+	var wg sync.WaitGroup
+	for _, prio := range []int{0, 2, 1, 2} {
+		prio := prio
+		wg.Add(1)
+		jq.EnqueueWithPriority(prio, func(ctx context.Context) error {
+			got = append(got, prio)
+			wg.Done()
+			return nil
+		})
+	}
+	close(block)
+	wg.Wait()
+	want := []int{2, 2, 1, 0}
+	for i := range want {
+		if got[i] != want[i] {
+			t.Fatalf("want %v got %v", want, got)
+		}
+	}
+}
+
+func TestGroupCancel(t *testing.T) {
+	jq := New(2)
+	defer jq.Close()
+
+	g1, g2 := jq.NewGroup(), jq.NewGroup()
+	started := make(chan struct{})
+	cancelled := make(chan struct{})
+	g1.Enqueue(func(ctx context.Context) error {
+		close(started)
+		<-ctx.Done()
+		close(cancelled)
+		return nil
+	})
+	<-started
+
+	var done int32
+	g2.Enqueue(func(ctx context.Context) error {
+		time.Sleep(25 * time.Millisecond)
+		if ctx.Err() == nil {
+			atomic.StoreInt32(&done, 1)
+		}
+		return nil
+	})
+	g1.CancelAll()
+	select {
+	case <-cancelled:
+	case <-time.After(time.Second):
+		t.Fatal("running job of the cancelled group was not cancelled")
+	}
+	time.Sleep(50 * time.Millisecond)
+	if atomic.LoadInt32(&done) != 1 {
+		t.Error("job of another group was cancelled")
+	}
+
+	// The group can be used after cancellation
+	ch := make(chan struct{})
+	g1.Enqueue(func(ctx context.Context) error {
+		close(ch)
+		return nil
+	})
+	select {
+	case <-ch:
+	case <-time.After(time.Second):
+		t.Fatal("job enqueued after cancellation did not run")
+	}
+}
+
+func BenchmarkThroughput(b *testing.B) {
+	jq := New(runtime.NumCPU())
+	defer jq.Close()
+
+	var wg sync.WaitGroup
+	wg.Add(b.N)
+	b.ResetTimer()
+	for i := 0; i < b.N; i++ {
+		jq.Enqueue(func(ctx context.Context) error {
+			wg.Done()
+			return nil
+		})
+	}
+	wg.Wait()
+}
+
+func BenchmarkCancelLatency(b *testing.B) {
+	jq := New(runtime.NumCPU())
+	defer jq.Close()
+
+	g := jq.NewGroup()
+	for i := 0; i < b.N; i++ {
+		b.StopTimer()
+		started := make(chan struct{})
+		cancelled := make(chan struct{})
+		g.Enqueue(func(ctx context.Context) error {
+			close(started)
+			<-ctx.Done()
+			close(cancelled)
+			return nil
+		})
+		for j := 0; j < 100; j++ {
+			g.Enqueue(func(ctx context.Context) error { return nil })
+		}
+		<-started
+		b.StartTimer()
+		g.CancelAll()
+		<-cancelled
+	}
+}
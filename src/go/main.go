@@ -76,7 +76,9 @@ func main() {
 
 	exitCh := make(chan struct{})
 	go ipcm.Main(exitCh)
-	gcDone := gc.Start(exitCh)
+	gcPolicy := gc.DefaultPolicy
+	gcPolicy.MemoryLimit = gc.MemoryLimitFromEnv()
+	gcDone := gc.Start(exitCh, gcPolicy)
 
 	if err := g.Init(
 		"PSDToolKit "+gitTag+" ( "+gitRevision+" )",
@@ -0,0 +1,151 @@
+// Package nrgbapool recycles pixel buffers of *image.NRGBA canvases.
+//
+// Buffers are grouped into size classes (four classes per power of two), so a
+// buffer released for one canvas size can be reused for slightly smaller ones.
+// Unlike sync.Pool, retained buffers survive garbage collection; the total
+// amount of retained memory is capped by SetLimit.
+package nrgbapool
+
+import (
+	"image"
+	"math/bits"
+	"sync"
+	"sync/atomic"
+)
+
+const (
+	// minClassBits is the smallest pooled buffer size (4KiB); smaller buffers are just allocated.
+	minClassBits = 12
+	subClasses   = 4
+)
+
+type Stats struct {
+	Hits     uint64 // Get calls served from the pool
+	Misses   uint64 // Get calls that allocated a new buffer
+	Puts     uint64 // buffers accepted by Put
+	Dropped  uint64 // buffers rejected by Put because of the limit
+	Retained int    // bytes currently held by the pool
+}
+
+var (
+	m        sync.Mutex
+	free     = map[int][][]byte{}
+	retained int
+	limit    = 128 * 1024 * 1024
+
+	hits, misses, puts, dropped uint64
+)
+
+// classSize returns the byte size of class c.
+func classSize(c int) int {
+	e, i := c/subClasses, c%subClasses
+	return (subClasses + i) << e / subClasses
+}
+
+// ceilClass returns the smallest class whose size is n or larger.
+func ceilClass(n int) int {
+	e := bits.Len(uint(n)) - 1
+	step := 1 << e / subClasses
+	i := (n - 1<<e + step - 1) / step
+	if i == subClasses {
+		return (e + 1) * subClasses
+	}
+	return e*subClasses + i
+}
+
+// floorClass returns the largest class whose size is n or smaller.
+func floorClass(n int) int {
+	e := bits.Len(uint(n)) - 1
+	step := 1 << e / subClasses
+	return e*subClasses + (n-1<<e)/step
+}
+
+// SetLimit sets the maximum number of bytes retained by the pool and returns the previous value.
+func SetLimit(bytes int) int {
+	m.Lock()
+	defer m.Unlock()
+	old := limit
+	limit = bytes
+	for c, l := range free {
+		for len(l) > 0 && retained > limit {
+			retained -= cap(l[len(l)-1])
+			l[len(l)-1] = nil
+			l = l[:len(l)-1]
+		}
+		free[c] = l
+	}
+	return old
+}
+
+// GetPix returns a byte slice of length n. The contents are undefined.
+func GetPix(n int) []byte {
+	if n < 1<<minClassBits {
+		return make([]byte, n)
+	}
+	c := ceilClass(n)
+	m.Lock()
+	if l := free[c]; len(l) > 0 {
+		b := l[len(l)-1]
+		l[len(l)-1] = nil
+		free[c] = l[:len(l)-1]
+		retained -= cap(b)
+		m.Unlock()
+		atomic.AddUint64(&hits, 1)
+		return b[:n]
+	}
+	m.Unlock()
+	atomic.AddUint64(&misses, 1)
+	return make([]byte, n, classSize(c))
+}
+
+// PutPix releases b to the pool. The caller must not use b afterwards.
+func PutPix(b []byte) {
+	if cap(b) < 1<<minClassBits {
+		return
+	}
+	c := floorClass(cap(b))
+	m.Lock()
+	if retained+cap(b) > limit {
+		m.Unlock()
+		atomic.AddUint64(&dropped, 1)
+		return
+	}
+	free[c] = append(free[c], b[:0])
+	retained += cap(b)
+	m.Unlock()
+	atomic.AddUint64(&puts, 1)
+}
+
+// Get returns an *image.NRGBA with bounds r. The pixels are undefined, so the caller
+// must overwrite every pixel or clear the image before use.
+func Get(r image.Rectangle) *image.NRGBA {
+	w, h := r.Dx(), r.Dy()
+	return &image.NRGBA{
+		Pix:    GetPix(4 * w * h),
+		Stride: 4 * w,
+		Rect:   r,
+	}
+}
+
+// Put releases the pixel buffer of img to the pool. The caller must not use img afterwards.
+func Put(img *image.NRGBA) {
+	if img == nil {
+		return
+	}
+	PutPix(img.Pix)
+	img.Pix = nil
+}
+
+// GetStats returns the current pool statistics.
+func GetStats() Stats {
+	m.Lock()
+	r := retained
+	m.Unlock()
+	return Stats{
+		Hits:     atomic.LoadUint64(&hits),
+		Misses:   atomic.LoadUint64(&misses),
+		Puts:     atomic.LoadUint64(&puts),
+		Dropped:  atomic.LoadUint64(&dropped),
+		Retained: r,
+	}
+}
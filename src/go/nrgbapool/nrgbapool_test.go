@@ -0,0 +1,67 @@
+package nrgbapool
+
+import (
+	"image"
+	"testing"
+)
+
+func TestClass(t *testing.T) {
+	for n := 1 << minClassBits; n < 1<<20; n += 97 {
+		c := ceilClass(n)
+		if s := classSize(c); s < n {
+			t.Fatalf("ceilClass(%d): class size %d is too small", n, s)
+		}
+		if c > 0 && classSize(c-1) >= n {
+			t.Fatalf("ceilClass(%d): class %d is not the smallest", n, c)
+		}
+		f := floorClass(n)
+		if s := classSize(f); s > n {
+			t.Fatalf("floorClass(%d): class size %d is too large", n, s)
+		}
+		if classSize(f+1) <= n {
+			t.Fatalf("floorClass(%d): class %d is not the largest", n, f)
+		}
+	}
+}
+
+func TestReuse(t *testing.T) {
+	a := Get(image.Rect(0, 0, 100, 100))
+	if len(a.Pix) != 100*100*4 || a.Stride != 400 {
+		t.Fatalf("unexpected image: len %d stride %d", len(a.Pix), a.Stride)
+	}
+	p := &a.Pix[0]
+	Put(a)
+	before := GetStats()
+	b := Get(image.Rect(10, 10, 108, 110))
+	if &b.Pix[0] != p {
+		t.Errorf("want recycled buffer")
+	}
+	if got := GetStats().Hits - before.Hits; got != 1 {
+		t.Errorf("want 1 hit got %d", got)
+	}
+	if len(b.Pix) != 98*100*4 || b.Stride != 98*4 {
+		t.Errorf("unexpected image: len %d stride %d", len(b.Pix), b.Stride)
+	}
+	Put(b)
+}
+
+func TestLimit(t *testing.T) {
+	old := SetLimit(0)
+	defer SetLimit(old)
+	if r := GetStats().Retained; r != 0 {
+		t.Fatalf("want 0 retained bytes got %d", r)
+	}
+	before := GetStats()
+	Put(Get(image.Rect(0, 0, 64, 64)))
+	if got := GetStats().Dropped - before.Dropped; got != 1 {
+		t.Errorf("want 1 dropped got %d", got)
+	}
+}
+
+func BenchmarkGetPut(b *testing.B) {
+	r := image.Rect(0, 0, 1280, 720)
+	b.ReportAllocs()
+	for i := 0; i < b.N; i++ {
+		Put(Get(r))
+	}
+}
@@ -8,9 +8,11 @@
 --value@anm5:閉じ~ptkl,""
 --track@locut:ローカット,0,2000,100,1
 --track@hicut:ハイカット,0,8000,1000,1
+--select@levelmode:音量計算=0,平均=0,RMS=1,ピーク=2,A特性=3
 --track@threshold:しきい値,0,100,20,1
 --track@sensitivity:感度,1,100,1,1
 --check@enabled:発声がなくても有効,1
+--check@precomputed:事前解析,0
 require("PSDToolKit").psdcall(function()
 	require("PSDToolKit").add_lipsync({
 		["開き~ptkl"] = anm1,
@@ -20,8 +22,10 @@ require("PSDToolKit").psdcall(function()
 		["閉じ~ptkl"] = anm5,
 		["ローカット"] = tostring(locut),
 		["ハイカット"] = tostring(hicut),
+		["音量計算"] = tostring(levelmode),
 		["しきい値"] = tostring(threshold),
 		["感度"] = tostring(sensitivity),
 		["発声がなくても有効"] = enabled and "1" or "0",
+		["事前解析"] = precomputed and "1" or "0",
 	}, obj)
 end)
@@ -10,11 +10,13 @@ local overwriter_states = require("PSDToolKit.OverwriterStates")
 local audio_cache = {}
 
 --- Calculate audio level from pre-captured fourier data in Voice object.
+-- The band level is calculated by the script module.
 -- @param voice table: Voice object with fourier_data, fourier_sample_rate, fourier_n
 -- @param locut number: Low frequency cutoff (Hz)
 -- @param hicut number: High frequency cutoff (Hz)
+-- @param mode number: Level calculation mode (0: mean, 1: RMS, 2: peak, 3: A-weighted)
 -- @return number: Audio level
-local function calculate_audio_level_from_voice(voice, locut, hicut)
+local function calculate_audio_level_from_voice(voice, locut, hicut, mode)
 	if not voice then
 		return 0
 	end
@@ -27,34 +29,11 @@ local function calculate_audio_level_from_voice(voice, locut, hicut)
 		return 0
 	end
 
-	-- Calculate frequency per bin
-	local freq_per_bin = sample_rate / 2048
-
-	-- Calculate bin range for locut/hicut
-	local lo_bin = math.floor(locut / freq_per_bin)
-	local hi_bin = math.ceil(hicut / freq_per_bin)
-
-	-- Clamp to valid range (1 to n)
-	if lo_bin < 1 then
-		lo_bin = 1
-	end
-	if hi_bin > n then
-		hi_bin = n
-	end
-
-	-- Sum amplitude in the frequency range
-	local sum = 0
-	local count = 0
-	for i = lo_bin, hi_bin do
-		sum = sum + math.abs(buf[i] or 0)
-		count = count + 1
-	end
-
-	if count == 0 then
+	local ptk = obj.module("PSDToolKit")
+	if not ptk then
 		return 0
 	end
-
-	return sum / count
+	return ptk.get_audio_level(buf, sample_rate, locut, hicut, mode)
 end
 
 --- Create a context object for state evaluation.
@@ -85,8 +64,9 @@ function Context.new(psd, obj)
 	-- @param voice_id string|number: Voice ID to look up
 	-- @param locut number: Low frequency cutoff (Hz)
 	-- @param hicut number: High frequency cutoff (Hz)
+	-- @param mode number|nil: Level calculation mode (0: mean, 1: RMS, 2: peak, 3: A-weighted), default 0
 	-- @return number: Audio level
-	function ctx:get_audio_level(voice_id, locut, hicut)
+	function ctx:get_audio_level(voice_id, locut, hicut, mode)
 		if voice_id == nil then
 			error("voice_id is required")
 		end
@@ -97,19 +77,46 @@ function Context.new(psd, obj)
 			error("hicut is required")
 		end
 
+		mode = mode or 0
+
 		-- Create cache key using voice_id
-		local key = tostring(voice_id) .. ":" .. tostring(locut) .. ":" .. tostring(hicut)
+		local key = tostring(voice_id) .. ":" .. tostring(locut) .. ":" .. tostring(hicut) .. ":" .. tostring(mode)
 		if audio_cache[key] then
 			return audio_cache[key]
 		end
 
 		-- Get voice and calculate level from pre-captured fourier data
 		local voice = voice_states:get(voice_id)
-		local level = calculate_audio_level_from_voice(voice, locut, hicut)
+		local level = calculate_audio_level_from_voice(voice, locut, hicut, mode)
 		audio_cache[key] = level
 		return level
 	end
 
+	--- Get audio level of the voice file from its precomputed envelope.
+	-- Unlike get_audio_level, the result only depends on the current time of the voice,
+	-- and frames > 1 averages the levels of the preceding video frames.
+	-- @param voice_id string|number: Voice ID to look up
+	-- @param locut number: Low frequency cutoff (Hz)
+	-- @param hicut number: High frequency cutoff (Hz)
+	-- @param mode number|nil: Level calculation mode (0: mean, 1: RMS, 2: peak, 3: A-weighted), default 0
+	-- @param frames number: Number of video frames to average
+	-- @param interval number: Duration of a video frame in seconds
+	-- @return number|nil: Audio level, or nil if the voice file has not been analysed yet
+	function ctx:get_voice_level(voice_id, locut, hicut, mode, frames, interval)
+		if voice_id == nil then
+			error("voice_id is required")
+		end
+		local voice = voice_states:get(voice_id)
+		if not voice or not voice.audio or voice.audio == "" then
+			return nil
+		end
+		local ptk = obj.module("PSDToolKit")
+		if not ptk then
+			return nil
+		end
+		return ptk.get_voice_level(voice.audio, voice.time, locut, hicut, mode or 0, frames, interval)
+	end
+
 	--- Get overwriter values by character ID.
 	-- @param id string: Character ID (can be nil or empty for default)
 	-- @return table|nil: Overwriter values table {p1=number, ...}, or nil if not found
@@ -9,9 +9,47 @@ local initialized = false
 local has_error = false
 
 -- Frame tracking for multi-frame state management
+-- Tracked frames form a doubly linked list ordered from least to most recently
+-- accessed. Links are stored in tables keyed by frame number so that tracking,
+-- reordering and removal are all constant time.
 local MAX_RECENT_FRAMES = 4
-local recent_frames = {} -- Array of {frame=number, access_order=number}
-local access_counter = 0 -- Monotonically increasing counter for LRU-like ordering
+local prev_frames = {} -- frame number -> previous (less recently accessed) frame number
+local next_frames = {} -- frame number -> next (more recently accessed) frame number
+local tracked = {} -- frame number -> true if tracked
+local oldest_frame = nil
+local newest_frame = nil
+local num_frames = 0
+
+--- Unlink a tracked frame from the list.
+-- @param frame_number number: The tracked frame number
+local function unlink(frame_number)
+	local prev = prev_frames[frame_number]
+	local next_ = next_frames[frame_number]
+	if prev then
+		next_frames[prev] = next_
+	else
+		oldest_frame = next_
+	end
+	if next_ then
+		prev_frames[next_] = prev
+	else
+		newest_frame = prev
+	end
+	prev_frames[frame_number] = nil
+	next_frames[frame_number] = nil
+end
+
+--- Append a frame to the most recently accessed end of the list.
+-- @param frame_number number: The frame number, must not be linked
+local function append(frame_number)
+	if newest_frame then
+		next_frames[newest_frame] = frame_number
+		prev_frames[frame_number] = newest_frame
+	else
+		oldest_frame = frame_number
+	end
+	newest_frame = frame_number
+end
 
 --- Clear frame state for a new frame.
 -- Called at the beginning of each frame processing.
@@ -49,56 +87,49 @@ end
 -- This is called when data is registered for a specific frame.
 -- @param frame_number number: The frame number that was accessed
 function FrameState.track_frame_access(frame_number)
-	access_counter = access_counter + 1
-
-	-- Check if frame already tracked, update access order
-	for _, entry in ipairs(recent_frames) do
-		if entry.frame == frame_number then
-			entry.access_order = access_counter
-			return
-		end
+	if newest_frame == frame_number then
+		return
 	end
-
-	-- Add new frame
-	table.insert(recent_frames, {
-		frame = frame_number,
-		access_order = access_counter,
-	})
+	if tracked[frame_number] then
+		unlink(frame_number)
+	else
+		tracked[frame_number] = true
+		num_frames = num_frames + 1
+	end
+	append(frame_number)
 end
 
+local no_frames = {}
+
 --- Get frames to cleanup (frames not in the most recent MAX_RECENT_FRAMES).
 -- Returns and removes stale frame entries from tracking.
--- @return table: Array of frame numbers to clean up
+-- The returned array must not be modified.
+-- @return table: Array of frame numbers to clean up, oldest first
 function FrameState.get_frames_to_cleanup()
-	if #recent_frames <= MAX_RECENT_FRAMES then
-		return {}
+	if num_frames <= MAX_RECENT_FRAMES then
+		return no_frames
 	end
 
-	-- Sort by access_order (oldest first)
-	table.sort(recent_frames, function(a, b)
-		return a.access_order < b.access_order
-	end)
-
-	-- Collect frames to remove (all but the last MAX_RECENT_FRAMES)
 	local to_cleanup = {}
-	local remove_count = #recent_frames - MAX_RECENT_FRAMES
-	for i = 1, remove_count do
-		table.insert(to_cleanup, recent_frames[i].frame)
+	while num_frames > MAX_RECENT_FRAMES do
+		local frame = oldest_frame
+		unlink(frame)
+		tracked[frame] = nil
+		num_frames = num_frames - 1
+		to_cleanup[#to_cleanup + 1] = frame
 	end
-
-	-- Remove from tracking
-	for _ = 1, remove_count do
-		table.remove(recent_frames, 1)
-	end
-
 	return to_cleanup
 end
 
 --- Clear all frame tracking data.
 -- Called when cache is invalidated (project load or cache clear).
 function FrameState.clear_all_frames()
-	recent_frames = {}
-	access_counter = 0
+	prev_frames = {}
+	next_frames = {}
+	tracked = {}
+	oldest_frame = nil
+	newest_frame = nil
+	num_frames = 0
 end
 
 return FrameState
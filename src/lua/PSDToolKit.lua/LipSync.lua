@@ -6,6 +6,7 @@ LipSync.__index = LipSync
 
 local debug = require("PSDToolKit.debug")
 local dbg = debug.dbg
+local MovingAverage = require("PSDToolKit.MovingAverage")
 
 -- Per-layer state cache for smooth animation
 local states = {}
@@ -73,9 +74,11 @@ end
 --   Numeric parameters (stored as strings):
 --     "ローカット": Low frequency cutoff in Hz (default 100)
 --     "ハイカット": High frequency cutoff in Hz (default 1000)
+--     "音量計算": Level calculation mode (0: mean, 1: RMS, 2: peak, 3: A-weighted, default 0)
 --     "しきい値": Volume threshold for opening mouth (default 20)
 --     "感度": Number of frames for moving average (default 1)
 --     "発声がなくても有効": Apply even when no voice data is available (0 or 1)
+--     "事前解析": Use the precomputed envelope of the voice file (0 or 1)
 -- @return LipSync: New LipSync object
 function LipSync.new(opts)
 	if not opts then
@@ -95,12 +98,14 @@ function LipSync.new(opts)
 	-- Parse numeric parameters (stored as strings)
 	local locut = tonumber(opts["ローカット"]) or 100
 	local hicut = tonumber(opts["ハイカット"]) or 1000
+	local level_mode = tonumber(opts["音量計算"]) or 0
 	local threshold = tonumber(opts["しきい値"]) or 20
 	local sensitivity = tonumber(opts["感度"]) or 1
 
 	-- Convert alwaysapply to boolean (stored as "0" or "1")
 	local alwaysapply_val = tonumber(opts["発声がなくても有効"]) or 0
 	local alwaysapply = alwaysapply_val ~= 0
+	local precomputed = (tonumber(opts["事前解析"]) or 0) ~= 0
 
 	return setmetatable({
 		patterns = patterns,
@@ -108,40 +113,30 @@ function LipSync.new(opts)
 		alwaysapply = alwaysapply,
 		locut = locut,
 		hicut = hicut,
+		level_mode = level_mode,
 		threshold = threshold,
+		precomputed = precomputed,
 	}, LipSync)
 end
 
 --- Calculate moving average volume.
--- @param stat table: State table with vols array
+-- @param stat table: State table with vols MovingAverage
 -- @param volume number: Current volume
 -- @param time number: Current time
 -- @param sensitivity number: Number of frames for moving average
 -- @return number: Averaged volume
 local function calculate_moving_average(stat, volume, time, sensitivity)
+	stat.vols:resize(sensitivity)
+
 	-- Reset if time goes backwards or jumps too far forward
 	-- Allow 1 second tolerance for preview scrubbing
 	if stat.time > time or stat.time + 1 < time then
-		stat.vols = {}
-	end
-
-	-- Add current volume to history
-	table.insert(stat.vols, volume)
-
-	-- Keep only the last 'sensitivity' frames
-	while #stat.vols > sensitivity do
-		table.remove(stat.vols, 1)
+		stat.vols:reset()
 	end
 
 	stat.time = time
 
-	-- Calculate average
-	local sum = 0
-	for _, v in ipairs(stat.vols) do
-		sum = sum + v
-	end
-
-	return sum / #stat.vols
+	return stat.vols:push(volume)
 end
 
 --- Gets the current lip state based on audio volume.
@@ -174,25 +169,36 @@ function LipSync:getstate(ctx)
 	-- Get or initialize per-layer state
 	local stat = states[obj.layer]
 	if not stat then
-		stat = { time = obj.time, pat = 0, vols = {}, voice_obj_id = voice.obj_id }
+		stat = { time = obj.time, pat = 0, vols = MovingAverage.new(self.sensitivity), voice_obj_id = voice.obj_id }
 	end
 
 	-- Reset animation state if voice object changed
 	if stat.voice_obj_id ~= voice.obj_id then
-		stat = { time = obj.time, pat = 0, vols = {}, voice_obj_id = voice.obj_id }
+		stat = { time = obj.time, pat = 0, vols = MovingAverage.new(self.sensitivity), voice_obj_id = voice.obj_id }
 	end
 
 	-- Reset animation state if time goes backwards or jumps too far forward
 	if stat.time > obj.time or stat.time + 1 < obj.time then
 		stat.pat = 0
-		stat.vols = {}
+		stat.vols:reset()
 	end
 
-	-- Get audio level from Voice's pre-captured fourier data (via voice_id)
-	local raw_volume = ctx:get_audio_level(voice_id, self.locut, self.hicut)
+	-- The precomputed envelope already averages the preceding frames, so the result
+	-- does not depend on which frames were rendered before.
+	-- Falls back to the fourier data while the voice file is being analysed.
+	local raw_volume, avg_volume
+	if self.precomputed then
+		avg_volume =
+			ctx:get_voice_level(voice_id, self.locut, self.hicut, self.level_mode, self.sensitivity, 1 / obj.framerate)
+		raw_volume = avg_volume
+	end
+	if avg_volume == nil then
+		-- Get audio level from Voice's pre-captured fourier data (via voice_id)
+		raw_volume = ctx:get_audio_level(voice_id, self.locut, self.hicut, self.level_mode)
 
-	-- Apply moving average for smooth animation
-	local avg_volume = calculate_moving_average(stat, raw_volume, obj.time, self.sensitivity)
+		-- Apply moving average for smooth animation
+		avg_volume = calculate_moving_average(stat, raw_volume, obj.time, self.sensitivity)
+	end
 
 	dbg("LipSync: raw=%.2f avg=%.2f threshold=%.2f pat=%d", raw_volume, avg_volume, self.threshold, stat.pat)
 
@@ -222,19 +222,6 @@ function LipSyncLab.new(opts)
 	}, LipSyncLab)
 end
 
---- Get adjacent phoneme from entries
--- @param entries table: Phoneme entries array
--- @param index number: Current index
--- @param offset number: Offset (-1 for previous, +1 for next)
--- @return table|nil: Adjacent entry or nil if out of bounds
-local function get_adjacent(entries, index, offset)
-	local adj_index = index + offset
-	if adj_index < 1 or adj_index > #entries then
-		return nil
-	end
-	return entries[adj_index]
-end
-
 --- Mode 0: All consonants become N (closed)
 -- @param cur string: Current phoneme
 -- @param pat table: Patterns table
@@ -302,21 +289,18 @@ function LipSyncLab:process_mode2(cur, phoneme_info, pat)
 		return pat.N
 	end
 
-	local entries = phoneme_info.entries
-	local index = phoneme_info.index
 	local progress = phoneme_info.progress
 
 	-- Get adjacent entries
-	local prev_entry = get_adjacent(entries, index, -1)
-	local next_entry = get_adjacent(entries, index, 1)
+	local prev_entry = phoneme_info.prev
+	local next_entry = phoneme_info.next
 
 	if cur == "cl" then
 		-- Geminate consonant (っ)
 		if progress < 0.5 then
 			-- First half: use previous vowel if adjacent
 			if prev_entry and isvowel(prev_entry.phoneme) ~= 0 then
-				local cur_entry = entries[index]
-				if prev_entry.end_ == cur_entry.start then
+				if prev_entry.end_ == phoneme_info.start then
 					return pat[prev_entry.phoneme] or pat.N
 				end
 			end
@@ -331,8 +315,7 @@ function LipSyncLab:process_mode2(cur, phoneme_info, pat)
 	if progress < 0.5 then
 		-- First half: inherit from previous vowel
 		if prev_entry and isvowel(prev_entry.phoneme) ~= 0 then
-			local cur_entry = entries[index]
-			if prev_entry.end_ == cur_entry.start then
+			if prev_entry.end_ == phoneme_info.start then
 				local prev_p = prev_entry.phoneme
 				-- Transition to smaller shape
 				if prev_p == "a" or prev_p == "A" then
@@ -348,8 +331,7 @@ function LipSyncLab:process_mode2(cur, phoneme_info, pat)
 	else
 		-- Second half: prepare for next vowel
 		if next_entry and isvowel(next_entry.phoneme) ~= 0 then
-			local cur_entry = entries[index]
-			if next_entry.start == cur_entry.end_ then
+			if next_entry.start == phoneme_info.end_ then
 				local next_p = next_entry.phoneme
 				-- Transition to smaller shape
 				if next_p == "a" or next_p == "A" then
@@ -0,0 +1,97 @@
+--- MovingAverage - Fixed size moving average over a ring buffer
+-- Adding a value and reading the average are O(1) regardless of the window size.
+local MovingAverage = {}
+MovingAverage.__index = MovingAverage
+
+local function normalize_size(size)
+	return math.max(1, math.floor(size or 1))
+end
+
+--- Create a new moving average.
+-- @param size number: Window size (number of values averaged, at least 1)
+-- @return MovingAverage: New MovingAverage object
+function MovingAverage.new(size)
+	return setmetatable({
+		size = normalize_size(size),
+		buf = {},
+		pos = 0, -- Index of the most recently added value, 0 when empty
+		count = 0,
+		sum = 0,
+	}, MovingAverage)
+end
+
+--- Remove all values.
+function MovingAverage:reset()
+	self.pos = 0
+	self.count = 0
+	self.sum = 0
+end
+
+--- Change the window size.
+-- The most recent values are kept, as many as fit in the new window.
+-- @param size number: Window size (number of values averaged, at least 1)
+function MovingAverage:resize(size)
+	size = normalize_size(size)
+	if size == self.size then
+		return
+	end
+	local old_size = self.size
+	local old_buf = self.buf
+	local count = math.min(self.count, size)
+	-- Copy oldest first so that the ring starts at index 1 again
+	local buf = {}
+	local sum = 0
+	local src = self.pos - count
+	for i = 1, count do
+		src = src + 1
+		local v = old_buf[src < 1 and src + old_size or src]
+		buf[i] = v
+		sum = sum + v
+	end
+	self.size = size
+	self.buf = buf
+	self.pos = count
+	self.count = count
+	self.sum = sum
+end
+
+--- Add a value to the window, dropping the oldest value when the window is full.
+-- @param value number: Value to add
+-- @return number: Average of the values in the window
+function MovingAverage:push(value)
+	local size = self.size
+	local buf = self.buf
+	local pos = self.pos + 1
+	if pos > size then
+		pos = 1
+	end
+	if self.count == size then
+		self.sum = self.sum - buf[pos]
+	else
+		self.count = self.count + 1
+	end
+	buf[pos] = value
+	self.pos = pos
+	if pos == size then
+		-- Resum once per lap so that rounding errors of the running sum do not accumulate
+		local sum = 0
+		for i = 1, self.count do
+			sum = sum + buf[i]
+		end
+		self.sum = sum
+	else
+		self.sum = self.sum + value
+	end
+	return self.sum / self.count
+end
+
+--- Get the average of the values in the window.
+-- @return number: Average, or 0 when empty
+function MovingAverage:average()
+	if self.count == 0 then
+		return 0
+	end
+	return self.sum / self.count
+end
+
+return MovingAverage
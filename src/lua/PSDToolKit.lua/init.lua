@@ -12,7 +12,6 @@ local VoiceStates = require("PSDToolKit.VoiceStates")
 local OverwriterStates = require("PSDToolKit.OverwriterStates")
 local SubObjectStates = require("PSDToolKit.SubObjectStates")
 local Animations = require("PSDToolKit.Animations")
-local LabFile = require("PSDToolKit.LabFile")
 local LipSync = require("PSDToolKit.LipSync")
 local LipSyncLab = require("PSDToolKit.LipSyncLab")
 local ValueCache = require("PSDToolKit.ValueCache")
@@ -51,7 +50,6 @@ function M.new_frame()
 	-- Clear ALL caches when cache_index changes (project load or cache clear)
 	if last_cache_index ~= cfg.cache_index then
 		ValueCache.clear()
-		LabFile.clear()
 		LipSync.clear()
 		LipSyncLab.clear()
 		CurrentPSD.clear_all()